@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Puts the far field's pixels in the scene with their depth, for the meshes drawn after to test against
+
+layout(set = 0, binding = 1, rgba8) uniform readonly image2D farColor;
+layout(set = 0, binding = 2, r32f)  uniform readonly image2D farDepth;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    const ivec2 pixel = ivec2(gl_FragCoord.xy);
+    const float depth = imageLoad(farDepth, pixel).r;
+
+    if (depth >= 1.0)
+        discard;
+
+    outColor     = imageLoad(farColor, pixel);
+    gl_FragDepth = depth;
+}
\ No newline at end of file
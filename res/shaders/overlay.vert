@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform OverlayPushConstants {
+    vec4 scale;
+} overlay;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition * overlay.scale.xy - 1.0, 0.0, 1.0);
+    fragUV = inUV;
+    fragColor = inColor;
+}
\ No newline at end of file
@@ -1,12 +1,23 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+layout(set = 0, binding = 0) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 time;
+} frame;
+
+layout(push_constant) uniform ChunkPushConstants {
+    vec4 origin;
+} chunk;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(inPosition, 1.0);
+    gl_Position = frame.projection * frame.view * vec4(inPosition + chunk.origin.xyz, 1.0);
     fragColor = inColor;
 }
\ No newline at end of file
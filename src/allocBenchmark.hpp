@@ -0,0 +1,284 @@
+#pragma once
+
+#include "header.hpp"
+#include "chunk.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "threadPool.hpp"
+#include "chunkMesher.hpp"
+#include "slabAllocator.hpp"
+
+#ifdef _WIN32
+#   include <psapi.h>
+#else
+#   include <unistd.h>
+#   include <sys/wait.h>
+#   include <sys/resource.h>
+#endif // _WIN32
+
+/*
+ * Section storage from the slabs against the heap, under the churn of a player walking in a straight
+ * line: every round a row of chunks unloads behind and a row loads ahead, the new sections are meshed
+ * and some random ones remeshed, their meshing scratch coming from the same allocator as the sections.
+ * Meshes stay alive with their section, as in the mesh cache, so the heap holds both. Each allocator
+ * runs in a process of its own where there are processes to fork, so neither inherits the other's heap.
+ */
+
+namespace mc {
+
+    struct AllocBenchmarkResult {
+        u64 loadUS    = 0; // Allocating and filling the sections loaded
+        u64 meshUS    = 0;
+        u64 sections  = 0; // Loaded
+        u64 meshed    = 0;
+        u64 rssBytes  = 0; // Resident set growth over the run
+        u64 faults    = 0; // Page faults over the run, minor ones included
+        u64 liveBytes = 0; // What the sections loaded at the end need
+
+        std::array<SlabStats, 4> slabs{}; // The pools at the end, in the slab run
+        u32                      slabCount = 0;
+    }; // struct AllocBenchmarkResult
+
+    class AllocBenchmark {
+    private:
+        static constexpr i32 WINDOW          = 32; // Loaded chunks along each axis
+        static constexpr u32 SECTIONS        = 4;  // Per chunk, the terrain stays below y = 64
+        static constexpr u32 REMESH_PER_ROUND = 256;
+
+        struct Column {
+            std::array<std::shared_ptr<ChunkSection>, SECTIONS> sections;
+            std::array<std::vector<Vertex>, SECTIONS>           meshes;
+        }; // struct Column
+
+        struct ProcessMemory {
+            u64 rssBytes = 0;
+            u64 faults   = 0;
+        }; // struct ProcessMemory
+
+        static ProcessMemory SampleProcessMemory() {
+            ProcessMemory memory;
+
+#ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters{};
+            if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+                memory.rssBytes = counters.WorkingSetSize;
+                memory.faults   = counters.PageFaultCount;
+            }
+#else
+            std::ifstream statm("/proc/self/statm");
+            u64 pages = 0, resident = 0;
+
+            if (statm >> pages >> resident)
+                memory.rssBytes = resident * static_cast<u64>(sysconf(_SC_PAGESIZE));
+
+            rusage usage{};
+            if (getrusage(RUSAGE_SELF, &usage) == 0)
+                memory.faults = static_cast<u64>(usage.ru_minflt + usage.ru_majflt);
+#endif // _WIN32
+
+            return memory;
+        }
+
+        // Rolling hills of stone under dirt and grass
+        static std::shared_ptr<ChunkSection> MakeSection(const bool bSlab, const ChunkCoord coord, const u32 sectionY) {
+            std::shared_ptr<ChunkSection> pSection = bSlab ? std::allocate_shared<ChunkSection>(SlabAllocator<ChunkSection>{}) : std::make_shared<ChunkSection>();
+
+            for (u32 z = 0; z < MC_CHUNK_SECTION_SIZE; ++z) {
+                for (u32 x = 0; x < MC_CHUNK_SECTION_SIZE; ++x) {
+                    const i32 wx     = ChunkToWorld(coord.x) + static_cast<i32>(x);
+                    const i32 wz     = ChunkToWorld(coord.z) + static_cast<i32>(z);
+                    const i32 height = 56 + static_cast<i32>(noise::Hash(0, wx >> 3, 0, wz >> 3) % 8);
+
+                    for (u32 y = 0; y < MC_CHUNK_SECTION_SIZE; ++y) {
+                        const i32 wy = static_cast<i32>(sectionY * MC_CHUNK_SECTION_SIZE + y);
+
+                        if (wy < height)
+                            pSection->Set(x, y, z, wy + 1 == height ? Block::Grass : (wy + 4 >= height ? Block::Dirt : Block::Stone));
+                    }
+                }
+            }
+
+            return pSection;
+        }
+
+        static void Gather(const std::unordered_map<ChunkCoord, Column, ChunkCoordHash>& columns, const vec3i32& coord, MeshingInput& input) {
+            constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+            input.sectionCoord = coord;
+
+            const auto Section = [&columns](const vec3i32& c) -> const ChunkSection* {
+                if (c.y < 0 || c.y >= static_cast<i32>(SECTIONS))
+                    return nullptr;
+
+                const auto it = columns.find(ChunkCoord{ c.x, c.z });
+                return it != columns.end() ? it->second.sections[static_cast<u32>(c.y)].get() : nullptr;
+            };
+
+            for (i32 y = -1; y <= S; ++y) {
+                for (i32 z = -1; z <= S; ++z) {
+                    for (i32 x = -1; x <= S; ++x) {
+                        const ChunkSection* pSection = Section(coord + vec3i32{ x < 0 ? -1 : (x >= S ? 1 : 0), y < 0 ? -1 : (y >= S ? 1 : 0), z < 0 ? -1 : (z >= S ? 1 : 0) });
+
+                        input.blocks[MeshingInput::Index(x, y, z)] = pSection ? pSection->Get(WorldToLocal(x), WorldToLocal(y), WorldToLocal(z)) : Block::Air;
+                    }
+                }
+            }
+        }
+
+    public:
+        static AllocBenchmarkResult Run(const bool bSlab, const u32 rounds, ThreadPool& pool) {
+            AllocBenchmarkResult result;
+
+            std::unordered_map<ChunkCoord, Column, ChunkCoordHash> columns;
+            std::vector<vec3i32> toMesh;
+
+            const ProcessMemory before = SampleProcessMemory();
+
+            u64 rng = 0x416C6C6F63ull;
+
+            for (i32 round = 0; round < static_cast<i32>(rounds) + WINDOW; ++round) {
+                toMesh.clear();
+
+                // The first WINDOW rounds fill the window, the others move it by a row
+                const Timer loadTimer;
+
+                for (i32 z = 0; z < WINDOW; ++z) {
+                    columns.erase(ChunkCoord{ round - WINDOW, z });
+
+                    Column& column = columns[ChunkCoord{ round, z }];
+
+                    for (u32 y = 0; y < SECTIONS; ++y) {
+                        column.sections[y] = MakeSection(bSlab, ChunkCoord{ round, z }, y);
+                        toMesh.push_back(vec3i32{ round - 1, static_cast<i32>(y), z }); // The row behind now has all its neighbours
+                    }
+                }
+
+                result.loadUS   += loadTimer.GetElapsedUS();
+                result.sections += static_cast<u64>(WINDOW) * SECTIONS;
+
+                if (round < WINDOW)
+                    continue;
+
+                for (u32 i = 0; i < REMESH_PER_ROUND; ++i) {
+                    rng = noise::Hash(rng);
+                    toMesh.push_back(vec3i32{ round - WINDOW + 1 + static_cast<i32>(rng % (WINDOW - 2)), static_cast<i32>((rng >> 16) % SECTIONS), static_cast<i32>((rng >> 32) % WINDOW) });
+                }
+
+                const Timer meshTimer;
+
+                // Meshes are written in place, so a section is meshed once per round
+                std::sort(toMesh.begin(), toMesh.end(), [](const vec3i32& a, const vec3i32& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); });
+                toMesh.erase(std::unique(toMesh.begin(), toMesh.end()), toMesh.end());
+
+                pool.ParallelFor(toMesh.size(), 16, [&](const std::size_t begin, const std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        const auto it = columns.find(ChunkCoord{ toMesh[i].x, toMesh[i].z });
+                        if (it == columns.end())
+                            continue;
+
+                        std::vector<Vertex> out;
+
+                        if (bSlab) {
+                            SlabPtr<MeshingInput> pInput = MakeSlab<MeshingInput>();
+                            Gather(columns, toMesh[i], *pInput);
+                            MeshSection(*pInput, 0, 0, out);
+                        } else {
+                            std::unique_ptr<MeshingInput> pInput = std::make_unique<MeshingInput>();
+                            Gather(columns, toMesh[i], *pInput);
+                            MeshSection(*pInput, 0, 0, out);
+                        }
+
+                        it->second.meshes[static_cast<u32>(toMesh[i].y)].swap(out);
+                    }
+                });
+
+                result.meshUS += meshTimer.GetElapsedUS();
+                result.meshed += toMesh.size();
+            }
+
+            const ProcessMemory after = SampleProcessMemory();
+
+            result.rssBytes  = after.rssBytes > before.rssBytes ? after.rssBytes - before.rssBytes : 0;
+            result.faults    = after.faults - before.faults;
+            result.liveBytes = columns.size() * SECTIONS * sizeof(ChunkSection);
+
+            for (const auto& [coord, column] : columns)
+                for (const std::vector<Vertex>& mesh : column.meshes)
+                    result.liveBytes += mesh.capacity() * sizeof(Vertex);
+
+            for (const SlabStats& stats : SlabPool::GetAllStats())
+                if (result.slabCount < result.slabs.size())
+                    result.slabs[result.slabCount++] = stats;
+
+            return result;
+        }
+
+        // In a child process where fork exists, with a pool of its own: threads do not survive a fork
+        static AllocBenchmarkResult RunIsolated(const bool bSlab, const u32 rounds) {
+#ifdef _WIN32
+            ThreadPool pool;
+            return Run(bSlab, rounds, pool);
+#else
+            int fds[2];
+            if (pipe(fds) != 0)
+                throw std::runtime_error("Failed to create the benchmark's pipe");
+
+            const pid_t pid = fork();
+            if (pid < 0)
+                throw std::runtime_error("Failed to fork the benchmark's process");
+
+            if (pid == 0) {
+                close(fds[0]);
+
+                AllocBenchmarkResult result;
+                {
+                    ThreadPool pool;
+                    result = Run(bSlab, rounds, pool);
+                }
+
+                const ssize_t written = write(fds[1], &result, sizeof(result));
+                _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+            }
+
+            close(fds[1]);
+
+            AllocBenchmarkResult result;
+            const ssize_t bytes = read(fds[0], &result, sizeof(result));
+            close(fds[0]);
+
+            int status = 0;
+            waitpid(pid, &status, 0);
+
+            if (bytes != static_cast<ssize_t>(sizeof(result)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                throw std::runtime_error("The benchmark's process failed");
+
+            return result;
+#endif // _WIN32
+        }
+
+        static void RunAll(const u32 rounds, std::ostream& out) {
+            out << "[BENCHMARK] " << rounds << " rounds of " << WINDOW << " chunks loaded and unloaded, " << WINDOW * WINDOW << " chunks of " << SECTIONS << " sections loaded\n";
+
+            for (const bool bSlab : { false, true }) {
+                const AllocBenchmarkResult result = RunIsolated(bSlab, rounds);
+
+                out << "[BENCHMARK] " << std::left << std::setw(6) << (bSlab ? "slab" : "malloc") << std::right << std::fixed << std::setprecision(2)
+                    << " | load " << static_cast<f64>(result.loadUS) / static_cast<f64>(std::max<u64>(result.sections, 1)) << " us per section"
+                    << " | mesh " << std::setprecision(0) << static_cast<f64>(result.meshed) * 1e6 / static_cast<f64>(std::max<u64>(result.meshUS, 1)) << " sections/s"
+                    << " | RSS +" << std::setprecision(1) << static_cast<f64>(result.rssBytes) / (1 << 20) << " MiB for " << static_cast<f64>(result.liveBytes) / (1 << 20) << " MiB live"
+                    << " | " << result.faults << " page faults\n";
+
+                for (u32 i = 0; i < result.slabCount; ++i) {
+                    const SlabStats& slab = result.slabs[i];
+
+                    out << "[BENCHMARK]        " << slab.blockSize << " B blocks: " << slab.used << " of " << slab.capacity << " used ("
+                        << static_cast<f64>(slab.used) * 100.0 / static_cast<f64>(std::max<std::size_t>(slab.capacity, 1)) << "%), "
+                        << slab.threadCached << " cached by threads, " << slab.slabs << " slabs\n";
+                }
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class AllocBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "header.hpp"
+#include "input.hpp"
 
 namespace mc {
     class AppSurface {
@@ -10,13 +11,66 @@ namespace mc {
             HWND handle;
 #endif // _WIN32
             mc::u32 width, height;
+
+            // Look deltas accumulate until PollInput() hands them over
+            mc::InputFrame input;
+            mc::i32        lastMouseX, lastMouseY;
+            bool           bHasMouse;
+
+            // F3 presses not handed over yet; the overlay is not gameplay input, so it is not recorded with it
+            mc::u32 overlayToggles;
         } static s_;
 
     private:
 #ifdef _WIN32
+        static std::optional<InputButton> Win32KeyToButton(const WPARAM key) {
+            switch (key) {
+            case 'W':       return InputButton::Forward;
+            case 'S':       return InputButton::Back;
+            case 'A':       return InputButton::Left;
+            case 'D':       return InputButton::Right;
+            case VK_SPACE:  return InputButton::Up;
+            case VK_SHIFT:  return InputButton::Down;
+            default:        return {};
+            }
+        }
+
         static LRESULT CALLBACK Win32WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             if (hwnd == mc::AppSurface::s_.handle) {
+                mc::InputFrame& input = mc::AppSurface::s_.input;
+
                 switch (msg) {
+                case WM_KEYDOWN:
+                case WM_KEYUP:
+                    // Bit 30 is set on the repeats of a held key
+                    if (wParam == VK_F3 && msg == WM_KEYDOWN && !(lParam & (1 << 30)))
+                        ++mc::AppSurface::s_.overlayToggles;
+
+                    if (const std::optional<InputButton> button = Win32KeyToButton(wParam))
+                        input.SetDown(button.value(), msg == WM_KEYDOWN);
+                    return 0;
+                case WM_LBUTTONDOWN: input.SetDown(InputButton::Break, true);  return 0;
+                case WM_LBUTTONUP:   input.SetDown(InputButton::Break, false); return 0;
+                case WM_RBUTTONDOWN: input.SetDown(InputButton::Place, true);  return 0;
+                case WM_RBUTTONUP:   input.SetDown(InputButton::Place, false); return 0;
+                case WM_MOUSEMOVE: {
+                    const i32 x = GET_X_LPARAM(lParam), y = GET_Y_LPARAM(lParam);
+
+                    if (mc::AppSurface::s_.bHasMouse) {
+                        input.lookX += x - mc::AppSurface::s_.lastMouseX;
+                        input.lookY += y - mc::AppSurface::s_.lastMouseY;
+                    }
+
+                    mc::AppSurface::s_.lastMouseX = x;
+                    mc::AppSurface::s_.lastMouseY = y;
+                    mc::AppSurface::s_.bHasMouse  = true;
+                    return 0;
+                }
+                case WM_KILLFOCUS:
+                    // The key releases will go to another window
+                    input.buttons = 0;
+                    mc::AppSurface::s_.bHasMouse = false;
+                    return 0;
                 case WM_DESTROY:
                     mc::AppSurface::Release();
                     return 0;
@@ -71,6 +125,25 @@ namespace mc {
 #endif // _WIN32
         }
 
+        // What is held now, and how far the mouse moved since the previous call
+        static InputFrame PollInput() {
+#ifdef _WIN32
+            const InputFrame frame = s_.input;
+
+            s_.input.lookX = 0;
+            s_.input.lookY = 0;
+
+            return frame;
+#else
+            return InputFrame{};
+#endif // _WIN32
+        }
+
+        // Whether F3 was pressed an odd number of times since the previous call
+        static bool ConsumeOverlayToggle() {
+            return (std::exchange(s_.overlayToggles, 0u) & 1u) != 0;
+        }
+
         static vk::SurfaceKHR CreateVulkanSurface(const vk::Instance& instance) {
 #ifdef _WIN32
             vk::Win32SurfaceCreateInfoKHR win32SurfaceCIkhr{};
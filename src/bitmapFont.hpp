@@ -0,0 +1,100 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+
+/*
+ * A 3 x 5 pixel font for ASCII 32 to 95, which is enough for numbers, upper case labels and their
+ * punctuation; lower case letters draw as upper case and anything else as '?'. It is baked into a
+ * one channel atlas of 16 x 5 cells of 4 x 6 pixels, the cell after the last glyph being solid so
+ * rectangles come from the same texture as the text.
+ */
+
+namespace mc {
+
+    class BitmapFont {
+    public:
+        static constexpr u32 GLYPH_WIDTH  = 3;
+        static constexpr u32 GLYPH_HEIGHT = 5;
+        static constexpr u32 CELL_WIDTH   = GLYPH_WIDTH + 1; // One pixel of spacing right and below
+        static constexpr u32 CELL_HEIGHT  = GLYPH_HEIGHT + 1;
+
+        static constexpr u32 FIRST_CHAR  = 32;
+        static constexpr u32 GLYPH_COUNT = 64;
+        static constexpr u32 SOLID_CELL  = GLYPH_COUNT;
+
+        static constexpr u32 COLUMNS      = 16;
+        static constexpr u32 ROWS         = (GLYPH_COUNT + 1 + COLUMNS - 1) / COLUMNS;
+        static constexpr u32 ATLAS_WIDTH  = COLUMNS * CELL_WIDTH;
+        static constexpr u32 ATLAS_HEIGHT = ROWS * CELL_HEIGHT;
+
+        struct CellUV {
+            vec2f32 min;
+            vec2f32 max;
+        }; // struct CellUV
+
+    private:
+        // Bit y * 3 + x is the pixel at column x of row y, rows top down
+        static constexpr std::array<u16, GLYPH_COUNT> GLYPHS = {
+            0x0000, 0x2092, 0x002D, 0x5F7D, 0x3C9E, 0x52A5, 0x6AAA, 0x0012,
+            0x4494, 0x1491, 0x0AA8, 0x05D0, 0x1400, 0x01C0, 0x2000, 0x12A4,
+            0x7B6F, 0x749A, 0x73E7, 0x79A7, 0x49ED, 0x79CF, 0x7BCF, 0x24A7,
+            0x7BEF, 0x79EF, 0x0410, 0x1410, 0x4454, 0x0E38, 0x1511, 0x21A7,
+            0x736F, 0x5BEA, 0x3AEB, 0x624E, 0x3B6B, 0x72CF, 0x12CF, 0x6B4E,
+            0x5BED, 0x7497, 0x2B24, 0x5AED, 0x7249, 0x5BFD, 0x5B6B, 0x2B6A,
+            0x12EB, 0x676A, 0x5AEB, 0x388E, 0x2497, 0x7B6D, 0x2B6D, 0x5FED,
+            0x5AAD, 0x24AD, 0x72A7, 0x6496, 0x4889, 0x3493, 0x002A, 0x7000,
+        };
+
+    public:
+        // Row major, one byte per pixel, 255 where a glyph is drawn
+        static std::vector<u8> BakeAtlas() {
+            std::vector<u8> atlas(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+
+            for (u32 glyph = 0; glyph < GLYPH_COUNT; ++glyph) {
+                const u32 left = (glyph % COLUMNS) * CELL_WIDTH;
+                const u32 top  = (glyph / COLUMNS) * CELL_HEIGHT;
+
+                for (u32 y = 0; y < GLYPH_HEIGHT; ++y)
+                    for (u32 x = 0; x < GLYPH_WIDTH; ++x)
+                        if (GLYPHS[glyph] & (1u << (y * GLYPH_WIDTH + x)))
+                            atlas[(top + y) * ATLAS_WIDTH + left + x] = 255;
+            }
+
+            const u32 left = (SOLID_CELL % COLUMNS) * CELL_WIDTH;
+            const u32 top  = (SOLID_CELL / COLUMNS) * CELL_HEIGHT;
+
+            for (u32 y = 0; y < CELL_HEIGHT; ++y)
+                for (u32 x = 0; x < CELL_WIDTH; ++x)
+                    atlas[(top + y) * ATLAS_WIDTH + left + x] = 255;
+
+            return atlas;
+        }
+
+        static constexpr u32 GetCell(const char c) {
+            const u32 code = static_cast<u8>(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+
+            return code >= FIRST_CHAR && code < FIRST_CHAR + GLYPH_COUNT ? code - FIRST_CHAR : '?' - FIRST_CHAR;
+        }
+
+        // The glyph's pixels within its cell, spacing excluded
+        static constexpr CellUV GetGlyphUV(const u32 cell) {
+            const f32 left = static_cast<f32>((cell % COLUMNS) * CELL_WIDTH);
+            const f32 top  = static_cast<f32>((cell / COLUMNS) * CELL_HEIGHT);
+
+            return CellUV{
+                vec2f32{ left / ATLAS_WIDTH, top / ATLAS_HEIGHT },
+                vec2f32{ (left + GLYPH_WIDTH) / ATLAS_WIDTH, (top + GLYPH_HEIGHT) / ATLAS_HEIGHT }
+            };
+        }
+
+        // The middle of the solid cell, where any quad samples full coverage
+        static constexpr vec2f32 GetSolidUV() {
+            return vec2f32{
+                ((SOLID_CELL % COLUMNS) * CELL_WIDTH + CELL_WIDTH * 0.5f) / ATLAS_WIDTH,
+                ((SOLID_CELL / COLUMNS) * CELL_HEIGHT + CELL_HEIGHT * 0.5f) / ATLAS_HEIGHT
+            };
+        }
+    }; // class BitmapFont
+
+}; // namespace mc
\ No newline at end of file
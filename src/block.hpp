@@ -0,0 +1,76 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+
+namespace mc {
+
+    enum class Block : u16 {
+        Air = 0,
+        Stone,
+        Dirt,
+        Grass,
+        Sand,
+        Gravel,
+        Water,
+        Lava,
+        Wood,
+        Leaves,
+        Bedrock,
+        CoalOre,
+        IronOre,
+        GoldOre,
+        DiamondOre,
+        Cobblestone,
+        Planks,
+
+        Count
+    }; // enum class Block
+
+    enum class BlockFace : u8 { NegX, PosX, NegY, PosY, NegZ, PosZ, None };
+
+    struct BlockProperties {
+        const char* name;
+        vec3f32     color;
+        bool        bSolid;       // Collides with entities and stops rays
+        bool        bOpaque;      // Hides the faces of its neighbours
+        bool        bRandomTicks; // Changes on its own now and then, see BlockTickScheduler
+        bool        bFalls;       // Falls when the block below stops holding it, on a scheduled tick
+    }; // struct BlockProperties
+
+    namespace details {
+        constexpr inline std::array<BlockProperties, static_cast<std::size_t>(Block::Count)> BLOCK_PROPERTIES = {
+            BlockProperties{ "air",         { 0.00f, 0.00f, 0.00f }, false, false, false, false },
+            BlockProperties{ "stone",       { 0.50f, 0.50f, 0.50f }, true,  true,  false, false },
+            BlockProperties{ "dirt",        { 0.47f, 0.33f, 0.23f }, true,  true,  false, false },
+            BlockProperties{ "grass",       { 0.35f, 0.62f, 0.25f }, true,  true,  true,  false },
+            BlockProperties{ "sand",        { 0.86f, 0.81f, 0.60f }, true,  true,  false, true  },
+            BlockProperties{ "gravel",      { 0.55f, 0.52f, 0.50f }, true,  true,  false, true  },
+            BlockProperties{ "water",       { 0.20f, 0.35f, 0.80f }, false, false, false, false },
+            BlockProperties{ "lava",        { 0.90f, 0.40f, 0.10f }, false, true,  false, false },
+            BlockProperties{ "wood",        { 0.40f, 0.30f, 0.18f }, true,  true,  false, false },
+            BlockProperties{ "leaves",      { 0.20f, 0.45f, 0.15f }, true,  false, false, false },
+            BlockProperties{ "bedrock",     { 0.15f, 0.15f, 0.15f }, true,  true,  false, false },
+            BlockProperties{ "coal ore",    { 0.30f, 0.30f, 0.30f }, true,  true,  false, false },
+            BlockProperties{ "iron ore",    { 0.62f, 0.52f, 0.45f }, true,  true,  false, false },
+            BlockProperties{ "gold ore",    { 0.80f, 0.70f, 0.30f }, true,  true,  false, false },
+            BlockProperties{ "diamond ore", { 0.40f, 0.75f, 0.78f }, true,  true,  false, false },
+            BlockProperties{ "cobblestone", { 0.42f, 0.42f, 0.42f }, true,  true,  false, false },
+            BlockProperties{ "planks",      { 0.62f, 0.48f, 0.30f }, true,  true,  false, false },
+        };
+    }; // namespace details
+
+    constexpr const BlockProperties& GetBlockProperties(const Block block) {
+        return details::BLOCK_PROPERTIES[static_cast<std::size_t>(block)];
+    }
+
+    constexpr bool IsSolid(const Block block)  { return GetBlockProperties(block).bSolid;  }
+    constexpr bool IsOpaque(const Block block) { return GetBlockProperties(block).bOpaque; }
+
+    constexpr bool IsRandomTicking(const Block block) { return GetBlockProperties(block).bRandomTicks; }
+    constexpr bool IsFalling(const Block block)       { return GetBlockProperties(block).bFalls;       }
+
+    // Flows on its own, see FluidEngine
+    constexpr bool IsFluid(const Block block) { return block == Block::Water || block == Block::Lava; }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "threadPool.hpp"
+#include "timingWheel.hpp"
+
+/*
+ * Block updates that happen over time. Scheduled ticks run a block a given number of ticks later,
+ * which is how falling blocks wait before they drop; they sit in timing wheels, so a tick costs
+ * what expires in it rather than what is scheduled. Random ticks sample a few blocks per section
+ * every tick, grass spreading to dirt for one, and skip the sections holding no block that has
+ * them, as told by the counts sections keep.
+ *
+ * The work is split in regions of chunks, each with its own wheel, run in parallel on the pool.
+ * Regions only read the world while they run; the changes they ask for are applied afterwards,
+ * region by region in a fixed order, so the outcome does not depend on the threads.
+ */
+
+namespace mc {
+
+    struct BlockTickStats {
+        u64 ticks     = 0;
+        u64 tickUS    = 0; // Summed over the ticks
+        u64 maxTickUS = 0;
+
+        u64 scheduled = 0; // Scheduled ticks run, not counting the ones whose block changed meanwhile
+        u64 random    = 0; // Random ticks that landed on a block having them
+        u64 changes   = 0; // Block changes applied
+
+        u64 sectionsSampled = 0; // Sections random ticks looked into
+        u64 sectionsLoaded  = 0; // All the sections of the loaded chunks, air included
+    }; // struct BlockTickStats
+
+    class BlockTickScheduler {
+    private:
+        static constexpr i32 REGION_SHIFT = 2; // Regions of 4 x 4 chunks
+
+        // Per section and tick: Minecraft's 3 at 20 ticks per second, at MC_INPUT_TICK_RATE
+        static constexpr u32 RANDOM_TICKS_PER_SECTION = 1;
+        static constexpr u32 FALL_DELAY_TICKS         = 6;
+
+        struct ScheduledTick {
+            vec3i32 position;
+            Block   block; // The tick is dropped if the block is no longer there
+        }; // struct ScheduledTick
+
+        struct BlockEdit {
+            vec3i32 position;
+            Block   from;
+            Block   to;
+        }; // struct BlockEdit
+
+        // Edits applied together or not at all: a falling block leaves its place and lands below
+        struct BlockChange {
+            std::array<BlockEdit, 2> edits;
+            u32                      editCount;
+        }; // struct BlockChange
+
+        struct Region {
+            ChunkCoord coord;
+
+            TimingWheel<ScheduledTick>                wheel;
+            std::unordered_set<vec3i32, BlockPosHash> pending; // Positions with a scheduled tick, which is never doubled
+            std::vector<Chunk*>                       chunks;  // Loaded, gathered again every tick
+            std::vector<BlockChange>                  changes;
+
+            u64 scheduled       = 0;
+            u64 random          = 0;
+            u64 sectionsSampled = 0;
+
+            Region(const ChunkCoord coord, const u64 now)
+                : coord(coord), wheel(now)
+            { }
+        }; // struct Region
+
+        u64 m_seed;
+        u64 m_tick = 0; // The tick the next Tick() runs
+
+        std::unordered_map<ChunkCoord, std::unique_ptr<Region>, ChunkCoordHash> m_regions;
+        std::vector<Region*>                                                     m_active;
+
+        BlockTickStats m_stats;
+
+    private:
+        static inline ChunkCoord RegionOf(const ChunkCoord chunk) { return ChunkCoord{ chunk.x >> REGION_SHIFT, chunk.z >> REGION_SHIFT }; }
+
+        static inline ChunkCoord RegionOf(const vec3i32& p) { return RegionOf(ChunkCoord{ WorldToChunk(p.x), WorldToChunk(p.z) }); }
+
+        Region& GetRegion(const ChunkCoord coord) {
+            std::unique_ptr<Region>& pRegion = m_regions[coord];
+
+            if (!pRegion)
+                pRegion = std::make_unique<Region>(coord, m_tick);
+
+            return *pRegion;
+        }
+
+        static inline u64 NextRandom(u64& state) {
+            state = noise::Hash(state);
+            return state;
+        }
+
+        // Grass dies under an opaque block, and otherwise spreads to a dirt block around it that has light
+        static void RunRandomTick(const World& world, const vec3i32& p, const Block block, u64& rng, std::vector<BlockChange>& changes) {
+            if (block != Block::Grass)
+                return;
+
+            if (IsOpaque(world.GetBlock(p + vec3i32{ 0, 1, 0 }))) {
+                changes.push_back(BlockChange{ { BlockEdit{ p, Block::Grass, Block::Dirt } }, 1 });
+                return;
+            }
+
+            const u64 r = NextRandom(rng);
+            const vec3i32 target = p + vec3i32{ static_cast<i32>(r % 3) - 1, static_cast<i32>((r >> 8) % 5) - 3, static_cast<i32>((r >> 16) % 3) - 1 };
+
+            if (world.GetBlock(target) == Block::Dirt && !IsOpaque(world.GetBlock(target + vec3i32{ 0, 1, 0 })))
+                changes.push_back(BlockChange{ { BlockEdit{ target, Block::Dirt, Block::Grass } }, 1 });
+        }
+
+        // A falling block swaps places with what is below it when that does not hold it
+        static void RunScheduledTick(const World& world, const vec3i32& p, const Block block, std::vector<BlockChange>& changes) {
+            if (!IsFalling(block) || p.y <= 0)
+                return;
+
+            const vec3i32 below = p - vec3i32{ 0, 1, 0 };
+            const Block   under = world.GetBlock(below);
+
+            if (!IsSolid(under))
+                changes.push_back(BlockChange{ { BlockEdit{ p, block, under }, BlockEdit{ below, under, block } }, 2 });
+        }
+
+        // Runs on a worker: reads the world, and only writes to the region
+        void RunRegion(Region& region, const World& world) {
+            region.wheel.Advance([&region, &world](ScheduledTick&& tick) {
+                region.pending.erase(tick.position);
+
+                if (world.GetBlock(tick.position) != tick.block)
+                    return;
+
+                ++region.scheduled;
+                RunScheduledTick(world, tick.position, tick.block, region.changes);
+            });
+
+            u64 rng = noise::Hash(m_seed ^ noise::Hash(m_tick) ^ ChunkCoordHash{}(region.coord));
+
+            for (const Chunk* pChunk : region.chunks) {
+                const u16 mask = pChunk->GetRandomTickMask();
+                if (mask == 0)
+                    continue;
+
+                const ChunkCoord coord = pChunk->GetCoord();
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y) {
+                    if (!(mask & (1u << y)))
+                        continue;
+
+                    const Block* const pBlocks = pChunk->GetSection(y)->GetData();
+                    ++region.sectionsSampled;
+
+                    for (u32 i = 0; i < RANDOM_TICKS_PER_SECTION; ++i) {
+                        const u32   index = static_cast<u32>(NextRandom(rng) % MC_CHUNK_SECTION_VOLUME);
+                        const Block block = pBlocks[index];
+
+                        if (!IsRandomTicking(block))
+                            continue;
+
+                        // ChunkSection::Index is x fastest, then z, then y
+                        const vec3i32 p{
+                            ChunkToWorld(coord.x) + static_cast<i32>(index % MC_CHUNK_SECTION_SIZE),
+                            static_cast<i32>(y * MC_CHUNK_SECTION_SIZE + index / (MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE)),
+                            ChunkToWorld(coord.z) + static_cast<i32>((index / MC_CHUNK_SECTION_SIZE) % MC_CHUNK_SECTION_SIZE)
+                        };
+
+                        ++region.random;
+                        RunRandomTick(world, p, block, rng, region.changes);
+                    }
+                }
+            }
+        }
+
+        // A change is dropped whole when one of its blocks was changed by an earlier one
+        void Apply(World& world, const BlockChange& change) {
+            for (u32 i = 0; i < change.editCount; ++i)
+                if (world.GetBlock(change.edits[i].position) != change.edits[i].from)
+                    return;
+
+            for (u32 i = 0; i < change.editCount; ++i) {
+                world.SetBlock(change.edits[i].position, change.edits[i].to);
+                NotifyNeighbours(world, change.edits[i].position);
+            }
+
+            ++m_stats.changes;
+        }
+
+    public:
+        explicit BlockTickScheduler(const u64 seed = 0)
+            : m_seed(seed)
+        { }
+
+        BlockTickScheduler(const BlockTickScheduler&) = delete;
+        BlockTickScheduler& operator=(const BlockTickScheduler&) = delete;
+
+        // Runs the block at the position in delay ticks, 0 being the next Tick(), if it is still there then
+        void Schedule(const vec3i32& p, const Block block, const u32 delay) {
+            Region& region = GetRegion(RegionOf(p));
+
+            if (region.pending.insert(p).second)
+                region.wheel.Schedule(m_tick + delay, ScheduledTick{ p, block });
+        }
+
+        // To call after a block changed: the blocks around it may react, falling ones for now
+        void NotifyNeighbours(const World& world, const vec3i32& p) {
+            constexpr std::array<vec3i32, 7> OFFSETS = {
+                vec3i32{ 0, 0, 0 },  vec3i32{ -1, 0, 0 }, vec3i32{ 1, 0, 0 }, vec3i32{ 0, -1, 0 },
+                vec3i32{ 0, 1, 0 },  vec3i32{ 0, 0, -1 }, vec3i32{ 0, 0, 1 },
+            };
+
+            for (const vec3i32& offset : OFFSETS) {
+                const vec3i32 neighbour = p + offset;
+                const Block   block     = world.GetBlock(neighbour);
+
+                if (IsFalling(block))
+                    Schedule(neighbour, block, FALL_DELAY_TICKS);
+            }
+        }
+
+        void Tick(World& world, ThreadPool& pool) {
+            const Timer timer;
+
+            for (auto& [coord, pRegion] : m_regions)
+                pRegion->chunks.clear();
+
+            world.ForEachChunk([this](Chunk& chunk) {
+                GetRegion(RegionOf(chunk.GetCoord())).chunks.push_back(&chunk);
+            });
+
+            // Regions go once they have neither chunks nor ticks left; the rest run in a fixed order
+            m_active.clear();
+
+            for (auto it = m_regions.begin(); it != m_regions.end();) {
+                if (it->second->chunks.empty() && it->second->wheel.IsEmpty()) {
+                    it = m_regions.erase(it);
+                    continue;
+                }
+
+                m_active.push_back(it->second.get());
+                ++it;
+            }
+
+            std::sort(m_active.begin(), m_active.end(), [](const Region* a, const Region* b) {
+                return a->coord.x != b->coord.x ? a->coord.x < b->coord.x : a->coord.z < b->coord.z;
+            });
+
+            const World& readOnly = world;
+
+            pool.ParallelFor(m_active.size(), 1, [this, &readOnly](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    RunRegion(*m_active[i], readOnly);
+            });
+
+            // From here on, ticks scheduled by the changes count from the next tick
+            ++m_tick;
+
+            for (Region* pRegion : m_active) {
+                for (const BlockChange& change : pRegion->changes)
+                    Apply(world, change);
+
+                m_stats.scheduled       += pRegion->scheduled;
+                m_stats.random          += pRegion->random;
+                m_stats.sectionsSampled += pRegion->sectionsSampled;
+                m_stats.sectionsLoaded  += pRegion->chunks.size() * MC_CHUNK_SECTION_COUNT;
+
+                pRegion->changes.clear();
+                pRegion->scheduled       = 0;
+                pRegion->random          = 0;
+                pRegion->sectionsSampled = 0;
+            }
+
+            const u64 elapsedUS = timer.GetElapsedUS();
+
+            ++m_stats.ticks;
+            m_stats.tickUS   += elapsedUS;
+            m_stats.maxTickUS = std::max(m_stats.maxTickUS, elapsedUS);
+        }
+
+        std::size_t GetScheduledCount() const {
+            std::size_t count = 0;
+
+            for (const auto& [coord, pRegion] : m_regions)
+                count += pRegion->wheel.GetSize();
+
+            return count;
+        }
+
+        inline std::size_t    GetRegionCount() const { return m_regions.size(); }
+        inline BlockTickStats GetStats()       const { return m_stats;          }
+        inline void           ResetStats()           { m_stats = BlockTickStats{}; }
+    }; // class BlockTickScheduler
+
+}; // namespace mc
\ No newline at end of file
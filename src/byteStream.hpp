@@ -0,0 +1,153 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Little endian serialization for network messages. Integers that are usually small are
+ * written as LEB128 varints, signed ones zigzag encoded first.
+ *
+ * The reader never throws on malformed input (it comes from the network): reads past the
+ * end return zero and clear IsValid(), which callers check once per message.
+ */
+
+namespace mc {
+
+    class ByteWriter {
+    private:
+        std::vector<u8>& m_out;
+
+    public:
+        explicit ByteWriter(std::vector<u8>& out) : m_out(out) { }
+
+        inline void WriteU8(const u8 v) { m_out.push_back(v); }
+
+        inline void WriteU16(const u16 v) {
+            m_out.push_back(static_cast<u8>(v));
+            m_out.push_back(static_cast<u8>(v >> 8));
+        }
+
+        inline void WriteU32(const u32 v) {
+            for (u32 i = 0; i < 4; ++i)
+                m_out.push_back(static_cast<u8>(v >> (8 * i)));
+        }
+
+        inline void WriteI32(const i32 v) { WriteU32(static_cast<u32>(v)); }
+
+        inline void WriteF32(const f32 v) {
+            u32 bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+
+            WriteU32(bits);
+        }
+
+        inline void WriteVarU32(u32 v) {
+            while (v >= 0x80) {
+                m_out.push_back(static_cast<u8>(v | 0x80));
+                v >>= 7;
+            }
+
+            m_out.push_back(static_cast<u8>(v));
+        }
+
+        inline void WriteVarI32(const i32 v) { WriteVarU32((static_cast<u32>(v) << 1) ^ static_cast<u32>(v >> 31)); }
+
+        inline void WriteBytes(const void* pData, const std::size_t size) {
+            const u8* pBytes = static_cast<const u8*>(pData);
+
+            m_out.insert(m_out.end(), pBytes, pBytes + size);
+        }
+
+        inline std::size_t GetSize() const { return m_out.size(); }
+    }; // class ByteWriter
+
+    class ByteReader {
+    private:
+        const u8*   m_pData;
+        std::size_t m_size;
+        std::size_t m_position = 0;
+        bool        m_bValid   = true;
+
+    private:
+        inline bool Require(const std::size_t count) {
+            if (m_bValid && m_size - m_position >= count)
+                return true;
+
+            m_bValid = false;
+            return false;
+        }
+
+    public:
+        ByteReader(const void* pData, const std::size_t size) : m_pData(static_cast<const u8*>(pData)), m_size(size) { }
+
+        inline u8 ReadU8() { return Require(1) ? m_pData[m_position++] : 0; }
+
+        inline u16 ReadU16() {
+            if (!Require(2))
+                return 0;
+
+            const u16 v = static_cast<u16>(m_pData[m_position] | (m_pData[m_position + 1] << 8));
+            m_position += 2;
+
+            return v;
+        }
+
+        inline u32 ReadU32() {
+            if (!Require(4))
+                return 0;
+
+            u32 v = 0;
+            for (u32 i = 0; i < 4; ++i)
+                v |= static_cast<u32>(m_pData[m_position + i]) << (8 * i);
+            m_position += 4;
+
+            return v;
+        }
+
+        inline i32 ReadI32() { return static_cast<i32>(ReadU32()); }
+
+        inline f32 ReadF32() {
+            const u32 bits = ReadU32();
+
+            f32 v;
+            std::memcpy(&v, &bits, sizeof(v));
+
+            return v;
+        }
+
+        inline u32 ReadVarU32() {
+            u32 v = 0;
+
+            for (u32 shift = 0; shift < 35; shift += 7) {
+                const u8 byte = ReadU8();
+                v |= static_cast<u32>(byte & 0x7F) << shift;
+
+                if (!(byte & 0x80))
+                    return v;
+            }
+
+            m_bValid = false;
+            return 0;
+        }
+
+        inline i32 ReadVarI32() {
+            const u32 v = ReadVarU32();
+
+            return static_cast<i32>((v >> 1) ^ (~(v & 1) + 1));
+        }
+
+        // Points into the source buffer, nullptr when fewer than size bytes are left
+        inline const u8* ReadBytes(const std::size_t size) {
+            if (!Require(size))
+                return nullptr;
+
+            const u8* p = m_pData + m_position;
+            m_position += size;
+
+            return p;
+        }
+
+        inline std::size_t GetRemaining() const { return m_bValid ? m_size - m_position : 0; }
+        inline bool        IsValid()      const { return m_bValid; }
+    }; // class ByteReader
+
+}; // namespace mc
\ No newline at end of file
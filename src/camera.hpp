@@ -0,0 +1,50 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+#include "geometry.hpp"
+
+namespace mc {
+
+    class Camera {
+    private:
+        vec3f32 m_position{ 0.f, 0.f, 0.f };
+
+        f32 m_yaw   = 0.f; // Radians, 0 looks towards -Z
+        f32 m_pitch = 0.f; // Radians, positive looks up
+
+        f32 m_fovY  = 1.22f;
+        f32 m_zNear = 0.1f;
+        f32 m_zFar  = 2048.f;
+
+    public:
+        inline const vec3f32& GetPosition() const { return m_position; }
+        inline f32            GetYaw()      const { return m_yaw;      }
+        inline f32            GetPitch()    const { return m_pitch;    }
+
+        inline void SetPosition(const vec3f32& position) { m_position = position; }
+
+        inline void SetRotation(const f32 yaw, const f32 pitch) {
+            m_yaw   = yaw;
+            m_pitch = std::clamp(pitch, -1.55f, 1.55f);
+        }
+
+        inline vec3f32 GetForward() const {
+            return vec3f32{ -std::sin(m_yaw) * std::cos(m_pitch), std::sin(m_pitch), -std::cos(m_yaw) * std::cos(m_pitch) };
+        }
+
+        inline mat4f32 GetView() const {
+            return LookAtMat4f32(m_position, m_position + GetForward(), vec3f32{ 0.f, 1.f, 0.f });
+        }
+
+        inline mat4f32 GetProjection(const f32 aspect) const {
+            return PerspectiveMat4f32(m_fovY, aspect, m_zNear, m_zFar);
+        }
+
+        inline Frustumf32 GetFrustum(const f32 aspect) const {
+            return Frustumf32::FromViewProjection(GetProjection(aspect) * GetView());
+        }
+    }; // class Camera
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "header.hpp"
+#include "block.hpp"
+#include "vector.hpp"
+#include "noise.hpp"
+#include "slabAllocator.hpp"
+
+/*
+ * Chunks are 16 x 256 x 16 columns split in 16^3 sections.
+ * A missing section is all air, which is most of the sky.
+ *
+ * Sections are shared between chunks once interned by content: the solid stone deep down is
+ * stored once. A chunk copies a shared section before its first edit (copy on write).
+ *
+ * Sections come from slabs rather than the heap, as chunks keep loading and unloading.
+ */
+
+namespace mc {
+
+    constexpr u32 MC_CHUNK_SECTION_SIZE   = 16u;
+    constexpr u32 MC_CHUNK_SECTION_COUNT  = 16u;
+    constexpr u32 MC_CHUNK_SECTION_VOLUME = MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE;
+    constexpr i32 MC_CHUNK_HEIGHT         = static_cast<i32>(MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_COUNT);
+
+    // Sections are further split in 4^3 bricks to let traversals skip uniform air quickly
+    constexpr u32 MC_BRICK_SIZE  = 4u;
+    constexpr u32 MC_BRICK_COUNT = (MC_CHUNK_SECTION_SIZE / MC_BRICK_SIZE) * (MC_CHUNK_SECTION_SIZE / MC_BRICK_SIZE) * (MC_CHUNK_SECTION_SIZE / MC_BRICK_SIZE);
+
+    struct ChunkCoord {
+        i32 x, z;
+
+        constexpr bool operator==(const ChunkCoord& other) const { return x == other.x && z == other.z; }
+        constexpr bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+    }; // struct ChunkCoord
+
+    struct ChunkCoordHash {
+        inline std::size_t operator()(const ChunkCoord& c) const noexcept {
+            return std::hash<u64>{}((static_cast<u64>(static_cast<u32>(c.x)) << 32) | static_cast<u32>(c.z));
+        }
+    }; // struct ChunkCoordHash
+
+    // Section coordinates are block coordinates divided by 16 on all three axes
+    struct SectionCoordHash {
+        inline std::size_t operator()(const vec3i32& c) const noexcept {
+            return std::hash<u64>{}((static_cast<u64>(static_cast<u32>(c.x)) << 40) ^ (static_cast<u64>(static_cast<u32>(c.z)) << 8) ^ static_cast<u64>(static_cast<u32>(c.y)));
+        }
+    }; // struct SectionCoordHash
+
+    struct BlockPosHash {
+        inline std::size_t operator()(const vec3i32& p) const noexcept {
+            return static_cast<std::size_t>(noise::Hash(0, p.x, p.y, p.z));
+        }
+    }; // struct BlockPosHash
+
+    constexpr i32 WorldToChunk(const i32 v)   { return v >> 4; } // Arithmetic shift: floors negative coordinates
+    constexpr u32 WorldToLocal(const i32 v)   { return static_cast<u32>(v & 15); }
+    constexpr i32 ChunkToWorld(const i32 c)   { return c * static_cast<i32>(MC_CHUNK_SECTION_SIZE); }
+
+    class ChunkSection {
+    private:
+        std::array<Block, MC_CHUNK_SECTION_VOLUME> m_blocks{};
+        std::array<u8, MC_BRICK_COUNT>             m_brickCounts{};
+
+        u64 m_brickMask       = 0; // Bit i is set when brick i holds at least one non air block
+        u16 m_nonAirCount     = 0;
+        u16 m_randomTickCount = 0; // Blocks with random ticks, sections without any are never sampled
+
+        // Sum of BlockHash over the blocks, kept up to date by Set: an edit costs two hashes, not a rescan
+        u64 m_hash = 0;
+
+    private:
+        // Air hashes to 0, so an empty section hashes to 0 too
+        static constexpr u64 BlockHash(const u32 index, const Block block) {
+            return block == Block::Air ? 0 : noise::Hash((static_cast<u64>(index) << 16) | static_cast<u64>(block));
+        }
+
+    public:
+        static constexpr u32 Index(const u32 x, const u32 y, const u32 z)      { return (y * MC_CHUNK_SECTION_SIZE + z) * MC_CHUNK_SECTION_SIZE + x; }
+        static constexpr u32 BrickIndex(const u32 x, const u32 y, const u32 z) { return ((y >> 2) * 4 + (z >> 2)) * 4 + (x >> 2); }
+
+        inline Block Get(const u32 x, const u32 y, const u32 z) const { return m_blocks[Index(x, y, z)]; }
+
+        void Set(const u32 x, const u32 y, const u32 z, const Block block) {
+            Block& current = m_blocks[Index(x, y, z)];
+
+            if (current == block)
+                return;
+
+            const u32 brick = BrickIndex(x, y, z);
+
+            if (current == Block::Air) {
+                ++m_nonAirCount;
+                if (m_brickCounts[brick]++ == 0)
+                    m_brickMask |= u64{ 1 } << brick;
+            } else if (block == Block::Air) {
+                --m_nonAirCount;
+                if (--m_brickCounts[brick] == 0)
+                    m_brickMask &= ~(u64{ 1 } << brick);
+            }
+
+            if (IsRandomTicking(current)) --m_randomTickCount;
+            if (IsRandomTicking(block))   ++m_randomTickCount;
+
+            m_hash += BlockHash(Index(x, y, z), block) - BlockHash(Index(x, y, z), current);
+            current = block;
+        }
+
+        void Fill(const Block block) {
+            m_blocks.fill(block);
+
+            const bool bAir = block == Block::Air;
+            m_brickCounts.fill(bAir ? 0 : MC_BRICK_SIZE * MC_BRICK_SIZE * MC_BRICK_SIZE);
+            m_brickMask   = bAir ? 0 : ~u64{ 0 };
+            m_nonAirCount = bAir ? 0 : MC_CHUNK_SECTION_VOLUME;
+
+            m_randomTickCount = IsRandomTicking(block) ? MC_CHUNK_SECTION_VOLUME : 0;
+
+            m_hash = 0;
+            for (u32 i = 0; i < MC_CHUNK_SECTION_VOLUME; ++i)
+                m_hash += BlockHash(i, block);
+        }
+
+        inline bool IsEmpty()                                          const { return m_nonAirCount == 0; }
+        inline bool IsBrickEmpty(const u32 x, const u32 y, const u32 z) const { return !(m_brickMask & (u64{ 1 } << BrickIndex(x, y, z))); }
+
+        inline bool HasSameBlocks(const ChunkSection& other) const { return m_hash == other.m_hash && m_blocks == other.m_blocks; }
+
+        inline u64          GetHash()            const { return m_hash;            }
+        inline u16          GetNonAirCount()     const { return m_nonAirCount;     }
+        inline u16          GetRandomTickCount() const { return m_randomTickCount; }
+        inline u64          GetBrickMask()       const { return m_brickMask;       }
+        inline const Block* GetData()            const { return m_blocks.data();   }
+    }; // class ChunkSection
+
+    // Hands out one shared instance per distinct section content. Chunks can be interned from
+    // several threads at once, as long as no chunk is edited meanwhile
+    class SectionPool {
+    private:
+        std::mutex m_mutex;
+
+        // Weak, so a section no chunk uses anymore is freed; its entry goes at the next purge
+        std::unordered_multimap<u64, std::weak_ptr<ChunkSection>> m_sections;
+        std::size_t m_purgeThreshold = 1024;
+
+    private:
+        void PurgeExpired() {
+            for (auto it = m_sections.begin(); it != m_sections.end();)
+                it = it->second.expired() ? m_sections.erase(it) : std::next(it);
+
+            m_purgeThreshold = std::max<std::size_t>(1024, m_sections.size() * 2);
+        }
+
+    public:
+        std::shared_ptr<ChunkSection> Intern(std::shared_ptr<ChunkSection> pSection) {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Hashes can collide, so only an identical section is shared
+            const auto range = m_sections.equal_range(pSection->GetHash());
+            for (auto it = range.first; it != range.second; ++it)
+                if (std::shared_ptr<ChunkSection> pShared = it->second.lock(); pShared && pShared->HasSameBlocks(*pSection))
+                    return pShared;
+
+            if (m_sections.size() >= m_purgeThreshold)
+                PurgeExpired();
+
+            m_sections.emplace(pSection->GetHash(), pSection);
+
+            return pSection;
+        }
+    }; // class SectionPool
+
+    class Chunk {
+    private:
+        ChunkCoord m_coord;
+
+        std::array<std::shared_ptr<ChunkSection>, MC_CHUNK_SECTION_COUNT> m_sections;
+
+    public:
+        explicit Chunk(const ChunkCoord coord)
+            : m_coord(coord)
+        { }
+
+        inline ChunkCoord GetCoord() const { return m_coord; }
+
+        inline const ChunkSection* GetSection(const u32 sectionY) const { return m_sections[sectionY].get(); }
+
+        // The owning pointer, for World::Publish to share: a published section is then copied before an edit like any shared one
+        inline const std::shared_ptr<ChunkSection>& GetSectionPtr(const u32 sectionY) const { return m_sections[sectionY]; }
+
+        // Copies the section first when another chunk shares it
+        ChunkSection& GetOrCreateSection(const u32 sectionY) {
+            std::shared_ptr<ChunkSection>& pSection = m_sections[sectionY];
+
+            if (!pSection)
+                pSection = std::allocate_shared<ChunkSection>(SlabAllocator<ChunkSection>{});
+            else if (pSection.use_count() > 1)
+                pSection = std::allocate_shared<ChunkSection>(SlabAllocator<ChunkSection>{}, *pSection);
+
+            return *pSection;
+        }
+
+        // Bit y is set when section y holds blocks with random ticks
+        u16 GetRandomTickMask() const {
+            u16 mask = 0;
+
+            for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+                if (m_sections[y] && m_sections[y]->GetRandomTickCount() > 0)
+                    mask |= static_cast<u16>(1u << y);
+
+            return mask;
+        }
+
+        // Swaps each section for the pool's instance of the same content, and drops the all air ones
+        void Intern(SectionPool& pool) {
+            for (std::shared_ptr<ChunkSection>& pSection : m_sections) {
+                if (!pSection)
+                    continue;
+
+                if (pSection->IsEmpty())
+                    pSection.reset();
+                else
+                    pSection = pool.Intern(std::move(pSection));
+            }
+        }
+
+        Block GetBlock(const u32 x, const i32 y, const u32 z) const {
+            if (y < 0 || y >= MC_CHUNK_HEIGHT)
+                return Block::Air;
+
+            const ChunkSection* pSection = m_sections[y >> 4].get();
+
+            return pSection ? pSection->Get(x, WorldToLocal(y), z) : Block::Air;
+        }
+
+        void SetBlock(const u32 x, const i32 y, const u32 z, const Block block) {
+            if (y < 0 || y >= MC_CHUNK_HEIGHT)
+                return;
+
+            if (block == Block::Air && !m_sections[y >> 4])
+                return;
+
+            GetOrCreateSection(y >> 4).Set(x, WorldToLocal(y), z, block);
+        }
+    }; // class Chunk
+
+}; // namespace mc
\ No newline at end of file
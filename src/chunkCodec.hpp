@@ -0,0 +1,126 @@
+#pragma once
+
+#include "header.hpp"
+#include "chunk.hpp"
+#include "byteStream.hpp"
+
+/*
+ * Wire format of a chunk: a u16 mask of its non empty sections, then each of them as
+ *   varint palette size | palette (varint block ids, in order of first appearance) |
+ *   runs of (varint length, varint palette index) in ChunkSection::Index order,
+ * the runs being left out when the palette holds a single block.
+ *
+ * Sections are mostly long horizontal layers of one block, which run length encoding over
+ * palette indices shrinks well below the 8KB of raw block ids.
+ */
+
+namespace mc {
+
+    inline void EncodeSection(const ChunkSection& section, ByteWriter& writer) {
+        const Block* pBlocks = section.GetData();
+
+        std::array<i16, static_cast<std::size_t>(Block::Count)> paletteIndices;
+        paletteIndices.fill(-1);
+
+        std::vector<Block> palette;
+        for (u32 i = 0; i < MC_CHUNK_SECTION_VOLUME; ++i) {
+            i16& index = paletteIndices[static_cast<std::size_t>(pBlocks[i])];
+
+            if (index < 0) {
+                index = static_cast<i16>(palette.size());
+                palette.push_back(pBlocks[i]);
+            }
+        }
+
+        writer.WriteVarU32(static_cast<u32>(palette.size()));
+        for (const Block block : palette)
+            writer.WriteVarU32(static_cast<u32>(block));
+
+        if (palette.size() == 1)
+            return;
+
+        for (u32 i = 0; i < MC_CHUNK_SECTION_VOLUME;) {
+            u32 run = 1;
+            while (i + run < MC_CHUNK_SECTION_VOLUME && pBlocks[i + run] == pBlocks[i])
+                ++run;
+
+            writer.WriteVarU32(run);
+            writer.WriteVarU32(static_cast<u32>(paletteIndices[static_cast<std::size_t>(pBlocks[i])]));
+
+            i += run;
+        }
+    }
+
+    // Returns false on malformed input, out is then left partially written
+    inline bool DecodeSection(ByteReader& reader, std::array<Block, MC_CHUNK_SECTION_VOLUME>& out) {
+        const u32 paletteSize = reader.ReadVarU32();
+
+        if (paletteSize == 0 || paletteSize > static_cast<u32>(Block::Count))
+            return false;
+
+        std::array<Block, static_cast<std::size_t>(Block::Count)> palette;
+        for (u32 i = 0; i < paletteSize; ++i) {
+            const u32 id = reader.ReadVarU32();
+
+            if (id >= static_cast<u32>(Block::Count))
+                return false;
+
+            palette[i] = static_cast<Block>(id);
+        }
+
+        if (paletteSize == 1) {
+            out.fill(palette[0]);
+            return reader.IsValid();
+        }
+
+        for (u32 i = 0; i < MC_CHUNK_SECTION_VOLUME;) {
+            const u32 run   = reader.ReadVarU32();
+            const u32 index = reader.ReadVarU32();
+
+            if (!reader.IsValid() || run == 0 || run > MC_CHUNK_SECTION_VOLUME - i || index >= paletteSize)
+                return false;
+
+            std::fill_n(out.begin() + i, run, palette[index]);
+            i += run;
+        }
+
+        return true;
+    }
+
+    inline void EncodeChunk(const Chunk& chunk, ByteWriter& writer) {
+        u16 mask = 0;
+        for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+            if (chunk.GetSection(y) && !chunk.GetSection(y)->IsEmpty())
+                mask |= static_cast<u16>(1u << y);
+
+        writer.WriteU16(mask);
+
+        for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+            if (mask & (1u << y))
+                EncodeSection(*chunk.GetSection(y), writer);
+    }
+
+    // Decodes into an empty chunk
+    inline bool DecodeChunk(ByteReader& reader, Chunk& chunk) {
+        const u16 mask = reader.ReadU16();
+
+        std::array<Block, MC_CHUNK_SECTION_VOLUME> blocks;
+
+        for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y) {
+            if (!(mask & (1u << y)))
+                continue;
+
+            if (!DecodeSection(reader, blocks))
+                return false;
+
+            ChunkSection& section = chunk.GetOrCreateSection(y);
+
+            for (u32 i = 0; i < MC_CHUNK_SECTION_VOLUME; ++i)
+                if (blocks[i] != Block::Air)
+                    section.Set(i % MC_CHUNK_SECTION_SIZE, i / (MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE), (i / MC_CHUNK_SECTION_SIZE) % MC_CHUNK_SECTION_SIZE, blocks[i]);
+        }
+
+        return reader.IsValid();
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,699 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "camera.hpp"
+#include "renderer.hpp"
+#include "gpuMemory.hpp"
+#include "meshArena.hpp"
+#include "threadPool.hpp"
+#include "timer.hpp"
+#include "chunkMesher.hpp"
+#include "slabAllocator.hpp"
+
+/*
+ * Keeps one GPU mesh per non empty chunk section in view range, at the LOD picked by
+ * the distance ring the section's chunk falls in. LOD changes are gathered and meshed on
+ * the thread pool, off what the World last published, so the main thread never copies
+ * blocks; the previous mesh stays on screen until its replacement has been uploaded. Each
+ * mesh is a range of one of the MeshArena's few large vertex buffers.
+ *
+ * Block edits are different: the World reports the sections they dirtied, and those are
+ * remeshed before the next frame. Staged ranges keep some slack so the new mesh can
+ * usually be written in place, and only the byte blocks that differ are uploaded. Mapped ones
+ * are never written in place, the frames in flight may still be drawing from them: each edit
+ * writes a new range of the arena and retires the old one, which allocates no device memory.
+ *
+ * Meshes are also cached by the section's content hash and a hash of the border blocks copied from
+ * its neighbours: identical sections, like the solid ones deep underground, are only meshed once.
+ *
+ * When a memory heap nears its budget, the meshes left undrawn the longest, farthest first, give
+ * their ranges back. They keep their place; once one is in view again it is uploaded from the
+ * mesh cache, or remeshed when the cache dropped it.
+ */
+
+namespace mc {
+
+    struct LodSettings {
+        // Chebyshev distance (in chunks) at which each LOD ring ends; nothing is drawn past the last one
+        std::array<i32, MC_LOD_COUNT> ringEnds = { 6, 12, 18, 24 };
+
+        u32 maxJobsPerUpdate    = 64; // Sections queued per frame, so a far jump does not flood the pool
+        u32 maxUploadsPerUpdate = 32;
+        u32 maxEditsPerUpdate   = 16; // Dirty sections remeshed per frame, the rest wait for the next one
+
+        // Mapped ranges keep no CPU copy; staged ones do, and upload only what an edit changed
+        VertexBufferMode bufferMode = VertexBufferMode::eMapped;
+
+        std::size_t meshBlockBytes = 64u << 20u; // The vertex buffers the meshes are sub-allocated from (see MeshArena)
+
+        std::size_t meshCacheBytes = 32u << 20u; // Least recently used cached meshes are dropped past this
+
+        // Caps the budget of the device local heaps below the driver's (or estimated) one, 0 leaves it alone
+        vk::DeviceSize vramBudgetBytes = 0;
+
+        // Meshes are evicted once a heap's usage passes the high fraction of its budget, until it is back under the low one
+        f32 evictionHighWatermark = 0.9f;
+        f32 evictionLowWatermark  = 0.8f;
+    }; // struct LodSettings
+
+    struct MeshCacheStats {
+        u64         hits   = 0;
+        u64         misses = 0;
+        std::size_t bytes  = 0;
+    }; // struct MeshCacheStats
+
+    struct MeshMemoryStats {
+        u64 evictions = 0;
+        u64 reuploads = 0; // Evicted meshes brought back from the mesh cache
+        u64 remeshes  = 0; // Evicted meshes meshed again, the cache having dropped them
+
+        vk::DeviceSize residentBytes = 0; // In the meshes' ranges
+        std::size_t    evictedMeshes = 0; // Currently without a range
+
+        std::size_t    blocks     = 0; // MeshArena blocks, one device memory allocation each
+        vk::DeviceSize blockBytes = 0;
+    }; // struct MeshMemoryStats
+
+    class ChunkMeshManager {
+    private:
+        struct SectionMesh {
+            MeshRange range; // Its capacity, the vertices written may be fewer
+            u32 vertexCount = 0;
+            u32 lod         = 0;
+            u8  skirtMask   = 0;
+
+            u64  lastDrawn = 0; // The Update count when it was last in view
+            bool bEvicted  = false;
+        }; // struct SectionMesh
+
+        struct MeshKey {
+            u64 sectionHash;
+            u64 borderHash;
+            u32 lod;
+            u8  skirtMask;
+
+            inline bool operator==(const MeshKey& other) const {
+                return sectionHash == other.sectionHash && borderHash == other.borderHash && lod == other.lod && skirtMask == other.skirtMask;
+            }
+        }; // struct MeshKey
+
+        struct MeshKeyHash {
+            inline std::size_t operator()(const MeshKey& k) const noexcept {
+                return static_cast<std::size_t>(noise::Hash(k.sectionHash ^ (k.borderHash * 31) ^ (static_cast<u64>(k.lod) << 8 | k.skirtMask)));
+            }
+        }; // struct MeshKeyHash
+
+        // A gather job's result: the section with its border, and the key of the mesh they make
+        struct GatheredMesh {
+            SlabPtr<MeshingInput> pInput;
+            MeshKey               key;
+        }; // struct GatheredMesh
+
+        // Gathering first, then once the key is known meshing, or waiting on the cached mesh
+        struct PendingMesh {
+            u32  lod;
+            u8   skirtMask;
+            bool bRestore; // An evicted mesh brought back, counted once it is known whether the cache had it
+
+            std::future<GatheredMesh>               gathered; // Valid until the gather job is collected
+            MeshKey                                 key{};
+            std::shared_future<std::vector<Vertex>> vertices;
+        }; // struct PendingMesh
+
+        // Shared futures, so a section identical to one still being meshed waits on the same job
+        struct CachedMesh {
+            std::shared_future<std::vector<Vertex>> vertices;
+            std::size_t bytes    = 0; // Known once the mesh is collected
+            u64         lastUsed = 0;
+        }; // struct CachedMesh
+
+        struct DesiredMesh {
+            u32 lod;
+            u8  skirtMask;
+        }; // struct DesiredMesh
+
+        LodSettings m_settings;
+        MeshArena   m_arena;
+
+        std::unordered_map<vec3i32, SectionMesh, SectionCoordHash> m_meshes;
+        std::unordered_map<vec3i32, PendingMesh, SectionCoordHash> m_pending;
+
+        // The desired set is only rebuilt when one of these changes, or while jobs are left over
+        std::optional<ChunkCoord> m_lastCameraChunk;
+        std::size_t               m_lastChunkCount = 0;
+        bool                      m_bBacklog       = false;
+
+        u64 m_lastEditUS = 0;
+
+        std::unordered_map<MeshKey, CachedMesh, MeshKeyHash> m_meshCache;
+        MeshCacheStats m_cacheStats;
+        u64            m_updateCount = 0;
+
+        MeshMemoryStats      m_memoryStats;
+        std::vector<vec3i32> m_evictedInView; // Found by the last Draw, brought back by the next Update
+
+    private:
+        std::optional<u32> LodForChunk(const ChunkCoord chunk, const ChunkCoord cameraChunk) const {
+            const i32 distance = std::max(std::abs(chunk.x - cameraChunk.x), std::abs(chunk.z - cameraChunk.z));
+
+            for (u32 lod = 0; lod < MC_LOD_COUNT; ++lod)
+                if (distance < m_settings.ringEnds[lod])
+                    return lod;
+
+            return {};
+        }
+
+        // Horizontal neighbours drawn at another LOD need skirts on the shared side
+        u8 SkirtMaskForChunk(const ChunkCoord chunk, const ChunkCoord cameraChunk, const u32 lod) const {
+            constexpr std::array<std::pair<BlockFace, ChunkCoord>, 4> SIDES = {
+                std::pair{ BlockFace::NegX, ChunkCoord{ -1, 0 } }, std::pair{ BlockFace::PosX, ChunkCoord{ 1, 0 } },
+                std::pair{ BlockFace::NegZ, ChunkCoord{ 0, -1 } }, std::pair{ BlockFace::PosZ, ChunkCoord{ 0, 1 } },
+            };
+
+            u8 mask = 0;
+            for (const auto& [face, offset] : SIDES)
+                if (LodForChunk(ChunkCoord{ chunk.x + offset.x, chunk.z + offset.z }, cameraChunk) != std::optional<u32>(lod))
+                    mask |= static_cast<u8>(1u << static_cast<u32>(face));
+
+            return mask;
+        }
+
+        // From any thread, inside the EpochGuard the input was gathered in
+        static MeshKey KeyFor(const World& world, const MeshingInput& input, const u32 lod, const u8 skirtMask) {
+            const ChunkSection* pSection = world.ReadSection(input.sectionCoord);
+
+            return MeshKey{ pSection ? pSection->GetHash() : 0, HashMeshingBorder(input), lod, skirtMask };
+        }
+
+        void CacheMesh(const MeshKey& key, std::shared_future<std::vector<Vertex>> vertices, const std::size_t bytes) {
+            CachedMesh& cached = m_meshCache[key];
+
+            m_cacheStats.bytes -= cached.bytes;
+            m_cacheStats.bytes += bytes;
+
+            cached.vertices = std::move(vertices);
+            cached.bytes    = bytes;
+            cached.lastUsed = m_updateCount;
+        }
+
+        // Records the size of a mesh that finished meshing, if it is still cached
+        void AccountCachedMesh(const MeshKey& key, const std::size_t bytes) {
+            const auto it = m_meshCache.find(key);
+
+            if (it != m_meshCache.end() && it->second.bytes == 0) {
+                it->second.bytes    = bytes;
+                m_cacheStats.bytes += bytes;
+            }
+        }
+
+        // Drops the least recently used meshes down to three quarters of the budget
+        void TrimMeshCache() {
+            if (m_cacheStats.bytes <= m_settings.meshCacheBytes)
+                return;
+
+            std::vector<std::pair<u64, MeshKey>> byAge;
+            byAge.reserve(m_meshCache.size());
+
+            for (const auto& [key, cached] : m_meshCache)
+                byAge.emplace_back(cached.lastUsed, key);
+
+            std::sort(byAge.begin(), byAge.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            for (const auto& [lastUsed, key] : byAge) {
+                if (m_cacheStats.bytes <= m_settings.meshCacheBytes / 4 * 3)
+                    break;
+
+                const auto it = m_meshCache.find(key);
+                m_cacheStats.bytes -= it->second.bytes;
+                m_meshCache.erase(it);
+            }
+        }
+
+        void RetireMesh(const vec3i32& coord) {
+            const auto it = m_meshes.find(coord);
+
+            if (it != m_meshes.end()) {
+                m_arena.Retire(it->second.range);
+                m_meshes.erase(it);
+            }
+        }
+
+        // Writes the vertices into the mesh's range, replacing it when they no longer fit or when it is mapped. The upload is
+        // queued with the rest of the arena's by Update
+        void WriteMesh(SectionMesh& mesh, const std::vector<Vertex>& vertices) {
+            constexpr std::size_t BLOCK_SIZE = 256;
+
+            const u32         count = static_cast<u32>(vertices.size());
+            const std::size_t size  = vertices.size() * sizeof(Vertex);
+            mesh.vertexCount = count;
+            mesh.bEvicted    = false;
+
+            if (count == 0)
+                return;
+
+            const bool bMapped = mesh.range.count > 0 && m_arena.GetBuffer(mesh.range).GetMode() == VertexBufferMode::eMapped;
+
+            if (count > mesh.range.count || bMapped) {
+                // A quarter of slack absorbs most later edits of a staged range without moving it. The host writes to a
+                // mapped one would race the frames in flight drawing from it, so it moves to a new range of its exact size
+                const u32 capacity = m_settings.bufferMode == VertexBufferMode::eMapped ? count
+                                   : count > mesh.range.count ? count + count / 4 : mesh.range.count;
+
+                m_arena.Retire(mesh.range);
+                mesh.range = m_arena.Allocate(capacity);
+
+                m_arena.GetBuffer(mesh.range).Write(MeshArena::GetByteOffset(mesh.range), vertices.data(), size);
+            } else {
+                // The CPU copy mirrors what the GPU holds, so unchanged blocks need no upload
+                mc::VertexBuffer& buffer = m_arena.GetBuffer(mesh.range);
+                const std::size_t base   = MeshArena::GetByteOffset(mesh.range);
+
+                const u8* const pOld = static_cast<const u8*>(buffer.GetData()) + base;
+                const u8* const pNew = reinterpret_cast<const u8*>(vertices.data());
+
+                for (std::size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+                    const std::size_t bytes = std::min(BLOCK_SIZE, size - offset);
+
+                    if (std::memcmp(pOld + offset, pNew + offset, bytes) != 0)
+                        buffer.Write(base + offset, pNew + offset, bytes);
+                }
+            }
+        }
+
+        // Remeshes the sections dirtied by block edits, in parallel, and waits for them
+        void RemeshDirtySections(World& world, const ChunkCoord cameraChunk, ThreadPool& pool) {
+            if (world.GetDirtySections().empty()) {
+                m_lastEditUS = 0;
+                return;
+            }
+
+            const mc::Timer timer;
+
+            struct EditJob {
+                vec3i32             coord;
+                DesiredMesh         target;
+                std::vector<Vertex> vertices;
+                MeshKey             key;
+                bool                bCached;
+            }; // struct EditJob
+
+            std::vector<EditJob> jobs;
+            std::vector<vec3i32> handled;
+
+            for (const vec3i32& coord : world.GetDirtySections()) {
+                if (jobs.size() >= m_settings.maxEditsPerUpdate)
+                    break;
+
+                handled.push_back(coord);
+
+                // Whatever was in flight for this section was gathered before the edit
+                m_pending.erase(coord);
+
+                const std::optional<u32> lod      = LodForChunk(ChunkCoord{ coord.x, coord.z }, cameraChunk);
+                const ChunkSection*      pSection = world.GetSection(coord);
+
+                if (!lod.has_value() || !pSection || pSection->IsEmpty())
+                    RetireMesh(coord);
+                else
+                    jobs.push_back(EditJob{ coord, DesiredMesh{ lod.value(), SkirtMaskForChunk(ChunkCoord{ coord.x, coord.z }, cameraChunk, lod.value()) }, {}, {}, false });
+            }
+
+            for (const vec3i32& coord : handled)
+                world.ClearDirtySection(coord);
+
+            // The edits were published before the meshes update, and nothing writes to the cache until ParallelFor
+            // returns, so the jobs gather and look up for themselves
+            pool.ParallelFor(jobs.size(), 1, [&](const std::size_t begin, const std::size_t end) {
+                MeshingInput input;
+
+                for (std::size_t i = begin; i < end; ++i) {
+                    EditJob& job = jobs[i];
+
+                    {
+                        const EpochGuard guard;
+
+                        GatherPublishedMeshingInput(world, job.coord, input);
+                        job.key = KeyFor(world, input, job.target.lod, job.target.skirtMask);
+                    }
+
+                    const auto it = m_meshCache.find(job.key);
+                    job.bCached = it != m_meshCache.end() && it->second.vertices.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+                    if (job.bCached)
+                        job.vertices = it->second.vertices.get();
+                    else
+                        MeshSection(input, job.target.lod, job.target.skirtMask, job.vertices);
+                }
+            });
+
+            for (EditJob& job : jobs) {
+                if (job.bCached) {
+                    m_meshCache[job.key].lastUsed = m_updateCount;
+                    ++m_cacheStats.hits;
+                } else {
+                    std::promise<std::vector<Vertex>> ready;
+                    ready.set_value(job.vertices);
+
+                    CacheMesh(job.key, ready.get_future().share(), job.vertices.size() * sizeof(Vertex));
+                    ++m_cacheStats.misses;
+                }
+
+                SectionMesh& mesh = m_meshes[job.coord];
+                mesh.lod       = job.target.lod;
+                mesh.skirtMask = job.target.skirtMask;
+
+                WriteMesh(mesh, job.vertices);
+            }
+
+            m_lastEditUS = timer.GetElapsedUS();
+        }
+
+        // Gathers a section on the pool, off what the world last published; the mesh follows once the gather is collected
+        void QueueMesh(const World& world, const vec3i32& coord, const DesiredMesh& target, ThreadPool& pool, const bool bRestore = false) {
+            const u32 lod       = target.lod;
+            const u8  skirtMask = target.skirtMask;
+
+            std::future<GatheredMesh> gathered = pool.Submit([&world, coord, lod, skirtMask] {
+                // Scratch that lives until the mesh job ran, from a slab as one is made for every section meshed
+                GatheredMesh result{ MakeSlab<MeshingInput>(), {} };
+
+                const EpochGuard guard;
+
+                GatherPublishedMeshingInput(world, coord, *result.pInput);
+                result.key = KeyFor(world, *result.pInput, lod, skirtMask);
+
+                return result;
+            });
+
+            // A stale in flight job is simply dropped: its future is abandoned, not waited on
+            m_pending.erase(coord);
+            m_pending.emplace(coord, PendingMesh{ lod, skirtMask, bRestore, std::move(gathered), {}, {} });
+        }
+
+        // Meshes the gathered sections on the pool, or takes their mesh from the cache; either way they are then collected like a job
+        void CollectGatheredJobs(ThreadPool& pool) {
+            for (auto& [coord, pending] : m_pending) {
+                if (!pending.gathered.valid() || pending.gathered.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    continue;
+
+                GatheredMesh gathered = pending.gathered.get();
+                pending.key = gathered.key;
+
+                const auto it      = m_meshCache.find(gathered.key);
+                const bool bCached = it != m_meshCache.end();
+
+                if (bCached) {
+                    it->second.lastUsed = m_updateCount;
+                    pending.vertices    = it->second.vertices;
+                    ++m_cacheStats.hits;
+                } else {
+                    const u32 lod       = pending.lod;
+                    const u8  skirtMask = pending.skirtMask;
+
+                    pending.vertices = pool.Submit([pInput = std::move(gathered.pInput), lod, skirtMask] {
+                        std::vector<Vertex> out;
+                        MeshSection(*pInput, lod, skirtMask, out);
+
+                        return out;
+                    }).share();
+
+                    CacheMesh(gathered.key, pending.vertices, 0);
+                    ++m_cacheStats.misses;
+                }
+
+                if (pending.bRestore && bCached)
+                    ++m_memoryStats.reuploads;
+                else if (pending.bRestore)
+                    ++m_memoryStats.remeshes;
+            }
+        }
+
+        // Evicted meshes the last Draw wanted, unless a job already brings them back
+        void RestoreEvictedMeshes(const World& world, ThreadPool& pool) {
+            for (const vec3i32& coord : m_evictedInView) {
+                const auto it = m_meshes.find(coord);
+
+                if (it == m_meshes.end() || !it->second.bEvicted || m_pending.count(coord) || !world.GetSection(coord))
+                    continue;
+
+                QueueMesh(world, coord, DesiredMesh{ it->second.lod, it->second.skirtMask }, pool, true);
+            }
+
+            m_evictedInView.clear();
+        }
+
+        // Frees the ranges of the meshes out of view the longest, farthest first, from the heaps over their budget
+        void EvictOverBudget(const ChunkCoord cameraChunk) {
+            const std::vector<GpuHeapBudget> heaps = mc::GpuMemory::QueryHeapBudgets();
+
+            std::array<i64, VK_MAX_MEMORY_HEAPS> excess{};
+            bool bOver = false;
+
+            for (std::size_t heap = 0; heap < heaps.size(); ++heap) {
+                // Retired buffers are freed once the frames in flight are done with them, they are as good as gone. So is
+                // the room left in the arena's blocks, which new meshes take before any new block is made
+                const vk::DeviceSize gone   = mc::Renderer::GetRetiringBytes(static_cast<u32>(heap)) + m_arena.GetHeapUsage(static_cast<u32>(heap)).second;
+                const vk::DeviceSize usage  = heaps[heap].usage - std::min(heaps[heap].usage, gone);
+                vk::DeviceSize       budget = heaps[heap].budget;
+
+                if (heaps[heap].bDeviceLocal && m_settings.vramBudgetBytes > 0)
+                    budget = std::min(budget, m_settings.vramBudgetBytes);
+
+                if (static_cast<f64>(usage) > static_cast<f64>(budget) * m_settings.evictionHighWatermark) {
+                    excess[heap] = static_cast<i64>(usage) - static_cast<i64>(static_cast<f64>(budget) * m_settings.evictionLowWatermark);
+                    bOver = true;
+                }
+            }
+
+            if (!bOver)
+                return;
+
+            struct Candidate {
+                u64          lastDrawn;
+                i64          distanceSq;
+                SectionMesh* pMesh;
+            }; // struct Candidate
+
+            // Whatever was in view last frame stays, even when that leaves the heap over budget
+            std::vector<Candidate> candidates;
+
+            for (auto& [coord, mesh] : m_meshes) {
+                if (mesh.bEvicted || mesh.range.count == 0 || excess[m_arena.GetHeapIndex(mesh.range)] <= 0 || mesh.lastDrawn + 1 >= m_updateCount)
+                    continue;
+
+                const i64 dx = coord.x - cameraChunk.x, dz = coord.z - cameraChunk.z;
+                candidates.push_back(Candidate{ mesh.lastDrawn, dx * dx + dz * dz, &mesh });
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return a.lastDrawn != b.lastDrawn ? a.lastDrawn < b.lastDrawn : a.distanceSq > b.distanceSq;
+            });
+
+            for (const Candidate& candidate : candidates) {
+                SectionMesh& mesh = *candidate.pMesh;
+                i64& heapExcess   = excess[m_arena.GetHeapIndex(mesh.range)];
+
+                if (heapExcess <= 0)
+                    continue;
+
+                heapExcess -= static_cast<i64>(MeshArena::GetByteSize(mesh.range));
+
+                m_arena.Retire(std::exchange(mesh.range, MeshRange{}));
+                mesh.bEvicted = true;
+                ++m_memoryStats.evictions;
+            }
+        }
+
+        void CollectFinishedJobs() {
+            u32 uploads = 0;
+
+            for (auto it = m_pending.begin(); it != m_pending.end() && uploads < m_settings.maxUploadsPerUpdate;) {
+                if (!it->second.vertices.valid() || it->second.vertices.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    ++it;
+                    continue;
+                }
+
+                const std::vector<Vertex>& vertices = it->second.vertices.get();
+                AccountCachedMesh(it->second.key, vertices.size() * sizeof(Vertex));
+
+                SectionMesh& mesh = m_meshes[it->first];
+                mesh.lod       = it->second.lod;
+                mesh.skirtMask = it->second.skirtMask;
+
+                WriteMesh(mesh, vertices);
+                uploads += vertices.empty() ? 0 : 1;
+
+                it = m_pending.erase(it);
+            }
+        }
+
+    public:
+        inline LodSettings& GetSettings() { return m_settings; }
+
+        inline std::size_t GetMeshCount()    const { return m_meshes.size();  }
+        inline std::size_t GetPendingCount() const { return m_pending.size(); }
+
+        // Main thread time spent remeshing edited sections during the last Update
+        inline u64 GetLastEditUS() const { return m_lastEditUS; }
+
+        inline const MeshCacheStats& GetMeshCacheStats() const { return m_cacheStats; }
+
+        MeshMemoryStats GetMeshMemoryStats() const {
+            MeshMemoryStats stats = m_memoryStats;
+
+            for (const auto& [coord, mesh] : m_meshes) {
+                stats.residentBytes += MeshArena::GetByteSize(mesh.range);
+                stats.evictedMeshes += mesh.bEvicted ? 1 : 0;
+            }
+
+            stats.blocks = m_arena.GetBlockCount();
+            for (u32 heap = 0; heap < VK_MAX_MEMORY_HEAPS; ++heap)
+                stats.blockBytes += m_arena.GetHeapUsage(heap).first;
+
+            return stats;
+        }
+
+        void Update(World& world, const Camera& camera, ThreadPool& pool) {
+            const vec3i32    cameraBlock = FloorToVec3i32(camera.GetPosition());
+            const ChunkCoord cameraChunk{ WorldToChunk(cameraBlock.x), WorldToChunk(cameraBlock.z) };
+
+            ++m_updateCount;
+
+            m_arena.Configure(m_settings.bufferMode, m_settings.meshBlockBytes);
+            m_arena.ReleaseRetired();
+
+            RemeshDirtySections(world, cameraChunk, pool);
+            RestoreEvictedMeshes(world, pool);
+            CollectGatheredJobs(pool);
+            CollectFinishedJobs();
+            TrimMeshCache();
+            EvictOverBudget(cameraChunk);
+
+            m_arena.Upload();
+
+            if (!m_bBacklog && m_lastCameraChunk == std::optional<ChunkCoord>(cameraChunk) && m_lastChunkCount == world.GetChunkCount())
+                return;
+
+            m_lastCameraChunk = cameraChunk;
+            m_lastChunkCount  = world.GetChunkCount();
+
+            std::unordered_map<vec3i32, DesiredMesh, SectionCoordHash> desired;
+
+            world.ForEachChunk([&](const Chunk& chunk) {
+                const std::optional<u32> lod = LodForChunk(chunk.GetCoord(), cameraChunk);
+                if (!lod.has_value())
+                    return;
+
+                const u8 skirtMask = SkirtMaskForChunk(chunk.GetCoord(), cameraChunk, lod.value());
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y) {
+                    const ChunkSection* pSection = chunk.GetSection(y);
+
+                    if (pSection && !pSection->IsEmpty())
+                        desired.emplace(vec3i32{ chunk.GetCoord().x, static_cast<i32>(y), chunk.GetCoord().z }, DesiredMesh{ lod.value(), skirtMask });
+                }
+            });
+
+            // Out of range or unloaded sections
+            for (auto it = m_meshes.begin(); it != m_meshes.end();) {
+                if (desired.count(it->first)) {
+                    ++it;
+                    continue;
+                }
+
+                m_arena.Retire(it->second.range);
+                it = m_meshes.erase(it);
+            }
+
+            // Nearest sections first, so LOD transitions sweep outwards from the camera
+            std::vector<std::pair<vec3i32, DesiredMesh>> jobs;
+            for (const auto& [coord, target] : desired) {
+                const auto meshIt    = m_meshes.find(coord);
+                const auto pendingIt = m_pending.find(coord);
+
+                const bool bUpToDate = meshIt    != m_meshes.end()  && meshIt->second.lod    == target.lod && meshIt->second.skirtMask    == target.skirtMask;
+                const bool bInFlight = pendingIt != m_pending.end() && pendingIt->second.lod == target.lod && pendingIt->second.skirtMask == target.skirtMask;
+
+                // An evicted mesh is only meshed again once in view, at the LOD it has by then
+                if (meshIt != m_meshes.end() && meshIt->second.bEvicted) {
+                    meshIt->second.lod       = target.lod;
+                    meshIt->second.skirtMask = target.skirtMask;
+
+                    if (pendingIt != m_pending.end() && !bInFlight)
+                        m_pending.erase(pendingIt);
+
+                    continue;
+                }
+
+                if (!bUpToDate && !bInFlight)
+                    jobs.emplace_back(coord, target);
+            }
+
+            const auto DistanceSq = [&](const vec3i32& c) {
+                const i64 dx = c.x - cameraChunk.x, dz = c.z - cameraChunk.z;
+                return dx * dx + dz * dz;
+            };
+
+            const std::size_t jobCount = std::min<std::size_t>(jobs.size(), m_settings.maxJobsPerUpdate);
+            m_bBacklog = jobCount < jobs.size() || !m_pending.empty();
+            std::partial_sort(jobs.begin(), jobs.begin() + jobCount, jobs.end(), [&](const auto& a, const auto& b) { return DistanceSq(a.first) < DistanceSq(b.first); });
+
+            for (std::size_t i = 0; i < jobCount; ++i) {
+                const auto& [coord, target] = jobs[i];
+
+                QueueMesh(world, coord, target, pool);
+            }
+        }
+
+        void Draw(const Frustumf32& frustum) {
+            constexpr f32 S = static_cast<f32>(MC_CHUNK_SECTION_SIZE);
+
+            m_evictedInView.clear();
+
+            for (auto& [coord, mesh] : m_meshes) {
+                if (mesh.vertexCount == 0)
+                    continue;
+
+                const vec3f32 origin = ToVec3f32(coord) * S;
+
+                if (!frustum.Intersects(AABBf32{ origin, origin + vec3f32{ S, S, S } }))
+                    continue;
+
+                mesh.lastDrawn = m_updateCount;
+
+                if (mesh.bEvicted) {
+                    m_evictedInView.push_back(coord);
+                    continue;
+                }
+
+                mc::Renderer::Draw(m_arena.GetBuffer(mesh.range), mesh.range.first, mesh.vertexCount, origin);
+            }
+        }
+
+        // Must run before the renderer shuts down
+        void Clear() {
+            mc::Renderer::WaitIdle();
+
+            // Gather jobs read the world, which may go away after this
+            for (auto& [coord, pending] : m_pending) {
+                if (pending.gathered.valid())
+                    pending.gathered.wait();
+                if (pending.vertices.valid())
+                    pending.vertices.wait();
+            }
+            for (auto& [key, cached] : m_meshCache)
+                cached.vertices.wait();
+
+            m_pending.clear();
+            m_meshes.clear();
+            m_arena.Clear();
+            m_evictedInView.clear();
+            m_meshCache.clear();
+            m_cacheStats.bytes = 0;
+
+            m_lastCameraChunk.reset();
+        }
+    }; // class ChunkMeshManager
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "vertex.hpp"
+
+/*
+ * Turns one chunk section into a triangle list of colored faces, in section local
+ * coordinates (the section origin is pushed as a push constant at draw time).
+ *
+ * Meshing runs on worker threads, so it never touches the World: the section and a one
+ * block border of its neighbours are copied into a MeshingInput on the owning thread first,
+ * or on any thread from what the world last published.
+ *
+ * Level of detail L merges 2^L x 2^L x 2^L blocks into one cell. Where two sections are drawn
+ * at different LODs their surfaces do not line up, so the border faces on that side ("skirts")
+ * are emitted whatever the neighbour holds. Against a same LOD neighbour, a coarse border face
+ * is only dropped when the full resolution layer behind it is entirely opaque.
+ */
+
+namespace mc {
+
+    constexpr u32 MC_LOD_COUNT            = 4u; // 1x, 2x, 4x, 8x
+    constexpr i32 MC_MESHING_PADDED_SIZE  = static_cast<i32>(MC_CHUNK_SECTION_SIZE) + 2;
+
+    struct MeshingInput {
+        vec3i32 sectionCoord;
+
+        std::array<Block, MC_MESHING_PADDED_SIZE * MC_MESHING_PADDED_SIZE * MC_MESHING_PADDED_SIZE> blocks;
+
+        // x, y, z in [-1, 16]
+        static constexpr u32 Index(const i32 x, const i32 y, const i32 z) {
+            return static_cast<u32>(((y + 1) * MC_MESHING_PADDED_SIZE + (z + 1)) * MC_MESHING_PADDED_SIZE + (x + 1));
+        }
+
+        inline Block Get(const i32 x, const i32 y, const i32 z) const { return blocks[Index(x, y, z)]; }
+    }; // struct MeshingInput
+
+    // getSection maps a section coordinate to the section, or nullptr where there is none
+    template <typename GetSection>
+    void GatherMeshingInput(const vec3i32& sectionCoord, MeshingInput& input, const GetSection& getSection) {
+        constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+        input.sectionCoord = sectionCoord;
+
+        const ChunkSection* neighbours[27];
+        for (i32 dy = -1; dy <= 1; ++dy)
+            for (i32 dz = -1; dz <= 1; ++dz)
+                for (i32 dx = -1; dx <= 1; ++dx)
+                    neighbours[((dy + 1) * 3 + (dz + 1)) * 3 + (dx + 1)] = getSection(sectionCoord + vec3i32{ dx, dy, dz });
+
+        const auto Side = [](const i32 v) { return v < 0 ? 0 : (v >= S ? 2 : 1); };
+
+        for (i32 y = -1; y <= S; ++y) {
+            for (i32 z = -1; z <= S; ++z) {
+                for (i32 x = -1; x <= S; ++x) {
+                    const ChunkSection* pSection = neighbours[(Side(y) * 3 + Side(z)) * 3 + Side(x)];
+
+                    input.blocks[MeshingInput::Index(x, y, z)] = pSection ? pSection->Get(WorldToLocal(x), WorldToLocal(y), WorldToLocal(z)) : Block::Air;
+                }
+            }
+        }
+    }
+
+    inline void GatherMeshingInput(const World& world, const vec3i32& sectionCoord, MeshingInput& input) {
+        GatherMeshingInput(sectionCoord, input, [&world](const vec3i32& c) { return world.GetSection(c); });
+    }
+
+    // From any thread, off what the world last published: the caller holds an EpochGuard
+    inline void GatherPublishedMeshingInput(const World& world, const vec3i32& sectionCoord, MeshingInput& input) {
+        GatherMeshingInput(sectionCoord, input, [&world](const vec3i32& c) { return world.ReadSection(c); });
+    }
+
+    // Hashes the one block border copied from the neighbours. Together with the section's own hash it
+    // decides the whole mesh, since vertices are in section local coordinates
+    inline u64 HashMeshingBorder(const MeshingInput& input) {
+        constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+        u64 hash = 0;
+
+        for (i32 y = -1; y <= S; ++y) {
+            for (i32 z = -1; z <= S; ++z) {
+                // Rows inside the section only have their two end blocks on the border
+                const i32 step = (y < 0 || y == S || z < 0 || z == S) ? 1 : S + 1;
+
+                for (i32 x = -1; x <= S; x += step) {
+                    const Block block = input.Get(x, y, z);
+
+                    if (block != Block::Air)
+                        hash += noise::Hash((static_cast<u64>(MeshingInput::Index(x, y, z)) << 16) | static_cast<u64>(block));
+                }
+            }
+        }
+
+        return hash;
+    }
+
+    namespace details {
+
+        struct FaceDescription {
+            vec3i32 normal;
+            vec3f32 corners[4]; // Counter clockwise seen from outside the unit cube
+            f32     shade;
+        }; // struct FaceDescription
+
+        // Indexed by BlockFace
+        constexpr inline std::array<FaceDescription, 6> FACES = {
+            FaceDescription{ { -1,  0,  0 }, { { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 0, 0, 0 } }, 0.80f },
+            FaceDescription{ {  1,  0,  0 }, { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } }, 0.80f },
+            FaceDescription{ {  0, -1,  0 }, { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }, 0.50f },
+            FaceDescription{ {  0,  1,  0 }, { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } }, 1.00f },
+            FaceDescription{ {  0,  0, -1 }, { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } }, 0.65f },
+            FaceDescription{ {  0,  0,  1 }, { { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 }, { 0, 0, 1 } }, 0.65f },
+        };
+
+        inline void EmitFace(std::vector<Vertex>& out, const u32 face, const vec3f32& origin, const f32 scale, const Block block) {
+            const FaceDescription& description = FACES[face];
+            const vec3f32          color       = GetBlockProperties(block).color * description.shade;
+
+            constexpr u32 TRIANGLES[6] = { 0, 1, 2, 0, 2, 3 };
+            for (const u32 corner : TRIANGLES)
+                out.push_back(Vertex{ origin + description.corners[corner] * scale, color });
+        }
+
+        inline bool IsFaceVisible(const Block block, const Block neighbour) {
+            return !IsOpaque(neighbour) && neighbour != block;
+        }
+
+        // Representative block of a cell: the most common non air block, if the cell is at least half full
+        inline Block DownsampleCell(const MeshingInput& input, const i32 x0, const i32 y0, const i32 z0, const i32 size) {
+            std::array<u32, static_cast<std::size_t>(Block::Count)> counts{};
+            u32 nonAir = 0;
+
+            for (i32 y = y0; y < y0 + size; ++y)
+                for (i32 z = z0; z < z0 + size; ++z)
+                    for (i32 x = x0; x < x0 + size; ++x) {
+                        const Block block = input.Get(x, y, z);
+
+                        if (block != Block::Air) {
+                            ++counts[static_cast<std::size_t>(block)];
+                            ++nonAir;
+                        }
+                    }
+
+            if (nonAir * 2 < static_cast<u32>(size * size * size))
+                return Block::Air;
+
+            return static_cast<Block>(std::max_element(counts.begin() + 1, counts.end()) - counts.begin());
+        }
+
+        // True when the full resolution blocks just outside one face of a coarse cell are all opaque
+        inline bool IsBorderLayerOpaque(const MeshingInput& input, const vec3i32& cell, const i32 cellSize, const u32 face) {
+            const vec3i32& n = FACES[face].normal;
+            const vec3i32 base{ cell.x * cellSize, cell.y * cellSize, cell.z * cellSize };
+
+            for (i32 v = 0; v < cellSize; ++v) {
+                for (i32 u = 0; u < cellSize; ++u) {
+                    // Walk the face plane, pinned to the padding layer along the normal
+                    vec3i32 p = base;
+                    if      (n.x != 0) { p.x = n.x < 0 ? -1 : base.x + cellSize; p.y += u; p.z += v; }
+                    else if (n.y != 0) { p.y = n.y < 0 ? -1 : base.y + cellSize; p.x += u; p.z += v; }
+                    else               { p.z = n.z < 0 ? -1 : base.z + cellSize; p.x += u; p.y += v; }
+
+                    if (!IsOpaque(input.Get(p.x, p.y, p.z)))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+    }; // namespace details
+
+    // skirtMask: bit f (a BlockFace) forces border faces on that side, used where the neighbour is drawn at another LOD
+    inline void MeshSection(const MeshingInput& input, const u32 lod, const u8 skirtMask, std::vector<Vertex>& out) {
+        using namespace details;
+
+        constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+        out.clear();
+
+        if (lod == 0) {
+            for (i32 y = 0; y < S; ++y) {
+                for (i32 z = 0; z < S; ++z) {
+                    for (i32 x = 0; x < S; ++x) {
+                        const Block block = input.Get(x, y, z);
+
+                        if (block == Block::Air)
+                            continue;
+
+                        for (u32 f = 0; f < 6; ++f) {
+                            const vec3i32 n = vec3i32{ x, y, z } + FACES[f].normal;
+                            const bool bBorder = n.x < 0 || n.x >= S || n.y < 0 || n.y >= S || n.z < 0 || n.z >= S;
+
+                            if ((bBorder && (skirtMask & (1u << f))) || IsFaceVisible(block, input.Get(n.x, n.y, n.z)))
+                                EmitFace(out, f, ToVec3f32(vec3i32{ x, y, z }), 1.f, block);
+                        }
+                    }
+                }
+            }
+
+            return;
+        }
+
+        const i32 cellSize  = 1 << lod;
+        const i32 cellCount = S / cellSize;
+
+        std::vector<Block> cells(static_cast<std::size_t>(cellCount * cellCount * cellCount));
+        const auto Cell = [&](const i32 x, const i32 y, const i32 z) -> Block& { return cells[static_cast<std::size_t>((y * cellCount + z) * cellCount + x)]; };
+
+        for (i32 y = 0; y < cellCount; ++y)
+            for (i32 z = 0; z < cellCount; ++z)
+                for (i32 x = 0; x < cellCount; ++x)
+                    Cell(x, y, z) = DownsampleCell(input, x * cellSize, y * cellSize, z * cellSize, cellSize);
+
+        for (i32 y = 0; y < cellCount; ++y) {
+            for (i32 z = 0; z < cellCount; ++z) {
+                for (i32 x = 0; x < cellCount; ++x) {
+                    const Block block = Cell(x, y, z);
+
+                    if (block == Block::Air)
+                        continue;
+
+                    for (u32 f = 0; f < 6; ++f) {
+                        const vec3i32 n = vec3i32{ x, y, z } + FACES[f].normal;
+                        const bool bBorder = n.x < 0 || n.x >= cellCount || n.y < 0 || n.y >= cellCount || n.z < 0 || n.z >= cellCount;
+
+                        const bool bVisible = bBorder
+                            ? (skirtMask & (1u << f)) || !IsBorderLayerOpaque(input, vec3i32{ x, y, z }, cellSize, f)
+                            : IsFaceVisible(block, Cell(n.x, n.y, n.z));
+
+                        if (bVisible)
+                            EmitFace(out, f, ToVec3f32(vec3i32{ x, y, z }) * static_cast<f32>(cellSize), static_cast<f32>(cellSize), block);
+                    }
+                }
+            }
+        }
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "chunkMesher.hpp"
+
+/*
+ * Reader threads meshing random sections while the main thread keeps rewriting them, the way meshers
+ * and the simulation share the world. The writer fills whole sections with one block at a time and
+ * sometimes unloads and reloads a chunk; a reader that saw a section half written, or one already
+ * freed and reused, would find more than one block in it, which is counted as an inconsistency.
+ *
+ * Runs twice: readers reading what the world published under an EpochGuard, then readers and writer
+ * taking one mutex around every access as a baseline, and reports how each contends.
+ */
+
+namespace mc {
+
+    struct ChunkStressResult {
+        u64 reads           = 0; // Sections gathered and meshed
+        u64 missing         = 0; // Reads of a chunk unloaded at the time
+        u64 inconsistencies = 0;
+        u64 edits           = 0;
+        u64 readWaitUS      = 0; // Readers waiting on the lock, summed over the readers
+        u64 maxReadWaitUS   = 0;
+        u64 writeWaitUS     = 0;
+        u64 maxWriteWaitUS  = 0;
+        u64 elapsedUS       = 0;
+
+        PublishStats publish; // Of the epoch run
+    }; // struct ChunkStressResult
+
+    class ChunkStress {
+    private:
+        static constexpr i32 SIDE_CHUNKS   = 8;
+        static constexpr u32 SECTIONS      = 4;  // Per chunk, the ones written and read
+        static constexpr u32 PUBLISH_EVERY = 8;  // Edits between two publishes
+        static constexpr u32 RELOAD_EVERY  = 64; // Edits between two chunk reloads
+
+        static constexpr Block BLOCKS[] = { Block::Stone, Block::Dirt, Block::Sand, Block::Wood };
+
+        static void LoadChunk(World& world, const ChunkCoord coord, const Block block) {
+            Chunk& chunk = world.CreateChunk(coord);
+
+            for (u32 y = 0; y < SECTIONS; ++y)
+                chunk.GetOrCreateSection(y).Fill(block);
+        }
+
+        static vec3i32 PickSection(u64& rng) {
+            rng = noise::Hash(rng);
+            return vec3i32{ static_cast<i32>(rng % SIDE_CHUNKS), static_cast<i32>((rng >> 16) % SECTIONS), static_cast<i32>((rng >> 32) % SIDE_CHUNKS) };
+        }
+
+        // Whether the gathered section holds one block only
+        static bool IsUniform(const MeshingInput& input) {
+            constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+            const Block block = input.Get(0, 0, 0);
+
+            for (i32 y = 0; y < S; ++y)
+                for (i32 z = 0; z < S; ++z)
+                    for (i32 x = 0; x < S; ++x)
+                        if (input.Get(x, y, z) != block)
+                            return false;
+
+            return true;
+        }
+
+        static void RecordWait(const u64 waitUS, u64& sum, u64& max) {
+            sum += waitUS;
+            max  = std::max(max, waitUS);
+        }
+
+    public:
+        static ChunkStressResult Run(const bool bEpoch, const u32 readerCount, const u32 seconds) {
+            ChunkStressResult result;
+
+            World world;
+
+            for (i32 z = 0; z < SIDE_CHUNKS; ++z)
+                for (i32 x = 0; x < SIDE_CHUNKS; ++x)
+                    LoadChunk(world, ChunkCoord{ x, z }, Block::Stone);
+
+            world.Publish();
+
+            std::mutex        mutex; // The baseline's
+            std::atomic<bool> bStop{ false };
+
+            std::vector<ChunkStressResult> readerResults(readerCount);
+            std::vector<std::thread>       readers;
+
+            for (u32 i = 0; i < readerCount; ++i) {
+                readers.emplace_back([&, i]() {
+                    ChunkStressResult& reader = readerResults[i];
+
+                    std::unique_ptr<MeshingInput> pInput = std::make_unique<MeshingInput>();
+                    std::vector<Vertex>           mesh;
+
+                    u64 rng = 0x52656164ull + i;
+
+                    while (!bStop.load(std::memory_order_relaxed)) {
+                        const vec3i32 coord = PickSection(rng);
+
+                        bool bLoaded;
+
+                        if (bEpoch) {
+                            const EpochGuard guard;
+
+                            bLoaded = world.ReadSection(coord) != nullptr;
+                            if (bLoaded)
+                                GatherPublishedMeshingInput(world, coord, *pInput);
+                        } else {
+                            const Timer wait;
+                            std::lock_guard<std::mutex> lock(mutex);
+                            RecordWait(wait.GetElapsedUS(), reader.readWaitUS, reader.maxReadWaitUS);
+
+                            bLoaded = world.GetSection(coord) != nullptr;
+                            if (bLoaded)
+                                GatherMeshingInput(world, coord, *pInput);
+                        }
+
+                        if (!bLoaded) {
+                            ++reader.missing;
+                            continue;
+                        }
+
+                        if (!IsUniform(*pInput))
+                            ++reader.inconsistencies;
+
+                        mesh.clear();
+                        MeshSection(*pInput, 0, 0, mesh);
+
+                        ++reader.reads;
+                    }
+                });
+            }
+
+            const Timer timer;
+
+            u64 rng = 0x5772697465ull;
+            u32 blockIndex = 0;
+
+            std::vector<SectionEdit> edits(MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE);
+
+            while (timer.GetElapsedUS() < static_cast<u64>(seconds) * 1'000'000u) {
+                const vec3i32 coord = PickSection(rng);
+                const Block   block = BLOCKS[blockIndex++ % std::size(BLOCKS)];
+
+                for (u16 j = 0; j < edits.size(); ++j)
+                    edits[j] = SectionEdit{ j, block };
+
+                const bool bReload = (result.edits + 1) % RELOAD_EVERY == 0;
+
+                {
+                    const Timer wait;
+                    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+
+                    if (!bEpoch) {
+                        lock.lock();
+                        RecordWait(wait.GetElapsedUS(), result.writeWaitUS, result.maxWriteWaitUS);
+                    }
+
+                    world.SetSectionBlocks(coord, edits);
+
+                    if (bReload) {
+                        const ChunkCoord chunk{ coord.x, coord.z };
+
+                        world.DestroyChunk(chunk);
+                        LoadChunk(world, chunk, block);
+                    }
+
+                    // Readers in the baseline see every edit as it is made, nothing to publish
+                    if (bEpoch && (result.edits + 1) % PUBLISH_EVERY == 0)
+                        world.Publish();
+                }
+
+                while (!world.GetDirtySections().empty())
+                    world.ClearDirtySection(*world.GetDirtySections().begin());
+
+                ++result.edits;
+            }
+
+            result.elapsedUS = timer.GetElapsedUS();
+            result.publish   = world.GetPublishStats();
+
+            bStop.store(true, std::memory_order_relaxed);
+            for (std::thread& reader : readers)
+                reader.join();
+
+            for (const ChunkStressResult& reader : readerResults) {
+                result.reads           += reader.reads;
+                result.missing         += reader.missing;
+                result.inconsistencies += reader.inconsistencies;
+                result.readWaitUS      += reader.readWaitUS;
+                result.maxReadWaitUS    = std::max(result.maxReadWaitUS, reader.maxReadWaitUS);
+            }
+
+            // What was retired as the world goes away is freed by the next collections
+            EpochDomain::Get().Collect();
+
+            return result;
+        }
+
+        static void RunAll(const u32 seconds, std::ostream& out) {
+            const u32 readerCount = std::max(2u, std::thread::hardware_concurrency() - 1);
+
+            out << "[STRESS] " << seconds << " s per mode, " << readerCount << " readers meshing random sections of " << SIDE_CHUNKS * SIDE_CHUNKS
+                << " chunks, one writer rewriting whole sections\n";
+
+            for (const bool bEpoch : { true, false }) {
+                const EpochStats        before = EpochDomain::Get().GetStats();
+                const ChunkStressResult result = Run(bEpoch, readerCount, seconds);
+                const EpochStats        after  = EpochDomain::Get().GetStats();
+
+                const f64 elapsed = static_cast<f64>(std::max<u64>(result.elapsedUS, 1)) / 1e6;
+                const f64 reads   = static_cast<f64>(std::max<u64>(result.reads + result.missing, 1));
+                const f64 edits   = static_cast<f64>(std::max<u64>(result.edits, 1));
+
+                out << "[STRESS] " << std::left << std::setw(5) << (bEpoch ? "epoch" : "mutex") << std::right << std::fixed << std::setprecision(0)
+                    << " | " << static_cast<f64>(result.reads) / elapsed << " reads/s, " << static_cast<f64>(result.edits) / elapsed << " edits/s"
+                    << " | reader wait " << std::setprecision(2) << static_cast<f64>(result.readWaitUS) / reads << " us avg, " << result.maxReadWaitUS << " us max"
+                    << " | writer wait " << static_cast<f64>(result.writeWaitUS) / edits << " us avg, " << result.maxWriteWaitUS << " us max"
+                    << " | " << result.inconsistencies << " inconsistencies\n";
+
+                if (bEpoch) {
+                    const f64 publishes = static_cast<f64>(std::max<u64>(result.publish.publishes, 1));
+
+                    out << "[STRESS]       publish " << static_cast<f64>(result.publish.publishUS) / publishes << " us avg, " << result.publish.maxPublishUS << " us max, "
+                        << static_cast<f64>(result.publish.sections) / publishes << " sections and " << result.publish.tables << " chunk tables over " << result.publish.publishes << " publishes\n";
+
+                    out << "[STRESS]       epoch " << after.epoch << ", " << after.advances - before.advances << " advances, " << after.blocked - before.blocked << " blocked by a reader"
+                        << " | " << after.retired - before.retired << " retired, " << after.freed - before.freed << " freed, at most " << after.maxPending << " pending\n";
+                }
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class ChunkStress
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "header.hpp"
+#include "vertex.hpp"
+#include "timer.hpp"
+#include "bitmapFont.hpp"
+
+/*
+ * The performance overlay: a few lines of counters over graphs of the last frame, tick and GPU
+ * times, all turned into quads of one vertex format so the renderer draws them in a single call.
+ * Vertices are written straight into the renderer's mapped buffer for the frame, and only on
+ * frames that show the overlay.
+ */
+
+namespace mc {
+
+    constexpr u32 MC_OVERLAY_HISTORY = 240; // Samples per graph, one pixel each
+
+    using OverlayHistory = TimingHistory<MC_OVERLAY_HISTORY>;
+
+    // As OverlayVertex::color is read, R8G8B8A8 in memory
+    constexpr u32 RGBA(const u32 r, const u32 g, const u32 b, const u32 a) { return r | (g << 8) | (b << 16) | (a << 24); }
+
+    // What the overlay shows, gathered by the game each frame it is visible
+    struct DebugOverlayData {
+        const OverlayHistory* pFrames = nullptr; // CPU time of whole frames
+        const OverlayHistory* pTicks  = nullptr;
+        const OverlayHistory* pGpu    = nullptr; // Empty when the device has no timestamps
+
+        u64 recordUS = 0; // Recording the last frame's draws
+        u32 draws    = 0;
+
+        std::size_t chunks        = 0;
+        std::size_t meshes        = 0;
+        std::size_t pendingMeshes = 0;
+        std::size_t fluidCells    = 0;
+
+        vk::DeviceSize deviceBytes = 0;
+        vk::DeviceSize devicePeak  = 0;
+
+        u64 overlayUS = 0; // What the overlay cost the frame before, building and recording it
+    }; // struct DebugOverlayData
+
+    // Appends quads to a vertex array, dropping those past its capacity
+    class OverlayBatch {
+    private:
+        OverlayVertex* m_pVertices;
+        u32            m_capacity;
+        u32            m_count = 0;
+
+    public:
+        OverlayBatch(OverlayVertex* pVertices, const u32 capacity)
+            : m_pVertices(pVertices), m_capacity(capacity)
+        { }
+
+        inline u32 GetVertexCount() const { return m_count; }
+
+        void Quad(const f32 x0, const f32 y0, const f32 x1, const f32 y1, const vec2f32& uv0, const vec2f32& uv1, const u32 color) {
+            if (m_count + 6 > m_capacity)
+                return;
+
+            OverlayVertex* const p = m_pVertices + m_count;
+
+            p[0] = OverlayVertex{ vec2f32{ x0, y0 }, vec2f32{ uv0.x, uv0.y }, color };
+            p[1] = OverlayVertex{ vec2f32{ x1, y0 }, vec2f32{ uv1.x, uv0.y }, color };
+            p[2] = OverlayVertex{ vec2f32{ x1, y1 }, vec2f32{ uv1.x, uv1.y }, color };
+            p[3] = p[0];
+            p[4] = p[2];
+            p[5] = OverlayVertex{ vec2f32{ x0, y1 }, vec2f32{ uv0.x, uv1.y }, color };
+
+            m_count += 6;
+        }
+
+        void Rect(const f32 x, const f32 y, const f32 width, const f32 height, const u32 color) {
+            const vec2f32 uv = BitmapFont::GetSolidUV();
+
+            Quad(x, y, x + width, y + height, uv, uv, color);
+        }
+
+        // Returns where the text ends along x
+        f32 Text(f32 x, const f32 y, const char* pText, const u32 color, const f32 scale) {
+            for (; *pText; ++pText, x += BitmapFont::CELL_WIDTH * scale) {
+                if (*pText == ' ')
+                    continue;
+
+                const BitmapFont::CellUV uv = BitmapFont::GetGlyphUV(BitmapFont::GetCell(*pText));
+
+                Quad(x, y, x + BitmapFont::GLYPH_WIDTH * scale, y + BitmapFont::GLYPH_HEIGHT * scale, uv.min, uv.max, color);
+            }
+
+            return x;
+        }
+    }; // class OverlayBatch
+
+    class DebugOverlay {
+    private:
+        static constexpr f32 TEXT_SCALE   = 2.f;
+        static constexpr f32 LINE_HEIGHT  = BitmapFont::CELL_HEIGHT * TEXT_SCALE + 4.f;
+        static constexpr f32 MARGIN       = 8.f;
+        static constexpr f32 PADDING      = 6.f;
+        static constexpr f32 GRAPH_WIDTH  = static_cast<f32>(MC_OVERLAY_HISTORY);
+        static constexpr f32 GRAPH_HEIGHT = 48.f;
+        static constexpr u32 LINE_COUNT   = 6;
+        static constexpr f32 PANEL_WIDTH  = 46 * BitmapFont::CELL_WIDTH * TEXT_SCALE + PADDING * 2.f; // The longest line fits
+
+        static constexpr u64 FRAME_BUDGET_US = 1'000'000u / 60u;
+
+        static constexpr u32 TEXT_COLOR  = RGBA(255, 255, 255, 255);
+        static constexpr u32 PANEL_COLOR = RGBA(0, 0, 0, 160);
+        static constexpr u32 GRAPH_COLOR = RGBA(32, 32, 32, 200);
+        static constexpr u32 LINE_COLOR  = RGBA(255, 255, 255, 96);
+        static constexpr u32 GOOD_COLOR  = RGBA(64, 220, 64, 255);
+        static constexpr u32 SLOW_COLOR  = RGBA(240, 200, 40, 255);
+        static constexpr u32 BAD_COLOR   = RGBA(240, 64, 48, 255);
+
+        // Scaled so the budget sits at half height, samples over twice the budget clipped
+        static void Graph(OverlayBatch& batch, const f32 x, const f32 y, const char* pLabel, const OverlayHistory& history, const u64 budgetUS) {
+            batch.Rect(x, y, GRAPH_WIDTH, GRAPH_HEIGHT, GRAPH_COLOR);
+
+            const f32 perUS = GRAPH_HEIGHT / static_cast<f32>(budgetUS * 2);
+            const u32 count = history.GetCount();
+
+            for (u32 i = 0; i < count; ++i) {
+                const u32 us     = history.Get(i);
+                const f32 height = std::min(static_cast<f32>(us) * perUS, GRAPH_HEIGHT);
+                const u32 color  = us <= budgetUS ? GOOD_COLOR : (us <= budgetUS * 2 ? SLOW_COLOR : BAD_COLOR);
+
+                if (height >= 1.f)
+                    batch.Rect(x + GRAPH_WIDTH - static_cast<f32>(count - i), y + GRAPH_HEIGHT - height, 1.f, height, color);
+            }
+
+            batch.Rect(x, y + GRAPH_HEIGHT * 0.5f, GRAPH_WIDTH, 1.f, LINE_COLOR);
+
+            char text[48];
+            std::snprintf(text, sizeof(text), "%s %.2f MS", pLabel, history.GetLast() / 1e3);
+            batch.Text(x + 4.f, y + 4.f, text, TEXT_COLOR, TEXT_SCALE);
+        }
+
+    public:
+        // Returns the count of vertices written
+        static u32 Build(const DebugOverlayData& data, OverlayVertex* pVertices, const u32 capacity) {
+            OverlayBatch batch(pVertices, capacity);
+
+            const OverlayHistory empty;
+
+            const OverlayHistory& frames = data.pFrames ? *data.pFrames : empty;
+            const OverlayHistory& ticks  = data.pTicks  ? *data.pTicks  : empty;
+            const OverlayHistory& gpu    = data.pGpu    ? *data.pGpu    : empty;
+
+            const u32 graphCount = gpu.GetCount() > 0 ? 3 : 2;
+
+            batch.Rect(MARGIN, MARGIN, PANEL_WIDTH, LINE_COUNT * LINE_HEIGHT + graphCount * (GRAPH_HEIGHT + PADDING) + PADDING, PANEL_COLOR);
+
+            const f64 frameMS = frames.GetAverage() / 1e3;
+
+            char lines[LINE_COUNT][96];
+            std::snprintf(lines[0], sizeof(lines[0]), "FPS %.0f  FRAME %.2f MS  MAX %.2f MS", frameMS > 0.0 ? 1e3 / frameMS : 0.0, frameMS, frames.GetMax() / 1e3);
+            std::snprintf(lines[1], sizeof(lines[1]), "TICK %.2f MS  MAX %.2f MS", ticks.GetAverage() / 1e3, ticks.GetMax() / 1e3);
+            std::snprintf(lines[2], sizeof(lines[2]), "GPU %.2f MS  RECORD %.2f MS  DRAWS %u", gpu.GetAverage() / 1e3, data.recordUS / 1e3, data.draws);
+            std::snprintf(lines[3], sizeof(lines[3]), "CHUNKS %zu  MESHES %zu  QUEUED %zu", data.chunks, data.meshes, data.pendingMeshes);
+            std::snprintf(lines[4], sizeof(lines[4]), "DEVICE %.1f MB  PEAK %.1f MB", data.deviceBytes / 1048576.0, data.devicePeak / 1048576.0);
+            std::snprintf(lines[5], sizeof(lines[5]), "FLUIDS %zu ACTIVE  OVERLAY %.3f MS", data.fluidCells, data.overlayUS / 1e3);
+
+            f32 y = MARGIN + PADDING;
+
+            for (const char* pLine : lines) {
+                batch.Text(MARGIN + PADDING, y, pLine, TEXT_COLOR, TEXT_SCALE);
+                y += LINE_HEIGHT;
+            }
+
+            Graph(batch, MARGIN + PADDING, y, "FRAME", frames, FRAME_BUDGET_US);
+            y += GRAPH_HEIGHT + PADDING;
+
+            Graph(batch, MARGIN + PADDING, y, "TICK", ticks, FRAME_BUDGET_US);
+            y += GRAPH_HEIGHT + PADDING;
+
+            if (graphCount > 2)
+                Graph(batch, MARGIN + PADDING, y, "GPU", gpu, FRAME_BUDGET_US);
+
+            return batch.GetVertexCount();
+        }
+    }; // class DebugOverlay
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "physics.hpp"
+#include "threadPool.hpp"
+#include "spatialHash.hpp"
+
+namespace mc {
+
+    using EntityID = u32;
+
+    constexpr f32 MC_GRAVITY           = -28.f; // Blocks per second squared
+    constexpr f32 MC_TERMINAL_VELOCITY = -60.f;
+    constexpr f32 MC_GROUND_FRICTION   = 0.6f;  // Fraction of the horizontal velocity kept per tick on the ground
+    constexpr f32 MC_ENTITY_PUSH       = 0.5f;  // Fraction of an entity vs entity overlap resolved per tick
+
+    /*
+     * Entities are stored as parallel arrays indexed by a dense slot; EntityIDs map to
+     * slots and stay valid across despawns (which swap the last slot into the hole).
+     */
+    class EntitySystem {
+    private:
+        std::vector<EntityID> m_ids;
+        std::vector<vec3f32>  m_positions;   // Center of the bounding box
+        std::vector<vec3f32>  m_velocities;
+        std::vector<vec3f32>  m_halfExtents;
+        std::vector<u8>       m_bOnGround;
+
+        std::unordered_map<EntityID, u32> m_slots;
+        EntityID m_nextId = 1;
+
+        SpatialHash m_broadphase;
+
+        // Per tick scratch: slots ordered by chunk, and where each chunk's run starts
+        std::vector<u32>         m_order;
+        std::vector<std::size_t> m_partitions;
+
+        u64 m_lastTickUS = 0;
+
+    private:
+        static inline u64 ChunkKey(const vec3f32& p) {
+            const ChunkCoord c{ WorldToChunk(static_cast<i32>(std::floor(p.x))), WorldToChunk(static_cast<i32>(std::floor(p.z))) };
+
+            return (static_cast<u64>(static_cast<u32>(c.x)) << 32) | static_cast<u32>(c.z);
+        }
+
+        void PartitionByChunk() {
+            const std::size_t count = m_ids.size();
+
+            std::vector<u64> keys(count);
+            for (std::size_t i = 0; i < count; ++i)
+                keys[i] = ChunkKey(m_positions[i]);
+
+            m_order.resize(count);
+            std::iota(m_order.begin(), m_order.end(), 0u);
+            std::sort(m_order.begin(), m_order.end(), [&](const u32 a, const u32 b) { return keys[a] < keys[b]; });
+
+            m_partitions.clear();
+            for (std::size_t i = 0; i < count; ++i)
+                if (i == 0 || keys[m_order[i]] != keys[m_order[i - 1]])
+                    m_partitions.push_back(i);
+            m_partitions.push_back(count);
+        }
+
+        // Only writes to slot i, and only reads other entities through the broadphase snapshot
+        void UpdateEntity(const World& world, const u32 i, const f32 dt) {
+            vec3f32& velocity = m_velocities[i];
+
+            velocity.y = std::max(velocity.y + MC_GRAVITY * dt, MC_TERMINAL_VELOCITY);
+
+            const AABBf32 box = m_broadphase.GetBox(i);
+
+            vec3f32 push{ 0.f, 0.f, 0.f };
+            m_broadphase.Query(box, [&](const u32 j) {
+                if (j == i)
+                    return;
+
+                // Separate horizontally along the axis of least penetration
+                const AABBf32 other = m_broadphase.GetBox(j);
+                const f32 overlapX = std::min(box.max.x, other.max.x) - std::max(box.min.x, other.min.x);
+                const f32 overlapZ = std::min(box.max.z, other.max.z) - std::max(box.min.z, other.min.z);
+                const vec3f32 delta = box.GetCenter() - other.GetCenter();
+
+                if (overlapX < overlapZ)
+                    push.x += (delta.x >= 0.f ? overlapX : -overlapX) * MC_ENTITY_PUSH * 0.5f;
+                else
+                    push.z += (delta.z >= 0.f ? overlapZ : -overlapZ) * MC_ENTITY_PUSH * 0.5f;
+            });
+
+            const vec3f32         displacement = velocity * dt + push;
+            const CollisionResult collision    = SweepAABB(world, box, displacement);
+
+            m_positions[i] += collision.displacement;
+
+            if (collision.bCollided[0]) velocity.x = 0.f;
+            if (collision.bCollided[1]) velocity.y = 0.f;
+            if (collision.bCollided[2]) velocity.z = 0.f;
+
+            m_bOnGround[i] = collision.bCollided[1] && displacement.y < 0.f;
+
+            if (m_bOnGround[i]) {
+                velocity.x *= MC_GROUND_FRICTION;
+                velocity.z *= MC_GROUND_FRICTION;
+            }
+        }
+
+    public:
+        EntityID Spawn(const vec3f32& position, const vec3f32& halfExtents) {
+            const EntityID id = m_nextId++;
+
+            m_slots[id] = static_cast<u32>(m_ids.size());
+
+            m_ids.push_back(id);
+            m_positions.push_back(position);
+            m_velocities.push_back(vec3f32{ 0.f, 0.f, 0.f });
+            m_halfExtents.push_back(halfExtents);
+            m_bOnGround.push_back(false);
+
+            return id;
+        }
+
+        void Despawn(const EntityID id) {
+            const auto it = m_slots.find(id);
+            if (it == m_slots.end())
+                return;
+
+            const u32 slot = it->second;
+            const u32 last = static_cast<u32>(m_ids.size() - 1);
+
+            m_ids[slot]         = m_ids[last];
+            m_positions[slot]   = m_positions[last];
+            m_velocities[slot]  = m_velocities[last];
+            m_halfExtents[slot] = m_halfExtents[last];
+            m_bOnGround[slot]   = m_bOnGround[last];
+            m_slots[m_ids[slot]] = slot;
+
+            m_ids.pop_back(); m_positions.pop_back(); m_velocities.pop_back(); m_halfExtents.pop_back(); m_bOnGround.pop_back();
+            m_slots.erase(it);
+        }
+
+        inline std::size_t GetCount() const { return m_ids.size(); }
+
+        inline std::optional<u32> GetSlot(const EntityID id) const {
+            const auto it = m_slots.find(id);
+
+            return it != m_slots.end() ? std::optional<u32>(it->second) : std::nullopt;
+        }
+
+        inline const vec3f32& GetPosition(const u32 slot) const { return m_positions[slot];  }
+        inline const vec3f32& GetVelocity(const u32 slot) const { return m_velocities[slot]; }
+        inline bool           IsOnGround(const u32 slot)  const { return m_bOnGround[slot];  }
+        inline EntityID       GetID(const u32 slot)       const { return m_ids[slot];        }
+
+        inline void SetVelocity(const u32 slot, const vec3f32& velocity) { m_velocities[slot] = velocity; }
+        inline void SetPosition(const u32 slot, const vec3f32& position) { m_positions[slot]  = position; }
+
+        inline u64 GetLastTickUS() const { return m_lastTickUS; }
+
+        void Tick(const World& world, const f32 dt, ThreadPool& pool) {
+            const mc::Timer timer;
+
+            const std::size_t count = m_ids.size();
+
+            f32 maxHalfExtent = 0.5f;
+            for (const vec3f32& e : m_halfExtents)
+                maxHalfExtent = std::max({ maxHalfExtent, e.x, e.y, e.z });
+
+            m_broadphase.Build(count, m_positions.data(), m_halfExtents.data(), 2.f * maxHalfExtent);
+
+            PartitionByChunk();
+
+            // One job per run of chunks; every entity is owned by exactly one job
+            pool.ParallelFor(m_partitions.size() - 1, 4, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t p = begin; p < end; ++p)
+                    for (std::size_t k = m_partitions[p]; k < m_partitions[p + 1]; ++k)
+                        UpdateEntity(world, m_order[k], dt);
+            });
+
+            m_lastTickUS = timer.GetElapsedUS();
+        }
+    }; // class EntitySystem
+
+}; // namespace mc
\ No newline at end of file
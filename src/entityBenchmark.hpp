@@ -0,0 +1,89 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "noise.hpp"
+#include "entity.hpp"
+#include "threadPool.hpp"
+#include "netProtocol.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * What EntitySystem::Tick costs at 1k and 10k mobs on generated terrain, at the server's tick rate:
+ * the mobs drop in from a few blocks up and wander like the server's, a new heading every two
+ * seconds, so the ticks mix falls, ground friction, steps against the terrain and pushes between
+ * mobs. Tick times are EntitySystem::GetLastTickUS; generation is not timed.
+ */
+
+namespace mc {
+
+    class EntityBenchmark {
+    private:
+        static constexpr u64     SEED             = 0x456E7469ull;
+        static constexpr i32     SIDE             = 8;    // Chunks along each side of the world
+        static constexpr f32     DROP_HEIGHT      = 4.f;
+        static constexpr f32     MOB_SPEED        = 2.f;  // Blocks per second, as the server's
+        static constexpr u64     HEADING_TICKS    = 2 * MC_NET_TICK_RATE;
+        static constexpr vec3f32 MOB_HALF_EXTENTS = { 0.3f, 0.45f, 0.3f };
+
+    public:
+        static void Run(const World& world, const WorldGenerator& generator, const u32 mobs, const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            EntitySystem entities;
+
+            const i32 span = SIDE * MC_CHUNK_SECTION_SIZE;
+
+            for (u32 i = 0; i < mobs; ++i) {
+                const u64 h = noise::Hash(SEED, static_cast<i32>(i), static_cast<i32>(mobs), 0);
+                const i32 x = static_cast<i32>(h % static_cast<u64>(span));
+                const i32 z = static_cast<i32>((h >> 16) % static_cast<u64>(span));
+
+                entities.Spawn(vec3f32{ x + 0.5f, static_cast<f32>(generator.GetTerrainHeight(x, z) + 1) + DROP_HEIGHT, z + 0.5f }, MOB_HALF_EXTENTS);
+            }
+
+            u64 totalUS = 0;
+            u64 maxUS   = 0;
+
+            for (u64 tick = 0; tick < ticks; ++tick) {
+                if (tick % HEADING_TICKS == 0) {
+                    for (u32 slot = 0; slot < entities.GetCount(); ++slot) {
+                        const f32 angle = noise::HashToUnit(noise::Hash(SEED, static_cast<i32>(slot), 1, static_cast<i32>(tick / HEADING_TICKS))) * 6.2831853f;
+
+                        entities.SetVelocity(slot, vec3f32{ std::cos(angle) * MOB_SPEED, entities.GetVelocity(slot).y, std::sin(angle) * MOB_SPEED });
+                    }
+                }
+
+                entities.Tick(world, 1.f / MC_NET_TICK_RATE, pool);
+
+                totalUS += entities.GetLastTickUS();
+                maxUS    = std::max(maxUS, entities.GetLastTickUS());
+            }
+
+            out << "[BENCHMARK] " << std::setw(5) << mobs << " mobs | tick " << std::fixed << std::setprecision(3)
+                << static_cast<f64>(totalUS) / std::max<u32>(ticks, 1) / 1000.0 << " ms avg, " << maxUS / 1000.0 << " ms max\n"
+                << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+
+        static void RunAll(const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            World              world;
+            WorldGenerator     generator(SEED);
+            GenerationPipeline generation(generator, pool);
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = 0; z < SIDE; ++z)
+                for (i32 x = 0; x < SIDE; ++x)
+                    chunks.push_back(&world.CreateChunk(ChunkCoord{ x, z }));
+
+            generation.Generate(chunks);
+
+            for (Chunk* pChunk : chunks)
+                pChunk->Intern(world.GetSectionPool());
+
+            out << "[BENCHMARK] " << ticks << " entity ticks over " << chunks.size() << " generated chunks on " << pool.GetThreadCount() + 1 << " threads\n";
+
+            for (const u32 mobs : { 1'000u, 10'000u })
+                Run(world, generator, mobs, ticks, pool, out);
+        }
+    }; // class EntityBenchmark
+
+}; // namespace mc
\ No newline at end of file
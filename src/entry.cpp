@@ -8,4 +8,6 @@ int main(int argc, char** argv) {
     } catch (const std::runtime_error& e) {
         std::cout << e.what() << '\n';
     }
+
+    return mc::Minecraft::GetExitCode();
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Epoch based reclamation. Readers on any thread hold an EpochGuard while they use shared data
+ * and take no lock to do so: entering announces the global epoch in a slot of their own. A writer
+ * unlinks what it replaces and retires it rather than freeing it; a retired object is freed once
+ * the epoch moved on twice, as the epoch only moves on when every reader inside a guard announced
+ * the current one, so by then none can still hold it.
+ *
+ * A reader that stays inside a guard holds the epoch back, and with it every retirement: guards
+ * are for the length of a read, not of a frame.
+ */
+
+namespace mc {
+
+    struct EpochStats {
+        u64 epoch      = 0;
+        u64 guards     = 0; // Guards entered, nested ones not counted
+        u64 advances   = 0;
+        u64 blocked    = 0; // Collections that could not advance the epoch, a reader being behind
+        u64 retired    = 0;
+        u64 freed      = 0;
+        u64 pending    = 0; // Retired and not freed yet
+        u64 maxPending = 0;
+    }; // struct EpochStats
+
+    class EpochDomain {
+    private:
+        static constexpr u32 MAX_THREADS = 128;
+        static constexpr u64 INACTIVE    = 0;
+
+        struct alignas(64) Slot {
+            std::atomic<u64>  epoch{ INACTIVE };
+            std::atomic<u64>  guards{ 0 };
+            std::atomic<bool> bTaken{ false };
+        }; // struct Slot
+
+        // The calling thread's slot, claimed on its first guard and freed when it exits
+        struct ThreadSlot {
+            Slot* pSlot = nullptr;
+            u32   depth = 0;
+
+            ~ThreadSlot() {
+                if (pSlot) {
+                    pSlot->epoch.store(INACTIVE, std::memory_order_release);
+                    pSlot->bTaken.store(false, std::memory_order_release);
+                }
+            }
+        }; // struct ThreadSlot
+
+        struct RetiredBase {
+            virtual ~RetiredBase() = default;
+        }; // struct RetiredBase
+
+        template <typename T>
+        struct Retired final : RetiredBase {
+            T object;
+
+            explicit Retired(T&& object)
+                : object(std::move(object))
+            { }
+        }; // struct Retired
+
+        struct LimboEntry {
+            u64                          epoch;
+            std::unique_ptr<RetiredBase> pRetired;
+        }; // struct LimboEntry
+
+        std::array<Slot, MAX_THREADS> m_slots;
+        std::atomic<u64>              m_epoch{ 1 };
+
+        // Writers only
+        std::mutex             m_mutex;
+        std::deque<LimboEntry> m_limbo; // Oldest first, epochs never decrease
+        EpochStats             m_stats;
+
+    private:
+        EpochDomain() = default;
+
+        static ThreadSlot& GetThread() {
+            thread_local ThreadSlot thread;
+            return thread;
+        }
+
+        Slot& GetThreadSlot() {
+            ThreadSlot& thread = GetThread();
+
+            if (thread.pSlot)
+                return *thread.pSlot;
+
+            for (Slot& slot : m_slots) {
+                bool bFree = false;
+
+                if (slot.bTaken.compare_exchange_strong(bFree, true, std::memory_order_acq_rel)) {
+                    thread.pSlot = &slot;
+                    return slot;
+                }
+            }
+
+            throw std::runtime_error("More threads read through epochs than there are slots");
+        }
+
+        // Called with the lock held
+        void TryAdvance() {
+            u64 epoch = m_epoch.load(std::memory_order_seq_cst);
+
+            for (const Slot& slot : m_slots) {
+                const u64 announced = slot.epoch.load(std::memory_order_seq_cst);
+
+                if (announced != INACTIVE && announced != epoch) {
+                    ++m_stats.blocked;
+                    return;
+                }
+            }
+
+            if (m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst))
+                ++m_stats.advances;
+        }
+
+    public:
+        // Objects from any World can be retired here; it is never destroyed, as they may outlive it
+        static EpochDomain& Get() {
+            static EpochDomain& domain = *new EpochDomain;
+            return domain;
+        }
+
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        void Enter() {
+            if (GetThread().depth++ > 0)
+                return;
+
+            Slot& slot = GetThreadSlot();
+
+            // Seen by the writers before any of the loads the guard protects
+            slot.epoch.exchange(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            slot.guards.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Exit() {
+            ThreadSlot& thread = GetThread();
+
+            if (--thread.depth > 0)
+                return;
+
+            thread.pSlot->epoch.store(INACTIVE, std::memory_order_release);
+        }
+
+        // Takes ownership of what was unlinked: it is destroyed once no guard can still reach it
+        template <typename T>
+        void Retire(T object) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_limbo.push_back(LimboEntry{ m_epoch.load(std::memory_order_seq_cst), std::make_unique<Retired<T>>(std::move(object)) });
+
+            ++m_stats.retired;
+            m_stats.maxPending = std::max<u64>(m_stats.maxPending, m_limbo.size());
+        }
+
+        // Moves the epoch on if the readers allow it and frees what is old enough. Returns the count freed
+        std::size_t Collect() {
+            std::vector<LimboEntry> expired;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                TryAdvance();
+
+                const u64 epoch = m_epoch.load(std::memory_order_seq_cst);
+
+                while (!m_limbo.empty() && m_limbo.front().epoch + 2 <= epoch) {
+                    expired.push_back(std::move(m_limbo.front()));
+                    m_limbo.pop_front();
+                }
+
+                m_stats.freed += expired.size();
+            }
+
+            // Destroyed out of the lock: a retired chunk can hold many sections
+            return expired.size();
+        }
+
+        EpochStats GetStats() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            EpochStats stats = m_stats;
+            stats.epoch   = m_epoch.load(std::memory_order_relaxed);
+            stats.pending = m_limbo.size();
+
+            for (const Slot& slot : m_slots)
+                stats.guards += slot.guards.load(std::memory_order_relaxed);
+
+            return stats;
+        }
+    }; // class EpochDomain
+
+    class EpochGuard {
+    public:
+        EpochGuard()  { EpochDomain::Get().Enter(); }
+        ~EpochGuard() { EpochDomain::Get().Exit();  }
+
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    }; // class EpochGuard
+
+}; // namespace mc
\ No newline at end of file
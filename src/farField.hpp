@@ -0,0 +1,318 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "voxelTree.hpp"
+#include "threadPool.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * The terrain past the meshes' reach, kept in a VoxelTree for the renderer to ray march. Its window
+ * is the square of columns around the camera's chunk, less the ones the meshes draw but for a ring
+ * of overlap, so nothing shows through while the meshes catch up. Columns the world has are encoded
+ * from its sections; the others are generated by a pipeline of the far field's own, as the game's
+ * only runs one Generate call at a time, and are kept encoded only.
+ *
+ * Columns go in batches, nearest first, one at a time: generated and encoded on the thread pool,
+ * set in the tree on the main thread. Block edits reach the tree through the world's dirty sections,
+ * so Update must run before the meshes clear them.
+ */
+
+namespace mc {
+
+    struct FarFieldSettings {
+        i32 radius     = 63; // Chebyshev distance (in chunks) to the window's edge, at most (VoxelTree::GRID_SIDE - 1) / 2
+        i32 meshRadius = 24; // Where the meshes end, LodSettings::ringEnds.back()
+        i32 overlap    = 2;  // Rings of the meshes' columns the far field holds too
+
+        // 96 MB, so the whole tree stays under the 128 MB every device can bind as one storage buffer
+        std::size_t nodeWords = 24u << 20u;
+
+        u32 columnsPerBatch = 64;
+    }; // struct FarFieldSettings
+
+    struct FarFieldStats {
+        std::size_t residentColumns = 0;
+        u64         generatedChunks = 0;
+        u64         batches         = 0;
+        u64         batchUS         = 0; // Summed over the batches, on the pool
+    }; // struct FarFieldStats
+
+    class FarField {
+    private:
+        enum class ColumnState : u8 { eMissing, eQueued, eResident };
+
+        // One per grid column, for whichever column of the window falls on it
+        struct ColumnSlot {
+            ChunkCoord  coord{ 0, 0 };
+            ColumnState state = ColumnState::eMissing;
+        }; // struct ColumnSlot
+
+        struct QueuedColumn {
+            ChunkCoord coord;
+            bool       bFromWorld = false;
+
+            // The world's, shared: an edit on the main thread copies the section first
+            std::array<std::shared_ptr<ChunkSection>, MC_CHUNK_SECTION_COUNT> sections;
+        }; // struct QueuedColumn
+
+        struct Batch {
+            std::vector<QueuedColumn>   columns;
+            std::vector<EncodedSection> encoded; // MC_CHUNK_SECTION_COUNT per column, in the columns' order
+            u64                         generated = 0;
+            u64                         elapsedUS = 0;
+        }; // struct Batch
+
+        FarFieldSettings   m_settings;
+        VoxelTree          m_tree;
+        GenerationPipeline m_generation;
+
+        std::vector<ColumnSlot>   m_slots;
+        std::optional<ChunkCoord> m_centre;
+        std::size_t               m_worldChunks = 0; // When the world's count changes, columns may have come into the meshes' reach
+        i32                       m_scanRing    = 0; // The rings before have no wanted column missing
+
+        std::future<Batch> m_batch;
+        FarFieldStats      m_stats;
+
+    private:
+        inline ColumnSlot& Slot(const ChunkCoord coord) {
+            constexpr i32 MASK = static_cast<i32>(VoxelTree::GRID_SIDE) - 1;
+
+            return m_slots[static_cast<std::size_t>((coord.z & MASK) * static_cast<i32>(VoxelTree::GRID_SIDE) + (coord.x & MASK))];
+        }
+
+        bool IsWanted(const World& world, const ChunkCoord coord) const {
+            const i32 distance = std::max(std::abs(coord.x - m_centre->x), std::abs(coord.z - m_centre->z));
+
+            return distance <= m_settings.radius && (distance >= m_settings.meshRadius - m_settings.overlap || !world.GetChunk(coord));
+        }
+
+        void ClearColumn(const ChunkCoord coord) {
+            for (i32 y = 0; y < static_cast<i32>(MC_CHUNK_SECTION_COUNT); ++y)
+                m_tree.ClearSection(vec3i32{ coord.x, y, coord.z });
+        }
+
+        // Re-encodes a section of a resident column from the world, if it has it and it changed
+        void Refresh(const World& world, const vec3i32& section) {
+            const Chunk* pChunk = world.GetChunk(ChunkCoord{ section.x, section.z });
+
+            if (!pChunk)
+                return;
+
+            const ChunkSection* pSection = pChunk->GetSection(static_cast<u32>(section.y));
+            const u64           hash     = pSection && !pSection->IsEmpty() ? pSection->GetHash() : 0;
+
+            if (hash != m_tree.GetSectionHash(section))
+                m_tree.SetSection(VoxelTree::EncodeSection(section, pSection));
+        }
+
+        void DropUnwanted(const World& world) {
+            for (ColumnSlot& slot : m_slots) {
+                if (slot.state == ColumnState::eMissing || IsWanted(world, slot.coord))
+                    continue;
+
+                if (slot.state == ColumnState::eResident) {
+                    ClearColumn(slot.coord);
+                    --m_stats.residentColumns;
+                }
+
+                // A queued column is dropped with its batch
+                slot.state = ColumnState::eMissing;
+            }
+
+            m_scanRing = 0;
+        }
+
+        void Install(const World& world, Batch batch) {
+            for (std::size_t i = 0; i < batch.columns.size(); ++i) {
+                const ChunkCoord coord = batch.columns[i].coord;
+                ColumnSlot&      slot  = Slot(coord);
+
+                if (slot.coord != coord || slot.state != ColumnState::eQueued)
+                    continue;
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+                    m_tree.SetSection(batch.encoded[i * MC_CHUNK_SECTION_COUNT + y]);
+
+                // Edited since it was taken, its dirty sections maybe already cleared
+                if (batch.columns[i].bFromWorld)
+                    for (i32 y = 0; y < static_cast<i32>(MC_CHUNK_SECTION_COUNT); ++y)
+                        Refresh(world, vec3i32{ coord.x, y, coord.z });
+
+                slot.state = ColumnState::eResident;
+                ++m_stats.residentColumns;
+            }
+
+            ++m_stats.batches;
+            m_stats.generatedChunks += batch.generated;
+            m_stats.batchUS         += batch.elapsedUS;
+        }
+
+        // On the pool
+        Batch Build(Batch batch) {
+            const Timer timer;
+
+            std::vector<Chunk>  chunks;
+            std::vector<Chunk*> generated;
+
+            chunks.reserve(batch.columns.size());
+
+            for (const QueuedColumn& column : batch.columns) {
+                if (column.bFromWorld)
+                    continue;
+
+                chunks.emplace_back(column.coord);
+                generated.push_back(&chunks.back());
+            }
+
+            m_generation.Generate(generated);
+
+            batch.encoded.reserve(batch.columns.size() * MC_CHUNK_SECTION_COUNT);
+
+            for (std::size_t i = 0, g = 0; i < batch.columns.size(); ++i) {
+                QueuedColumn& column = batch.columns[i];
+
+                if (!column.bFromWorld) {
+                    for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+                        column.sections[y] = chunks[g].GetSectionPtr(y);
+
+                    ++g;
+                }
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+                    batch.encoded.push_back(VoxelTree::EncodeSection(vec3i32{ column.coord.x, static_cast<i32>(y), column.coord.z }, column.sections[y].get()));
+
+                column.sections = {};
+            }
+
+            batch.generated = generated.size();
+            batch.elapsedUS = timer.GetElapsedUS();
+
+            return batch;
+        }
+
+        // Returns false once the batch is full
+        bool TryQueue(const World& world, const ChunkCoord coord, Batch& batch) {
+            ColumnSlot& slot = Slot(coord);
+
+            if ((slot.coord == coord && slot.state != ColumnState::eMissing) || !IsWanted(world, coord))
+                return true;
+
+            if (batch.columns.size() >= m_settings.columnsPerBatch)
+                return false;
+
+            QueuedColumn column;
+            column.coord = coord;
+
+            if (const Chunk* pChunk = world.GetChunk(coord)) {
+                column.bFromWorld = true;
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y)
+                    column.sections[y] = pChunk->GetSectionPtr(y);
+            }
+
+            batch.columns.push_back(std::move(column));
+
+            slot.coord = coord;
+            slot.state = ColumnState::eQueued;
+
+            return true;
+        }
+
+        // The missing columns nearest to the centre first, ring by ring
+        void QueueBatch(const World& world, ThreadPool& pool) {
+            Batch batch;
+
+            for (; m_scanRing <= m_settings.radius; ++m_scanRing) {
+                const i32 r = m_scanRing;
+                bool      bRingDone = true;
+
+                if (r == 0) {
+                    bRingDone = TryQueue(world, m_centre.value(), batch);
+                } else {
+                    for (i32 d = -r; d <= r && bRingDone; ++d) {
+                        bRingDone = TryQueue(world, ChunkCoord{ m_centre->x + d, m_centre->z - r }, batch) && bRingDone;
+                        bRingDone = TryQueue(world, ChunkCoord{ m_centre->x + d, m_centre->z + r }, batch) && bRingDone;
+                    }
+
+                    for (i32 d = -r + 1; d < r && bRingDone; ++d) {
+                        bRingDone = TryQueue(world, ChunkCoord{ m_centre->x - r, m_centre->z + d }, batch) && bRingDone;
+                        bRingDone = TryQueue(world, ChunkCoord{ m_centre->x + r, m_centre->z + d }, batch) && bRingDone;
+                    }
+                }
+
+                if (!bRingDone)
+                    break;
+            }
+
+            if (batch.columns.empty())
+                return;
+
+            m_batch = pool.Submit([this, batch = std::move(batch)]() mutable { return Build(std::move(batch)); });
+        }
+
+    public:
+        explicit FarField(const WorldGenerator& generator, ThreadPool& pool, const FarFieldSettings& settings = FarFieldSettings{})
+            : m_settings(settings),
+              m_tree(settings.nodeWords),
+              m_generation(generator, pool, 1024),
+              m_slots(VoxelTree::GRID_SIDE * VoxelTree::GRID_SIDE)
+        {
+            m_settings.radius = std::clamp(m_settings.radius, 0, static_cast<i32>(VoxelTree::GRID_SIDE - 1) / 2);
+        }
+
+        FarField(const FarField&) = delete;
+        FarField& operator=(const FarField&) = delete;
+
+        // The batch in flight uses the pipeline and the members
+        ~FarField() {
+            if (m_batch.valid())
+                m_batch.wait();
+        }
+
+        // On the main thread, once per frame before the meshes' update
+        void Update(const World& world, const vec3f32& cameraPosition, ThreadPool& pool) {
+            const ChunkCoord centre{ WorldToChunk(static_cast<i32>(std::floor(cameraPosition.x))), WorldToChunk(static_cast<i32>(std::floor(cameraPosition.z))) };
+
+            if (m_centre != centre || m_worldChunks != world.GetChunkCount()) {
+                m_centre      = centre;
+                m_worldChunks = world.GetChunkCount();
+
+                DropUnwanted(world);
+            }
+
+            if (m_batch.valid() && m_batch.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                Install(world, m_batch.get());
+
+            for (const vec3i32& section : world.GetDirtySections()) {
+                ColumnSlot& slot = Slot(ChunkCoord{ section.x, section.z });
+
+                if (slot.coord == ChunkCoord{ section.x, section.z } && slot.state == ColumnState::eResident)
+                    Refresh(world, section);
+            }
+
+            if (!m_batch.valid())
+                QueueBatch(world, pool);
+        }
+
+        // Whether every wanted column is in the tree
+        inline bool IsComplete() const { return !m_batch.valid() && m_scanRing > m_settings.radius; }
+
+        inline ChunkCoord GetWindowLo() const {
+            const ChunkCoord centre = m_centre.value_or(ChunkCoord{ 0, 0 });
+
+            return ChunkCoord{ centre.x - m_settings.radius, centre.z - m_settings.radius };
+        }
+
+        inline i32 GetWindowChunks() const { return m_settings.radius * 2 + 1; }
+
+        inline VoxelTree&              GetTree()           { return m_tree; }
+        inline const VoxelTree&        GetTree()     const { return m_tree; }
+        inline const FarFieldSettings& GetSettings() const { return m_settings; }
+        inline const FarFieldStats&    GetStats()    const { return m_stats; }
+    }; // class FarField
+
+}; // namespace mc
\ No newline at end of file
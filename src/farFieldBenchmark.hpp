@@ -0,0 +1,371 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "camera.hpp"
+#include "farField.hpp"
+#include "fileUtils.hpp"
+#include "gpuMemory.hpp"
+#include "threadPool.hpp"
+#include "vulkanUtils.hpp"
+#include "farFieldPass.hpp"
+#include "worldGenerator.hpp"
+
+/*
+ * Milliseconds per frame of the far field's ray march at 1280 x 720, on a device of its own so no
+ * window is needed and software drivers such as lavapipe run it too. The far field first streams
+ * its whole window of generated terrain around a camera above the spawn, which is reported but not
+ * timed with the frames. The camera then turns a full circle over the frames, looking slightly
+ * down. Each frame is one dispatch submitted and waited for alone: the wall time is what a frame
+ * pays, the timestamps the GPU's share where the queue has them. The first frame uploads the whole
+ * tree, so it is reported apart.
+ *
+ * Last, the depth image is read back and checked against VoxelTree::Raycast on a grid of pixels, so
+ * a shader gone out of sync with the CPU's march shows up as mismatches. Rays grazing an edge may
+ * tie differently in the two, a few mismatches are expected.
+ */
+
+namespace mc {
+
+    class FarFieldBenchmark {
+    private:
+        static constexpr u64 SEED         = 0x4661724669656C64ull;
+        static constexpr u32 WIDTH        = 1280;
+        static constexpr u32 HEIGHT       = 720;
+        static constexpr f32 ALTITUDE     = 48.f;  // Above the terrain at the spawn
+        static constexpr f32 PITCH        = -0.2f;
+        static constexpr u32 CHECK_STRIDE = 40;    // Pixels between the ones checked, both ways
+
+        struct FrameResult {
+            u64                wallNS = 0;
+            std::optional<u64> gpuNS;
+        }; // struct FrameResult
+
+        vk::Instance       m_instance;
+        vk::PhysicalDevice m_physical;
+        vk::Device         m_device;
+        vk::Queue          m_queue;
+        u32                m_queueFamily   = 0;
+        u32                m_timestampBits = 0;
+
+        vk::CommandPool   m_commandPool;
+        vk::CommandBuffer m_cmdBuff;
+        vk::Fence         m_fence;
+        vk::QueryPool     m_timestampPool;
+
+    private:
+        // The pass' barriers name the fragment stage the renderer reads its images in, so graphics as well as compute
+        static std::optional<u32> FindQueueFamily(const vk::PhysicalDevice& physical) {
+            const std::vector<vk::QueueFamilyProperties> families = physical.getQueueFamilyProperties();
+
+            for (u32 i = 0; i < families.size(); ++i)
+                if (families[i].queueCount > 0 && (families[i].queueFlags & vk::QueueFlagBits::eGraphics) && (families[i].queueFlags & vk::QueueFlagBits::eCompute))
+                    return i;
+
+            return {};
+        }
+
+        void Submit() {
+            vk::SubmitInfo submitInfo{};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers    = &m_cmdBuff;
+
+            m_queue.submit(submitInfo, m_fence);
+
+            if (m_device.waitForFences(m_fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+                throw std::runtime_error("Failed to wait for the far field benchmark's frame");
+
+            m_device.resetFences(m_fence);
+        }
+
+        FrameResult RunFrame(FarFieldPass& pass, FarField& farField, const Camera& camera) {
+            pass.Upload(farField.GetTree(), 0);
+
+            m_cmdBuff.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+            if (m_timestampPool) {
+                m_cmdBuff.resetQueryPool(m_timestampPool, 0, 2);
+                m_cmdBuff.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_timestampPool, 0);
+            }
+
+            pass.Record(m_cmdBuff, FarFieldPass::MakePushConstants(camera.GetView(), camera.GetProjection(static_cast<f32>(WIDTH) / HEIGHT), camera.GetPosition(), farField.GetWindowLo(), farField.GetWindowChunks()));
+
+            if (m_timestampPool)
+                m_cmdBuff.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_timestampPool, 1);
+
+            m_cmdBuff.end();
+
+            FrameResult result;
+
+            const Timer timer;
+            Submit();
+            result.wallNS = timer.GetElapsedNS();
+
+            std::array<u64, 2> ticks{};
+            if (m_timestampPool && m_device.getQueryPoolResults(m_timestampPool, 0, 2, sizeof(ticks), ticks.data(), sizeof(u64), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess) {
+                const u64 mask = m_timestampBits >= 64 ? ~u64{ 0 } : (u64{ 1 } << m_timestampBits) - 1;
+
+                result.gpuNS = static_cast<u64>(static_cast<f64>((ticks[1] - ticks[0]) & mask) * m_physical.getProperties().limits.timestampPeriod);
+            }
+
+            return result;
+        }
+
+        // The depth the pass should have written at a pixel, with the depths a block nearer and farther as the tolerance
+        static std::optional<std::array<f32, 3>> ExpectedDepth(const FarField& farField, const Camera& camera, const FarFieldPushConstants& constants, const u32 x, const u32 y) {
+            const vec4f32 ndc{ (static_cast<f32>(x) + 0.5f) / WIDTH * 2.f - 1.f, (static_cast<f32>(y) + 0.5f) / HEIGHT * 2.f - 1.f, 1.f, 1.f };
+            const vec4f32 point = constants.inverseViewProjection * ndc;
+            const vec3f32 d     = Normalize(vec3f32{ point.x / point.w, point.y / point.w, point.z / point.w });
+
+            const std::optional<VoxelTreeHit> hit = farField.GetTree().Raycast(camera.GetPosition(), d, constants.origin.w, farField.GetWindowLo(), farField.GetWindowChunks());
+
+            if (!hit.has_value())
+                return {};
+
+            const auto Depth = [&](const f32 t) {
+                const vec4f32 p{ d.x * t * FarFieldPass::DEPTH_BIAS, d.y * t * FarFieldPass::DEPTH_BIAS, d.z * t * FarFieldPass::DEPTH_BIAS, 1.f };
+
+                return Dot(constants.depthRowZ, p) / Dot(constants.depthRowW, p);
+            };
+
+            return std::array<f32, 3>{ Depth(std::max(hit->distance - 1.f, 0.f)), Depth(hit->distance), Depth(hit->distance + 1.f) };
+        }
+
+        // Returns the pixels checked and the mismatches among them
+        std::pair<u32, u32> CheckDepth(FarFieldPass& pass, FarField& farField, const Camera& camera) {
+            constexpr vk::DeviceSize BYTES = vk::DeviceSize{ WIDTH } * HEIGHT * sizeof(f32);
+
+            vk::BufferCreateInfo bci{};
+            bci.size        = BYTES;
+            bci.usage       = vk::BufferUsageFlagBits::eTransferDst;
+            bci.sharingMode = vk::SharingMode::eExclusive;
+
+            const vk::Buffer             buffer       = m_device.createBuffer(bci);
+            const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(buffer);
+
+            vk::MemoryAllocateInfo allocationInfo{};
+            allocationInfo.allocationSize  = requirements.size;
+            allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(m_physical.getMemoryProperties(), requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+            const vk::DeviceMemory memory = GpuMemory::Allocate(m_device, allocationInfo);
+            m_device.bindBufferMemory(buffer, memory, 0);
+
+            const FarFieldPushConstants constants = FarFieldPass::MakePushConstants(camera.GetView(), camera.GetProjection(static_cast<f32>(WIDTH) / HEIGHT), camera.GetPosition(), farField.GetWindowLo(), farField.GetWindowChunks());
+
+            m_cmdBuff.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+            pass.Record(m_cmdBuff, constants);
+
+            vk::BufferImageCopy region{};
+            region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = vk::Extent3D{ WIDTH, HEIGHT, 1 };
+
+            m_cmdBuff.copyImageToBuffer(pass.GetDepthImage(), vk::ImageLayout::eGeneral, buffer, region);
+
+            vk::MemoryBarrier barrier{};
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+
+            m_cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, barrier, nullptr, nullptr);
+            m_cmdBuff.end();
+
+            Submit();
+
+            const f32* const pDepths = static_cast<const f32*>(m_device.mapMemory(memory, 0, BYTES));
+
+            u32 checked    = 0;
+            u32 mismatches = 0;
+
+            for (u32 y = CHECK_STRIDE / 2; y < HEIGHT; y += CHECK_STRIDE) {
+                for (u32 x = CHECK_STRIDE / 2; x < WIDTH; x += CHECK_STRIDE) {
+                    const f32                               depth    = pDepths[y * WIDTH + x];
+                    const std::optional<std::array<f32, 3>> expected = ExpectedDepth(farField, camera, constants, x, y);
+
+                    const bool bMatch = expected.has_value() ? depth >= (*expected)[0] && depth <= (*expected)[2] : depth >= 1.f;
+
+                    ++checked;
+                    mismatches += bMatch ? 0 : 1;
+                }
+            }
+
+            m_device.unmapMemory(memory);
+            m_device.destroyBuffer(buffer);
+            GpuMemory::Free(m_device, memory);
+
+            return { checked, mismatches };
+        }
+
+    public:
+        FarFieldBenchmark() {
+            vk::ApplicationInfo appInfo{};
+            appInfo.apiVersion         = MC_VULKAN_VERSION;
+            appInfo.applicationVersion = MC_APPLICATION_VERSION;
+            appInfo.engineVersion      = MC_APPLICATION_VERSION;
+            appInfo.pApplicationName   = "Minecraft far field benchmark";
+            appInfo.pEngineName        = "F. Weiss <3";
+
+            vk::InstanceCreateInfo instanceCI{};
+            instanceCI.pApplicationInfo = &appInfo;
+
+            m_instance = vk::createInstance(instanceCI);
+
+            for (const vk::PhysicalDevice& physical : m_instance.enumeratePhysicalDevices()) {
+                const std::optional<u32> family = FindQueueFamily(physical);
+
+                if (family.has_value()) {
+                    m_physical    = physical;
+                    m_queueFamily = family.value();
+                    break;
+                }
+            }
+
+            if (!m_physical)
+                throw std::runtime_error("No Vulkan device with a graphics and compute queue was found");
+
+            const f32 priority = 1.f;
+
+            vk::DeviceQueueCreateInfo dqci{};
+            dqci.queueFamilyIndex = m_queueFamily;
+            dqci.queueCount       = 1;
+            dqci.pQueuePriorities = &priority;
+
+            vk::DeviceCreateInfo deviceCI{};
+            deviceCI.queueCreateInfoCount = 1;
+            deviceCI.pQueueCreateInfos    = &dqci;
+
+            m_device = m_physical.createDevice(deviceCI);
+            m_queue  = m_device.getQueue(m_queueFamily, 0);
+
+            GpuMemory::Startup(m_instance, m_physical, false);
+
+            vk::CommandPoolCreateInfo cpci{};
+            cpci.flags            = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+            cpci.queueFamilyIndex = m_queueFamily;
+
+            m_commandPool = m_device.createCommandPool(cpci);
+
+            vk::CommandBufferAllocateInfo cbai{};
+            cbai.commandPool        = m_commandPool;
+            cbai.level              = vk::CommandBufferLevel::ePrimary;
+            cbai.commandBufferCount = 1;
+
+            m_cmdBuff = m_device.allocateCommandBuffers(cbai)[0];
+            m_fence   = m_device.createFence(vk::FenceCreateInfo{});
+
+            m_timestampBits = m_physical.getQueueFamilyProperties()[m_queueFamily].timestampValidBits;
+
+            if (m_timestampBits > 0) {
+                vk::QueryPoolCreateInfo qpci{};
+                qpci.queryType  = vk::QueryType::eTimestamp;
+                qpci.queryCount = 2;
+
+                m_timestampPool = m_device.createQueryPool(qpci);
+            }
+        }
+
+        FarFieldBenchmark(const FarFieldBenchmark&) = delete;
+        FarFieldBenchmark& operator=(const FarFieldBenchmark&) = delete;
+
+        inline std::string GetDeviceName() const { return m_physical.getProperties().deviceName.data(); }
+
+        // res/shaders/farField.comp.spv must have been built, it is all the benchmark runs
+        static void RunAll(const u32 frames, ThreadPool& pool, std::ostream& out) {
+            const std::optional<std::vector<char>> compCode = ReadBinaryFileToBuffer("res/shaders/farField.comp.spv");
+
+            if (!compCode.has_value()) {
+                out << "[BENCHMARK] res/shaders/farField.comp.spv was not built, the far field cannot be measured\n" << std::flush;
+                return;
+            }
+
+            FarFieldBenchmark benchmark;
+
+            out << "[BENCHMARK] " << frames << " far field frames of " << WIDTH << " x " << HEIGHT << " on " << benchmark.GetDeviceName() << '\n' << std::flush;
+
+            // No world: every column is generated, the far field holding the meshes' reach too
+            const WorldGenerator generator(SEED);
+            World                world;
+
+            FarFieldSettings settings;
+            settings.meshRadius = 0;
+
+            FarField farField(generator, pool, settings);
+
+            Camera camera;
+            camera.SetPosition(vec3f32{ 0.5f, static_cast<f32>(generator.GetTerrainHeight(0, 0)) + ALTITUDE, 0.5f });
+            camera.SetRotation(0.f, PITCH);
+
+            const Timer streamTimer;
+
+            while (!farField.IsComplete()) {
+                farField.Update(world, camera.GetPosition(), pool);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            const VoxelTreeStats tree  = farField.GetTree().GetStats();
+            const std::size_t    dirty = std::accumulate(farField.GetTree().GetDirtyRanges().begin(), farField.GetTree().GetDirtyRanges().end(), std::size_t{ 0 }, [](const std::size_t sum, const ByteRange& range) { return sum + range.size; });
+
+            out << "[BENCHMARK] " << farField.GetWindowChunks() << " x " << farField.GetWindowChunks() << " columns streamed in " << streamTimer.GetElapsedMS() << " ms, "
+                << farField.GetStats().generatedChunks << " generated | " << tree.nodes << " nodes, " << tree.solid << " solid sections, " << tree.nodeBytes / (1024 * 1024) << " MB of nodes"
+                << (tree.dropped > 0 ? ", " + std::to_string(tree.dropped) + " sections dropped" : std::string()) << '\n';
+
+            {
+                FarFieldPass pass(benchmark.m_device, benchmark.m_physical.getMemoryProperties(), compCode.value(), farField.GetTree().GetByteSize(), vk::Extent2D{ WIDTH, HEIGHT });
+
+                const FrameResult first = benchmark.RunFrame(pass, farField, camera);
+
+                out << "[BENCHMARK] first frame " << std::fixed << std::setprecision(2) << static_cast<f64>(first.wallNS) / 1e6 << " ms, uploading " << dirty / (1024 * 1024) << " MB\n";
+
+                u64 wallNS    = 0;
+                u64 bestNS    = UINT64_MAX;
+                u64 worstNS   = 0;
+                u64 gpuNS     = 0;
+                u32 gpuFrames = 0;
+
+                for (u32 i = 0; i < frames; ++i) {
+                    camera.SetRotation(6.2831853f * static_cast<f32>(i) / static_cast<f32>(frames), PITCH);
+
+                    const FrameResult frame = benchmark.RunFrame(pass, farField, camera);
+
+                    wallNS    += frame.wallNS;
+                    bestNS     = std::min(bestNS, frame.wallNS);
+                    worstNS    = std::max(worstNS, frame.wallNS);
+                    gpuNS     += frame.gpuNS.value_or(0);
+                    gpuFrames += frame.gpuNS.has_value() ? 1 : 0;
+                }
+
+                const f64 count = static_cast<f64>(std::max(frames, 1u));
+
+                out << "[BENCHMARK] per frame " << std::setw(8) << static_cast<f64>(wallNS) / count / 1e6 << " ms"
+                    << " | best "  << std::setw(8) << static_cast<f64>(frames > 0 ? bestNS : 0) / 1e6 << " ms"
+                    << " | worst " << std::setw(8) << static_cast<f64>(worstNS) / 1e6 << " ms"
+                    << " | gpu ";
+
+                if (gpuFrames > 0)
+                    out << std::setw(8) << static_cast<f64>(gpuNS) / gpuFrames / 1e6 << " ms\n";
+                else
+                    out << "unavailable\n";
+
+                const auto [checked, mismatches] = benchmark.CheckDepth(pass, farField, camera);
+
+                out << "[BENCHMARK] depth checked against VoxelTree::Raycast at " << checked << " pixels, " << mismatches << " mismatches\n";
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+
+        ~FarFieldBenchmark() {
+            m_device.waitIdle();
+
+            if (m_timestampPool)
+                m_device.destroyQueryPool(m_timestampPool);
+
+            m_device.destroyFence(m_fence);
+            m_device.destroyCommandPool(m_commandPool);
+            m_device.destroy();
+            m_instance.destroy();
+        }
+    }; // class FarFieldBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,365 @@
+#pragma once
+
+#include "header.hpp"
+#include "chunk.hpp"
+#include "matrix.hpp"
+#include "uniforms.hpp"
+#include "gpuMemory.hpp"
+#include "voxelTree.hpp"
+#include "vulkanUtils.hpp"
+#include "stagingBuffer.hpp"
+
+/*
+ * The far field's GPU side: the VoxelTree in a device local storage buffer, and a compute pipeline
+ * ray marching it once per pixel into a colour and a depth image. The images stay in the general
+ * layout, written by the dispatch and read by whatever draws them, the renderer's depth composite or
+ * the benchmark's readback. Only the tree's dirty ranges are uploaded, through a staging buffer per
+ * frame in flight grown as needed.
+ *
+ * Made from a device alone, so the headless benchmark runs it without a window.
+ */
+
+namespace mc {
+
+    class FarFieldPass {
+    public:
+        static constexpr u32 GROUP_SIZE = 8;      // Per side, as res/shaders/farField.comp's local size
+        static constexpr f32 DEPTH_BIAS = 1.002f; // As res/shaders/farField.comp's, which pushes its hits back for the meshes to win ties
+
+    private:
+        struct Target {
+            vk::Image        image;
+            vk::DeviceMemory memory;
+            vk::ImageView    view;
+        }; // struct Target
+
+        vk::Device                         m_device;
+        vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+        vk::Extent2D                       m_extent;
+
+        vk::Buffer       m_treeBuffer;
+        vk::DeviceMemory m_treeMemory;
+        vk::DeviceSize   m_treeBytes;
+
+        std::array<mc::StagingBuffer, MC_MAX_FRAMES_IN_FLIGHT> m_stagingBuffers;
+        std::vector<vk::BufferCopy>                            m_copies; // Uploaded, to be recorded by the next Record
+        u32                                                    m_copyFrame = 0;
+
+        Target m_color;
+        Target m_depth;
+
+        vk::DescriptorSetLayout m_setLayout;
+        vk::DescriptorPool      m_descriptorPool;
+        vk::DescriptorSet       m_set;
+        vk::PipelineLayout      m_pipelineLayout;
+        vk::Pipeline            m_pipeline;
+
+    private:
+        Target CreateTarget(const vk::Format format) const {
+            Target target;
+
+            vk::ImageCreateInfo ici{};
+            ici.imageType     = vk::ImageType::e2D;
+            ici.extent        = vk::Extent3D{ m_extent.width, m_extent.height, 1 };
+            ici.mipLevels     = 1;
+            ici.arrayLayers   = 1;
+            ici.format        = format;
+            ici.tiling        = vk::ImageTiling::eOptimal;
+            ici.initialLayout = vk::ImageLayout::eUndefined;
+            ici.usage         = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc;
+            ici.samples       = vk::SampleCountFlagBits::e1;
+            ici.sharingMode   = vk::SharingMode::eExclusive;
+
+            target.image = m_device.createImage(ici);
+
+            const vk::MemoryRequirements requirements = m_device.getImageMemoryRequirements(target.image);
+
+            vk::MemoryAllocateInfo allocationInfo{};
+            allocationInfo.allocationSize  = requirements.size;
+            allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(m_memoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            target.memory = mc::GpuMemory::Allocate(m_device, allocationInfo);
+            m_device.bindImageMemory(target.image, target.memory, 0);
+
+            vk::ImageViewCreateInfo ivci{};
+            ivci.image                       = target.image;
+            ivci.viewType                    = vk::ImageViewType::e2D;
+            ivci.format                      = format;
+            ivci.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+            ivci.subresourceRange.levelCount = 1;
+            ivci.subresourceRange.layerCount = 1;
+
+            target.view = m_device.createImageView(ivci);
+
+            return target;
+        }
+
+        void DestroyTarget(const Target& target) const {
+            m_device.destroyImageView(target.view);
+            m_device.destroyImage(target.image);
+            mc::GpuMemory::Free(m_device, target.memory);
+        }
+
+        void CreateTreeBuffer() {
+            vk::BufferCreateInfo bci{};
+            bci.size        = m_treeBytes;
+            bci.usage       = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+            bci.sharingMode = vk::SharingMode::eExclusive;
+
+            m_treeBuffer = m_device.createBuffer(bci);
+
+            const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(m_treeBuffer);
+
+            vk::MemoryAllocateInfo allocationInfo{};
+            allocationInfo.allocationSize  = requirements.size;
+            allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(m_memoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            m_treeMemory = mc::GpuMemory::Allocate(m_device, allocationInfo);
+            m_device.bindBufferMemory(m_treeBuffer, m_treeMemory, 0);
+        }
+
+        // Binding 0 is the tree, 1 and 2 the colour and the depth, which the composite's fragments read too
+        void CreateDescriptors() {
+            std::array<vk::DescriptorSetLayoutBinding, 3> bindings{};
+
+            for (u32 i = 0; i < bindings.size(); ++i) {
+                bindings[i].binding         = i;
+                bindings[i].descriptorType  = i == 0 ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eStorageImage;
+                bindings[i].descriptorCount = 1;
+                bindings[i].stageFlags      = i == 0 ? vk::ShaderStageFlagBits::eCompute : vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eFragment;
+            }
+
+            vk::DescriptorSetLayoutCreateInfo dslci{};
+            dslci.bindingCount = static_cast<u32>(bindings.size());
+            dslci.pBindings    = bindings.data();
+
+            m_setLayout = m_device.createDescriptorSetLayout(dslci);
+
+            const std::array poolSizes = {
+                vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, 1 },
+                vk::DescriptorPoolSize{ vk::DescriptorType::eStorageImage,  2 }
+            };
+
+            vk::DescriptorPoolCreateInfo dpci{};
+            dpci.maxSets       = 1;
+            dpci.poolSizeCount = static_cast<u32>(poolSizes.size());
+            dpci.pPoolSizes    = poolSizes.data();
+
+            m_descriptorPool = m_device.createDescriptorPool(dpci);
+
+            vk::DescriptorSetAllocateInfo dsai{};
+            dsai.descriptorPool     = m_descriptorPool;
+            dsai.descriptorSetCount = 1;
+            dsai.pSetLayouts        = &m_setLayout;
+
+            m_set = m_device.allocateDescriptorSets(dsai)[0];
+
+            const vk::DescriptorBufferInfo bufferInfo{ m_treeBuffer, 0, VK_WHOLE_SIZE };
+            const vk::DescriptorImageInfo  colorInfo{ vk::Sampler{}, m_color.view, vk::ImageLayout::eGeneral };
+            const vk::DescriptorImageInfo  depthInfo{ vk::Sampler{}, m_depth.view, vk::ImageLayout::eGeneral };
+
+            std::array<vk::WriteDescriptorSet, 3> writes{};
+
+            for (u32 i = 0; i < writes.size(); ++i) {
+                writes[i].dstSet          = m_set;
+                writes[i].dstBinding      = i;
+                writes[i].descriptorType  = bindings[i].descriptorType;
+                writes[i].descriptorCount = 1;
+            }
+
+            writes[0].pBufferInfo = &bufferInfo;
+            writes[1].pImageInfo  = &colorInfo;
+            writes[2].pImageInfo  = &depthInfo;
+
+            m_device.updateDescriptorSets(writes, nullptr);
+        }
+
+        void CreatePipeline(const std::vector<char>& compCode) {
+            vk::PushConstantRange pushConstantRange{};
+            pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+            pushConstantRange.offset     = 0;
+            pushConstantRange.size       = sizeof(mc::FarFieldPushConstants);
+
+            vk::PipelineLayoutCreateInfo plci{};
+            plci.setLayoutCount         = 1;
+            plci.pSetLayouts            = &m_setLayout;
+            plci.pushConstantRangeCount = 1;
+            plci.pPushConstantRanges    = &pushConstantRange;
+
+            m_pipelineLayout = m_device.createPipelineLayout(plci);
+            m_pipeline       = BuildPipeline(compCode);
+        }
+
+    public:
+        /*
+         * The camera relative view keeps only the rotation, as the pass starts rays at the camera:
+         * the depth rows then give the same depth the meshes get from the full view projection.
+         */
+        static mc::FarFieldPushConstants MakePushConstants(const mc::mat4f32& view, const mc::mat4f32& projection, const mc::vec3f32& cameraPosition, const mc::ChunkCoord windowLo, const i32 windowChunks) {
+            constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+            mc::mat4f32 rotation = view;
+            rotation.columns[3]  = mc::vec4f32{ 0.f, 0.f, 0.f, 1.f };
+
+            const mc::mat4f32 viewProjection = projection * rotation;
+            const mc::mat4f32 rows           = Transpose(viewProjection);
+
+            // The window's diagonal over the whole height: past it every ray left the window
+            const f32 side = static_cast<f32>(windowChunks * S);
+
+            mc::FarFieldPushConstants constants{};
+            constants.inverseViewProjection = Inverse(viewProjection);
+            constants.depthRowZ             = rows.columns[2];
+            constants.depthRowW             = rows.columns[3];
+            constants.origin                = mc::vec4f32{ cameraPosition.x - static_cast<f32>(windowLo.x * S), cameraPosition.y, cameraPosition.z - static_cast<f32>(windowLo.z * S), std::sqrt(2.f * side * side + static_cast<f32>(MC_CHUNK_HEIGHT * MC_CHUNK_HEIGHT)) };
+            constants.window[0]             = windowLo.x;
+            constants.window[1]             = windowLo.z;
+            constants.window[2]             = windowChunks;
+
+            return constants;
+        }
+
+        FarFieldPass(const vk::Device& device, const vk::PhysicalDeviceMemoryProperties& memoryProperties, const std::vector<char>& compCode, const vk::DeviceSize treeBytes, const vk::Extent2D extent)
+            : m_device(device), m_memoryProperties(memoryProperties), m_extent(extent), m_treeBytes(treeBytes)
+        {
+            CreateTreeBuffer();
+
+            m_color = CreateTarget(vk::Format::eR8G8B8A8Unorm);
+            m_depth = CreateTarget(vk::Format::eR32Sfloat);
+
+            CreateDescriptors();
+            CreatePipeline(compCode);
+        }
+
+        FarFieldPass(const FarFieldPass&) = delete;
+        FarFieldPass& operator=(const FarFieldPass&) = delete;
+
+        // A pipeline of the pass' layout, from any thread: the pass' own, or a hot reloaded one for ReplacePipeline
+        vk::Pipeline BuildPipeline(const std::vector<char>& compCode) const {
+            vk::ShaderModuleCreateInfo smci{};
+            smci.codeSize = compCode.size();
+            smci.pCode    = reinterpret_cast<const mc::u32*>(compCode.data());
+
+            const vk::ShaderModule module = m_device.createShaderModule(smci);
+
+            vk::ComputePipelineCreateInfo cpci{};
+            cpci.stage.stage  = vk::ShaderStageFlagBits::eCompute;
+            cpci.stage.module = module;
+            cpci.stage.pName  = "main";
+            cpci.layout       = m_pipelineLayout;
+
+            const vk::Pipeline pipeline = m_device.createComputePipeline({}, cpci).value;
+
+            m_device.destroyShaderModule(module);
+
+            return pipeline;
+        }
+
+        // Records with the given pipeline from now on. Returns the replaced one, for the caller to destroy once
+        // the submissions recording it are done
+        inline vk::Pipeline ReplacePipeline(const vk::Pipeline pipeline) { return std::exchange(m_pipeline, pipeline); }
+
+        /*
+         * Copies the tree's dirty ranges into the frame's staging buffer and clears them; the copies
+         * are recorded by the next Record. The GPU must be done with the frame's previous submission.
+         */
+        void Upload(mc::VoxelTree& tree, const u32 frame) {
+            const std::vector<mc::ByteRange>& ranges = tree.GetDirtyRanges();
+
+            mc::StagingBuffer& stagingBuffer = m_stagingBuffers[frame];
+            stagingBuffer.Reset();
+
+            m_copies.clear();
+            m_copyFrame = frame;
+
+            if (ranges.empty())
+                return;
+
+            vk::DeviceSize bytes = 0;
+            for (const mc::ByteRange& range : ranges)
+                bytes += range.size;
+
+            if (stagingBuffer.GetCapacity() < bytes)
+                stagingBuffer = mc::StagingBuffer(m_device, m_memoryProperties, std::max<vk::DeviceSize>(bytes, stagingBuffer.GetCapacity() * 2));
+
+            const mc::u8* const pSrc = reinterpret_cast<const mc::u8*>(tree.GetData());
+
+            m_copies.reserve(ranges.size());
+
+            for (const mc::ByteRange& range : ranges)
+                m_copies.push_back(vk::BufferCopy{ stagingBuffer.Push(pSrc + range.offset, range.size).value(), range.offset, range.size });
+
+            tree.ClearDirtyRanges();
+        }
+
+        // Outside of a render pass. Leaves the images ready for fragment shaders to read
+        void Record(const vk::CommandBuffer& cmdBuff, const mc::FarFieldPushConstants& pushConstants) {
+            if (!m_copies.empty()) {
+                // Earlier submissions' dispatches may still read what is overwritten
+                cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, nullptr);
+                cmdBuff.copyBuffer(m_stagingBuffers[m_copyFrame].GetHandle(), m_treeBuffer, m_copies);
+
+                vk::MemoryBarrier barrier{};
+                barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+                cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, barrier, nullptr, nullptr);
+
+                m_copies.clear();
+            }
+
+            // The previous contents are not kept, and may still be read by earlier submissions
+            std::array<vk::ImageMemoryBarrier, 2> barriers{};
+
+            for (u32 i = 0; i < barriers.size(); ++i) {
+                barriers[i].srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+                barriers[i].dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+                barriers[i].image                       = i == 0 ? m_color.image : m_depth.image;
+                barriers[i].subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                barriers[i].subresourceRange.levelCount = 1;
+                barriers[i].subresourceRange.layerCount = 1;
+                barriers[i].oldLayout                   = vk::ImageLayout::eUndefined;
+                barriers[i].newLayout                   = vk::ImageLayout::eGeneral;
+                barriers[i].dstAccessMask               = vk::AccessFlagBits::eShaderWrite;
+            }
+
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barriers);
+
+            cmdBuff.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+            cmdBuff.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_set, nullptr);
+            cmdBuff.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pushConstants), &pushConstants);
+            cmdBuff.dispatch((m_extent.width + GROUP_SIZE - 1) / GROUP_SIZE, (m_extent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+            for (vk::ImageMemoryBarrier& barrier : barriers) {
+                barrier.oldLayout     = vk::ImageLayout::eGeneral;
+                barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead;
+            }
+
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barriers);
+        }
+
+        inline const vk::DescriptorSetLayout& GetSetLayout()  const { return m_setLayout; }
+        inline const vk::DescriptorSet&       GetSet()        const { return m_set;       }
+        inline const vk::Image&               GetColorImage() const { return m_color.image; }
+        inline const vk::Image&               GetDepthImage() const { return m_depth.image; }
+        inline vk::Extent2D                   GetExtent()     const { return m_extent;    }
+
+        ~FarFieldPass() {
+            m_device.destroyPipeline(m_pipeline);
+            m_device.destroyPipelineLayout(m_pipelineLayout);
+            m_device.destroyDescriptorPool(m_descriptorPool);
+            m_device.destroyDescriptorSetLayout(m_setLayout);
+
+            DestroyTarget(m_color);
+            DestroyTarget(m_depth);
+
+            for (mc::StagingBuffer& stagingBuffer : m_stagingBuffers)
+                stagingBuffer = mc::StagingBuffer();
+
+            m_device.destroyBuffer(m_treeBuffer);
+            mc::GpuMemory::Free(m_device, m_treeMemory);
+        }
+    }; // class FarFieldPass
+
+}; // namespace mc
\ No newline at end of file
@@ -2,6 +2,12 @@
 
 #include "header.hpp"
 
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/stat.h>
+#endif // _WIN32
+
 namespace mc {
 
     std::optional<std::vector<char>> ReadBinaryFileToBuffer(const std::string& filename) {
@@ -21,4 +27,127 @@ namespace mc {
         return buffer;
     }
 
+    // Succeeds when the directory already exists
+    inline bool MakeDirectory(const std::string& path) {
+#ifdef _WIN32
+        return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif // _WIN32
+    }
+
+    struct FileWrite {
+        std::string     filename;
+        std::vector<u8> data;
+    }; // struct FileWrite
+
+    namespace details {
+
+#ifdef _WIN32
+        using FileHandle = HANDLE;
+        static const FileHandle INVALID_FILE = INVALID_HANDLE_VALUE;
+
+        inline FileHandle CreateFileForWrite(const std::string& filename) {
+            return CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        }
+
+        inline bool WriteAll(const FileHandle file, const std::vector<u8>& data) {
+            DWORD written = 0;
+            return WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) && written == data.size();
+        }
+
+        inline bool SyncFile(const FileHandle file) { return FlushFileBuffers(file) != 0; }
+        inline void CloseFile(const FileHandle file) { CloseHandle(file); }
+
+        inline bool RenameOver(const std::string& from, const std::string& to) {
+            return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        }
+
+        // MOVEFILE_WRITE_THROUGH already waits for the rename to reach the disk
+        inline void SyncDirectory(const std::string&) { }
+#else
+        using FileHandle = int;
+        static constexpr FileHandle INVALID_FILE = -1;
+
+        inline FileHandle CreateFileForWrite(const std::string& filename) {
+            return open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+
+        inline bool WriteAll(const FileHandle file, const std::vector<u8>& data) {
+            for (std::size_t offset = 0; offset < data.size();) {
+                const ssize_t written = write(file, data.data() + offset, data.size() - offset);
+
+                if (written < 0 && errno != EINTR)
+                    return false;
+
+                offset += written > 0 ? static_cast<std::size_t>(written) : 0;
+            }
+
+            return true;
+        }
+
+        inline bool SyncFile(const FileHandle file) { return fsync(file) == 0; }
+        inline void CloseFile(const FileHandle file) { close(file); }
+
+        inline bool RenameOver(const std::string& from, const std::string& to) { return rename(from.c_str(), to.c_str()) == 0; }
+
+        // A rename only survives a crash once the directory entry itself is on disk
+        inline void SyncDirectory(const std::string& directory) {
+            const int dir = open(directory.c_str(), O_RDONLY);
+
+            if (dir >= 0) {
+                fsync(dir);
+                close(dir);
+            }
+        }
+#endif // _WIN32
+
+    }; // namespace details
+
+    // Writes every file to "<filename>.tmp", syncs them, then renames them over the originals: after a crash
+    // each file is either entirely old or entirely new. Syncing as a batch lets the disk flush everything in
+    // one go rather than one round trip per file. Returns false if any file could not be written
+    inline bool WriteFilesAtomically(const std::vector<FileWrite>& files) {
+        std::vector<details::FileHandle> handles;
+        handles.reserve(files.size());
+
+        bool bSuccess = true;
+
+        for (const FileWrite& file : files) {
+            const details::FileHandle handle = details::CreateFileForWrite(file.filename + ".tmp");
+
+            if (handle != details::INVALID_FILE && !details::WriteAll(handle, file.data))
+                bSuccess = false;
+
+            bSuccess = bSuccess && handle != details::INVALID_FILE;
+            handles.push_back(handle);
+        }
+
+        for (const details::FileHandle handle : handles) {
+            if (handle == details::INVALID_FILE)
+                continue;
+
+            bSuccess = details::SyncFile(handle) && bSuccess;
+            details::CloseFile(handle);
+        }
+
+        // Nothing is renamed unless the whole batch made it to disk, so the files on disk stay consistent with each other
+        if (!bSuccess)
+            return false;
+
+        std::unordered_set<std::string> directories;
+
+        for (const FileWrite& file : files) {
+            bSuccess = details::RenameOver(file.filename + ".tmp", file.filename) && bSuccess;
+
+            const std::size_t slash = file.filename.find_last_of("/\\");
+            directories.insert(slash == std::string::npos ? "." : file.filename.substr(0, slash));
+        }
+
+        for (const std::string& directory : directories)
+            details::SyncDirectory(directory);
+
+        return bSuccess;
+    }
+
 }; // namespace mc
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "fluids.hpp"
+#include "threadPool.hpp"
+
+/*
+ * A dam break: a block of still water held by a stone wall on a flat stone floor, the wall taken
+ * away at once. Measures what fluid ticks cost as the water collapses and runs over the floor, and
+ * checks that it is all still there at the end.
+ */
+
+namespace mc {
+
+    class FluidBenchmark {
+    private:
+        static constexpr i32 FLOOR_SECTIONS = 4;  // Stone up to y = 64
+        static constexpr i32 SIDE_CHUNKS    = 12; // The floor is 192 x 192 blocks, closed by the unloaded chunks around it
+        static constexpr i32 WIDTH          = 50; // Along x and z, the height follows from the block count
+
+        static u64 MeasureVolume(const World& world, const FluidEngine& fluids) {
+            u64 volume = 0;
+
+            for (i32 x = 0; x < SIDE_CHUNKS * static_cast<i32>(MC_CHUNK_SECTION_SIZE); ++x)
+                for (i32 z = 0; z < SIDE_CHUNKS * static_cast<i32>(MC_CHUNK_SECTION_SIZE); ++z)
+                    for (i32 y = FLOOR_SECTIONS * static_cast<i32>(MC_CHUNK_SECTION_SIZE); y < static_cast<i32>(MC_CHUNK_HEIGHT); ++y)
+                        volume += fluids.GetVolume(world, vec3i32{ x, y, z });
+
+            return volume;
+        }
+
+    public:
+        static void Run(const u32 blocks, const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            constexpr i32 FLOOR = FLOOR_SECTIONS * static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+            const i32 height = std::min(static_cast<i32>((blocks + WIDTH * WIDTH - 1) / (WIDTH * WIDTH)), static_cast<i32>(MC_CHUNK_HEIGHT) - FLOOR);
+
+            World world;
+
+            for (i32 z = 0; z < SIDE_CHUNKS; ++z) {
+                for (i32 x = 0; x < SIDE_CHUNKS; ++x) {
+                    Chunk& chunk = world.CreateChunk(ChunkCoord{ x, z });
+
+                    for (i32 y = 0; y < FLOOR_SECTIONS; ++y)
+                        chunk.GetOrCreateSection(static_cast<u32>(y)).Fill(Block::Stone);
+                }
+            }
+
+            // The water in a corner, the dam along its two open sides
+            for (i32 x = 0; x <= WIDTH; ++x) {
+                for (i32 z = 0; z <= WIDTH; ++z) {
+                    for (i32 y = FLOOR; y < FLOOR + height; ++y) {
+                        const ChunkCoord coord{ WorldToChunk(x), WorldToChunk(z) };
+                        const Block      block = x == WIDTH || z == WIDTH ? Block::Stone : Block::Water;
+
+                        world.GetChunk(coord)->SetBlock(WorldToLocal(x), y, WorldToLocal(z), block);
+                    }
+                }
+            }
+
+            FluidEngine fluids;
+
+            const u64 volume = MeasureVolume(world, fluids);
+
+            for (i32 i = 0; i <= WIDTH; ++i) {
+                for (i32 y = FLOOR; y < FLOOR + height; ++y) {
+                    for (const vec3i32& p : { vec3i32{ WIDTH, y, i }, vec3i32{ i, y, WIDTH } }) {
+                        world.SetBlock(p, Block::Air);
+                        fluids.Notify(world, p);
+                    }
+                }
+            }
+
+            u64 remeshed = 0;
+
+            for (u32 i = 0; i < ticks; ++i) {
+                fluids.Tick(world, pool);
+
+                // As the mesh manager would, which is not what is measured
+                remeshed += world.GetDirtySections().size();
+                while (!world.GetDirtySections().empty())
+                    world.ClearDirtySection(*world.GetDirtySections().begin());
+            }
+
+            const FluidStats stats = fluids.GetStats();
+            const f64 count = static_cast<f64>(std::max<u64>(stats.ticks, 1));
+
+            const u64 volumeAfter = MeasureVolume(world, fluids);
+
+            out << "[BENCHMARK] " << static_cast<u64>(WIDTH) * WIDTH * height << " water blocks, " << WIDTH << " x " << WIDTH << " x " << height
+                << " | tick " << std::fixed << std::setprecision(3) << static_cast<f64>(stats.tickUS) / count / 1000.0 << " ms avg, " << stats.maxTickUS / 1000.0 << " ms max"
+                << " | per tick " << std::setprecision(1) << static_cast<f64>(stats.cells) / count << " active cells, " << static_cast<f64>(stats.changes) / count << " changes, "
+                << static_cast<f64>(stats.sections) / count << " sections edited, " << static_cast<f64>(remeshed) / count << " remeshes"
+                << " | " << fluids.GetActiveCount() << " cells still active, volume " << (volumeAfter == volume ? "kept" : "LOST") << '\n'
+                << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+
+        static void RunAll(const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            out << "[BENCHMARK] " << ticks << " fluid ticks on " << pool.GetThreadCount() + 1 << " threads\n";
+
+            Run(100'000, ticks, pool, out);
+        }
+    }; // class FluidBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,405 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "threadPool.hpp"
+
+/*
+ * Water and lava as a cellular automaton. A fluid cell holds a volume, up to FULL; the blocks only
+ * say which fluid is there, so the volumes of the cells that are not full are kept here, per section.
+ * A tick moves fluid in two steps: it falls into the cell below as far as that has room, then cells
+ * resting on something give each open neighbour holding less a share of the difference. Volume is
+ * kept: what one cell gives, the other receives, except where lava meets water and turns to cobblestone.
+ *
+ * Every cell's next state is computed from the state before the tick alone, both steps included,
+ * which is the double buffer: cells read the world and never write it while the sections run in
+ * parallel, and the edits are applied afterwards, section by section in a fixed order. A cell's next
+ * state only depends on the cells up to two below, one above and one aside, so only the cells around
+ * what changed in a tick are updated in the next one; settled water costs nothing. Each section's
+ * edits go to the world in one batch, so it is remeshed once per tick however many cells changed.
+ */
+
+namespace mc {
+
+    struct FluidStats {
+        u64 ticks     = 0;
+        u64 tickUS    = 0; // Summed over the ticks
+        u64 maxTickUS = 0;
+
+        u64 cells    = 0; // Active cells updated
+        u64 changes  = 0; // Cells whose block or volume changed
+        u64 sections = 0; // Sections edited, each remeshed once for the tick
+    }; // struct FluidStats
+
+    class FluidEngine {
+    public:
+        static constexpr u8  FULL          = 64; // Volume of a full cell, which is also what a fluid block without volume holds
+        static constexpr u32 TICK_INTERVAL = 3;  // Input ticks per fluid tick, 20 per second at MC_INPUT_TICK_RATE
+
+    private:
+        // A cell gives a neighbour 1/k of the difference between them, k being at least 4 so that
+        // a cell never gives more than it holds nor receives more than it has room for
+        static constexpr i32 WATER_SPREAD = 5;
+        static constexpr i32 LAVA_SPREAD  = 10; // Lava is thicker: it stops on steeper slopes, so it goes less far
+
+        struct CellEdit {
+            u16   index; // ChunkSection::Index
+            Block block;
+            u8    volume;
+        }; // struct CellEdit
+
+        struct Section {
+            vec3i32 coord;
+
+            std::unordered_map<u16, u8> volumes; // Fluid cells holding less than FULL
+
+            std::vector<u16>                      active;     // Cells updated this tick
+            std::vector<u16>                      next;       // Cells updated next tick
+            std::bitset<MC_CHUNK_SECTION_VOLUME> nextMask;   // So that next holds a cell once
+
+            std::vector<CellEdit> edits;
+            u64                   cells = 0;
+
+            explicit Section(const vec3i32& coord)
+                : coord(coord)
+            { }
+        }; // struct Section
+
+        using SectionMap = std::unordered_map<vec3i32, std::unique_ptr<Section>, SectionCoordHash>;
+
+        // What a section's cells read, the chunks and the volumes around it, looked up once per tick
+        class View {
+        private:
+            vec3i32 m_coord;
+
+            std::array<const Chunk*, 9>    m_chunks{};   // 3 x 3 around the section, x fastest
+            std::array<const Section*, 27> m_sections{}; // 3 x 3 x 3 around the section, x fastest, then z, then y
+
+        public:
+            View(const World& world, const SectionMap& sections, const vec3i32& coord)
+                : m_coord(coord)
+            {
+                for (i32 dy = -1; dy <= 1; ++dy) {
+                    for (i32 dz = -1; dz <= 1; ++dz) {
+                        for (i32 dx = -1; dx <= 1; ++dx) {
+                            const auto it = sections.find(coord + vec3i32{ dx, dy, dz });
+
+                            m_sections[((dy + 1) * 3 + dz + 1) * 3 + dx + 1] = it != sections.end() ? it->second.get() : nullptr;
+                        }
+                    }
+                }
+
+                for (i32 dz = -1; dz <= 1; ++dz)
+                    for (i32 dx = -1; dx <= 1; ++dx)
+                        m_chunks[(dz + 1) * 3 + dx + 1] = world.GetChunk(ChunkCoord{ coord.x + dx, coord.z + dz });
+            }
+
+            // Unloaded chunks and what is past the bottom or the top of the world hold fluid back like bedrock
+            Block GetBlock(const vec3i32& p) const {
+                if (p.y < 0 || p.y >= static_cast<i32>(MC_CHUNK_HEIGHT))
+                    return Block::Bedrock;
+
+                const Chunk* pChunk = m_chunks[(WorldToChunk(p.z) - m_coord.z + 1) * 3 + WorldToChunk(p.x) - m_coord.x + 1];
+
+                return pChunk ? pChunk->GetBlock(WorldToLocal(p.x), p.y, WorldToLocal(p.z)) : Block::Bedrock;
+            }
+
+            // The volume of the fluid at p, 0 when p holds anything else
+            i32 GetVolume(const vec3i32& p, const Block fluid) const {
+                if (GetBlock(p) != fluid)
+                    return 0;
+
+                const Section* pSection = m_sections[((WorldToChunk(p.y) - m_coord.y + 1) * 3 + WorldToChunk(p.z) - m_coord.z + 1) * 3 + WorldToChunk(p.x) - m_coord.x + 1];
+                if (!pSection)
+                    return FULL;
+
+                const auto it = pSection->volumes.find(static_cast<u16>(ChunkSection::Index(WorldToLocal(p.x), WorldToLocal(p.y), WorldToLocal(p.z))));
+
+                return it != pSection->volumes.end() ? it->second : FULL;
+            }
+
+            inline bool IsOpen(const vec3i32& p, const Block fluid) const {
+                const Block block = GetBlock(p);
+
+                return block == Block::Air || block == fluid;
+            }
+        }; // class View
+
+        SectionMap            m_sections;
+        std::vector<Section*> m_active;
+
+        FluidStats m_stats;
+
+    private:
+        static constexpr vec3i32 UP{ 0, 1, 0 };
+
+        static constexpr std::array<vec3i32, 4> SIDES = {
+            vec3i32{ -1, 0, 0 }, vec3i32{ 1, 0, 0 }, vec3i32{ 0, 0, -1 }, vec3i32{ 0, 0, 1 }
+        };
+
+        static constexpr i32 GetSpread(const Block fluid) { return fluid == Block::Water ? WATER_SPREAD : LAVA_SPREAD; }
+
+        // First step: what p passes down, as much as the cell below has room for
+        static i32 GetFall(const View& view, const vec3i32& p, const Block fluid) {
+            const i32 volume = view.GetVolume(p, fluid);
+
+            if (volume == 0 || !view.IsOpen(p - UP, fluid))
+                return 0;
+
+            return std::min(volume, FULL - view.GetVolume(p - UP, fluid));
+        }
+
+        // What p holds after the first step. Never more than FULL: what falls in is at most the room p had
+        static i32 GetFallen(const View& view, const vec3i32& p, const Block fluid) {
+            return view.GetVolume(p, fluid) - GetFall(view, p, fluid) + GetFall(view, p + UP, fluid);
+        }
+
+        // Only fluid resting on something spreads; the rest keeps falling
+        static bool IsResting(const View& view, const vec3i32& p, const Block fluid) {
+            return !view.IsOpen(p - UP, fluid) || GetFallen(view, p - UP, fluid) == FULL;
+        }
+
+        // What p holds after the second step. Its neighbours compute the same flows from their side
+        static i32 GetSpreadVolume(const View& view, const vec3i32& p, const Block fluid) {
+            const i32  spread   = GetSpread(fluid);
+            const i32  volume   = GetFallen(view, p, fluid);
+            const bool bResting = volume > 0 && IsResting(view, p, fluid);
+
+            i32 flow = 0;
+
+            for (const vec3i32& side : SIDES) {
+                const vec3i32 neighbour = p + side;
+
+                if (!view.IsOpen(neighbour, fluid))
+                    continue;
+
+                const i32 other = GetFallen(view, neighbour, fluid);
+
+                if (volume > other && bResting)
+                    flow -= (volume - other) / spread;
+                else if (other > volume && IsResting(view, neighbour, fluid))
+                    flow += (other - volume) / spread;
+            }
+
+            return volume + flow;
+        }
+
+        static bool Touches(const View& view, const vec3i32& p, const Block block) {
+            if (view.GetBlock(p + UP) == block || view.GetBlock(p - UP) == block)
+                return true;
+
+            for (const vec3i32& side : SIDES)
+                if (view.GetBlock(p + side) == block)
+                    return true;
+
+            return false;
+        }
+
+        // Runs on a worker: reads the world and the volumes, and only writes to the section's edits
+        static void RunSection(Section& section, const View& view) {
+            const vec3i32 origin{ ChunkToWorld(section.coord.x), ChunkToWorld(section.coord.y), ChunkToWorld(section.coord.z) };
+
+            for (const u16 index : section.active) {
+                // ChunkSection::Index is x fastest, then z, then y
+                const vec3i32 p = origin + vec3i32{
+                    static_cast<i32>(index % MC_CHUNK_SECTION_SIZE),
+                    static_cast<i32>(index / (MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE)),
+                    static_cast<i32>((index / MC_CHUNK_SECTION_SIZE) % MC_CHUNK_SECTION_SIZE)
+                };
+
+                const Block block = view.GetBlock(p);
+                if (block != Block::Air && !IsFluid(block))
+                    continue;
+
+                Block nextBlock  = Block::Air;
+                i32   nextVolume = 0;
+
+                if (block == Block::Air) {
+                    const i32 water = GetSpreadVolume(view, p, Block::Water);
+                    const i32 lava  = GetSpreadVolume(view, p, Block::Lava);
+
+                    if (water > 0 && lava > 0)
+                        nextBlock = Block::Cobblestone;
+                    else if (water > 0 || lava > 0)
+                        nextBlock = water > 0 ? Block::Water : Block::Lava;
+
+                    nextVolume = std::max(water, lava);
+                } else if (block == Block::Lava && Touches(view, p, Block::Water)) {
+                    nextBlock = Block::Cobblestone;
+                } else {
+                    nextVolume = GetSpreadVolume(view, p, block);
+                    nextBlock  = nextVolume > 0 ? block : Block::Air;
+                }
+
+                ++section.cells;
+
+                const i32 volume = IsFluid(block) ? view.GetVolume(p, block) : 0;
+
+                if (nextBlock != block || (IsFluid(nextBlock) && nextVolume != volume))
+                    section.edits.push_back(CellEdit{ index, nextBlock, static_cast<u8>(IsFluid(nextBlock) ? nextVolume : 0) });
+            }
+        }
+
+        Section& GetSection(const vec3i32& coord) {
+            std::unique_ptr<Section>& pSection = m_sections[coord];
+
+            if (!pSection)
+                pSection = std::make_unique<Section>(coord);
+
+            return *pSection;
+        }
+
+        void Activate(const vec3i32& p) {
+            if (p.y < 0 || p.y >= static_cast<i32>(MC_CHUNK_HEIGHT))
+                return;
+
+            Section&  section = GetSection(vec3i32{ WorldToChunk(p.x), WorldToChunk(p.y), WorldToChunk(p.z) });
+            const u16 index   = static_cast<u16>(ChunkSection::Index(WorldToLocal(p.x), WorldToLocal(p.y), WorldToLocal(p.z)));
+
+            if (!section.nextMask.test(index)) {
+                section.nextMask.set(index);
+                section.next.push_back(index);
+            }
+        }
+
+        // The cells whose next state reads p: those up to one below and two above it, and beside those
+        void ActivateAround(const vec3i32& p) {
+            for (i32 dy = -1; dy <= 2; ++dy) {
+                Activate(p + vec3i32{ 0, dy, 0 });
+
+                for (const vec3i32& side : SIDES)
+                    Activate(p + side + vec3i32{ 0, dy, 0 });
+            }
+        }
+
+    public:
+        FluidEngine() = default;
+
+        FluidEngine(const FluidEngine&) = delete;
+        FluidEngine& operator=(const FluidEngine&) = delete;
+
+        // To call after a block changed outside the engine: the fluid around it may start flowing
+        void Notify(const World& world, const vec3i32& p) {
+            const vec3i32 coord{ WorldToChunk(p.x), WorldToChunk(p.y), WorldToChunk(p.z) };
+
+            // A volume left behind by a fluid cell that was replaced
+            if (!IsFluid(world.GetBlock(p))) {
+                const auto it = m_sections.find(coord);
+
+                if (it != m_sections.end())
+                    it->second->volumes.erase(static_cast<u16>(ChunkSection::Index(WorldToLocal(p.x), WorldToLocal(p.y), WorldToLocal(p.z))));
+            }
+
+            ActivateAround(p);
+        }
+
+        // The volume of the fluid cell at p, FULL for a cell the engine never moved
+        u8 GetVolume(const World& world, const vec3i32& p) const {
+            if (!IsFluid(world.GetBlock(p)))
+                return 0;
+
+            const auto it = m_sections.find(vec3i32{ WorldToChunk(p.x), WorldToChunk(p.y), WorldToChunk(p.z) });
+            if (it == m_sections.end())
+                return FULL;
+
+            const auto cell = it->second->volumes.find(static_cast<u16>(ChunkSection::Index(WorldToLocal(p.x), WorldToLocal(p.y), WorldToLocal(p.z))));
+
+            return cell != it->second->volumes.end() ? cell->second : FULL;
+        }
+
+        void Tick(World& world, ThreadPool& pool) {
+            const Timer timer;
+
+            // Last tick's next cells become this tick's; sections with neither cells nor volumes go
+            m_active.clear();
+
+            for (auto it = m_sections.begin(); it != m_sections.end();) {
+                Section& section = *it->second;
+
+                section.active.swap(section.next);
+                section.next.clear();
+                section.nextMask.reset();
+
+                if (section.active.empty()) {
+                    it = section.volumes.empty() ? m_sections.erase(it) : std::next(it);
+                    continue;
+                }
+
+                m_active.push_back(&section);
+                ++it;
+            }
+
+            std::sort(m_active.begin(), m_active.end(), [](const Section* a, const Section* b) {
+                if (a->coord.x != b->coord.x) return a->coord.x < b->coord.x;
+                if (a->coord.z != b->coord.z) return a->coord.z < b->coord.z;
+                return a->coord.y < b->coord.y;
+            });
+
+            const World& readOnly = world;
+
+            pool.ParallelFor(m_active.size(), 1, [this, &readOnly](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    RunSection(*m_active[i], View(readOnly, m_sections, m_active[i]->coord));
+            });
+
+            std::vector<SectionEdit> blocks;
+
+            for (Section* pSection : m_active) {
+                m_stats.cells += pSection->cells;
+                pSection->cells = 0;
+
+                if (pSection->edits.empty())
+                    continue;
+
+                blocks.clear();
+
+                for (const CellEdit& edit : pSection->edits) {
+                    blocks.push_back(SectionEdit{ edit.index, edit.block });
+
+                    if (IsFluid(edit.block) && edit.volume < FULL)
+                        pSection->volumes[edit.index] = edit.volume;
+                    else
+                        pSection->volumes.erase(edit.index);
+                }
+
+                world.SetSectionBlocks(pSection->coord, blocks);
+
+                const vec3i32 origin{ ChunkToWorld(pSection->coord.x), ChunkToWorld(pSection->coord.y), ChunkToWorld(pSection->coord.z) };
+
+                for (const CellEdit& edit : pSection->edits) {
+                    ActivateAround(origin + vec3i32{
+                        static_cast<i32>(edit.index % MC_CHUNK_SECTION_SIZE),
+                        static_cast<i32>(edit.index / (MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE)),
+                        static_cast<i32>((edit.index / MC_CHUNK_SECTION_SIZE) % MC_CHUNK_SECTION_SIZE)
+                    });
+                }
+
+                m_stats.changes += pSection->edits.size();
+                ++m_stats.sections;
+
+                pSection->edits.clear();
+            }
+
+            const u64 elapsedUS = timer.GetElapsedUS();
+
+            ++m_stats.ticks;
+            m_stats.tickUS   += elapsedUS;
+            m_stats.maxTickUS = std::max(m_stats.maxTickUS, elapsedUS);
+        }
+
+        // Cells to update at the next Tick()
+        std::size_t GetActiveCount() const {
+            std::size_t count = 0;
+
+            for (const auto& [coord, pSection] : m_sections)
+                count += pSection->next.size();
+
+            return count;
+        }
+
+        inline FluidStats GetStats()   const { return m_stats;       }
+        inline void       ResetStats()       { m_stats = FluidStats{}; }
+    }; // class FluidEngine
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,312 @@
+#pragma once
+
+#include "header.hpp"
+#include "timer.hpp"
+
+/*
+ * How frames reach the display, and when the CPU starts on them.
+ *
+ * A PresentPolicy trades throughput for latency: it picks the present mode, how many images the
+ * swap chain has and how many frames the CPU may run ahead of the GPU. The FramePacer then holds
+ * a frame back until just before it is needed, so input is sampled as late as possible instead of
+ * the frame waiting on the display after sampling it. With VK_KHR_present_wait it waits for an
+ * earlier frame to reach the display and sleeps from there; without, it learns how long acquiring
+ * an image blocks, which is time spent after the input was sampled, and sleeps that before instead.
+ *
+ * Either way it measures the latency from the input a frame shows to its present, and to its
+ * display when VK_KHR_present_wait tells when that was.
+ */
+
+namespace mc {
+
+    struct PresentPolicy {
+        std::vector<vk::PresentModeKHR> presentModes   = { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo }; // By preference, FIFO is always supported
+        u32                             extraImages    = 1;                           // Swap chain images beyond the surface's minimum
+        u32                             imageCount     = 0;                           // When not 0, replaces the minimum plus extraImages
+        u32                             framesInFlight = MC_DEFAULT_FRAMES_IN_FLIGHT; // 1 to MC_MAX_FRAMES_IN_FLIGHT
+        bool                            bPacing        = false;                       // Only with FIFO, the other modes never make the CPU wait for the display
+
+        // Vsync with a single frame queued, started as late as the display allows
+        static PresentPolicy LowLatency() {
+            return PresentPolicy{ { vk::PresentModeKHR::eFifo }, 0, 0, 1, true };
+        }
+
+        // Mailbox where the surface has it: no tearing, and the newest frame replaces the queued one
+        static PresentPolicy Balanced() {
+            return PresentPolicy{};
+        }
+
+        // Tearing allowed, with an image and a frame more to keep the GPU busy
+        static PresentPolicy Throughput() {
+            return PresentPolicy{ { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo }, 2, 0, MC_MAX_FRAMES_IN_FLIGHT, false };
+        }
+
+        static PresentPolicy FromName(const std::string_view name) {
+            if (name == "low-latency") return LowLatency();
+            if (name == "balanced")    return Balanced();
+            if (name == "throughput")  return Throughput();
+
+            throw std::runtime_error("Unknown present policy: " + std::string(name));
+        }
+
+        static vk::PresentModeKHR ParsePresentMode(const std::string_view name) {
+            for (const vk::PresentModeKHR mode : { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifoRelaxed })
+                if (name == GetPresentModeName(mode))
+                    return mode;
+
+            throw std::runtime_error("Unknown present mode: " + std::string(name));
+        }
+
+        static const char* GetPresentModeName(const vk::PresentModeKHR mode) {
+            switch (mode) {
+            case vk::PresentModeKHR::eImmediate:   return "immediate";
+            case vk::PresentModeKHR::eMailbox:     return "mailbox";
+            case vk::PresentModeKHR::eFifo:        return "fifo";
+            case vk::PresentModeKHR::eFifoRelaxed: return "fifo-relaxed";
+            default:                               return "other";
+            }
+        }
+    }; // struct PresentPolicy
+
+    struct FrameLatencyStats {
+        u64 frames  = 0;
+        u64 wallUS  = 0; // Since the stats were reset
+        u64 pacedUS = 0; // Slept by the pacer
+
+        // Frames presented after the first input sample; the latency counts from the last sample before the present
+        u64 sampled             = 0;
+        u64 inputToPresentUS    = 0; // Summed over them
+        u64 maxInputToPresentUS = 0;
+
+        // Of those, the ones VK_KHR_present_wait gave a display time for
+        u64 displayed           = 0;
+        u64 inputToDisplayUS    = 0;
+        u64 maxInputToDisplayUS = 0;
+    }; // struct FrameLatencyStats
+
+    class FramePacer {
+    private:
+        static constexpr u64 MARGIN_US          = 1000;        // Left between the end of the sleep and the deadline
+        static constexpr u64 SLEEP_STEP_US      = 100;         // Added to the sleep every frame that made its vblank
+        static constexpr u64 MAX_SLEEP_US       = 50'000;
+        static constexpr u64 PRESENT_TIMEOUT_NS = 100'000'000; // A present not displayed by then was lost, to a hidden window for instance
+        static constexpr u32 INTERVAL_WINDOW    = 120;         // Frames over which the display interval is the shortest seen
+        static constexpr std::size_t MAX_PENDING = 16;
+
+        struct PendingPresent {
+            u64  id;
+            bool bSampled;
+            u64  inputUS;
+        }; // struct PendingPresent
+
+        vk::Device              m_device;
+        vk::SwapchainKHR        m_swapChain;
+        PFN_vkWaitForPresentKHR m_pfnWaitForPresent = nullptr; // Loaded when VK_KHR_present_wait was enabled
+        bool                    m_bPacing           = false;
+        u32                     m_framesInFlight    = 1;
+
+        mc::Timer m_clock;
+
+        bool m_bInputSampled = false;
+        u64  m_inputUS       = 0;
+        u64  m_nextPresentId = 1;
+
+        std::deque<PendingPresent> m_pending; // Presented, not known to be displayed yet
+
+        u64  m_sleepUS       = 0;
+        u64  m_lastDisplayId = 0;
+        u64  m_lastDisplayUS = 0;
+        bool m_bMissed       = false; // The last frame displayed came more than an interval after the one before
+
+        u64 m_intervalUS   = 0;
+        u64 m_windowMinUS  = UINT64_MAX;
+        u32 m_windowFrames = 0;
+
+        FrameLatencyStats m_stats;
+        u64               m_statsStartUS = 0;
+
+    private:
+        // Sleeps most of the way, and yields through the last stretch the scheduler can't be trusted with
+        u64 SleepUntil(const u64 deadlineUS) {
+            const u64 startUS = m_clock.GetElapsedUS();
+
+            for (u64 nowUS = startUS; nowUS < deadlineUS; nowUS = m_clock.GetElapsedUS()) {
+                if (deadlineUS - nowUS > 2 * MARGIN_US)
+                    std::this_thread::sleep_for(std::chrono::microseconds(deadlineUS - nowUS - MARGIN_US));
+                else
+                    std::this_thread::yield();
+            }
+
+            const u64 sleptUS = m_clock.GetElapsedUS() - startUS;
+            m_stats.pacedUS += sleptUS;
+
+            return sleptUS;
+        }
+
+        // Presents complete in order, so every pending one up to the id was displayed by now
+        void OnDisplayed(const u64 id, const u64 displayUS) {
+            while (!m_pending.empty() && m_pending.front().id <= id) {
+                const PendingPresent& present = m_pending.front();
+
+                if (present.bSampled) {
+                    const u64 latencyUS = displayUS - present.inputUS;
+
+                    ++m_stats.displayed;
+                    m_stats.inputToDisplayUS   += latencyUS;
+                    m_stats.maxInputToDisplayUS = std::max(m_stats.maxInputToDisplayUS, latencyUS);
+                }
+
+                m_pending.pop_front();
+            }
+
+            // Only two consecutive frames are an interval apart; a frame skipped by mailbox says nothing
+            if (id == m_lastDisplayId + 1 && m_lastDisplayId != 0) {
+                const u64 deltaUS = displayUS - m_lastDisplayUS;
+
+                m_bMissed     = m_intervalUS != 0 && 2 * deltaUS > 3 * m_intervalUS;
+                m_windowMinUS = std::min(m_windowMinUS, deltaUS);
+
+                if (++m_windowFrames == INTERVAL_WINDOW || m_intervalUS == 0) {
+                    m_intervalUS   = m_windowMinUS;
+                    m_windowMinUS  = UINT64_MAX;
+                    m_windowFrames = 0;
+                }
+            }
+
+            m_lastDisplayId = id;
+            m_lastDisplayUS = displayUS;
+        }
+
+        // False when the present was not displayed within the timeout
+        bool WaitForPresent(const u64 id, const u64 timeoutNS) {
+            const VkResult result = m_pfnWaitForPresent(static_cast<VkDevice>(m_device), static_cast<VkSwapchainKHR>(m_swapChain), id, timeoutNS);
+
+            if (result == VK_TIMEOUT)
+                return false;
+
+            if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+                throw std::runtime_error("vkWaitForPresentKHR failed");
+
+            OnDisplayed(id, m_clock.GetElapsedUS());
+
+            return true;
+        }
+
+        /*
+         * Waits for the frame framesInFlight before this one to be displayed, which leaves one
+         * vblank per frame in flight to make, then sleeps from that vblank. The sleep grows a
+         * little every frame that made its vblank and halves when one was missed.
+         */
+        void PaceOnDisplay() {
+            if (m_nextPresentId <= m_framesInFlight)
+                return;
+
+            const u64 id = m_nextPresentId - m_framesInFlight;
+
+            if (id > m_lastDisplayId && !WaitForPresent(id, PRESENT_TIMEOUT_NS))
+                return;
+
+            if (m_intervalUS == 0)
+                return;
+
+            m_sleepUS = m_bMissed ? m_sleepUS / 2 : m_sleepUS + SLEEP_STEP_US;
+            m_sleepUS = std::min(m_sleepUS, m_intervalUS > MARGIN_US ? m_intervalUS - MARGIN_US : 0);
+
+            SleepUntil(m_lastDisplayUS + m_sleepUS);
+        }
+
+    public:
+        FramePacer() = default;
+
+        // bPresentWait: VK_KHR_present_id and VK_KHR_present_wait were enabled on the device, with their features
+        void Startup(const vk::Device& device, const vk::SwapchainKHR& swapChain, const bool bPresentWait, const bool bPacing, const u32 framesInFlight) {
+            m_device         = device;
+            m_swapChain      = swapChain;
+            m_bPacing        = bPacing;
+            m_framesInFlight = framesInFlight;
+
+            m_pfnWaitForPresent = bPresentWait ? reinterpret_cast<PFN_vkWaitForPresentKHR>(device.getProcAddr("vkWaitForPresentKHR")) : nullptr;
+
+            ResetStats();
+        }
+
+        // Called before the frame samples input, and where the pacer sleeps
+        void BeginFrame() {
+            if (m_pfnWaitForPresent) {
+                if (m_bPacing) {
+                    PaceOnDisplay();
+                    return;
+                }
+
+                // Not pacing, the display times are only polled for, so they are late by up to a frame
+                while (!m_pending.empty() && WaitForPresent(m_pending.front().id, 0)) { }
+            } else if (m_bPacing) {
+                SleepUntil(m_clock.GetElapsedUS() + m_sleepUS);
+            }
+        }
+
+        // Ticks sample input at MC_INPUT_TICK_RATE; a frame without a tick shows the last sample
+        inline void MarkInputSampled() {
+            m_bInputSampled = true;
+            m_inputUS       = m_clock.GetElapsedUS();
+        }
+
+        /*
+         * How long acquiring the frame's image blocked. Without VK_KHR_present_wait that is what the
+         * pacer goes by: blocking beyond the margin lengthens the sleep before the next frame, and
+         * blocking less shortens it, until the frame starts about when its image is free.
+         */
+        void OnAcquired(const u64 blockedUS) {
+            if (!m_bPacing || m_pfnWaitForPresent)
+                return;
+
+            const i64 errorUS = static_cast<i64>(blockedUS) - static_cast<i64>(MARGIN_US);
+
+            m_sleepUS = static_cast<u64>(std::clamp<i64>(static_cast<i64>(m_sleepUS) + errorUS / 2, 0, static_cast<i64>(MAX_SLEEP_US)));
+        }
+
+        // The id the next present carries in its VkPresentIdKHR, when VK_KHR_present_id is there
+        inline u64 GetNextPresentId() const noexcept { return m_nextPresentId; }
+
+        // Called right after the present was queued
+        void OnPresented() {
+            const u64 nowUS = m_clock.GetElapsedUS();
+
+            ++m_stats.frames;
+
+            if (m_bInputSampled) {
+                const u64 latencyUS = nowUS - m_inputUS;
+
+                ++m_stats.sampled;
+                m_stats.inputToPresentUS   += latencyUS;
+                m_stats.maxInputToPresentUS = std::max(m_stats.maxInputToPresentUS, latencyUS);
+            }
+
+            if (m_pfnWaitForPresent) {
+                m_pending.push_back(PendingPresent{ m_nextPresentId, m_bInputSampled, m_inputUS });
+
+                // Presents that are never displayed, while the window is hidden, must not pile up
+                if (m_pending.size() > MAX_PENDING)
+                    m_pending.pop_front();
+            }
+
+            ++m_nextPresentId;
+        }
+
+        inline bool UsesPresentWait() const noexcept { return m_pfnWaitForPresent != nullptr; }
+        inline bool IsPacing()        const noexcept { return m_bPacing; }
+
+        FrameLatencyStats GetStats() const {
+            FrameLatencyStats stats = m_stats;
+            stats.wallUS = m_clock.GetElapsedUS() - m_statsStartUS;
+
+            return stats;
+        }
+
+        void ResetStats() {
+            m_stats        = FrameLatencyStats{};
+            m_statsStartUS = m_clock.GetElapsedUS();
+        }
+    }; // class FramePacer
+
+}; // namespace mc
\ No newline at end of file
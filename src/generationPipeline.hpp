@@ -0,0 +1,349 @@
+#pragma once
+
+#include "header.hpp"
+#include "timer.hpp"
+#include "threadPool.hpp"
+#include "worldGenerator.hpp"
+
+/*
+ * Schedules the generation stages of many chunks on a thread pool. A chunk runs its next stage
+ * as soon as it finished the previous one and the chunks within the stage's radius reached the
+ * stage it reads from them, so there is no barrier between stages: the middle of an area is
+ * already placing trees while its edges are still shaping terrain.
+ *
+ * Chunks generated only as neighbours stay in the pipeline, partly generated, for the next
+ * calls; so do the heightmaps of the chunks handed out. Only one Generate call runs at a time.
+ */
+
+namespace mc {
+
+    struct GenerationStats {
+        u64 chunks = 0; // Handed out fully generated
+        u64 wallUS = 0; // Spent in Generate
+
+        // Per stage, summed over the threads
+        std::array<u64, static_cast<std::size_t>(GenerationStage::Count)> runs{};
+        std::array<u64, static_cast<std::size_t>(GenerationStage::Count)> stageUS{};
+    }; // struct GenerationStats
+
+    class GenerationPipeline {
+    private:
+        struct ProtoChunk {
+            Chunk     chunk;
+            Heightmap heightmap{};
+
+            GenerationStage stage  = GenerationStage::Empty; // The last stage done
+            GenerationStage target = GenerationStage::Empty; // The last stage a request needs
+
+            bool   bRunning = false;
+            Chunk* pOutput  = nullptr; // Where a requested chunk goes once done
+            u64    lastUse  = 0;
+
+            explicit ProtoChunk(const ChunkCoord coord)
+                : chunk(coord)
+            { }
+        }; // struct ProtoChunk
+
+        struct Task {
+            ProtoChunk*             pChunk;
+            GenerationStage         stage;
+            GenerationNeighbourhood neighbours;
+        }; // struct Task
+
+        const WorldGenerator& m_generator;
+        ThreadPool&           m_pool;
+        std::size_t           m_maxCachedChunks;
+
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_condition;
+
+        std::unordered_map<ChunkCoord, std::unique_ptr<ProtoChunk>, ChunkCoordHash> m_chunks;
+
+        std::deque<Task> m_ready;
+        u32              m_running   = 0;
+        u32              m_helpers   = 0; // Jobs submitted to the pool, which may start after Generate returned
+        std::size_t      m_remaining = 0; // Requested chunks not handed out yet
+        u64              m_callCount = 0;
+
+        std::exception_ptr m_pException;
+        GenerationStats    m_stats;
+
+    private:
+        static inline GenerationStage NextStage(const GenerationStage stage) { return static_cast<GenerationStage>(static_cast<u8>(stage) + 1); }
+
+        // How far away the chunks reading a stage from their neighbours can be, 0 when none does
+        static constexpr i32 GetReaderRadius(const GenerationStage stage) {
+            i32 radius = 0;
+
+            for (const GenerationStageInfo& info : details::GENERATION_STAGES)
+                if (info.neighbourStage == stage && info.radius > 0)
+                    radius = std::max(radius, info.radius);
+
+            return radius;
+        }
+
+        ProtoChunk& GetOrCreate(const ChunkCoord coord) {
+            std::unique_ptr<ProtoChunk>& pChunk = m_chunks[coord];
+
+            if (!pChunk)
+                pChunk = std::make_unique<ProtoChunk>(coord);
+
+            pChunk->lastUse = m_callCount;
+
+            return *pChunk;
+        }
+
+        // Raises the target of a chunk, and of the chunks its new stages read from
+        void Require(const ChunkCoord coord, const GenerationStage stage) {
+            ProtoChunk& proto = GetOrCreate(coord);
+
+            if (proto.target >= stage)
+                return;
+
+            const GenerationStage from = proto.target;
+            proto.target = stage;
+
+            for (GenerationStage s = NextStage(from); s <= stage; s = NextStage(s)) {
+                const GenerationStageInfo& info = GetGenerationStageInfo(s);
+
+                for (i32 dz = -info.radius; dz <= info.radius; ++dz)
+                    for (i32 dx = -info.radius; dx <= info.radius; ++dx)
+                        if (dx != 0 || dz != 0)
+                            Require(ChunkCoord{ coord.x + dx, coord.z + dz }, info.neighbourStage);
+            }
+        }
+
+        // Queues the next stage of a chunk if everything it reads is there. Called with the lock held, like the rest
+        void TrySchedule(ProtoChunk& proto) {
+            if (proto.bRunning || proto.stage >= proto.target)
+                return;
+
+            const GenerationStage next = NextStage(proto.stage);
+            const GenerationStageInfo& info = GetGenerationStageInfo(next);
+            const ChunkCoord coord = proto.chunk.GetCoord();
+
+            Task task{ &proto, next, GenerationNeighbourhood(coord) };
+
+            for (i32 dz = -info.radius; dz <= info.radius; ++dz) {
+                for (i32 dx = -info.radius; dx <= info.radius; ++dx) {
+                    const auto it = m_chunks.find(ChunkCoord{ coord.x + dx, coord.z + dz });
+
+                    if (it == m_chunks.end() || it->second->stage < info.neighbourStage)
+                        return;
+
+                    task.neighbours.Set(dx, dz, &it->second->heightmap);
+                }
+            }
+
+            proto.bRunning = true;
+            m_ready.push_back(task);
+        }
+
+        // Records a finished stage and queues what was waiting on it. Called with the lock held
+        void Complete(const Task& task) {
+            ProtoChunk& proto = *task.pChunk;
+            const ChunkCoord coord = proto.chunk.GetCoord();
+
+            proto.stage    = task.stage;
+            proto.bRunning = false;
+
+            if (proto.stage == GenerationStage::Full && proto.pOutput) {
+                *proto.pOutput = std::move(proto.chunk);
+                proto.chunk    = Chunk(coord);
+                proto.pOutput  = nullptr;
+
+                ++m_stats.chunks;
+                if (--m_remaining == 0)
+                    m_condition.notify_all();
+            }
+
+            TrySchedule(proto);
+
+            // Only the chunks that can be waiting on this stage are looked at again
+            const i32 reach = GetReaderRadius(proto.stage);
+
+            for (i32 dz = -reach; dz <= reach; ++dz) {
+                for (i32 dx = -reach; dx <= reach; ++dx) {
+                    if (dx == 0 && dz == 0)
+                        continue;
+
+                    const auto it = m_chunks.find(ChunkCoord{ coord.x + dx, coord.z + dz });
+
+                    if (it != m_chunks.end())
+                        TrySchedule(*it->second);
+                }
+            }
+        }
+
+        // Runs queued stages until there are none left, or, for the caller, until its chunks are done
+        void RunTasks(const bool bCaller) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            for (;;) {
+                if (bCaller && (m_remaining == 0 || m_pException))
+                    break;
+
+                if (m_ready.empty()) {
+                    if (!bCaller)
+                        break;
+
+                    m_condition.wait(lock);
+                    continue;
+                }
+
+                const Task task = m_ready.front();
+                m_ready.pop_front();
+                ++m_running;
+
+                lock.unlock();
+
+                std::exception_ptr pException;
+                const Timer timer;
+
+                try {
+                    m_generator.RunStage(task.stage, task.pChunk->chunk, task.pChunk->heightmap, task.neighbours);
+                } catch (...) {
+                    pException = std::current_exception();
+                }
+
+                const u64 elapsedUS = timer.GetElapsedUS();
+
+                lock.lock();
+
+                // Generate waits for the last stage to finish before it looks at the chunks again
+                if (--m_running == 0)
+                    m_condition.notify_all();
+
+                m_stats.runs[static_cast<std::size_t>(task.stage)]    += 1;
+                m_stats.stageUS[static_cast<std::size_t>(task.stage)] += elapsedUS;
+
+                if (pException) {
+                    if (!m_pException)
+                        m_pException = pException;
+
+                    m_condition.notify_all();
+                    continue;
+                }
+
+                const std::size_t queued = m_ready.size();
+                Complete(task);
+
+                // Newly ready stages wake the caller, and get helpers while some workers are idle
+                if (m_ready.size() > queued) {
+                    m_condition.notify_all();
+                    SpawnHelpers();
+                }
+            }
+
+            if (!bCaller && --m_helpers == 0)
+                m_condition.notify_all();
+        }
+
+        // Called with the lock held
+        void SpawnHelpers() {
+            while (m_helpers < std::min<std::size_t>(m_ready.size(), m_pool.GetThreadCount())) {
+                ++m_helpers;
+                m_pool.Submit([this] { RunTasks(false); });
+            }
+        }
+
+    public:
+        GenerationPipeline(const WorldGenerator& generator, ThreadPool& pool, const std::size_t maxCachedChunks = 4096)
+            : m_generator(generator), m_pool(pool), m_maxCachedChunks(maxCachedChunks)
+        { }
+
+        // Helpers still queued when Generate returned find nothing to do, but they must find the pipeline
+        ~GenerationPipeline() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_helpers == 0; });
+        }
+
+        GenerationPipeline(const GenerationPipeline&) = delete;
+        GenerationPipeline& operator=(const GenerationPipeline&) = delete;
+
+        // Fully generates the given chunks in place, and waits for them
+        void Generate(const std::vector<Chunk*>& chunks) {
+            if (chunks.empty())
+                return;
+
+            const Timer timer;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_callCount;
+
+                for (Chunk* pChunk : chunks) {
+                    ProtoChunk& proto = GetOrCreate(pChunk->GetCoord());
+
+                    // Handed out before and asked for again, which only its heightmap survived
+                    if (proto.stage == GenerationStage::Full) {
+                        proto.stage  = GenerationStage::Empty;
+                        proto.target = GenerationStage::Empty;
+                        proto.chunk  = Chunk(pChunk->GetCoord());
+                    }
+
+                    proto.pOutput = pChunk;
+                    ++m_remaining;
+
+                    Require(pChunk->GetCoord(), GenerationStage::Full);
+                }
+
+                for (auto& [coord, pProto] : m_chunks)
+                    TrySchedule(*pProto);
+
+                SpawnHelpers();
+            }
+
+            RunTasks(true);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_running == 0; });
+
+            if (m_pException) {
+                const std::exception_ptr pException = m_pException;
+
+                // The chunks are left half done, start over from nothing
+                m_pException = nullptr;
+                m_ready.clear();
+                m_chunks.clear();
+                m_remaining = 0;
+
+                std::rethrow_exception(pException);
+            }
+
+            // Partly generated chunks go first to the ones left unused for the longest
+            if (m_chunks.size() > m_maxCachedChunks) {
+                std::vector<std::pair<u64, ChunkCoord>> ages;
+                for (const auto& [coord, pProto] : m_chunks)
+                    ages.emplace_back(pProto->lastUse, coord);
+
+                const std::size_t excess = m_chunks.size() - m_maxCachedChunks;
+                std::nth_element(ages.begin(), ages.begin() + excess, ages.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+                for (std::size_t i = 0; i < excess; ++i)
+                    m_chunks.erase(ages[i].second);
+            }
+
+            m_stats.wallUS += timer.GetElapsedUS();
+        }
+
+        std::size_t GetCachedChunkCount() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_chunks.size();
+        }
+
+        GenerationStats GetStats() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_stats;
+        }
+
+        void ResetStats() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stats = GenerationStats{};
+        }
+    }; // class GenerationPipeline
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+
+namespace mc {
+
+    struct AABBf32 {
+        vec3f32 min;
+        vec3f32 max;
+
+        constexpr vec3f32 GetCenter()  const { return (min + max) * 0.5f; }
+        constexpr vec3f32 GetExtents() const { return (max - min) * 0.5f; }
+
+        constexpr bool Overlaps(const AABBf32& other) const {
+            return min.x < other.max.x && max.x > other.min.x
+                && min.y < other.max.y && max.y > other.min.y
+                && min.z < other.max.z && max.z > other.min.z;
+        }
+
+        constexpr bool Contains(const vec3f32& p) const {
+            return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z;
+        }
+
+        constexpr AABBf32 Translated(const vec3f32& t) const { return AABBf32{ min + t, max + t }; }
+        constexpr AABBf32 Merged(const AABBf32& o)     const { return AABBf32{ Min(min, o.min), Max(max, o.max) }; }
+    }; // struct AABBf32
+
+    /*
+     * Six planes (n.x, n.y, n.z, d) pointing inwards: a point p is inside when dot(n, p) + d >= 0 for all of them.
+     */
+    struct Frustumf32 {
+        std::array<vec4f32, 6> planes;
+
+        // Gribb & Hartmann extraction, adapted to Vulkan's [0, 1] depth range
+        static Frustumf32 FromViewProjection(const mat4f32& viewProjection) {
+            const mat4f32 t = Transpose(viewProjection);
+            const vec4f32 &r0 = t.columns[0], &r1 = t.columns[1], &r2 = t.columns[2], &r3 = t.columns[3];
+
+            Frustumf32 frustum{ { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2 } };
+
+            for (vec4f32& plane : frustum.planes)
+                plane = plane * (1.f / Length(ToVec3f32(plane)));
+
+            return frustum;
+        }
+
+        bool Intersects(const AABBf32& box) const {
+            for (const vec4f32& plane : planes) {
+                const vec3f32 p{ plane.x >= 0.f ? box.max.x : box.min.x, plane.y >= 0.f ? box.max.y : box.min.y, plane.z >= 0.f ? box.max.z : box.min.z };
+
+                if (Dot(ToVec3f32(plane), p) + plane.w < 0.f)
+                    return false;
+            }
+
+            return true;
+        }
+    }; // struct Frustumf32
+
+}; // namespace mc
\ No newline at end of file
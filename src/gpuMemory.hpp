@@ -0,0 +1,125 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Accounts for every device memory allocation the renderer makes, per memory heap. With
+ * VK_EXT_memory_budget the usage and budget of a heap are the driver's, which also sees
+ * what the swap chain and other processes take; without it the usage is what was allocated
+ * through here and the budget an estimate from the heap's size.
+ */
+
+namespace mc {
+
+    struct GpuHeapBudget {
+        vk::DeviceSize usage        = 0;
+        vk::DeviceSize budget       = 0;
+        bool           bDeviceLocal = false;
+    }; // struct GpuHeapBudget
+
+    struct GpuMemoryStats {
+        vk::DeviceSize allocated       = 0; // Live bytes allocated through GpuMemory, all heaps
+        vk::DeviceSize peak            = 0;
+        u64            allocationCount = 0;
+        bool           bDriverBudget   = false; // Budgets come from VK_EXT_memory_budget
+    }; // struct GpuMemoryStats
+
+    class GpuMemory {
+    private:
+        // Without VK_EXT_memory_budget, the share of a heap assumed to be ours: the driver and other processes take the rest
+        static constexpr f64 ESTIMATED_BUDGET_FRACTION = 0.8;
+
+        struct {
+            vk::PhysicalDevice                 physical;
+            vk::PhysicalDeviceMemoryProperties properties;
+
+            // Loaded when the device has VK_EXT_memory_budget, which is read through it
+            PFN_vkGetPhysicalDeviceMemoryProperties2KHR pfnGetMemoryProperties2 = nullptr;
+
+            std::mutex mutex;
+            std::unordered_map<VkDeviceMemory, std::pair<u32, vk::DeviceSize>> allocations; // Heap index and size
+            std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> heapAllocated{};
+
+            vk::DeviceSize allocated = 0;
+            vk::DeviceSize peak      = 0;
+        } static s_;
+
+    public:
+        // bMemoryBudget: VK_EXT_memory_budget was enabled on the device, and VK_KHR_get_physical_device_properties2 on the instance
+        static void Startup(const vk::Instance& instance, const vk::PhysicalDevice& physical, const bool bMemoryBudget) {
+            s_.physical   = physical;
+            s_.properties = physical.getMemoryProperties();
+
+            s_.pfnGetMemoryProperties2 = bMemoryBudget ? reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(instance.getProcAddr("vkGetPhysicalDeviceMemoryProperties2KHR")) : nullptr;
+        }
+
+        static vk::DeviceMemory Allocate(const vk::Device& device, const vk::MemoryAllocateInfo& allocationInfo) {
+            const vk::DeviceMemory memory = device.allocateMemory(allocationInfo);
+            const u32              heap   = GetHeapIndex(allocationInfo.memoryTypeIndex);
+
+            std::lock_guard<std::mutex> lock(s_.mutex);
+
+            s_.allocations.emplace(static_cast<VkDeviceMemory>(memory), std::pair{ heap, allocationInfo.allocationSize });
+            s_.heapAllocated[heap] += allocationInfo.allocationSize;
+            s_.allocated           += allocationInfo.allocationSize;
+            s_.peak                 = std::max(s_.peak, s_.allocated);
+
+            return memory;
+        }
+
+        static void Free(const vk::Device& device, const vk::DeviceMemory memory) {
+            device.freeMemory(memory);
+
+            std::lock_guard<std::mutex> lock(s_.mutex);
+
+            const auto it = s_.allocations.find(static_cast<VkDeviceMemory>(memory));
+            if (it == s_.allocations.end())
+                return;
+
+            s_.heapAllocated[it->second.first] -= it->second.second;
+            s_.allocated                       -= it->second.second;
+            s_.allocations.erase(it);
+        }
+
+        static inline u32 GetHeapIndex(const u32 memoryTypeIndex) { return s_.properties.memoryTypes[memoryTypeIndex].heapIndex; }
+        static inline u32 GetHeapCount()                          { return s_.properties.memoryHeapCount; }
+
+        // Asks the driver every call when it can tell, so it is meant for once a frame at most
+        static std::vector<GpuHeapBudget> QueryHeapBudgets() {
+            std::vector<GpuHeapBudget> budgets(s_.properties.memoryHeapCount);
+
+            for (u32 heap = 0; heap < s_.properties.memoryHeapCount; ++heap)
+                budgets[heap].bDeviceLocal = static_cast<bool>(s_.properties.memoryHeaps[heap].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+
+            if (s_.pfnGetMemoryProperties2) {
+                vk::StructureChain<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT> chain;
+                s_.pfnGetMemoryProperties2(static_cast<VkPhysicalDevice>(s_.physical), reinterpret_cast<VkPhysicalDeviceMemoryProperties2*>(&chain.get<vk::PhysicalDeviceMemoryProperties2>()));
+
+                const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& driver = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+                for (u32 heap = 0; heap < s_.properties.memoryHeapCount; ++heap) {
+                    budgets[heap].usage  = driver.heapUsage[heap];
+                    budgets[heap].budget = driver.heapBudget[heap];
+                }
+            } else {
+                std::lock_guard<std::mutex> lock(s_.mutex);
+
+                for (u32 heap = 0; heap < s_.properties.memoryHeapCount; ++heap) {
+                    budgets[heap].usage  = s_.heapAllocated[heap];
+                    budgets[heap].budget = static_cast<vk::DeviceSize>(static_cast<f64>(s_.properties.memoryHeaps[heap].size) * ESTIMATED_BUDGET_FRACTION);
+                }
+            }
+
+            return budgets;
+        }
+
+        static GpuMemoryStats GetStats() {
+            std::lock_guard<std::mutex> lock(s_.mutex);
+
+            return GpuMemoryStats{ s_.allocated, s_.peak, s_.allocations.size(), s_.pfnGetMemoryProperties2 != nullptr };
+        }
+    }; // class GpuMemory
+
+    decltype(GpuMemory::s_) GpuMemory::s_;
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Numbers the submissions to a queue: each one signals the next value, and since a queue finishes
+ * its work in submission order, the GPU having passed a value means everything submitted up to it
+ * is done. Resources are retired with the value of the last submission that can use them, and the
+ * CPU waits for the value it needs rather than for the whole queue.
+ *
+ * With Vulkan 1.2 the values are those of a timeline semaphore. On 1.0 every submission gets a fence
+ * instead, recycled once it signalled; the values then only exist on the CPU side.
+ */
+
+namespace mc {
+
+    enum class GpuTimelineMode : u8 {
+        eFences,   // Vulkan 1.0
+        eTimeline, // Vulkan 1.2, with the timelineSemaphore feature enabled
+    }; // enum class GpuTimelineMode
+
+    class GpuTimeline {
+    private:
+        vk::Device      m_device;
+        vk::Queue       m_queue;
+        GpuTimelineMode m_mode = GpuTimelineMode::eFences;
+
+        vk::Semaphore m_semaphore; // eTimeline only
+
+        std::deque<std::pair<u64, vk::Fence>> m_inFlight; // eFences only, by increasing value
+        std::vector<vk::Fence>                m_freeFences;
+
+        u64 m_submitted = 0;
+        u64 m_completed = 0;
+
+    public:
+        GpuTimeline() = default;
+
+        GpuTimeline(const vk::Device& device, const vk::Queue& queue, const GpuTimelineMode mode)
+            : m_device(device), m_queue(queue), m_mode(mode)
+        {
+            if (m_mode == GpuTimelineMode::eTimeline) {
+                vk::SemaphoreTypeCreateInfo stci{};
+                stci.semaphoreType = vk::SemaphoreType::eTimeline;
+                stci.initialValue  = 0;
+
+                vk::SemaphoreCreateInfo sci{};
+                sci.pNext = &stci;
+
+                m_semaphore = m_device.createSemaphore(sci);
+            }
+        }
+
+        GpuTimeline(GpuTimeline&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        GpuTimeline& operator=(GpuTimeline&& other) noexcept {
+            std::swap(m_device,     other.m_device);
+            std::swap(m_queue,      other.m_queue);
+            std::swap(m_mode,       other.m_mode);
+            std::swap(m_semaphore,  other.m_semaphore);
+            std::swap(m_inFlight,   other.m_inFlight);
+            std::swap(m_freeFences, other.m_freeFences);
+            std::swap(m_submitted,  other.m_submitted);
+            std::swap(m_completed,  other.m_completed);
+
+            return *this;
+        }
+
+        /*
+         * Submits the batch, which must not have a pNext chain of its own, and returns the value it
+         * signals. The batch's own semaphores are waited and signalled as they are.
+         */
+        u64 Submit(const vk::SubmitInfo& submitInfo) {
+            const u64 value = m_submitted + 1;
+
+            if (m_mode == GpuTimelineMode::eTimeline) {
+                std::vector<vk::Semaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+                signalSemaphores.push_back(m_semaphore);
+
+                // Binary semaphores ignore their value, but every signalled semaphore needs one
+                std::vector<u64> signalValues(signalSemaphores.size(), 0);
+                signalValues.back() = value;
+
+                vk::TimelineSemaphoreSubmitInfo tssi{};
+                tssi.signalSemaphoreValueCount = static_cast<u32>(signalValues.size());
+                tssi.pSignalSemaphoreValues    = signalValues.data();
+
+                vk::SubmitInfo timelineSubmitInfo = submitInfo;
+                timelineSubmitInfo.pNext                = &tssi;
+                timelineSubmitInfo.signalSemaphoreCount = static_cast<u32>(signalSemaphores.size());
+                timelineSubmitInfo.pSignalSemaphores    = signalSemaphores.data();
+
+                m_queue.submit(timelineSubmitInfo);
+            } else {
+                vk::Fence fence;
+
+                if (m_freeFences.empty()) {
+                    fence = m_device.createFence(vk::FenceCreateInfo{});
+                } else {
+                    fence = m_freeFences.back();
+                    m_freeFences.pop_back();
+                }
+
+                m_queue.submit(submitInfo, fence);
+                m_inFlight.emplace_back(value, fence);
+            }
+
+            m_submitted = value;
+
+            return value;
+        }
+
+        // Asks the device how far it got, which also recycles the fences that signalled
+        u64 GetCompletedValue() {
+            if (m_mode == GpuTimelineMode::eTimeline) {
+                m_completed = m_device.getSemaphoreCounterValue(m_semaphore);
+                return m_completed;
+            }
+
+            while (!m_inFlight.empty() && m_device.getFenceStatus(m_inFlight.front().second) == vk::Result::eSuccess) {
+                m_completed = m_inFlight.front().first;
+
+                m_device.resetFences(m_inFlight.front().second);
+                m_freeFences.push_back(m_inFlight.front().second);
+                m_inFlight.pop_front();
+            }
+
+            return m_completed;
+        }
+
+        // Blocks until the device passed the value, which must have been submitted
+        void Wait(const u64 value) {
+            if (value <= m_completed)
+                return;
+
+            assert(value <= m_submitted);
+
+            if (m_mode == GpuTimelineMode::eTimeline) {
+                vk::SemaphoreWaitInfo swi{};
+                swi.semaphoreCount = 1;
+                swi.pSemaphores    = &m_semaphore;
+                swi.pValues        = &value;
+
+                if (m_device.waitSemaphores(swi, UINT64_MAX) != vk::Result::eSuccess)
+                    throw std::runtime_error("GpuTimeline::Wait timed out");
+
+                m_completed = value;
+                return;
+            }
+
+            // Fences are kept by increasing value, and each submission has its own
+            const auto it = std::lower_bound(m_inFlight.begin(), m_inFlight.end(), value, [](const std::pair<u64, vk::Fence>& entry, const u64 v) { return entry.first < v; });
+
+            if (m_device.waitForFences(it->second, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+                throw std::runtime_error("GpuTimeline::Wait timed out");
+
+            GetCompletedValue();
+        }
+
+        inline void WaitIdle() { Wait(m_submitted); }
+
+        inline u64             GetSubmittedValue() const noexcept { return m_submitted;     }
+        inline u64             GetNextValue()      const noexcept { return m_submitted + 1; } // Signalled by the next Submit
+        inline GpuTimelineMode GetMode()           const noexcept { return m_mode;          }
+
+        // The queue must be done with every submission: see WaitIdle
+        ~GpuTimeline() {
+            if ((VkDevice)m_device == VK_NULL_HANDLE)
+                return;
+
+            if (m_semaphore)
+                m_device.destroySemaphore(m_semaphore);
+
+            for (const auto& [value, fence] : m_inFlight)
+                m_device.destroyFence(fence);
+
+            for (const vk::Fence fence : m_freeFences)
+                m_device.destroyFence(fence);
+        }
+    }; // class GpuTimeline
+
+}; // namespace mc
\ No newline at end of file
@@ -41,6 +41,7 @@
 #include <list>
 #include <array>
 #include <queue>
+#include <deque>
 #include <mutex>
 #include <cmath>
 #include <future>
@@ -50,11 +51,13 @@
 #include <vector>
 #include <memory>
 #include <bitset>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <numeric>
 #include <codecvt>
 #include <variant>
+#include <utility>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -63,8 +66,10 @@
 #include <exception>
 #include <algorithm>
 #include <functional>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <condition_variable>
 
 #ifdef _WIN32
 #   undef _CRT_SECURE_NO_WARNINGS
@@ -116,6 +121,20 @@
 #   define DO_DEBUG_COMMA(x) x,
 #endif
 
+/*
+ * SIMD Detection.
+ * SSE2 is part of x86-64, AVX has to be requested with MC_ENABLE_AVX.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define MC_SIMD_SSE
+#   include <immintrin.h>
+#endif
+
+#if defined(MC_SIMD_SSE) && defined(__AVX__)
+#   define MC_SIMD_AVX
+#endif
+
 /*
  * Better basic typenames.
  */
@@ -139,6 +158,14 @@ namespace mc {
     constexpr u32         MC_ENGINE_VERSION = MC_APPLICATION_VERSION;
 
     constexpr u32 MC_VULKAN_VERSION = VK_VERSION_1_0;
+    constexpr u32 MC_VULKAN_TIMELINE_VERSION = VK_API_VERSION_1_2; // Asked for when timeline semaphores are opted into (--timeline)
+
+    constexpr u32 MC_MAX_FRAMES_IN_FLIGHT     = 3u; // Per frame resources are sized for this many, the present policy picks how many are used
+    constexpr u32 MC_DEFAULT_FRAMES_IN_FLIGHT = 2u;
+
+    constexpr std::size_t MC_STAGING_BUFFER_SIZE = 16u << 20u; // Bytes of vertex data uploaded per frame before a flush
+    constexpr std::size_t MC_MIN_DRAWS_PER_RECORDING_BATCH = 64u; // Below this a batch costs more to hand to a worker than to record
+    constexpr u32 MC_OVERLAY_MAX_VERTICES = 8192u; // Per frame for the debug overlay, what does not fit is dropped
 
     constexpr inline std::array MC_VULKAN_INSTANCE_EXTENSIONS = {
         VK_KHR_SURFACE_EXTENSION_NAME,
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "header.hpp"
+#include "fileUtils.hpp"
+#include "byteStream.hpp"
+
+/*
+ * The game reads its input one tick at a time as InputFrames, whether they come from the window,
+ * from a recording being replayed, or both (while recording). A recording holds the world seed and
+ * the tick rate alongside the frames, which is all it takes to replay a session tick for tick.
+ *
+ * File layout: magic, version, seed, tick rate and tick count, then one record per tick whose input
+ * differs from "same buttons, no look": the number of ticks skipped since the previous record, a
+ * flags byte, then the buttons and/or the look deltas. Idle stretches cost a couple of bytes.
+ */
+
+namespace mc {
+
+    constexpr u32 MC_INPUT_TICK_RATE = 60; // Simulation ticks per second in single player
+
+    constexpr u32 MC_INPUT_RECORDING_MAGIC   = 0x4D434952u; // "MCIR"
+    constexpr u16 MC_INPUT_RECORDING_VERSION = 1;
+
+    enum class InputButton : u8 {
+        Forward, Back, Left, Right, Up, Down, Break, Place,
+        Count
+    }; // enum class InputButton
+
+    struct InputFrame {
+        u16 buttons = 0; // Bit per InputButton, set while held
+        i32 lookX   = 0; // Mouse movement during the tick, in pixels
+        i32 lookY   = 0;
+
+        inline bool IsDown(const InputButton button) const { return buttons & (1u << static_cast<u32>(button)); }
+
+        inline void SetDown(const InputButton button, const bool bDown) {
+            const u16 bit = static_cast<u16>(1u << static_cast<u32>(button));
+            buttons = bDown ? (buttons | bit) : (buttons & ~bit);
+        }
+    }; // struct InputFrame
+
+    namespace details {
+
+        enum InputRecordFlags : u8 {
+            INPUT_RECORD_BUTTONS = 1 << 0,
+            INPUT_RECORD_LOOK    = 1 << 1,
+        }; // enum InputRecordFlags
+
+    }; // namespace details
+
+    class InputRecorder {
+    private:
+        u64 m_seed;
+
+        std::vector<u8> m_body;
+        u32             m_tickCount   = 0;
+        u32             m_lastRecord  = 0; // Tick after the last record written
+        u16             m_lastButtons = 0;
+
+    public:
+        explicit InputRecorder(const u64 seed) : m_seed(seed) { }
+
+        inline u32 GetTickCount() const { return m_tickCount; }
+
+        void Record(const InputFrame& frame) {
+            u8 flags = 0;
+            flags |= frame.buttons != m_lastButtons      ? details::INPUT_RECORD_BUTTONS : 0;
+            flags |= frame.lookX != 0 || frame.lookY != 0 ? details::INPUT_RECORD_LOOK    : 0;
+
+            if (flags != 0) {
+                ByteWriter writer(m_body);
+                writer.WriteVarU32(m_tickCount - m_lastRecord);
+                writer.WriteU8(flags);
+
+                if (flags & details::INPUT_RECORD_BUTTONS)
+                    writer.WriteU16(frame.buttons);
+
+                if (flags & details::INPUT_RECORD_LOOK) {
+                    writer.WriteVarI32(frame.lookX);
+                    writer.WriteVarI32(frame.lookY);
+                }
+
+                m_lastRecord  = m_tickCount + 1;
+                m_lastButtons = frame.buttons;
+            }
+
+            ++m_tickCount;
+        }
+
+        bool Save(const std::string& filename) const {
+            FileWrite file{ filename, {} };
+
+            ByteWriter writer(file.data);
+            writer.WriteU32(MC_INPUT_RECORDING_MAGIC);
+            writer.WriteU16(MC_INPUT_RECORDING_VERSION);
+            writer.WriteU32(static_cast<u32>(m_seed));
+            writer.WriteU32(static_cast<u32>(m_seed >> 32));
+            writer.WriteU32(MC_INPUT_TICK_RATE);
+            writer.WriteU32(m_tickCount);
+            writer.WriteBytes(m_body.data(), m_body.size());
+
+            return WriteFilesAtomically({ file });
+        }
+    }; // class InputRecorder
+
+    class InputReplay {
+    private:
+        u64 m_seed = 0;
+
+        std::vector<InputFrame> m_frames;
+        std::size_t             m_next = 0;
+
+    public:
+        static InputReplay Load(const std::string& filename) {
+            const std::optional<std::vector<char>> file = ReadBinaryFileToBuffer(filename);
+
+            if (!file.has_value())
+                throw std::runtime_error("[INPUT] Could not read the recording " + filename);
+
+            ByteReader reader(file->data(), file->size());
+
+            if (reader.ReadU32() != MC_INPUT_RECORDING_MAGIC || reader.ReadU16() != MC_INPUT_RECORDING_VERSION)
+                throw std::runtime_error("[INPUT] " + filename + " is not a recording this version can replay");
+
+            InputReplay replay;
+            replay.m_seed = reader.ReadU32();
+            replay.m_seed |= static_cast<u64>(reader.ReadU32()) << 32;
+
+            if (reader.ReadU32() != MC_INPUT_TICK_RATE)
+                throw std::runtime_error("[INPUT] " + filename + " was recorded at another tick rate");
+
+            replay.m_frames.resize(reader.ReadU32());
+
+            std::vector<InputFrame>& frames = replay.m_frames;
+
+            // Held buttons are only written when they change, every tick up to the next change keeps them
+            u16         buttons = 0;
+            std::size_t filled  = 0;
+
+            const auto FillButtons = [&](const std::size_t end) {
+                for (; filled < std::min(end, frames.size()); ++filled)
+                    frames[filled].buttons = buttons;
+            };
+
+            for (std::size_t tick = 0; reader.IsValid() && reader.GetRemaining() > 0; ++tick) {
+                tick += reader.ReadVarU32();
+
+                const u8 flags = reader.ReadU8();
+
+                if (flags & details::INPUT_RECORD_BUTTONS) {
+                    FillButtons(tick);
+                    buttons = reader.ReadU16();
+                }
+
+                if (flags & details::INPUT_RECORD_LOOK) {
+                    const i32 lookX = reader.ReadVarI32();
+                    const i32 lookY = reader.ReadVarI32();
+
+                    if (tick < frames.size()) {
+                        frames[tick].lookX = lookX;
+                        frames[tick].lookY = lookY;
+                    }
+                }
+            }
+
+            FillButtons(frames.size());
+
+            if (!reader.IsValid())
+                throw std::runtime_error("[INPUT] " + filename + " is truncated");
+
+            return replay;
+        }
+
+        /*
+         * A canned session for comparing render settings: climbs for CLIMB_TICKS, then flies forward
+         * while turning a pixel a tick, a circle of about 80 blocks around the spawn that sweeps the
+         * view over every LOD ring and keeps within the spawn area. The same on every run, so two
+         * runs' reports compare like those of any recording.
+         */
+        static InputReplay FlyThrough(const u64 seed, const u32 ticks) {
+            constexpr u32 CLIMB_TICKS = 5 * MC_INPUT_TICK_RATE;
+
+            InputReplay replay;
+            replay.m_seed = seed;
+            replay.m_frames.resize(ticks);
+
+            for (u32 tick = 0; tick < ticks; ++tick) {
+                InputFrame& frame = replay.m_frames[tick];
+
+                frame.SetDown(tick < CLIMB_TICKS ? InputButton::Up : InputButton::Forward, true);
+                frame.lookX = tick < CLIMB_TICKS ? 0 : 1;
+            }
+
+            return replay;
+        }
+
+        inline u64         GetSeed()        const { return m_seed;                     }
+        inline std::size_t GetTickCount()   const { return m_frames.size();            }
+        inline std::size_t GetCurrentTick() const { return m_next;                     }
+        inline bool        IsFinished()     const { return m_next >= m_frames.size();  }
+
+        inline InputFrame Next() { return IsFinished() ? InputFrame{} : m_frames[m_next++]; }
+    }; // class InputReplay
+
+}; // namespace mc
\ No newline at end of file
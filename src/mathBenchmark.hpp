@@ -0,0 +1,139 @@
+#pragma once
+
+#include "header.hpp"
+#include "simd.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "matrix.hpp"
+#include "geometry.hpp"
+
+/*
+ * The math library's SIMD paths against the scalar code they replace: mat4 products, dot products,
+ * box overlaps and frustum tests, each over the same batch of random inputs, the scalar side as the
+ * compiler made it (it may vectorize some of it on its own). The SIMD side is whatever the build
+ * has: AVX with MC_ENABLE_AVX, SSE2 on any x86-64, else the scalar fallback, which then times the same.
+ * Results are summed into a volatile so nothing timed is optimized away.
+ */
+
+namespace mc {
+
+    class MathBenchmark {
+    private:
+        static constexpr u32 BATCH = 4096; // Items per round, a multiple of 8; small enough to stay in cache
+        static constexpr u64 SEED  = 0x4D617468ull;
+
+        struct Inputs {
+            std::vector<mat4f32>    matrices;
+            std::vector<simd::mat4> wideMatrices;
+            std::vector<vec4f32>    vectors;
+            std::vector<simd::vec4> wideVectors;
+            std::vector<AABBf32>    boxes;
+            std::vector<simd::AABBx8> wideBoxes; // The same boxes, eight per batch
+            AABBf32                 query;
+            Frustumf32              frustum;
+        }; // struct Inputs
+
+        // Nanoseconds per item, scalar then SIMD
+        struct Result {
+            const char* name;
+            f64         scalarNS;
+            f64         simdNS;
+        }; // struct Result
+
+        static f32 Random(u64& state, const f32 lo, const f32 hi) {
+            state = noise::Hash(state);
+
+            return lo + (hi - lo) * noise::HashToUnit(state);
+        }
+
+        static Inputs MakeInputs() {
+            Inputs inputs;
+            u64    state = SEED;
+
+            for (u32 i = 0; i < BATCH; ++i) {
+                mat4f32 m;
+                for (f32& value : m.data)
+                    value = Random(state, -1.f, 1.f);
+
+                const vec4f32 v{ Random(state, -1.f, 1.f), Random(state, -1.f, 1.f), Random(state, -1.f, 1.f), Random(state, -1.f, 1.f) };
+
+                // Chunk sized boxes over a square a frustum from its middle sees a part of
+                const vec3f32 min{ Random(state, -512.f, 512.f), Random(state, 0.f, 240.f), Random(state, -512.f, 512.f) };
+
+                inputs.matrices.push_back(m);
+                inputs.wideMatrices.push_back(simd::mat4::Load(m));
+                inputs.vectors.push_back(v);
+                inputs.wideVectors.push_back(simd::vec4::Load(v));
+                inputs.boxes.push_back(AABBf32{ min, min + vec3f32{ 16.f, 16.f, 16.f } });
+            }
+
+            inputs.wideBoxes.resize(BATCH / 8);
+            for (u32 i = 0; i < BATCH; ++i)
+                inputs.wideBoxes[i / 8].Set(i % 8, inputs.boxes[i]);
+
+            inputs.query = AABBf32{ vec3f32{ -128.f, 32.f, -128.f }, vec3f32{ 128.f, 160.f, 128.f } };
+
+            const mat4f32 view       = LookAtMat4f32(vec3f32{ 0.f, 100.f, 0.f }, vec3f32{ 1.f, 95.f, -1.f }, vec3f32{ 0.f, 1.f, 0.f });
+            const mat4f32 projection = PerspectiveMat4f32(1.22f, 16.f / 9.f, 0.1f, 2048.f);
+
+            inputs.frustum = Frustumf32::FromViewProjection(projection * view);
+
+            return inputs;
+        }
+
+        // Runs the body over the rounds and returns the nanoseconds per item
+        template <typename F>
+        static f64 Time(const u32 rounds, const F& body) {
+            volatile f32 sink = 0.f;
+
+            const Timer timer;
+
+            for (u32 round = 0; round < rounds; ++round)
+                sink = sink + body();
+
+            return static_cast<f64>(timer.GetElapsedNS()) / (static_cast<f64>(rounds) * BATCH);
+        }
+
+    public:
+        static void RunAll(const u32 rounds, std::ostream& out) {
+#if defined(MC_SIMD_AVX)
+            const char* pPath = "AVX";
+#elif defined(MC_SIMD_SSE)
+            const char* pPath = "SSE2";
+#else
+            const char* pPath = "none, the SIMD side is the scalar fallback";
+#endif
+
+            out << "[BENCHMARK] " << rounds << " rounds of " << BATCH << " items, SIMD: " << pPath << '\n';
+
+            const Inputs in = MakeInputs();
+            std::vector<Result> results;
+
+            results.push_back(Result{ "mat4 multiply",
+                Time(rounds, [&] { f32 sum = 0.f; for (u32 i = 0; i < BATCH; ++i) sum += (in.matrices[i] * in.matrices[(i + 1) % BATCH]).data[5]; return sum; }),
+                Time(rounds, [&] { f32 sum = 0.f; for (u32 i = 0; i < BATCH; ++i) sum += (in.wideMatrices[i] * in.wideMatrices[(i + 1) % BATCH]).columns[1].Store().y; return sum; }) });
+
+            results.push_back(Result{ "vec4 dot",
+                Time(rounds, [&] { f32 sum = 0.f; for (u32 i = 0; i < BATCH; ++i) sum += Dot(in.vectors[i], in.vectors[(i + 1) % BATCH]); return sum; }),
+                Time(rounds, [&] { f32 sum = 0.f; for (u32 i = 0; i < BATCH; ++i) sum += simd::Dot(in.wideVectors[i], in.wideVectors[(i + 1) % BATCH]); return sum; }) });
+
+            results.push_back(Result{ "AABB overlap",
+                Time(rounds, [&] { u32 hits = 0; for (u32 i = 0; i < BATCH; ++i) hits += in.boxes[i].Overlaps(in.query) ? 1 : 0; return static_cast<f32>(hits); }),
+                Time(rounds, [&] { u32 hits = 0; for (const simd::AABBx8& boxes : in.wideBoxes) hits += static_cast<u32>(std::bitset<8>(simd::Overlaps(boxes, in.query)).count()); return static_cast<f32>(hits); }) });
+
+            results.push_back(Result{ "frustum test",
+                Time(rounds, [&] { u32 hits = 0; for (u32 i = 0; i < BATCH; ++i) hits += in.frustum.Intersects(in.boxes[i]) ? 1 : 0; return static_cast<f32>(hits); }),
+                Time(rounds, [&] { u32 hits = 0; for (const simd::AABBx8& boxes : in.wideBoxes) hits += static_cast<u32>(std::bitset<8>(simd::Intersects(in.frustum, boxes)).count()); return static_cast<f32>(hits); }) });
+
+            for (const Result& result : results) {
+                out << "[BENCHMARK] " << std::left << std::setw(14) << result.name << std::right << std::fixed << std::setprecision(2)
+                    << " scalar " << std::setw(7) << result.scalarNS << " ns"
+                    << " | simd "  << std::setw(7) << result.simdNS   << " ns"
+                    << " | "       << std::setw(5) << result.scalarNS / std::max(result.simdNS, 1e-3) << "x\n";
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class MathBenchmark
+
+}; // namespace mc
\ No newline at end of file
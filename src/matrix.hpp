@@ -0,0 +1,126 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+
+/*
+ * Column major 4x4 matrices, laid out like GLSL's mat4 so they can be
+ * copied straight into uniform blocks. Clip space follows Vulkan's
+ * conventions: Y points down and depth goes from 0 to 1.
+ */
+
+namespace mc {
+
+    struct mat4f32 { union { vec4f32 columns[4]; f32 data[16]; }; };
+
+    static_assert(sizeof(mat4f32) == 16 * sizeof(f32), "mat4f32 must match the layout of a GLSL mat4");
+
+    constexpr mat4f32 IdentityMat4f32() {
+        return mat4f32{ {
+            vec4f32{ 1.f, 0.f, 0.f, 0.f },
+            vec4f32{ 0.f, 1.f, 0.f, 0.f },
+            vec4f32{ 0.f, 0.f, 1.f, 0.f },
+            vec4f32{ 0.f, 0.f, 0.f, 1.f }
+        } };
+    }
+
+    constexpr vec4f32 operator*(const mat4f32& m, const vec4f32& v) {
+        return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z + m.columns[3] * v.w;
+    }
+
+    constexpr mat4f32 operator*(const mat4f32& a, const mat4f32& b) {
+        return mat4f32{ { a * b.columns[0], a * b.columns[1], a * b.columns[2], a * b.columns[3] } };
+    }
+
+    constexpr mat4f32 Transpose(const mat4f32& m) {
+        return mat4f32{ {
+            vec4f32{ m.columns[0].x, m.columns[1].x, m.columns[2].x, m.columns[3].x },
+            vec4f32{ m.columns[0].y, m.columns[1].y, m.columns[2].y, m.columns[3].y },
+            vec4f32{ m.columns[0].z, m.columns[1].z, m.columns[2].z, m.columns[3].z },
+            vec4f32{ m.columns[0].w, m.columns[1].w, m.columns[2].w, m.columns[3].w }
+        } };
+    }
+
+    constexpr vec3f32 TransformPoint(const mat4f32& m, const vec3f32& p) {
+        return ToVec3f32(m * ToVec4f32(p, 1.f));
+    }
+
+    constexpr mat4f32 TranslationMat4f32(const vec3f32& t) {
+        return mat4f32{ {
+            vec4f32{ 1.f, 0.f, 0.f, 0.f },
+            vec4f32{ 0.f, 1.f, 0.f, 0.f },
+            vec4f32{ 0.f, 0.f, 1.f, 0.f },
+            vec4f32{ t.x, t.y, t.z, 1.f }
+        } };
+    }
+
+    constexpr mat4f32 ScaleMat4f32(const vec3f32& s) {
+        return mat4f32{ {
+            vec4f32{ s.x, 0.f, 0.f, 0.f },
+            vec4f32{ 0.f, s.y, 0.f, 0.f },
+            vec4f32{ 0.f, 0.f, s.z, 0.f },
+            vec4f32{ 0.f, 0.f, 0.f, 1.f }
+        } };
+    }
+
+    inline mat4f32 PerspectiveMat4f32(const f32 fovYRadians, const f32 aspect, const f32 zNear, const f32 zFar) {
+        const f32 f = 1.f / std::tan(fovYRadians * 0.5f);
+
+        return mat4f32{ {
+            vec4f32{ f / aspect, 0.f, 0.f,                             0.f },
+            vec4f32{ 0.f,        -f,  0.f,                             0.f },
+            vec4f32{ 0.f,        0.f, zFar / (zNear - zFar),          -1.f },
+            vec4f32{ 0.f,        0.f, zNear * zFar / (zNear - zFar),   0.f }
+        } };
+    }
+
+    inline mat4f32 LookAtMat4f32(const vec3f32& eye, const vec3f32& target, const vec3f32& up) {
+        const vec3f32 f = Normalize(target - eye);
+        const vec3f32 s = Normalize(Cross(f, up));
+        const vec3f32 u = Cross(s, f);
+
+        return mat4f32{ {
+            vec4f32{ s.x,           u.x,          -f.x,          0.f },
+            vec4f32{ s.y,           u.y,          -f.y,          0.f },
+            vec4f32{ s.z,           u.z,          -f.z,          0.f },
+            vec4f32{ -Dot(s, eye), -Dot(u, eye),  Dot(f, eye),  1.f }
+        } };
+    }
+
+    // General inverse through cofactors. Only used off the hot path (unprojecting picking rays, ...)
+    inline mat4f32 Inverse(const mat4f32& m) {
+        const f32* a = m.data;
+
+        mat4f32 r{};
+        f32* inv = r.data;
+
+        inv[0]  =  a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+        inv[4]  = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+        inv[8]  =  a[4] * a[9]  * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+        inv[12] = -a[4] * a[9]  * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+        inv[1]  = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+        inv[5]  =  a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+        inv[9]  = -a[0] * a[9]  * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+        inv[13] =  a[0] * a[9]  * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+        inv[2]  =  a[1] * a[6]  * a[15] - a[1] * a[7]  * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7]  - a[13] * a[3] * a[6];
+        inv[6]  = -a[0] * a[6]  * a[15] + a[0] * a[7]  * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7]  + a[12] * a[3] * a[6];
+        inv[10] =  a[0] * a[5]  * a[15] - a[0] * a[7]  * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7]  - a[12] * a[3] * a[5];
+        inv[14] = -a[0] * a[5]  * a[14] + a[0] * a[6]  * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6]  + a[12] * a[2] * a[5];
+        inv[3]  = -a[1] * a[6]  * a[11] + a[1] * a[7]  * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9]  * a[2] * a[7]  + a[9]  * a[3] * a[6];
+        inv[7]  =  a[0] * a[6]  * a[11] - a[0] * a[7]  * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8]  * a[2] * a[7]  - a[8]  * a[3] * a[6];
+        inv[11] = -a[0] * a[5]  * a[11] + a[0] * a[7]  * a[9]  + a[4] * a[1] * a[11] - a[4] * a[3] * a[9]  - a[8]  * a[1] * a[7]  + a[8]  * a[3] * a[5];
+        inv[15] =  a[0] * a[5]  * a[10] - a[0] * a[6]  * a[9]  - a[4] * a[1] * a[10] + a[4] * a[2] * a[9]  + a[8]  * a[1] * a[6]  - a[8]  * a[2] * a[5];
+
+        const f32 det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+
+        if (det == 0.f)
+            return IdentityMat4f32();
+
+        const f32 invDet = 1.f / det;
+        for (f32& v : r.data)
+            v *= invDet;
+
+        return r;
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "header.hpp"
+#include "vertex.hpp"
+#include "renderer.hpp"
+#include "vertexBuffer.hpp"
+
+/*
+ * The chunk meshes' vertices, sub-allocated from a few large vertex buffers ("blocks") instead of
+ * one buffer and one device memory allocation per mesh: tens of thousands of sections in view would
+ * otherwise run into maxMemoryAllocationCount, 4096 on many drivers. A mesh is a range of vertices
+ * in a block, drawn with its first vertex as the offset.
+ *
+ * Each block keeps its free ranges by position, so a freed range merges with its neighbours, and by
+ * size, so an allocation takes the smallest one that fits. A freed range may still be drawn by the
+ * frames in flight: it is retired against the renderer's timeline and only goes back to its block
+ * once the GPU passed them. A block left empty is given back to the driver.
+ */
+
+namespace mc {
+
+    // A mesh's vertices in a MeshArena block; an empty range holds nothing and draws nothing
+    struct MeshRange {
+        u32 block = 0;
+        u32 first = 0; // In vertices from the start of the block
+        u32 count = 0;
+    }; // struct MeshRange
+
+    class MeshArena {
+    private:
+        struct Block {
+            mc::VertexBuffer buffer;
+            u32              capacity = 0; // In vertices
+            u32              used     = 0; // Allocated or retired
+
+            std::map<u32, u32>            freeByFirst; // First vertex to count
+            std::set<std::pair<u32, u32>> freeBySize;  // Count and first vertex
+        }; // struct Block
+
+        VertexBufferMode m_mode          = VertexBufferMode::eMapped;
+        u32              m_blockVertices = 0;
+
+        // Null where a block was given back, so the ranges' block indices stay valid
+        std::vector<std::unique_ptr<Block>>   m_blocks;
+        std::deque<std::pair<MeshRange, u64>> m_retired; // With the timeline value to wait for
+
+    private:
+        void AddFreeRange(Block& block, u32 first, u32 count) {
+            auto next = block.freeByFirst.lower_bound(first);
+
+            if (next != block.freeByFirst.end() && first + count == next->first) {
+                count += next->second;
+                block.freeBySize.erase({ next->second, next->first });
+                next = block.freeByFirst.erase(next);
+            }
+
+            if (next != block.freeByFirst.begin()) {
+                const auto previous = std::prev(next);
+
+                if (previous->first + previous->second == first) {
+                    first  = previous->first;
+                    count += previous->second;
+                    block.freeBySize.erase({ previous->second, previous->first });
+                    block.freeByFirst.erase(previous);
+                }
+            }
+
+            block.freeByFirst.emplace(first, count);
+            block.freeBySize.emplace(count, first);
+        }
+
+        std::optional<u32> TakeFreeRange(Block& block, const u32 count) {
+            const auto it = block.freeBySize.lower_bound({ count, 0 });
+
+            if (it == block.freeBySize.end())
+                return {};
+
+            const auto [size, first] = *it;
+
+            block.freeBySize.erase(it);
+            block.freeByFirst.erase(first);
+
+            if (size > count) {
+                block.freeByFirst.emplace(first + count, size - count);
+                block.freeBySize.emplace(size - count, first + count);
+            }
+
+            block.used += count;
+
+            return first;
+        }
+
+        void Free(const MeshRange& range) {
+            Block& block = *m_blocks[range.block];
+
+            AddFreeRange(block, range.first, range.count);
+            block.used -= range.count;
+
+            if (block.used == 0) {
+                mc::Renderer::Retire(std::move(block.buffer));
+                m_blocks[range.block].reset();
+            }
+        }
+
+    public:
+        MeshArena() = default;
+
+        MeshArena(const MeshArena&) = delete;
+        MeshArena& operator=(const MeshArena&) = delete;
+
+        // Takes effect for the blocks made from now on
+        inline void Configure(const VertexBufferMode mode, const std::size_t blockBytes) {
+            m_mode          = mode;
+            m_blockVertices = static_cast<u32>(std::max<std::size_t>(blockBytes / sizeof(Vertex), 1));
+        }
+
+        // The first block with room, or a new one. A mesh larger than a block gets a block of its own
+        MeshRange Allocate(const u32 count) {
+            if (count == 0)
+                return MeshRange{};
+
+            for (u32 i = 0; i < m_blocks.size(); ++i)
+                if (m_blocks[i] && m_blocks[i]->buffer.GetMode() == m_mode)
+                    if (const std::optional<u32> first = TakeFreeRange(*m_blocks[i], count))
+                        return MeshRange{ i, first.value(), count };
+
+            u32 index = 0;
+            while (index < m_blocks.size() && m_blocks[index])
+                ++index;
+
+            if (index == m_blocks.size())
+                m_blocks.emplace_back();
+
+            auto pBlock = std::make_unique<Block>();
+            pBlock->capacity = std::max(m_blockVertices, count);
+            pBlock->buffer   = mc::Renderer::CreateVertexBuffer(static_cast<std::size_t>(pBlock->capacity) * sizeof(Vertex), m_mode);
+
+            AddFreeRange(*pBlock, 0, pBlock->capacity);
+
+            const u32 first = TakeFreeRange(*pBlock, count).value();
+            m_blocks[index] = std::move(pBlock);
+
+            return MeshRange{ index, first, count };
+        }
+
+        // The range goes back to its block once the GPU passed every submission that may still read it
+        void Retire(const MeshRange& range) {
+            if (range.count > 0)
+                m_retired.emplace_back(range, mc::Renderer::GetRetireValue());
+        }
+
+        void ReleaseRetired() {
+            if (m_retired.empty())
+                return;
+
+            const u64 completed = mc::Renderer::GetCompletedValue();
+
+            while (!m_retired.empty() && m_retired.front().second <= completed) {
+                Free(m_retired.front().first);
+                m_retired.pop_front();
+            }
+        }
+
+        inline mc::VertexBuffer& GetBuffer(const MeshRange& range) { return m_blocks[range.block]->buffer; }
+
+        static inline std::size_t GetByteOffset(const MeshRange& range) { return static_cast<std::size_t>(range.first) * sizeof(Vertex); }
+        static inline std::size_t GetByteSize(const MeshRange& range)   { return static_cast<std::size_t>(range.count) * sizeof(Vertex); }
+
+        inline u32 GetHeapIndex(const MeshRange& range) const { return m_blocks[range.block]->buffer.GetHeapIndex(); }
+
+        // Queues the uploads of what was written to the blocks since the last call
+        void Upload() {
+            for (const std::unique_ptr<Block>& pBlock : m_blocks)
+                if (pBlock)
+                    mc::Renderer::Upload(pBlock->buffer);
+        }
+
+        std::size_t GetBlockCount() const {
+            return static_cast<std::size_t>(std::count_if(m_blocks.begin(), m_blocks.end(), [](const std::unique_ptr<Block>& pBlock) { return pBlock != nullptr; }));
+        }
+
+        // What the blocks take from a heap, and how much of it no mesh holds (retired ranges included)
+        std::pair<vk::DeviceSize, vk::DeviceSize> GetHeapUsage(const u32 heap) const {
+            vk::DeviceSize allocated = 0, free = 0;
+
+            for (const std::unique_ptr<Block>& pBlock : m_blocks) {
+                if (!pBlock || pBlock->buffer.GetHeapIndex() != heap)
+                    continue;
+
+                allocated += pBlock->buffer.GetAllocationSize();
+                free      += static_cast<vk::DeviceSize>(pBlock->capacity - pBlock->used) * sizeof(Vertex);
+            }
+
+            for (const auto& [range, value] : m_retired)
+                if (m_blocks[range.block]->buffer.GetHeapIndex() == heap)
+                    free += GetByteSize(range);
+
+            return { allocated, free };
+        }
+
+        // Once the GPU is idle
+        void Clear() {
+            m_retired.clear();
+            m_blocks.clear();
+        }
+    }; // class MeshArena
+
+}; // namespace mc
\ No newline at end of file
@@ -3,37 +3,867 @@
 #include "appSurface.hpp"
 #include "renderer.hpp"
 #include "timer.hpp"
+#include "world.hpp"
+#include "camera.hpp"
+#include "threadPool.hpp"
+#include "shaderWatcher.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+#include "chunkMeshManager.hpp"
+#include "farField.hpp"
+#include "netClient.hpp"
+#include "server.hpp"
+#include "worldSaver.hpp"
+#include "raycast.hpp"
+#include "input.hpp"
+#include "tickTimings.hpp"
+#include "submitBenchmark.hpp"
+#include "blockTicks.hpp"
+#include "tickBenchmark.hpp"
+#include "fluids.hpp"
+#include "fluidBenchmark.hpp"
+#include "allocBenchmark.hpp"
+#include "chunkStress.hpp"
+#include "debugOverlay.hpp"
+#include "pathBenchmark.hpp"
+#include "parseUtils.hpp"
+#include "farFieldBenchmark.hpp"
+#include "mathBenchmark.hpp"
+#include "raycastBenchmark.hpp"
+#include "entityBenchmark.hpp"
+#include "saveBenchmark.hpp"
+
+#include <csignal>
+#include <cstring>
 
 namespace mc {
 
     class Minecraft {
+    private:
+        static constexpr u64 WORLD_SEED      = 0x4D696E6563726166ull;
+        static constexpr u32 STARTUP_THREADS = 3; // Besides the main one: the spawn area, and the instance and the files next to it
+
+        // A benchmark run instead of the game by its flag, which takes how many rounds, frames or seconds to run
+        struct BenchmarkTool {
+            const char* flag;
+            void      (*run)(u32 count);
+        }; // struct BenchmarkTool
+
+        struct {
+            mc::World              world;
+            mc::WorldGenerator     generator{ WORLD_SEED };
+            mc::ThreadPool         threadPool;
+            mc::GenerationPipeline generation{ generator, threadPool };
+            mc::Camera             camera;
+            mc::ChunkMeshManager   chunkMeshes;
+            mc::BlockTickScheduler blockTicks{ WORLD_SEED };
+            mc::FluidEngine        fluids;
+            mc::ShaderWatcher      shaderWatcher;
+
+            // The terrain past the meshes' reach, ray marched by the renderer. Made once the renderer started
+            std::unique_ptr<mc::FarField> pFarField;
+
+            // Set by --server: no window, no renderer, just the server and its bots
+            std::optional<mc::ServerSettings> serverSettings;
+            u32                               botCount = 0;
+            std::atomic<bool>                 bStopServer{ false }; // Set by SIGINT or SIGTERM
+
+            // Set by --connect: the world is whatever the server streams in
+            std::unique_ptr<mc::NetClient> pClient;
+
+            // Single player only, the server saves its own world
+            std::unique_ptr<mc::WorldSaver> pSaver;
+            mc::Timer                       autosaveTimer;
+
+            // Single player runs at a fixed MC_INPUT_TICK_RATE so that input can be recorded and replayed per tick
+            mc::Timer      tickClock;
+            u64            clockTicks = 0; // Ticks run since tickClock started
+            u32            tick       = 0;
+            mc::InputFrame lastInput;
+
+            // --record and --replay sessions start from the seed alone, never from the save. --flythrough TICKS
+            // replays a canned flight over the spawn area instead, which with --lod-scale K (ringEnds times K)
+            // compares the frame times of two render distances: --compare the two runs' reports
+            std::unique_ptr<mc::InputRecorder> pRecorder;
+            std::optional<mc::InputReplay>     replay;
+            std::string                        recordFilename;
+            std::string                        reportFilename = "replay.csv";
+            bool                               bHeadless      = false; // Replay without window nor renderer
+            bool                               bRealtime      = false; // Replay at the tick rate rather than as fast as possible
+            mc::TickTimings                    timings;
+
+            // --record-sweep N: once the meshes are all in, N frames of draw recording per batch limit, from
+            // one thread to every worker, the input ignored so the draws stay the same; then quits
+            u32 recordSweepFrames = 0;
+            u32 sweepLimit        = 0; // Being measured, 0 until the meshes are in
+            u32 sweepFrame        = 0;
+            u64 sweepRecordUS     = 0;
+
+            // --compare baseline.csv current.csv: a regression gate over two replay reports
+            std::vector<std::string> compareFilenames;
+            f64                      tolerance = 0.05;
+
+            bool bTimelineSemaphores = false; // --timeline: opts into Vulkan 1.2 for the renderer's synchronization
+            bool bSerialStartup      = false; // --serial-startup: runs the startup's tasks one after the other, to compare against
+
+            // Set by one of GetBenchmarkTools()' flags
+            const BenchmarkTool* pBenchmark     = nullptr;
+            u32                  benchmarkCount = 0;
+
+            // --present low-latency|balanced|throughput, then --present-mode, --swapchain-images, --frames-in-flight and --pacing on|off override its parts
+            mc::PresentPolicy presentPolicy;
+            mc::Timer         frameReportTimer;
+
+            // The performance overlay, toggled by F3 and shown from the start by --overlay. Its histories are
+            // fed whether it shows or not, so it opens on full graphs
+            bool               bOverlay = false;
+            mc::OverlayHistory frameTimes; // From one frame's start to the next's
+            mc::OverlayHistory tickTimes;
+            mc::OverlayHistory gpuTimes;
+            mc::Timer          frameClock;
+            u64                overlayUS = 0; // Building the last overlay
+
+            mc::Timer startupClock;       // Made with the statics, so from the program's start
+            bool      bFirstFrame = true; // Until one is rendered, to report how long it took
+
+            bool bQuit    = false;
+            int  exitCode = 0;
+        } static s_;
+
+    private:
+        static void PrintGenerationStats() {
+            const mc::GenerationStats stats = s_.generation.GetStats();
+
+            if (stats.chunks == 0)
+                return;
+
+            std::cout << "[WORLD] Generated " << stats.chunks << " chunks in " << stats.wallUS / 1000 << " ms, "
+                      << stats.chunks * 1000000 / std::max<u64>(stats.wallUS, 1) << " chunks/s on " << s_.threadPool.GetThreadCount() + 1 << " threads |";
+
+            for (std::size_t i = 1; i < stats.runs.size(); ++i)
+                std::cout << ' ' << mc::GetGenerationStageInfo(static_cast<mc::GenerationStage>(i)).name << ' ' << stats.runs[i] << "x " << stats.stageUS[i] / 1000 << " ms";
+
+            std::cout << '\n' << std::flush;
+        }
+
+        static void PrintMemoryStats() {
+            const mc::GpuMemoryStats  device = mc::GpuMemory::GetStats();
+            const mc::MeshMemoryStats meshes = s_.chunkMeshes.GetMeshMemoryStats();
+
+            std::cout << "[RENDERER] " << device.allocated / (1024 * 1024) << " MB of device memory in " << device.allocationCount << " allocations, peak "
+                      << device.peak / (1024 * 1024) << " MB, budget " << (device.bDriverBudget ? "from the driver" : "estimated") << " | meshes "
+                      << meshes.residentBytes / (1024 * 1024) << " MB of " << meshes.blockBytes / (1024 * 1024) << " MB in " << meshes.blocks << " blocks, "
+                      << meshes.evictions << " evictions, " << meshes.reuploads << " reuploads, "
+                      << meshes.remeshes << " remeshes\n" << std::flush;
+        }
+
+        // Frame rate and input latency since the last report, which resets them
+        static void PrintFrameStats() {
+            const mc::FrameLatencyStats stats = Renderer::GetFrameLatencyStats();
+            Renderer::ResetFrameLatencyStats();
+
+            if (stats.frames == 0)
+                return;
+
+            std::cout << "[RENDERER] " << std::fixed << std::setprecision(1) << static_cast<f64>(stats.frames) * 1e6 / static_cast<f64>(std::max<u64>(stats.wallUS, 1)) << " fps";
+
+            if (stats.sampled > 0)
+                std::cout << " | input to present " << static_cast<f64>(stats.inputToPresentUS) / static_cast<f64>(stats.sampled) / 1e3 << " ms avg, " << stats.maxInputToPresentUS / 1e3 << " ms max";
+
+            if (stats.displayed > 0)
+                std::cout << " | to display " << static_cast<f64>(stats.inputToDisplayUS) / static_cast<f64>(stats.displayed) / 1e3 << " ms avg, " << stats.maxInputToDisplayUS / 1e3 << " ms max";
+
+            if (stats.pacedUS > 0)
+                std::cout << " | paced " << static_cast<f64>(stats.pacedUS) / static_cast<f64>(stats.frames) / 1e3 << " ms per frame";
+
+            std::cout << '\n';
+
+            for (const mc::SlabStats& slab : mc::SlabPool::GetAllStats()) {
+                std::cout << "[SLABS] " << slab.blockSize << " B blocks: " << slab.used << " of " << slab.capacity << " used ("
+                          << static_cast<f64>(slab.used) * 100.0 / static_cast<f64>(std::max<std::size_t>(slab.capacity, 1)) << "%), "
+                          << slab.threadCached << " cached by threads, " << slab.slabs << " slabs\n";
+            }
+
+            std::cout << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+
+        // Loads every chunk the furthest LOD ring can reach around the spawn point, from the save when it has them
+        static void GenerateSpawnArea() {
+            const i32 radius = s_.chunkMeshes.GetSettings().ringEnds.back();
+
+            std::vector<mc::Chunk*> chunks;
+            for (i32 z = -radius; z <= radius; ++z)
+                for (i32 x = -radius; x <= radius; ++x)
+                    chunks.push_back(&s_.world.CreateChunk(mc::ChunkCoord{ x, z }));
+
+            std::vector<u8> loaded(chunks.size());
+            s_.threadPool.ParallelFor(chunks.size(), 16, [&chunks, &loaded](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    loaded[i] = s_.pSaver && s_.pSaver->LoadChunk(*chunks[i]);
+            });
+
+            std::vector<mc::Chunk*> generated;
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+                if (!loaded[i])
+                    generated.push_back(chunks[i]);
+
+            s_.generation.Generate(generated);
+            PrintGenerationStats();
+
+            s_.threadPool.ParallelFor(chunks.size(), 16, [&chunks](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    chunks[i]->Intern(s_.world.GetSectionPool());
+            });
+
+            const mc::SectionStats stats = s_.world.GetSectionStats();
+            std::cout << "[WORLD] " << stats.sections << " sections stored as " << stats.unique << " unique ones, "
+                      << (stats.sections - stats.unique) * sizeof(mc::ChunkSection) / (1024 * 1024) << " MB saved\n" << std::flush;
+
+            s_.camera.SetPosition(mc::vec3f32{ 0.5f, static_cast<f32>(s_.generator.GetTerrainHeight(0, 0)) + 24.f, 0.5f });
+            s_.camera.SetRotation(0.f, -0.35f);
+        }
+
+        // Takes the value following argv[i] if the argument matches, advancing i past it
+        static const char* ParseOption(const int argc, char** argv, int& i, const char* name) {
+            if (std::strcmp(argv[i], name) != 0 || i + 1 >= argc)
+                return nullptr;
+
+            return argv[++i];
+        }
+
+        static const std::array<BenchmarkTool, 11>& GetBenchmarkTools() {
+            static const std::array<BenchmarkTool, 11> tools = {{
+                // N submissions with fences and timeline semaphores
+                { "--submit-benchmark",   [](const u32 n) { mc::SubmitBenchmark::RunAll(n, std::cout); } },
+                // N block ticks over 1M, 10M and 100M loaded blocks
+                { "--tick-benchmark",     [](const u32 n) { mc::TickBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N fluid ticks of a dam break of 100k water blocks
+                { "--fluid-benchmark",    [](const u32 n) { mc::FluidBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N rounds of chunk churn, sections from the slabs against the heap
+                { "--alloc-benchmark",    [](const u32 n) { mc::AllocBenchmark::RunAll(n, std::cout); } },
+                // N seconds of readers meshing sections a writer keeps rewriting, epochs against a mutex
+                { "--chunk-stress",       [](const u32 n) { mc::ChunkStress::RunAll(n, std::cout); } },
+                // N mob paths per distance, 16, 64 and 256 blocks, hierarchical against flat A*
+                { "--path-benchmark",     [](const u32 n) { mc::PathBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N frames of the far field's ray march at 1280 x 720, without a window
+                { "--farfield-benchmark", [](const u32 n) { mc::FarFieldBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N rounds of mat4 products, dot products, box overlaps and frustum tests, scalar against SIMD
+                { "--math-benchmark",     [](const u32 n) { mc::MathBenchmark::RunAll(n, std::cout); } },
+                // N rays per reach through generated terrain, Raycast against RaycastBatch on the pool
+                { "--raycast-benchmark",  [](const u32 n) { mc::RaycastBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N entity ticks of 1k and 10k mobs wandering over generated terrain
+                { "--entity-benchmark",   [](const u32 n) { mc::EntityBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+                // N saves of 1000 edited chunks, the snapshot on the tick against the background write
+                { "--save-benchmark",     [](const u32 n) { mc::SaveBenchmark::RunAll(n, s_.threadPool, std::cout); } },
+            }};
+
+            return tools;
+        }
+
+        // Takes a benchmark's flag and its count, the last one given being the one run
+        static bool ParseBenchmark(const int argc, char** argv, int& i) {
+            for (const BenchmarkTool& tool : GetBenchmarkTools()) {
+                if (const char* pCount = ParseOption(argc, argv, i, tool.flag)) {
+                    s_.pBenchmark     = &tool;
+                    s_.benchmarkCount = mc::ParseUnsigned<u32>(tool.flag, pCount, 1u);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        static void ParseArguments(const int argc, char** argv) {
+            const char* pConnect = nullptr;
+
+            std::vector<vk::PresentModeKHR> presentModes;
+            std::optional<u32>              imageCount;
+            std::optional<u32>              framesInFlight;
+            std::optional<bool>             bPacing;
+
+            for (int i = 1; i < argc; ++i) {
+                if (ParseBenchmark(argc, argv, i))
+                    continue;
+
+                if (std::strcmp(argv[i], "--server") == 0) {
+                    s_.serverSettings.emplace();
+                } else if (const char* pPort = ParseOption(argc, argv, i, "--port")) {
+                    if (!s_.serverSettings.has_value())
+                        s_.serverSettings.emplace();
+
+                    s_.serverSettings->port = mc::ParseUnsigned<u16>("--port", pPort);
+                } else if (const char* pMaxClients = ParseOption(argc, argv, i, "--max-clients")) {
+                    if (!s_.serverSettings.has_value())
+                        s_.serverSettings.emplace();
+
+                    s_.serverSettings->maxClients = mc::ParseUnsigned<u32>("--max-clients", pMaxClients, 1u);
+                } else if (const char* pBots = ParseOption(argc, argv, i, "--bots")) {
+                    s_.botCount = mc::ParseUnsigned<u32>("--bots", pBots);
+                } else if (const char* pAddress = ParseOption(argc, argv, i, "--connect")) {
+                    pConnect = pAddress;
+                } else if (const char* pRecord = ParseOption(argc, argv, i, "--record")) {
+                    s_.recordFilename = pRecord;
+                } else if (const char* pReplay = ParseOption(argc, argv, i, "--replay")) {
+                    s_.replay = mc::InputReplay::Load(pReplay);
+                } else if (const char* pFlightTicks = ParseOption(argc, argv, i, "--flythrough")) {
+                    s_.replay = mc::InputReplay::FlyThrough(WORLD_SEED, mc::ParseUnsigned<u32>("--flythrough", pFlightTicks, 1u));
+                } else if (const char* pScale = ParseOption(argc, argv, i, "--lod-scale")) {
+                    const i32 scale = static_cast<i32>(mc::ParseUnsigned<u32>("--lod-scale", pScale, 1u, 8u));
+
+                    for (i32& ringEnd : s_.chunkMeshes.GetSettings().ringEnds)
+                        ringEnd *= scale;
+                } else if (const char* pReport = ParseOption(argc, argv, i, "--report")) {
+                    s_.reportFilename = pReport;
+                } else if (const char* pBudget = ParseOption(argc, argv, i, "--vram-budget")) {
+                    s_.chunkMeshes.GetSettings().vramBudgetBytes = mc::ParseUnsigned<vk::DeviceSize>("--vram-budget", pBudget, 0, std::numeric_limits<vk::DeviceSize>::max() >> 20u) << 20u;
+                } else if (const char* pTolerance = ParseOption(argc, argv, i, "--tolerance")) {
+                    s_.tolerance = mc::ParseReal("--tolerance", pTolerance, 0.0, 1000.0) / 100.0;
+                } else if (std::strcmp(argv[i], "--compare") == 0 && i + 2 < argc) {
+                    s_.compareFilenames = { argv[i + 1], argv[i + 2] };
+                    i += 2;
+                } else if (std::strcmp(argv[i], "--headless") == 0) {
+                    s_.bHeadless = true;
+                } else if (std::strcmp(argv[i], "--realtime") == 0) {
+                    s_.bRealtime = true;
+                } else if (std::strcmp(argv[i], "--timeline") == 0) {
+                    s_.bTimelineSemaphores = true;
+                } else if (const char* pSweepFrames = ParseOption(argc, argv, i, "--record-sweep")) {
+                    s_.recordSweepFrames = mc::ParseUnsigned<u32>("--record-sweep", pSweepFrames, 1u);
+                } else if (std::strcmp(argv[i], "--overlay") == 0) {
+                    s_.bOverlay = true;
+                } else if (std::strcmp(argv[i], "--serial-startup") == 0) {
+                    s_.bSerialStartup = true;
+                } else if (const char* pPolicy = ParseOption(argc, argv, i, "--present")) {
+                    s_.presentPolicy = mc::PresentPolicy::FromName(pPolicy);
+                } else if (const char* pMode = ParseOption(argc, argv, i, "--present-mode")) {
+                    presentModes = { mc::PresentPolicy::ParsePresentMode(pMode) };
+                } else if (const char* pImages = ParseOption(argc, argv, i, "--swapchain-images")) {
+                    imageCount = mc::ParseUnsigned<u32>("--swapchain-images", pImages, 1u);
+                } else if (const char* pFrames = ParseOption(argc, argv, i, "--frames-in-flight")) {
+                    framesInFlight = mc::ParseUnsigned<u32>("--frames-in-flight", pFrames, 1u, MC_MAX_FRAMES_IN_FLIGHT);
+                } else if (const char* pPacing = ParseOption(argc, argv, i, "--pacing")) {
+                    bPacing = mc::ParseSwitch("--pacing", pPacing);
+                } else {
+                    throw std::runtime_error(std::string("Unknown argument, or one missing its value: ") + argv[i]);
+                }
+            }
+
+            // The overrides apply to the policy whichever order they came in
+            if (!presentModes.empty())
+                s_.presentPolicy.presentModes = presentModes;
+            if (imageCount.has_value())
+                s_.presentPolicy.imageCount = imageCount.value();
+            if (framesInFlight.has_value())
+                s_.presentPolicy.framesInFlight = framesInFlight.value();
+            if (bPacing.has_value())
+                s_.presentPolicy.bPacing = bPacing.value();
+
+            // A replay regenerates the world the recording was made in
+            if (s_.replay.has_value())
+                s_.generator = mc::WorldGenerator(s_.replay->GetSeed());
+
+            s_.bHeadless = s_.bHeadless && s_.replay.has_value();
+
+            if (!s_.recordFilename.empty() && !s_.replay.has_value())
+                s_.pRecorder = std::make_unique<mc::InputRecorder>(s_.generator.GetSeed());
+
+            if (pConnect && !s_.serverSettings.has_value()) {
+                const i32 viewRadius = std::min(s_.chunkMeshes.GetSettings().ringEnds.back(), 255);
+
+                s_.pClient = std::make_unique<mc::NetClient>(mc::NetAddress::Resolve(pConnect, MC_NET_DEFAULT_PORT), &s_.world, static_cast<u8>(viewRadius));
+            }
+        }
+
+        // Asks the server to stop after its current tick. A second signal is not caught, and kills it
+        static void OnStopSignal(const int signal) {
+            s_.bStopServer = true;
+            std::signal(signal, SIG_DFL);
+        }
+
+        // Ticks the server at MC_NET_TICK_RATE, printing its load every five seconds, until SIGINT or
+        // SIGTERM. The bots stop first, then the server saves the world as it is destroyed
+        static void RunServer() {
+            mc::Server server(s_.serverSettings.value(), s_.threadPool, WORLD_SEED);
+
+            std::cout << "[SERVER] Listening on port " << server.GetPort() << '\n' << std::flush;
+
+            std::signal(SIGINT, OnStopSignal);
+            std::signal(SIGTERM, OnStopSignal);
+
+            std::thread botThread;
+
+            if (s_.botCount > 0) {
+                botThread = std::thread([address = mc::NetAddress::Resolve("127.0.0.1", server.GetPort())] {
+                    std::vector<std::unique_ptr<mc::NetBot>> bots;
+                    for (u32 i = 0; i < s_.botCount; ++i)
+                        bots.push_back(std::make_unique<mc::NetBot>(address, static_cast<u8>(s_.serverSettings->viewRadius), i));
+
+                    while (!s_.bStopServer) {
+                        for (const auto& pBot : bots)
+                            pBot->Update();
+
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    }
+                });
+            }
+
+            constexpr u64 TICK_US   = 1'000'000u / MC_NET_TICK_RATE;
+            constexpr u64 REPORT_US = 5'000'000u;
+
+            const mc::Timer clock;
+            u64      nextTick   = 0;
+            u64      nextReport = REPORT_US;
+            NetStats lastTraffic;
+
+            while (!s_.bStopServer) {
+                while (clock.GetElapsedUS() < nextTick)
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+                nextTick += TICK_US;
+                server.Tick();
+
+                if (clock.GetElapsedUS() < nextReport)
+                    continue;
+
+                const ServerStats& stats   = server.GetStats();
+                const NetStats     traffic = server.GetTotalTraffic();
+                const f64          clients = static_cast<f64>(std::max<std::size_t>(server.GetClientCount(), 1));
+                const f64          seconds = REPORT_US * 1e-6;
+
+                // Counters are per connection, so a disconnect can make them go backwards: clamp to zero
+                const u64 sent     = traffic.bytesSent     > lastTraffic.bytesSent     ? traffic.bytesSent     - lastTraffic.bytesSent     : 0;
+                const u64 received = traffic.bytesReceived > lastTraffic.bytesReceived ? traffic.bytesReceived - lastTraffic.bytesReceived : 0;
+
+                std::cout << "[SERVER] " << server.GetClientCount() << " clients | tick avg "
+                          << stats.sumTickUS / std::max<u64>(stats.tickCount, 1) / 1e3 << " ms, max " << stats.maxTickUS / 1e3 << " ms | per client "
+                          << sent / clients / seconds / 1024.0 << " KB/s down, " << received / clients / seconds / 1024.0 << " KB/s up | "
+                          << stats.pathsFound << " of " << stats.paths << " mob paths found in " << stats.pathUS / 1e3 << " ms\n" << std::flush;
+
+                lastTraffic = traffic;
+                nextReport += REPORT_US;
+                server.ResetStats();
+            }
+
+            std::cout << "[SERVER] Stopping, saving the world\n" << std::flush;
+
+            if (botThread.joinable())
+                botThread.join();
+        }
+
+        // The camera follows the player's entity, at eye height, once the server has sent it
+        static void FollowPlayer() {
+            const std::optional<EntityID>& player = s_.pClient->GetPlayerID();
+
+            if (!player.has_value())
+                return;
+
+            const auto it = s_.pClient->GetEntities().find(player.value());
+
+            if (it != s_.pClient->GetEntities().end())
+                s_.camera.SetPosition(it->second.GetPosition() + mc::vec3f32{ 0.f, 0.7f, 0.f });
+        }
+
+        static void RunCompare() {
+            const std::optional<mc::TickTimings> baseline = mc::TickTimings::Load(s_.compareFilenames[0]);
+            const std::optional<mc::TickTimings> current  = mc::TickTimings::Load(s_.compareFilenames[1]);
+
+            if (!baseline.has_value() || !current.has_value())
+                throw std::runtime_error("[REPLAY] Could not read the reports to compare");
+
+            s_.exitCode = mc::TickTimings::Compare(baseline.value(), current.value(), s_.tolerance, std::cout) ? 0 : 1;
+        }
+
+        // A fly camera in single player; over the network the input moves the player's entity instead
+        static void SimulateTick(const mc::InputFrame& input) {
+            constexpr f32 FLY_SPEED   = 12.f;     // Blocks per second
+            constexpr f32 SENSITIVITY = 0.0025f;  // Radians per pixel
+            constexpr f32 REACH       = 8.f;
+            constexpr f32 DT          = 1.f / MC_INPUT_TICK_RATE;
+
+            // Indexed by BlockFace: where a block placed against that face goes
+            constexpr std::array<mc::vec3i32, 6> FACE_NORMALS = {
+                mc::vec3i32{ -1, 0, 0 }, mc::vec3i32{ 1, 0, 0 }, mc::vec3i32{ 0, -1, 0 },
+                mc::vec3i32{ 0, 1, 0 },  mc::vec3i32{ 0, 0, -1 }, mc::vec3i32{ 0, 0, 1 },
+            };
+
+            const auto Axis = [&input](const InputButton positive, const InputButton negative) {
+                return (input.IsDown(positive) ? 1.f : 0.f) - (input.IsDown(negative) ? 1.f : 0.f);
+            };
+
+            s_.camera.SetRotation(s_.camera.GetYaw() - input.lookX * SENSITIVITY, s_.camera.GetPitch() - input.lookY * SENSITIVITY);
+
+            const f32 yaw = s_.camera.GetYaw();
+            const f32 forward = Axis(InputButton::Forward, InputButton::Back);
+            const f32 right   = Axis(InputButton::Right, InputButton::Left);
+
+            const mc::vec3f32 move{ -std::sin(yaw) * forward + std::cos(yaw) * right, Axis(InputButton::Up, InputButton::Down), -std::cos(yaw) * forward - std::sin(yaw) * right };
+
+            if (s_.pClient) {
+                s_.pClient->SetInput(move.x, move.z, input.IsDown(InputButton::Up));
+                return;
+            }
+
+            s_.camera.SetPosition(s_.camera.GetPosition() + move * (FLY_SPEED * DT));
+
+            // Edits happen on the tick a button goes down, not for as long as it is held
+            const bool bBreak = input.IsDown(InputButton::Break) && !s_.lastInput.IsDown(InputButton::Break);
+            const bool bPlace = input.IsDown(InputButton::Place) && !s_.lastInput.IsDown(InputButton::Place);
+
+            if (bBreak || bPlace) {
+                const std::optional<mc::RaycastHit> hit = mc::Raycast(s_.world, mc::Ray{ s_.camera.GetPosition(), s_.camera.GetForward(), REACH });
+
+                if (hit.has_value() && bBreak) {
+                    s_.world.SetBlock(hit->block, Block::Air);
+                    s_.blockTicks.NotifyNeighbours(s_.world, hit->block);
+                    s_.fluids.Notify(s_.world, hit->block);
+                } else if (hit.has_value() && hit->face != BlockFace::None) {
+                    const mc::vec3i32 placed = hit->block + FACE_NORMALS[static_cast<u32>(hit->face)];
+
+                    s_.world.SetBlock(placed, Block::Dirt);
+                    s_.blockTicks.NotifyNeighbours(s_.world, placed);
+                    s_.fluids.Notify(s_.world, placed);
+                }
+            }
+        }
+
+        // What a tick changes: the camera, and the world through the edits, which all count as unsaved
+        static u64 HashSimulationState() {
+            const mc::vec3f32& p = s_.camera.GetPosition();
+
+            u64 hash = s_.world.GetUnsavedChunkCount();
+            for (const f32 v : { p.x, p.y, p.z, s_.camera.GetYaw(), s_.camera.GetPitch() }) {
+                u32 bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+
+                hash = noise::Hash(hash ^ bits);
+            }
+
+            return hash;
+        }
+
+        static void Tick() {
+            const mc::Timer timer;
+
+            const mc::InputFrame input = s_.replay.has_value() ? s_.replay->Next() : s_.recordSweepFrames > 0 ? mc::InputFrame{} : AppSurface::PollInput();
+
+            if (s_.pRecorder)
+                s_.pRecorder->Record(input);
+
+            if (!s_.bHeadless)
+                Renderer::MarkInputSampled();
+
+            SimulateTick(input);
+            s_.lastInput = input;
+
+            // Over the network the server owns the world
+            if (!s_.pClient) {
+                s_.blockTicks.Tick(s_.world, s_.threadPool);
+
+                if (s_.tick % mc::FluidEngine::TICK_INTERVAL == 0)
+                    s_.fluids.Tick(s_.world, s_.threadPool);
+            }
+
+            s_.tickTimes.Add(timer.GetElapsedUS());
+
+            if (s_.replay.has_value()) {
+                s_.timings.Add(s_.tick, timer.GetElapsedUS(), HashSimulationState());
+                s_.bQuit = s_.replay->IsFinished();
+            }
+
+            ++s_.tick;
+        }
+
+        // Ticks the clock owes, at most a few so a long frame does not snowball. As fast as possible
+        // replays simulate exactly one tick per frame, so their frames line up from one run to the next
+        static u32 GetDueTicks() {
+            constexpr u32 MAX_TICKS_PER_FRAME = 5;
+
+            if (s_.replay.has_value() && !s_.bRealtime)
+                return s_.replay->IsFinished() ? 0 : 1;
+
+            const u64 due   = s_.tickClock.GetElapsedUS() * MC_INPUT_TICK_RATE / 1'000'000u;
+            const u64 count = due - s_.clockTicks;
+
+            // Behind by more than the cap: drop the time rather than catching up
+            if (count > MAX_TICKS_PER_FRAME) {
+                s_.tickClock  = mc::Timer();
+                s_.clockTicks = 0;
+
+                return MAX_TICKS_PER_FRAME;
+            }
+
+            s_.clockTicks = due;
+
+            return static_cast<u32>(count);
+        }
+
+        static void RunHeadlessReplay() {
+            while (!s_.bQuit) {
+                for (u32 i = GetDueTicks(); i > 0; --i)
+                    Tick();
+
+                if (s_.bRealtime)
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+
+        static void FinishSession() {
+            if (s_.pRecorder) {
+                const bool bSaved = s_.pRecorder->Save(s_.recordFilename);
+
+                std::cout << "[INPUT] " << (bSaved ? "Recorded " : "Could not record ") << s_.pRecorder->GetTickCount() << " ticks to " << s_.recordFilename << '\n' << std::flush;
+            }
+
+            if (s_.replay.has_value()) {
+                s_.timings.PrintSummary(std::cout);
+
+                if (!s_.timings.Save(s_.reportFilename))
+                    std::cout << "[REPLAY] Could not write the report to " << s_.reportFilename << '\n' << std::flush;
+            }
+        }
+
+        // Servers, report comparisons and benchmarks run without a window
+        static bool IsToolRun() {
+            return s_.serverSettings.has_value() || !s_.compareFilenames.empty() || s_.pBenchmark;
+        }
+
     public:
+        static inline int GetExitCode() { return s_.exitCode; }
+
         static void Startup(int argc, char** argv) {
-            AppSurface::Acquire();
-            Renderer::Startup();
+            ParseArguments(argc, argv);
+
+            if (IsToolRun())
+                return;
+
+            if (s_.bHeadless) {
+                GenerateSpawnArea();
+                return;
+            }
+
+            // The spawn area needs nothing from the renderer: it is generated on the pool while the renderer
+            // starts. Added first so it starts first, being the longest
+            mc::TaskGraph graph(STARTUP_THREADS);
+
+            if (!s_.pClient) {
+                graph.Add("spawn area", {}, [] {
+                    if (!s_.pRecorder && !s_.replay.has_value())
+                        s_.pSaver = std::make_unique<mc::WorldSaver>("save", s_.threadPool);
+
+                    GenerateSpawnArea();
+                });
+            }
+
+            Renderer::AddStartupTasks(graph, s_.threadPool, s_.bTimelineSemaphores, s_.presentPolicy);
+
+            graph.Run(s_.bSerialStartup);
+            graph.PrintTimeline(std::cout);
+
+            // Overlapping the meshes' outer rings, so nothing shows through while they catch up
+            mc::FarFieldSettings farFieldSettings;
+            farFieldSettings.meshRadius = s_.chunkMeshes.GetSettings().ringEnds.back();
+
+            s_.pFarField = std::make_unique<mc::FarField>(s_.generator, s_.threadPool, farFieldSettings);
+
+            s_.shaderWatcher.Start("res/shaders", [](const std::set<std::string>& changed) { Renderer::ReloadPipelines(changed); });
+
+            if (s_.pClient)
+                s_.camera.SetRotation(0.f, -0.35f);
+
+            s_.tickClock  = mc::Timer();
+            s_.clockTicks = 0;
         }
 
         static void Update() {
             AppSurface::Update();
+
+            for (u32 i = GetDueTicks(); i > 0; --i)
+                Tick();
+
+            if (s_.pClient) {
+                s_.pClient->Update();
+                FollowPlayer();
+            }
+
+            // Before the meshes, which clear the world's dirty sections
+            if (s_.pFarField)
+                s_.pFarField->Update(s_.world, s_.camera.GetPosition(), s_.threadPool);
+
+            // What the meshing jobs, reading through epochs, see from now on: this frame's ticks and what the server sent
+            s_.world.Publish();
+
+            s_.chunkMeshes.Update(s_.world, s_.camera, s_.threadPool);
+
+            if (s_.pSaver && s_.autosaveTimer.GetElapsedMS() >= MC_AUTOSAVE_INTERVAL_MS) {
+                s_.pSaver->Save(s_.world);
+                s_.autosaveTimer.Reset();
+            }
+        }
+
+        // Written straight into the renderer's buffer for this frame; nothing runs while it is hidden
+        static void DrawOverlay() {
+            if (AppSurface::ConsumeOverlayToggle())
+                s_.bOverlay = !s_.bOverlay;
+
+            if (const std::optional<u64> gpuUS = Renderer::TakeGpuTimeUS())
+                s_.gpuTimes.Add(gpuUS.value());
+
+            if (!s_.bOverlay || !Renderer::IsOverlayAvailable())
+                return;
+
+            const mc::Timer timer;
+
+            const mc::GpuMemoryStats device = mc::GpuMemory::GetStats();
+
+            mc::DebugOverlayData data;
+            data.pFrames       = &s_.frameTimes;
+            data.pTicks        = &s_.tickTimes;
+            data.pGpu          = &s_.gpuTimes;
+            data.recordUS      = Renderer::GetLastRecordUS();
+            data.draws         = Renderer::GetLastDrawCount();
+            data.chunks        = s_.world.GetChunkCount();
+            data.meshes        = s_.chunkMeshes.GetMeshCount();
+            data.pendingMeshes = s_.chunkMeshes.GetPendingCount();
+            data.fluidCells    = s_.fluids.GetActiveCount();
+            data.deviceBytes   = device.allocated;
+            data.devicePeak    = device.peak;
+            data.overlayUS     = s_.overlayUS;
+
+            Renderer::DrawOverlay(mc::DebugOverlay::Build(data, Renderer::GetOverlayVertices(), MC_OVERLAY_MAX_VERTICES));
+
+            s_.overlayUS = timer.GetElapsedUS();
         }
 
         static void Render() {
+            const f32 aspect = Renderer::GetAspectRatio();
+
+            Renderer::SetCamera(s_.camera.GetView(), s_.camera.GetProjection(aspect), s_.camera.GetPosition());
+            s_.chunkMeshes.Draw(s_.camera.GetFrustum(aspect));
+
+            if (s_.pFarField)
+                Renderer::DrawFarField(s_.pFarField->GetTree(), s_.pFarField->GetWindowLo(), s_.pFarField->GetWindowChunks());
+
+            DrawOverlay();
+
             Renderer::Render();
         }
 
+        // Called after each frame of a --record-sweep: the limit set applies from the next frame's recording
+        static void StepRecordSweep() {
+            const u32 maxLimit = s_.threadPool.GetThreadCount() + 1;
+
+            if (s_.sweepLimit == 0) {
+                if (s_.chunkMeshes.GetPendingCount() == 0) {
+                    s_.sweepLimit = 1;
+                    Renderer::SetRecordingBatchLimit(s_.sweepLimit);
+                }
+
+                return;
+            }
+
+            s_.sweepRecordUS += Renderer::GetLastRecordUS();
+
+            if (++s_.sweepFrame < s_.recordSweepFrames)
+                return;
+
+            std::cout << "[RENDERER] " << Renderer::GetLastDrawCount() << " draws recorded on up to " << s_.sweepLimit << " threads | " << std::fixed << std::setprecision(1)
+                      << static_cast<f64>(s_.sweepRecordUS) / s_.sweepFrame << " us avg\n" << std::defaultfloat << std::setprecision(6) << std::flush;
+
+            s_.sweepFrame    = 0;
+            s_.sweepRecordUS = 0;
+
+            if (s_.sweepLimit < maxLimit) {
+                Renderer::SetRecordingBatchLimit(++s_.sweepLimit);
+            } else {
+                Renderer::SetRecordingBatchLimit(maxLimit);
+                s_.bQuit = true;
+            }
+        }
+
         static void Run() {
-            while (AppSurface::Exists()) {
+            if (s_.serverSettings.has_value()) {
+                RunServer();
+                return;
+            }
+
+            if (!s_.compareFilenames.empty()) {
+                RunCompare();
+                return;
+            }
+
+            if (s_.pBenchmark) {
+                s_.pBenchmark->run(s_.benchmarkCount);
+                return;
+            }
+
+            if (s_.bHeadless) {
+                RunHeadlessReplay();
+                return;
+            }
+
+            constexpr u32 FRAME_REPORT_MS = 5000;
+
+            Renderer::ResetFrameLatencyStats();
+            s_.frameReportTimer.Reset();
+            s_.frameClock.Reset();
+
+            while (AppSurface::Exists() && !s_.bQuit) {
+                // The pacer's sleep is not part of the frame, it is what keeps the input fresh
+                Renderer::BeginFrame();
+
+                const mc::Timer frameTimer;
+                const u32       firstTick = s_.tick;
+
+                s_.frameTimes.Add(s_.frameClock.Lap());
+
                 Minecraft::Update();
                 Minecraft::Render();
 
+                if (std::exchange(s_.bFirstFrame, false))
+                    std::cout << "[STARTUP] First frame after " << s_.startupClock.GetElapsedMS() << " ms\n" << std::flush;
+
+                s_.timings.SetFrameTime(firstTick, frameTimer.GetElapsedUS());
+
+                if (s_.recordSweepFrames > 0)
+                    StepRecordSweep();
+
+                if (s_.frameReportTimer.GetElapsedMS() >= FRAME_REPORT_MS) {
+                    PrintFrameStats();
+                    s_.frameReportTimer.Reset();
+                }
+
                 std::this_thread::yield();
             }
         }
 
         static void Terminate() {
+            if (IsToolRun())
+                return;
+
+            FinishSession();
+
+            if (s_.bHeadless)
+                return;
+
+            s_.shaderWatcher.Stop();
+
+            PrintMemoryStats();
+            s_.chunkMeshes.Clear();
+
+            // Waits for the batch it has in flight
+            s_.pFarField.reset();
+
+            // Destroying the saver waits for the last save to be written
+            if (s_.pSaver) {
+                s_.pSaver->Save(s_.world);
+                s_.pSaver.reset();
+            }
+
             AppSurface::Release();
             Renderer::Shutdown();
         }
     }; // class Minecraft
 
+    decltype(Minecraft::s_) Minecraft::s_;
+
 }; // namespace mc
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "udpSocket.hpp"
+#include "chunkCodec.hpp"
+#include "netProtocol.hpp"
+#include "netConnection.hpp"
+
+/*
+ * The client side of the protocol: says hello, then sends its input every tick and keeps the
+ * chunks and entity snapshots the server streams back. Without a world the chunks are decoded
+ * and dropped, which is all a bot needs.
+ */
+
+namespace mc {
+
+    class NetClient {
+    private:
+        UdpSocket     m_socket;
+        NetConnection m_connection;
+        mc::Timer     m_clock;
+
+        World* m_pWorld;
+        u8     m_viewRadius;
+
+        std::optional<EntityID> m_player;
+
+        std::array<NetSnapshot, MC_NET_SNAPSHOT_HISTORY> m_history;
+        u32 m_latestSnapshot = 0;
+
+        i8   m_moveX = 0, m_moveZ = 0;
+        bool m_bJump = false;
+
+        f64 m_nextInputTime = 0.0;
+
+    private:
+        inline f64 Now() const { return static_cast<f64>(m_clock.GetElapsedUS()) * 1e-6; }
+
+        void HandleChunkData(ByteReader& reader) {
+            const ChunkCoord coord{ reader.ReadI32(), reader.ReadI32() };
+
+            if (!m_pWorld) {
+                Chunk scratch(coord);
+                DecodeChunk(reader, scratch);
+                return;
+            }
+
+            m_pWorld->DestroyChunk(coord);
+
+            Chunk& chunk = m_pWorld->CreateChunk(coord);
+
+            if (!DecodeChunk(reader, chunk)) {
+                m_pWorld->DestroyChunk(coord);
+                return;
+            }
+
+            chunk.Intern(m_pWorld->GetSectionPool());
+
+            m_pWorld->MarkChunkDirty(coord);
+        }
+
+        void HandleMessage(const NetMessage& message) {
+            ByteReader reader(message.data.data(), message.data.size());
+
+            switch (static_cast<NetMessageType>(reader.ReadU8())) {
+            case NetMessageType::eWelcome: {
+                const EntityID player = reader.ReadU32();
+
+                if (reader.IsValid())
+                    m_player = player;
+                break;
+            }
+            case NetMessageType::eChunkData:
+                HandleChunkData(reader);
+                break;
+            case NetMessageType::eChunkUnload: {
+                const ChunkCoord coord{ reader.ReadI32(), reader.ReadI32() };
+
+                if (reader.IsValid() && m_pWorld)
+                    m_pWorld->DestroyChunk(coord);
+                break;
+            }
+            case NetMessageType::eSnapshot: {
+                std::optional<NetSnapshot> snapshot = DecodeSnapshot(reader, m_history);
+
+                // Snapshots are unreliable, so they can arrive late: only the newest one counts
+                if (snapshot.has_value() && snapshot->id > m_latestSnapshot) {
+                    m_latestSnapshot = snapshot->id;
+                    m_history[snapshot->id % MC_NET_SNAPSHOT_HISTORY] = std::move(snapshot.value());
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+    public:
+        NetClient(const NetAddress& server, World* pWorld, const u8 viewRadius)
+            : m_socket(0), m_connection(server, 0.0), m_pWorld(pWorld), m_viewRadius(viewRadius)
+        {
+            std::vector<u8> hello;
+            ByteWriter writer(hello);
+            writer.WriteU8(static_cast<u8>(NetMessageType::eHello));
+            writer.WriteU8(m_viewRadius);
+
+            m_connection.SendReliable(hello);
+        }
+
+        inline const std::optional<EntityID>& GetPlayerID() const { return m_player;                  }
+        inline const NetStats&                GetStats()    const { return m_connection.GetStats();   }
+        inline f64                            GetRTT()      const { return m_connection.GetRTT();     }
+        inline bool                           IsTimedOut()  const { return m_connection.IsTimedOut(Now()); }
+
+        // The entities of the newest snapshot, the player included
+        inline const EntityStates& GetEntities() const { return m_history[m_latestSnapshot % MC_NET_SNAPSHOT_HISTORY].entities; }
+
+        // Movement axes in [-1, 1]
+        inline void SetInput(const f32 moveX, const f32 moveZ, const bool bJump) {
+            m_moveX = static_cast<i8>(std::clamp(moveX, -1.f, 1.f) * 127.f);
+            m_moveZ = static_cast<i8>(std::clamp(moveZ, -1.f, 1.f) * 127.f);
+            m_bJump = bJump;
+        }
+
+        void Update() {
+            const f64 now = Now();
+
+            std::array<u8, 2048> buffer;
+            NetAddress from;
+
+            while (const std::optional<std::size_t> size = m_socket.Receive(buffer.data(), buffer.size(), from))
+                if (from == m_connection.GetAddress())
+                    m_connection.ProcessPacket(buffer.data(), size.value(), now);
+
+            while (const std::optional<NetMessage> message = m_connection.PopMessage())
+                HandleMessage(message.value());
+
+            if (now < m_nextInputTime)
+                return;
+
+            m_nextInputTime = std::max(m_nextInputTime + 1.0 / MC_NET_TICK_RATE, now);
+
+            // The input doubles as the snapshot ack, so it goes out every tick even when nothing changed
+            if (m_player.has_value()) {
+                std::vector<u8> input;
+                ByteWriter writer(input);
+                writer.WriteU8(static_cast<u8>(NetMessageType::eInput));
+                writer.WriteU32(m_latestSnapshot);
+                writer.WriteU8(static_cast<u8>(m_moveX));
+                writer.WriteU8(static_cast<u8>(m_moveZ));
+                writer.WriteU8(m_bJump ? 1 : 0);
+
+                m_connection.SendUnreliable(std::move(input));
+            }
+
+            for (const std::vector<u8>& packet : m_connection.BuildPackets(now, 4))
+                m_socket.SendTo(m_connection.GetAddress(), packet.data(), packet.size());
+        }
+    }; // class NetClient
+
+    // A headless client walking in a random direction for a few seconds at a time, for load testing a server
+    class NetBot {
+    private:
+        NetClient m_client;
+        u32       m_index;
+        mc::Timer m_clock;
+
+    public:
+        NetBot(const NetAddress& server, const u8 viewRadius, const u32 index)
+            : m_client(server, nullptr, viewRadius), m_index(index) { }
+
+        inline const NetClient& GetClient() const { return m_client; }
+
+        void Update() {
+            const u64 period = m_clock.GetElapsedUS() / 3'000'000u;
+            const u64 h      = noise::Hash(0x426F74ull, static_cast<i32>(m_index), 0, static_cast<i32>(period));
+            const f32 angle  = noise::HashToUnit(h) * 6.2831853f;
+
+            m_client.SetInput(std::cos(angle), std::sin(angle), (h & 0xF) == 0);
+            m_client.Update();
+        }
+    }; // class NetBot
+
+}; // namespace mc
\ No newline at end of file
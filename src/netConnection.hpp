@@ -0,0 +1,358 @@
+#pragma once
+
+#include "header.hpp"
+#include "byteStream.hpp"
+#include "udpSocket.hpp"
+
+/*
+ * One end of a client/server link over UDP, with two channels multiplexed into every packet:
+ *  - reliable ordered: messages are cut into fragments that are resent until the packet
+ *    carrying them is acked, and delivered whole and in order;
+ *  - unreliable: messages ride the next packet once and are dropped if it is lost.
+ *
+ * Packet layout (little endian):
+ *   u32 protocol id | u16 sequence | u16 ack | u32 ack bits (the 32 sequences before ack)
+ *   u8 fragment count, then per fragment: u16 message id | u16 size, top bit set when more fragments follow | bytes
+ *   u8 message count,  then per message:  u16 size | bytes
+ */
+
+namespace mc {
+
+    constexpr u32         MC_NET_PROTOCOL_ID    = 0x4D43'0001u;
+    constexpr std::size_t MC_NET_MAX_PACKET     = 1200;  // Stays clear of IP fragmentation on common paths
+    constexpr std::size_t MC_NET_FRAGMENT_SIZE  = 1024;
+    constexpr u16         MC_NET_RELIABLE_WINDOW = 1024; // Fragments in flight, so also what the receiver may have to buffer
+    constexpr std::size_t MC_NET_MAX_QUEUED     = 4 * MC_NET_RELIABLE_WINDOW; // Fragments queued, far below the 65536 ids so none is reused while queued
+    constexpr f64         MC_NET_TIMEOUT        = 5.0;   // Seconds without a packet before a connection is considered dead
+
+    constexpr bool SequenceGreaterThan(const u16 a, const u16 b) {
+        return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+    }
+
+    struct NetStats {
+        u64 bytesSent       = 0;
+        u64 bytesReceived   = 0;
+        u64 packetsSent     = 0;
+        u64 packetsReceived = 0;
+        u64 fragmentsResent = 0;
+    }; // struct NetStats
+
+    struct NetMessage {
+        bool            bReliable;
+        std::vector<u8> data;
+    }; // struct NetMessage
+
+    class NetConnection {
+    private:
+        struct SentPacket {
+            u16              sequence = 0;
+            bool             bValid   = false;
+            bool             bAcked   = false;
+            f64              time     = 0.0;
+            std::vector<u16> fragmentIds;
+        }; // struct SentPacket
+
+        struct OutgoingFragment {
+            u16             id       = 0;
+            bool            bMore    = false;
+            bool            bAcked   = false;
+            f64             lastSent = -1.0;
+            std::vector<u8> data;
+        }; // struct OutgoingFragment
+
+        struct IncomingFragment {
+            bool            bMore;
+            std::vector<u8> data;
+        }; // struct IncomingFragment
+
+        NetAddress m_address;
+
+        u16  m_localSequence  = 0;
+        u16  m_remoteSequence = 0;
+        u32  m_ackBits        = 0;
+        bool m_bReceivedAny   = false;
+
+        std::array<SentPacket, 256> m_sentPackets;
+
+        // Reliable send side; the front is the oldest fragment not acked yet
+        u16                          m_nextFragmentId = 0;
+        std::deque<OutgoingFragment> m_outgoing;
+        std::size_t                  m_outgoingBytes  = 0;
+
+        // Reliable receive side
+        u16                                            m_expectedFragmentId = 0;
+        std::unordered_map<u16, IncomingFragment>      m_outOfOrder;
+        std::vector<u8>                                m_assembly;
+
+        std::vector<std::vector<u8>> m_unreliableOut;
+        std::deque<NetMessage>       m_inbox;
+
+        f64 m_rtt              = 0.1;
+        f64 m_lastReceiveTime  = 0.0;
+
+        NetStats m_stats;
+
+    private:
+        void AckPacket(const u16 sequence, const f64 now) {
+            SentPacket& packet = m_sentPackets[sequence % m_sentPackets.size()];
+
+            if (!packet.bValid || packet.bAcked || packet.sequence != sequence)
+                return;
+
+            packet.bAcked = true;
+            m_rtt += (now - packet.time - m_rtt) * 0.1;
+
+            for (const u16 id : packet.fragmentIds) {
+                if (m_outgoing.empty())
+                    break;
+
+                const u16 index = static_cast<u16>(id - m_outgoing.front().id);
+
+                if (index < m_outgoing.size() && !m_outgoing[index].bAcked) {
+                    m_outgoing[index].bAcked = true;
+                    m_outgoingBytes -= m_outgoing[index].data.size();
+                }
+            }
+
+            while (!m_outgoing.empty() && m_outgoing.front().bAcked)
+                m_outgoing.pop_front();
+        }
+
+        void ReceiveSequence(const u16 sequence) {
+            if (!m_bReceivedAny) {
+                m_bReceivedAny   = true;
+                m_remoteSequence = sequence;
+                m_ackBits        = 0;
+            } else if (SequenceGreaterThan(sequence, m_remoteSequence)) {
+                const u16 shift = static_cast<u16>(sequence - m_remoteSequence);
+
+                m_ackBits = shift >= 32 ? 0 : (m_ackBits << shift);
+                if (shift <= 32)
+                    m_ackBits |= 1u << (shift - 1);
+
+                m_remoteSequence = sequence;
+            } else {
+                const u16 age = static_cast<u16>(m_remoteSequence - sequence);
+
+                if (age >= 1 && age <= 32)
+                    m_ackBits |= 1u << (age - 1);
+            }
+        }
+
+        void DeliverFragment(const bool bMore, const u8* pData, const std::size_t size) {
+            m_assembly.insert(m_assembly.end(), pData, pData + size);
+
+            if (!bMore)
+                m_inbox.push_back(NetMessage{ true, std::exchange(m_assembly, {}) });
+        }
+
+        void ReceiveFragment(const u16 id, const bool bMore, const u8* pData, const std::size_t size) {
+            const u16 ahead = static_cast<u16>(id - m_expectedFragmentId);
+
+            // Behind the window: a resend of something already delivered
+            if (ahead >= MC_NET_RELIABLE_WINDOW)
+                return;
+
+            if (ahead > 0) {
+                m_outOfOrder.emplace(id, IncomingFragment{ bMore, std::vector<u8>(pData, pData + size) });
+                return;
+            }
+
+            DeliverFragment(bMore, pData, size);
+            ++m_expectedFragmentId;
+
+            for (auto it = m_outOfOrder.find(m_expectedFragmentId); it != m_outOfOrder.end(); it = m_outOfOrder.find(m_expectedFragmentId)) {
+                DeliverFragment(it->second.bMore, it->second.data.data(), it->second.data.size());
+                m_outOfOrder.erase(it);
+                ++m_expectedFragmentId;
+            }
+        }
+
+    public:
+        NetConnection() = default;
+
+        NetConnection(const NetAddress& address, const f64 now) : m_address(address), m_lastReceiveTime(now) { }
+
+        inline const NetAddress& GetAddress()          const { return m_address;         }
+        inline const NetStats&   GetStats()            const { return m_stats;           }
+        inline f64               GetRTT()              const { return m_rtt;             }
+        inline std::size_t       GetPendingReliable()  const { return m_outgoingBytes;   }
+
+        inline bool IsTimedOut(const f64 now) const { return now - m_lastReceiveTime > MC_NET_TIMEOUT; }
+
+        // A full window has nothing more to put on the wire until acks arrive, so senders should hold back
+        inline bool IsWindowFull() const { return m_outgoing.size() >= MC_NET_RELIABLE_WINDOW; }
+
+        // Returns false, queuing nothing, when the message would overflow the queue
+        bool SendReliable(const std::vector<u8>& message) {
+            const std::size_t fragmentCount = std::max<std::size_t>((message.size() + MC_NET_FRAGMENT_SIZE - 1) / MC_NET_FRAGMENT_SIZE, 1);
+
+            if (m_outgoing.size() + fragmentCount > MC_NET_MAX_QUEUED)
+                return false;
+
+            std::size_t offset = 0;
+
+            do {
+                const std::size_t size = std::min(MC_NET_FRAGMENT_SIZE, message.size() - offset);
+
+                OutgoingFragment fragment;
+                fragment.id    = m_nextFragmentId++;
+                fragment.bMore = offset + size < message.size();
+                fragment.data.assign(message.begin() + offset, message.begin() + offset + size);
+
+                m_outgoingBytes += size;
+                m_outgoing.push_back(std::move(fragment));
+
+                offset += size;
+            } while (offset < message.size());
+
+            return true;
+        }
+
+        // Has to fit in one packet next to the header; larger messages are dropped
+        void SendUnreliable(std::vector<u8> message) {
+            m_unreliableOut.push_back(std::move(message));
+        }
+
+        inline const NetMessage* PeekMessage() const { return m_inbox.empty() ? nullptr : &m_inbox.front(); }
+
+        std::optional<NetMessage> PopMessage() {
+            if (m_inbox.empty())
+                return {};
+
+            NetMessage message = std::move(m_inbox.front());
+            m_inbox.pop_front();
+
+            return message;
+        }
+
+        // Returns false for datagrams that are not ours or are malformed
+        bool ProcessPacket(const u8* pData, const std::size_t size, const f64 now) {
+            ByteReader reader(pData, size);
+
+            if (reader.ReadU32() != MC_NET_PROTOCOL_ID)
+                return false;
+
+            const u16 sequence = reader.ReadU16();
+            const u16 ack      = reader.ReadU16();
+            const u32 ackBits  = reader.ReadU32();
+
+            if (!reader.IsValid())
+                return false;
+
+            ReceiveSequence(sequence);
+
+            AckPacket(ack, now);
+            for (u32 i = 0; i < 32; ++i)
+                if (ackBits & (1u << i))
+                    AckPacket(static_cast<u16>(ack - i - 1), now);
+
+            const u8 fragmentCount = reader.ReadU8();
+            for (u8 i = 0; i < fragmentCount && reader.IsValid(); ++i) {
+                const u16 id          = reader.ReadU16();
+                const u16 sizeAndMore = reader.ReadU16();
+                const u8* pFragment   = reader.ReadBytes(sizeAndMore & 0x7FFF);
+
+                if (pFragment)
+                    ReceiveFragment(id, (sizeAndMore & 0x8000) != 0, pFragment, sizeAndMore & 0x7FFF);
+            }
+
+            const u8 messageCount = reader.ReadU8();
+            for (u8 i = 0; i < messageCount && reader.IsValid(); ++i) {
+                const u16 messageSize = reader.ReadU16();
+                const u8* pMessage    = reader.ReadBytes(messageSize);
+
+                if (pMessage)
+                    m_inbox.push_back(NetMessage{ false, std::vector<u8>(pMessage, pMessage + messageSize) });
+            }
+
+            m_lastReceiveTime = now;
+            m_stats.bytesReceived += size;
+            ++m_stats.packetsReceived;
+
+            return reader.IsValid();
+        }
+
+        /*
+         * Builds this tick's datagrams: always one (it carries the acks), more while reliable
+         * fragments are due, up to maxPackets. Queued unreliable messages go in the first one.
+         */
+        std::vector<std::vector<u8>> BuildPackets(const f64 now, const u32 maxPackets) {
+            std::vector<std::vector<u8>> packets;
+
+            const f64 resendDelay = std::max(0.05, m_rtt * 1.5);
+
+            std::size_t next = 0; // First outgoing fragment not looked at yet this call
+
+            for (u32 p = 0; p < std::max(maxPackets, 1u); ++p) {
+                std::vector<u8> packet;
+                packet.reserve(MC_NET_MAX_PACKET);
+
+                ByteWriter writer(packet);
+                writer.WriteU32(MC_NET_PROTOCOL_ID);
+                writer.WriteU16(m_localSequence);
+                writer.WriteU16(m_remoteSequence);
+                writer.WriteU32(m_ackBits);
+
+                const std::size_t countOffset = packet.size();
+                writer.WriteU8(0);
+
+                SentPacket& record = m_sentPackets[m_localSequence % m_sentPackets.size()];
+                record = SentPacket{ m_localSequence, true, false, now, {} };
+
+                const std::size_t window = std::min<std::size_t>(m_outgoing.size(), MC_NET_RELIABLE_WINDOW);
+
+                for (; next < window && record.fragmentIds.size() < 255; ++next) {
+                    OutgoingFragment& fragment = m_outgoing[next];
+
+                    if (fragment.bAcked || (fragment.lastSent >= 0.0 && now - fragment.lastSent < resendDelay))
+                        continue;
+
+                    if (packet.size() + 4 + fragment.data.size() + 1 > MC_NET_MAX_PACKET)
+                        break;
+
+                    writer.WriteU16(fragment.id);
+                    writer.WriteU16(static_cast<u16>(fragment.data.size() | (fragment.bMore ? 0x8000 : 0)));
+                    writer.WriteBytes(fragment.data.data(), fragment.data.size());
+
+                    m_stats.fragmentsResent += fragment.lastSent >= 0.0 ? 1 : 0;
+                    fragment.lastSent = now;
+                    record.fragmentIds.push_back(fragment.id);
+                }
+
+                packet[countOffset] = static_cast<u8>(record.fragmentIds.size());
+
+                const std::size_t messageCountOffset = packet.size();
+                writer.WriteU8(0);
+
+                if (p == 0) {
+                    u8 messageCount = 0;
+
+                    for (const std::vector<u8>& message : m_unreliableOut) {
+                        if (messageCount == 255 || packet.size() + 2 + message.size() > MC_NET_MAX_PACKET)
+                            continue;
+
+                        writer.WriteU16(static_cast<u16>(message.size()));
+                        writer.WriteBytes(message.data(), message.size());
+                        ++messageCount;
+                    }
+
+                    packet[messageCountOffset] = messageCount;
+                    m_unreliableOut.clear();
+                } else if (record.fragmentIds.empty()) {
+                    record.bValid = false;
+                    break;
+                }
+
+                ++m_localSequence;
+                m_stats.bytesSent += packet.size();
+                ++m_stats.packetsSent;
+
+                packets.push_back(std::move(packet));
+            }
+
+            return packets;
+        }
+    }; // class NetConnection
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "header.hpp"
+#include "entity.hpp"
+#include "byteStream.hpp"
+
+/*
+ * Messages exchanged on top of NetConnection; the first byte of each is its NetMessageType.
+ * A client connects with Hello: the server ignores an address until a packet from it delivers one.
+ *
+ * Entities are replicated with snapshots sent on the unreliable channel. Each snapshot is a
+ * delta against the newest snapshot the client acknowledged (through its Input messages), so
+ * entities that did not move cost nothing, and a lost snapshot simply means the next one is
+ * encoded against an older baseline.
+ */
+
+namespace mc {
+
+    constexpr u16         MC_NET_DEFAULT_PORT     = 25565;
+    constexpr u32         MC_NET_TICK_RATE        = 20;   // Server ticks, and client inputs, per second
+    constexpr u32         MC_NET_SNAPSHOT_HISTORY = 32;   // Snapshots kept to encode against / decode from
+    constexpr std::size_t MC_NET_SNAPSHOT_BUDGET  = 1000; // Bytes, so a snapshot always fits in one packet
+
+    constexpr f32 MC_NET_POSITION_SCALE = 64.f;  // Positions are sent in 1/64th of a block
+    constexpr f32 MC_NET_VELOCITY_SCALE = 256.f; // Velocities in 1/256th of a block per second
+
+    enum class NetMessageType : u8 {
+        // Client to server
+        eHello,       // reliable:   u8 view radius, always the first message
+        eInput,       // unreliable: u32 newest snapshot id | i8 move x | i8 move z | u8 jump
+        // Server to client
+        eWelcome,     // reliable:   u32 player entity id
+        eChunkData,   // reliable:   i32 x | i32 z | chunk (see chunkCodec.hpp)
+        eChunkUnload, // reliable:   i32 x | i32 z
+        eSnapshot,    // unreliable: see EncodeSnapshot
+    }; // enum class NetMessageType
+
+    struct EntityState {
+        std::array<i32, 3> position;
+        std::array<i16, 3> velocity;
+
+        inline bool operator==(const EntityState& other) const { return position == other.position && velocity == other.velocity; }
+        inline bool operator!=(const EntityState& other) const { return !(*this == other); }
+
+        static EntityState Quantize(const vec3f32& position, const vec3f32& velocity) {
+            const auto Velocity = [](const f32 v) { return static_cast<i16>(std::clamp(std::round(v * MC_NET_VELOCITY_SCALE), -32767.f, 32767.f)); };
+
+            return EntityState{
+                { static_cast<i32>(std::round(position.x * MC_NET_POSITION_SCALE)), static_cast<i32>(std::round(position.y * MC_NET_POSITION_SCALE)), static_cast<i32>(std::round(position.z * MC_NET_POSITION_SCALE)) },
+                { Velocity(velocity.x), Velocity(velocity.y), Velocity(velocity.z) }
+            };
+        }
+
+        inline vec3f32 GetPosition() const { return vec3f32{ position[0] / MC_NET_POSITION_SCALE, position[1] / MC_NET_POSITION_SCALE, position[2] / MC_NET_POSITION_SCALE }; }
+        inline vec3f32 GetVelocity() const { return vec3f32{ velocity[0] / MC_NET_VELOCITY_SCALE, velocity[1] / MC_NET_VELOCITY_SCALE, velocity[2] / MC_NET_VELOCITY_SCALE }; }
+    }; // struct EntityState
+
+    using EntityStates = std::unordered_map<EntityID, EntityState>;
+
+    struct NetSnapshot {
+        u32          id = 0; // 0 is "no snapshot", the baseline of the very first one
+        EntityStates entities;
+    }; // struct NetSnapshot
+
+    namespace details {
+
+        enum EntityUpdateFlags : u8 {
+            ENTITY_UPDATE_POSITION = 1 << 0,
+            ENTITY_UPDATE_VELOCITY = 1 << 1,
+            ENTITY_UPDATE_NEW      = 1 << 2, // Absolute values, the client has no baseline for it
+        }; // enum EntityUpdateFlags
+
+    }; // namespace details
+
+    /*
+     * Layout: type | u32 id | u32 baseline id | u16 removed count | removed ids (varint) |
+     *         u16 update count | per update: varint id | u8 flags | position and/or velocity,
+     *         zigzag varints relative to the baseline state (absolute for new entities).
+     *
+     * visible is in priority order: whatever does not fit in MC_NET_SNAPSHOT_BUDGET is left at
+     * its baseline state. Returns what the client will hold once it decoded the message, which
+     * is what later snapshots get encoded against.
+     */
+    inline NetSnapshot EncodeSnapshot(const u32 id, const NetSnapshot& baseline, const std::vector<std::pair<EntityID, EntityState>>& visible, std::vector<u8>& out) {
+        NetSnapshot result{ id, baseline.entities };
+
+        ByteWriter writer(out);
+        writer.WriteU8(static_cast<u8>(NetMessageType::eSnapshot));
+        writer.WriteU32(id);
+        writer.WriteU32(baseline.id);
+
+        std::unordered_set<EntityID> visibleIds;
+        visibleIds.reserve(visible.size());
+        for (const auto& [entityId, state] : visible)
+            visibleIds.insert(entityId);
+
+        const std::size_t removedCountOffset = out.size();
+        writer.WriteU16(0);
+
+        u16 removedCount = 0;
+        for (const auto& [entityId, state] : baseline.entities) {
+            if (visibleIds.count(entityId))
+                continue;
+
+            if (out.size() + 5 > MC_NET_SNAPSHOT_BUDGET)
+                break;
+
+            writer.WriteVarU32(entityId);
+            result.entities.erase(entityId);
+            ++removedCount;
+        }
+
+        out[removedCountOffset]     = static_cast<u8>(removedCount);
+        out[removedCountOffset + 1] = static_cast<u8>(removedCount >> 8);
+
+        const std::size_t updateCountOffset = out.size();
+        writer.WriteU16(0);
+
+        u16 updateCount = 0;
+        for (const auto& [entityId, state] : visible) {
+            const auto it = baseline.entities.find(entityId);
+
+            if (it != baseline.entities.end() && it->second == state)
+                continue;
+
+            const std::size_t rollback = out.size();
+
+            const bool bNew = it == baseline.entities.end();
+            const EntityState reference = bNew ? EntityState{} : it->second;
+
+            u8 flags = bNew ? details::ENTITY_UPDATE_NEW : 0;
+            if (state.position != reference.position) flags |= details::ENTITY_UPDATE_POSITION;
+            if (state.velocity != reference.velocity) flags |= details::ENTITY_UPDATE_VELOCITY;
+
+            writer.WriteVarU32(entityId);
+            writer.WriteU8(flags);
+
+            if (flags & details::ENTITY_UPDATE_POSITION)
+                for (u32 a = 0; a < 3; ++a)
+                    writer.WriteVarI32(state.position[a] - reference.position[a]);
+
+            if (flags & details::ENTITY_UPDATE_VELOCITY)
+                for (u32 a = 0; a < 3; ++a)
+                    writer.WriteVarI32(state.velocity[a] - reference.velocity[a]);
+
+            if (out.size() > MC_NET_SNAPSHOT_BUDGET) {
+                out.resize(rollback);
+                break;
+            }
+
+            result.entities[entityId] = state;
+            ++updateCount;
+        }
+
+        out[updateCountOffset]     = static_cast<u8>(updateCount);
+        out[updateCountOffset + 1] = static_cast<u8>(updateCount >> 8);
+
+        return result;
+    }
+
+    // The reader is positioned after the type byte; history maps snapshot ids to what was decoded before
+    inline std::optional<NetSnapshot> DecodeSnapshot(ByteReader& reader, const std::array<NetSnapshot, MC_NET_SNAPSHOT_HISTORY>& history) {
+        NetSnapshot result;
+        result.id = reader.ReadU32();
+
+        const u32 baselineId = reader.ReadU32();
+
+        if (baselineId != 0) {
+            const NetSnapshot& baseline = history[baselineId % MC_NET_SNAPSHOT_HISTORY];
+
+            // Fell out of the history: the server will move on to a newer baseline once our acks reach it
+            if (baseline.id != baselineId)
+                return {};
+
+            result.entities = baseline.entities;
+        }
+
+        const u16 removedCount = reader.ReadU16();
+        for (u16 i = 0; i < removedCount && reader.IsValid(); ++i)
+            result.entities.erase(reader.ReadVarU32());
+
+        const u16 updateCount = reader.ReadU16();
+        for (u16 i = 0; i < updateCount && reader.IsValid(); ++i) {
+            const EntityID entityId = reader.ReadVarU32();
+            const u8       flags    = reader.ReadU8();
+
+            EntityState state = (flags & details::ENTITY_UPDATE_NEW) ? EntityState{} : result.entities[entityId];
+
+            if (flags & details::ENTITY_UPDATE_POSITION)
+                for (u32 a = 0; a < 3; ++a)
+                    state.position[a] += reader.ReadVarI32();
+
+            if (flags & details::ENTITY_UPDATE_VELOCITY)
+                for (u32 a = 0; a < 3; ++a)
+                    state.velocity[a] = static_cast<i16>(state.velocity[a] + reader.ReadVarI32());
+
+            result.entities[entityId] = state;
+        }
+
+        if (!reader.IsValid())
+            return {};
+
+        return result;
+    }
+
+}; // namespace mc
\ No newline at end of file
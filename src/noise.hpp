@@ -0,0 +1,90 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Stateless, seedable value noise. Everything is a pure function of (seed, position)
+ * so chunks can be generated in any order and on any thread.
+ */
+
+namespace mc {
+
+    namespace noise {
+
+        constexpr u64 Hash(u64 v) {
+            // SplitMix64 finalizer
+            v += 0x9E3779B97F4A7C15ull;
+            v  = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ull;
+            v  = (v ^ (v >> 27)) * 0x94D049BB133111EBull;
+
+            return v ^ (v >> 31);
+        }
+
+        constexpr u64 Hash(const u64 seed, const i32 x, const i32 y, const i32 z) {
+            return Hash(seed ^ Hash(static_cast<u64>(static_cast<u32>(x)) | (static_cast<u64>(static_cast<u32>(z)) << 32)) ^ Hash(static_cast<u64>(static_cast<u32>(y)) + 0x632BE59BD9B4E019ull));
+        }
+
+        // Uniform in [0, 1)
+        constexpr f32 HashToUnit(const u64 h) { return static_cast<f32>(h >> 40) / static_cast<f32>(1ull << 24); }
+
+        constexpr f32 SmoothStep(const f32 t) { return t * t * (3.f - 2.f * t); }
+        constexpr f32 Lerp(const f32 a, const f32 b, const f32 t) { return a + (b - a) * t; }
+
+        inline f32 Value2D(const u64 seed, const f32 x, const f32 z) {
+            const f32 fx = std::floor(x), fz = std::floor(z);
+            const i32 ix = static_cast<i32>(fx), iz = static_cast<i32>(fz);
+            const f32 tx = SmoothStep(x - fx), tz = SmoothStep(z - fz);
+
+            const f32 v00 = HashToUnit(Hash(seed, ix,     0, iz));
+            const f32 v10 = HashToUnit(Hash(seed, ix + 1, 0, iz));
+            const f32 v01 = HashToUnit(Hash(seed, ix,     0, iz + 1));
+            const f32 v11 = HashToUnit(Hash(seed, ix + 1, 0, iz + 1));
+
+            return Lerp(Lerp(v00, v10, tx), Lerp(v01, v11, tx), tz);
+        }
+
+        inline f32 Value3D(const u64 seed, const f32 x, const f32 y, const f32 z) {
+            const f32 fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+            const i32 ix = static_cast<i32>(fx), iy = static_cast<i32>(fy), iz = static_cast<i32>(fz);
+            const f32 tx = SmoothStep(x - fx), ty = SmoothStep(y - fy), tz = SmoothStep(z - fz);
+
+            f32 corners[8];
+            for (int i = 0; i < 8; ++i)
+                corners[i] = HashToUnit(Hash(seed, ix + (i & 1), iy + ((i >> 1) & 1), iz + (i >> 2)));
+
+            const f32 y0 = Lerp(Lerp(corners[0], corners[1], tx), Lerp(corners[2], corners[3], tx), ty);
+            const f32 y1 = Lerp(Lerp(corners[4], corners[5], tx), Lerp(corners[6], corners[7], tx), ty);
+
+            return Lerp(y0, y1, tz);
+        }
+
+        // Fractal Brownian motion, normalized to [0, 1)
+        inline f32 Fractal2D(const u64 seed, const f32 x, const f32 z, const u32 octaves) {
+            f32 sum = 0.f, amplitude = 1.f, frequency = 1.f, total = 0.f;
+
+            for (u32 i = 0; i < octaves; ++i) {
+                sum       += Value2D(seed + i, x * frequency, z * frequency) * amplitude;
+                total     += amplitude;
+                amplitude *= 0.5f;
+                frequency *= 2.f;
+            }
+
+            return sum / total;
+        }
+
+        inline f32 Fractal3D(const u64 seed, const f32 x, const f32 y, const f32 z, const u32 octaves) {
+            f32 sum = 0.f, amplitude = 1.f, frequency = 1.f, total = 0.f;
+
+            for (u32 i = 0; i < octaves; ++i) {
+                sum       += Value3D(seed + i, x * frequency, y * frequency, z * frequency) * amplitude;
+                total     += amplitude;
+                amplitude *= 0.5f;
+                frequency *= 2.f;
+            }
+
+            return sum / total;
+        }
+
+    }; // namespace noise
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "header.hpp"
+
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+
+/*
+ * Numbers and switches given on the command line or in addresses. Anything but the whole text
+ * being a number in range, or a switch, throws std::runtime_error naming where it came from,
+ * which the entry point reports.
+ */
+
+namespace mc {
+
+    // A whole number in [min, max], without sign, spaces or anything after it
+    template <typename T>
+    T ParseUnsigned(const std::string& name, const std::string& text, const T min = 0, const T max = std::numeric_limits<T>::max()) {
+        static_assert(std::is_unsigned_v<T>, "ParseUnsigned only parses unsigned types");
+
+        const std::string range = std::to_string(min) + " to " + std::to_string(max);
+
+        if (text.empty() || !std::isdigit(static_cast<unsigned char>(text.front())))
+            throw std::runtime_error(name + " expects a whole number from " + range + ", not \"" + text + '"');
+
+        char* pEnd = nullptr;
+        errno = 0;
+
+        const unsigned long long value = std::strtoull(text.c_str(), &pEnd, 10);
+
+        if (*pEnd != '\0')
+            throw std::runtime_error(name + " expects a whole number from " + range + ", not \"" + text + '"');
+
+        if (errno == ERANGE || value < min || value > max)
+            throw std::runtime_error(name + " must be from " + range + ", not " + text);
+
+        return static_cast<T>(value);
+    }
+
+    // A decimal number in [min, max]
+    inline f64 ParseReal(const std::string& name, const std::string& text, const f64 min, const f64 max) {
+        char* pEnd = nullptr;
+        errno = 0;
+
+        const f64 value = std::strtod(text.c_str(), &pEnd);
+
+        if (text.empty() || *pEnd != '\0' || errno == ERANGE || !std::isfinite(value))
+            throw std::runtime_error(name + " expects a number, not \"" + text + '"');
+
+        if (value < min || value > max) {
+            std::ostringstream range;
+            range << min << " to " << max;
+
+            throw std::runtime_error(name + " must be from " + range.str() + ", not " + text);
+        }
+
+        return value;
+    }
+
+    // "on" or "off"
+    inline bool ParseSwitch(const std::string& name, const std::string& text) {
+        if (text == "on")  return true;
+        if (text == "off") return false;
+
+        throw std::runtime_error(name + " expects on or off, not \"" + text + '"');
+    }
+
+}; // namespace mc
\ No newline at end of file
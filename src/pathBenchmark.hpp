@@ -0,0 +1,170 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "threadPool.hpp"
+#include "pathfinder.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * Paths per second between surface cells 16, 64 and 256 blocks apart on generated terrain, in
+ * batches over the thread pool, searching the regions first against searching the cells directly.
+ * The first hierarchical batch also builds the regions and portals it goes through, so it is
+ * reported apart. Then a few hundred blocks are placed around the map, the sections they touch
+ * invalidated, and the batch run again to show what rebuilding them costs. Generation is not timed.
+ */
+
+namespace mc {
+
+    class PathBenchmark {
+    private:
+        static constexpr i32 SIDE_CHUNKS = 24; // Room for the longest paths with a margin
+        static constexpr i32 MARGIN      = 8;  // Blocks kept off the world's edge
+        static constexpr u32 EDITS       = 256;
+
+        struct BatchResult {
+            u64 elapsedUS = 0;
+            u64 found     = 0;
+            u64 expanded  = 0;
+            u64 regions   = 0;
+            u64 length    = 0; // Cells on the paths found
+        }; // struct BatchResult
+
+        // Where a walker stands on the terrain at (x, z), if it can stand there
+        static std::optional<vec3i32> SurfaceCell(const World& world, const WorldGenerator& generator, const i32 x, const i32 z) {
+            const vec3i32 cell{ x, generator.GetTerrainHeight(x, z) + 1, z };
+
+            if (!IsSolid(world.GetBlock(cell - vec3i32{ 0, 1, 0 })))
+                return {};
+
+            for (i32 h = 0; h < MC_PATH_CLEARANCE; ++h)
+                if (IsSolid(world.GetBlock(cell + vec3i32{ 0, h, 0 })))
+                    return {};
+
+            return cell;
+        }
+
+        static std::vector<PathRequest> MakeRequests(const World& world, const WorldGenerator& generator, const i32 distance, const u32 count) {
+            constexpr i32 SIDE = SIDE_CHUNKS * static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+            std::vector<PathRequest> requests;
+            u64 rng = 0x50617468ull + static_cast<u64>(distance);
+
+            while (requests.size() < count) {
+                rng = noise::Hash(rng);
+
+                const f32 angle = noise::HashToUnit(rng) * 6.2831853f;
+                const i32 x     = MARGIN + static_cast<i32>((rng >> 20) % (SIDE - 2 * MARGIN));
+                const i32 z     = MARGIN + static_cast<i32>((rng >> 40) % (SIDE - 2 * MARGIN));
+                const i32 gx    = x + static_cast<i32>(std::round(std::cos(angle) * distance));
+                const i32 gz    = z + static_cast<i32>(std::round(std::sin(angle) * distance));
+
+                if (gx < MARGIN || gx >= SIDE - MARGIN || gz < MARGIN || gz >= SIDE - MARGIN)
+                    continue;
+
+                const std::optional<vec3i32> start = SurfaceCell(world, generator, x, z);
+                const std::optional<vec3i32> goal  = SurfaceCell(world, generator, gx, gz);
+
+                if (start.has_value() && goal.has_value())
+                    requests.push_back(PathRequest{ start.value(), goal.value() });
+            }
+
+            return requests;
+        }
+
+        static BatchResult RunBatch(Pathfinder& paths, const World& world, const std::vector<PathRequest>& requests, std::vector<PathResult>& results, ThreadPool& pool, const bool bHierarchical) {
+            BatchResult batch;
+
+            const Timer timer;
+            paths.FindPaths(world, requests, results, pool, bHierarchical);
+            batch.elapsedUS = timer.GetElapsedUS();
+
+            for (const PathResult& result : results) {
+                batch.found    += !result.path.empty();
+                batch.expanded += result.expanded;
+                batch.regions  += result.regions;
+                batch.length   += result.path.size();
+            }
+
+            return batch;
+        }
+
+        static void Print(std::ostream& out, const i32 distance, const char* pMode, const BatchResult& batch, const std::size_t count) {
+            const f64 paths = static_cast<f64>(std::max<std::size_t>(count, 1));
+            const f64 found = static_cast<f64>(std::max<u64>(batch.found, 1));
+
+            out << "[BENCHMARK] " << std::setw(3) << distance << " blocks " << std::left << std::setw(12) << pMode << std::right << std::fixed << std::setprecision(0)
+                << " | " << std::setw(8) << paths * 1e6 / static_cast<f64>(std::max<u64>(batch.elapsedUS, 1)) << " paths/s | " << std::setprecision(1)
+                << static_cast<f64>(batch.found) * 100.0 / paths << "% found | " << std::setprecision(0) << static_cast<f64>(batch.expanded) / paths << " cells expanded, "
+                << static_cast<f64>(batch.length) / found << " long";
+
+            if (batch.regions > 0)
+                out << ", " << static_cast<f64>(batch.regions) / found << " regions";
+
+            out << '\n';
+        }
+
+    public:
+        static void RunAll(const u32 count, ThreadPool& pool, std::ostream& out) {
+            World              world;
+            WorldGenerator     generator(0x50617468ull);
+            GenerationPipeline generation(generator, pool);
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = 0; z < SIDE_CHUNKS; ++z)
+                for (i32 x = 0; x < SIDE_CHUNKS; ++x)
+                    chunks.push_back(&world.CreateChunk(ChunkCoord{ x, z }));
+
+            generation.Generate(chunks);
+
+            out << "[BENCHMARK] " << count << " paths per distance on " << pool.GetThreadCount() + 1 << " threads over " << SIDE_CHUNKS << " x " << SIDE_CHUNKS << " chunks\n";
+
+            Pathfinder              paths;
+            std::vector<PathResult> results;
+
+            for (const i32 distance : { 16, 64, 256 }) {
+                const std::vector<PathRequest> requests = MakeRequests(world, generator, distance, count);
+
+                Print(out, distance, "cold", RunBatch(paths, world, requests, results, pool, true), requests.size());
+                Print(out, distance, "hierarchical", RunBatch(paths, world, requests, results, pool, true), requests.size());
+                Print(out, distance, "flat", RunBatch(paths, world, requests, results, pool, false), requests.size());
+            }
+
+            const PathStats before = paths.GetStats();
+
+            // Pillars on the surface, as players building would
+            u64 rng = 0x45646974ull;
+
+            for (u32 i = 0; i < EDITS; ++i) {
+                rng = noise::Hash(rng);
+
+                const i32 x = static_cast<i32>(rng % (SIDE_CHUNKS * MC_CHUNK_SECTION_SIZE));
+                const i32 z = static_cast<i32>((rng >> 24) % (SIDE_CHUNKS * MC_CHUNK_SECTION_SIZE));
+                const i32 y = generator.GetTerrainHeight(x, z) + 1;
+
+                world.SetBlock(vec3i32{ x, y, z }, Block::Cobblestone);
+                world.SetBlock(vec3i32{ x, y + 1, z }, Block::Cobblestone);
+            }
+
+            const std::size_t dirty = world.GetDirtySections().size();
+
+            for (const vec3i32& section : world.GetDirtySections())
+                paths.Invalidate(section);
+
+            const std::vector<PathRequest> requests = MakeRequests(world, generator, 64, count);
+            const BatchResult              batch    = RunBatch(paths, world, requests, results, pool, true);
+            const PathStats                after    = paths.GetStats();
+
+            out << "[BENCHMARK] " << EDITS << " pillars built: " << dirty << " dirty sections dropped " << after.invalidations - before.invalidations << " sections of regions\n";
+            Print(out, 64, "after edits", batch, requests.size());
+            out << "[BENCHMARK]            rebuilt " << after.regionBuilds - before.regionBuilds << " sections of regions and " << after.linkBuilds - before.linkBuilds
+                << " of portals | " << after.sections << " sections held, " << std::setprecision(1) << static_cast<f64>(after.bytes) / (1 << 20) << " MiB\n";
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class PathBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,737 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "threadPool.hpp"
+
+/*
+ * Hierarchical A* for walking mobs. A walker stands in an air cell over a solid block, with
+ * MC_PATH_CLEARANCE free blocks from its feet up, and moves to one of the four cells around it,
+ * one block up or down at most; stepping up needs one more free block over its head.
+ *
+ * Each chunk section is cut into regions, the cells a walker can reach from one another without
+ * leaving the section, and each region is linked to the regions next to it across the section's
+ * borders, its portals. A search first finds a chain of regions on that graph, which is small,
+ * then the cell path within only those regions. The paths found are not always the shortest, in
+ * exchange the searches no longer grow with the area around the path, and an unreachable goal
+ * is known before a single cell is visited.
+ *
+ * Regions and portals are built the first time a search needs them and dropped by Invalidate()
+ * when the blocks they come from change, to be rebuilt by the next search through them. The
+ * searches themselves run on a fixed pool of nodes per thread and allocate nothing.
+ */
+
+namespace mc {
+
+    constexpr i32 MC_PATH_CLEARANCE   = 2;       // Free blocks a walker needs from its feet up
+    constexpr u32 MC_PATH_MAX_NODES   = 1 << 16; // Cells a search may visit before it gives up
+    constexpr u32 MC_PATH_MAX_REGIONS = 1 << 12; // Regions an abstract search may visit before it gives up
+
+    static_assert(MC_PATH_CLEARANCE < static_cast<i32>(MC_CHUNK_SECTION_SIZE), "A walker's clearance must fit in the section above");
+
+    struct PathRequest {
+        vec3i32 start; // The cells the walker's feet are in
+        vec3i32 goal;
+    }; // struct PathRequest
+
+    struct PathResult {
+        std::vector<vec3i32> path;         // From the start to the goal, both included; empty when none was found
+        u32                  regions  = 0; // On the abstract path
+        u32                  expanded = 0; // Cells expanded finding the path
+    }; // struct PathResult
+
+    struct PathStats {
+        u64 regionBuilds  = 0; // Sections cut into regions
+        u64 linkBuilds    = 0; // Sections whose portals were found
+        u64 invalidations = 0; // Sections whose regions were dropped
+        u64 sections      = 0; // Holding regions now
+        u64 bytes         = 0; // Held by regions and portals, roughly
+    }; // struct PathStats
+
+    // The cells of a section a walker can stand in, and the regions they belong to
+    struct SectionRegions {
+        static constexpr u16 NONE     = 0x7FFF; // Not a cell a walker can stand in
+        static constexpr u16 HEADROOM = 0x8000; // Set on the cells a walker can step up from
+
+        std::vector<u16>     cells;     // Region and HEADROOM per cell, empty when there is no cell to stand in
+        std::vector<vec3f32> centroids; // Per region, in world space
+
+        static constexpr u32 Index(const u32 x, const u32 y, const u32 z) { return (y * MC_CHUNK_SECTION_SIZE + z) * MC_CHUNK_SECTION_SIZE + x; }
+
+        inline u16 Get(const u32 x, const u32 y, const u32 z) const { return cells.empty() ? NONE : cells[Index(x, y, z)]; }
+
+        static constexpr u16 RegionOf(const u16 cell) { return cell & NONE; }
+
+        // Whether a walker can move between two cells one apart horizontally, dy being to's height over from's
+        static constexpr bool CanStep(const u16 from, const u16 to, const i32 dy) {
+            if (RegionOf(from) == NONE || RegionOf(to) == NONE)
+                return false;
+
+            return dy == 0 || (dy > 0 ? (from & HEADROOM) != 0 : (to & HEADROOM) != 0);
+        }
+    }; // struct SectionRegions
+
+    struct RegionLink {
+        vec3i32 section;
+        u16     region;
+        f32     cost;     // Between the two regions' centroids
+        vec3f32 centroid; // The linked region's
+    }; // struct RegionLink
+
+    // The portals of a section's regions: those of region r are links[linkStarts[r], linkStarts[r + 1])
+    struct SectionLinks {
+        std::vector<u32>        linkStarts;
+        std::vector<RegionLink> links;
+    }; // struct SectionLinks
+
+    // A* open and closed sets over a fixed pool of nodes, reused from one search to the next
+    class SearchPool {
+    public:
+        static constexpr u32 NONE = UINT32_MAX;
+
+        struct Node {
+            u64  key;
+            f32  g;
+            u32  parent;
+            bool bClosed;
+        }; // struct Node
+
+    private:
+        struct Slot {
+            u32 stamp;
+            u32 node;
+        }; // struct Slot
+
+        struct Open {
+            f32 f;
+            u32 node;
+
+            inline bool operator>(const Open& other) const { return f > other.f; }
+        }; // struct Open
+
+        u32               m_capacity;
+        u32               m_shift;
+        u32               m_stamp = 0;
+        std::vector<Node> m_nodes;
+        std::vector<Slot> m_table; // Open addressing, a slot being empty unless stamped by the current search
+        std::vector<Open> m_open;  // A binary heap, nodes pushed again when their cost drops
+
+    private:
+        inline std::size_t Hash(const u64 key) const { return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> m_shift); }
+
+    public:
+        explicit SearchPool(const u32 capacity)
+            : m_capacity(capacity)
+        {
+            u32 bits = 1;
+            while ((1u << bits) < capacity * 2)
+                ++bits;
+
+            m_shift = 64 - bits;
+            m_table.resize(std::size_t{ 1 } << bits, Slot{ 0, NONE });
+            m_nodes.reserve(capacity);
+            m_open.reserve(capacity * 4);
+        }
+
+        void Begin() {
+            m_nodes.clear();
+            m_open.clear();
+
+            if (++m_stamp == 0) {
+                std::fill(m_table.begin(), m_table.end(), Slot{ 0, NONE });
+                m_stamp = 1;
+            }
+        }
+
+        u32 Find(const u64 key) const {
+            const std::size_t mask = m_table.size() - 1;
+
+            for (std::size_t i = Hash(key); m_table[i].stamp == m_stamp; i = (i + 1) & mask)
+                if (m_nodes[m_table[i].node].key == key)
+                    return m_table[i].node;
+
+            return NONE;
+        }
+
+        // NONE once the pool is full
+        u32 Insert(const u64 key, const f32 g, const u32 parent) {
+            if (m_nodes.size() == m_capacity)
+                return NONE;
+
+            const std::size_t mask = m_table.size() - 1;
+
+            std::size_t i = Hash(key);
+            while (m_table[i].stamp == m_stamp)
+                i = (i + 1) & mask;
+
+            const u32 node = static_cast<u32>(m_nodes.size());
+
+            m_table[i] = Slot{ m_stamp, node };
+            m_nodes.push_back(Node{ key, g, parent, false });
+
+            return node;
+        }
+
+        inline Node& Get(const u32 node) { return m_nodes[node]; }
+
+        // False once the open set is full
+        bool Push(const u32 node, const f32 f) {
+            if (m_open.size() == m_open.capacity())
+                return false;
+
+            m_open.push_back(Open{ f, node });
+            std::push_heap(m_open.begin(), m_open.end(), std::greater<Open>());
+
+            return true;
+        }
+
+        // The open node of lowest cost, NONE when there is none left
+        u32 Pop() {
+            while (!m_open.empty()) {
+                std::pop_heap(m_open.begin(), m_open.end(), std::greater<Open>());
+
+                const u32 node = m_open.back().node;
+                m_open.pop_back();
+
+                if (!m_nodes[node].bClosed)
+                    return node;
+            }
+
+            return NONE;
+        }
+
+        inline u32 GetCount() const { return static_cast<u32>(m_nodes.size()); }
+    }; // class SearchPool
+
+    class Pathfinder {
+    private:
+        static constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+
+        static constexpr f32 CLIMB_COST = 0.5f; // On top of a step's, per block up or down
+
+        // The four directions a walker moves in, each one block up, level or one block down
+        static constexpr std::array<std::array<i32, 2>, 4> DIRECTIONS = { { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } } };
+
+        struct SectionCacheEntry {
+            vec3i32               section;
+            const SectionRegions* pRegions = nullptr;
+        }; // struct SectionCacheEntry
+
+        // What a thread searches with: allocated the first time it searches, then reused
+        struct Scratch {
+            SearchPool       regions{ MC_PATH_MAX_REGIONS };
+            SearchPool       cells{ MC_PATH_MAX_NODES };
+            std::vector<u64> corridor; // Sorted keys of the regions on the abstract path
+
+            std::array<SectionCacheEntry, 16> sectionCache;
+
+            Scratch() { corridor.reserve(MC_PATH_MAX_REGIONS); }
+        }; // struct Scratch
+
+        mutable std::shared_mutex m_mutex;
+        std::unordered_map<vec3i32, std::shared_ptr<const SectionRegions>, SectionCoordHash> m_regions;
+        std::unordered_map<vec3i32, std::shared_ptr<const SectionLinks>, SectionCoordHash>   m_links;
+        PathStats m_stats;
+
+    private:
+        static Scratch& GetScratch() {
+            thread_local Scratch scratch;
+            return scratch;
+        }
+
+        static const SectionRegions& GetEmptyRegions() {
+            static const SectionRegions empty;
+            return empty;
+        }
+
+        static inline vec3i32 SectionOf(const vec3i32& cell) { return vec3i32{ WorldToChunk(cell.x), WorldToChunk(cell.y), WorldToChunk(cell.z) }; }
+
+        static inline u64 RegionKey(const vec3i32& section, const u16 region) {
+            return (static_cast<u64>(static_cast<u32>(section.x + (1 << 21)) & 0x3FFFFF) << 42)
+                 | (static_cast<u64>(static_cast<u32>(section.z + (1 << 21)) & 0x3FFFFF) << 20)
+                 | (static_cast<u64>(static_cast<u32>(section.y) & 0x1F) << 15)
+                 | region;
+        }
+
+        static inline vec3i32 RegionKeySection(const u64 key) {
+            return vec3i32{ static_cast<i32>((key >> 42) & 0x3FFFFF) - (1 << 21), static_cast<i32>((key >> 15) & 0x1F), static_cast<i32>((key >> 20) & 0x3FFFFF) - (1 << 21) };
+        }
+
+        static inline u64 CellKey(const vec3i32& cell) {
+            return (static_cast<u64>(static_cast<u32>(cell.x + (1 << 25)) & 0x3FFFFFF) << 38)
+                 | (static_cast<u64>(static_cast<u32>(cell.z + (1 << 25)) & 0x3FFFFFF) << 12)
+                 | (static_cast<u64>(static_cast<u32>(cell.y) & 0xFFF));
+        }
+
+        static inline vec3i32 CellKeyCell(const u64 key) {
+            return vec3i32{ static_cast<i32>((key >> 38) & 0x3FFFFFF) - (1 << 25), static_cast<i32>(key & 0xFFF), static_cast<i32>((key >> 12) & 0x3FFFFFF) - (1 << 25) };
+        }
+
+        static inline f32 Distance(const vec3f32& a, const vec3f32& b) {
+            return std::abs(a.x - b.x) + std::abs(a.z - b.z) + std::abs(a.y - b.y) * CLIMB_COST;
+        }
+
+        static inline f32 Distance(const vec3i32& a, const vec3i32& b) {
+            return static_cast<f32>(std::abs(a.x - b.x) + std::abs(a.z - b.z)) + static_cast<f32>(std::abs(a.y - b.y)) * CLIMB_COST;
+        }
+
+        /*
+         * Cuts a section into regions. A cell's standing depends on the block under it and on those
+         * up to its headroom, so the top layer of the section below and the bottom ones of the section
+         * above are read too.
+         */
+        static std::shared_ptr<const SectionRegions> BuildRegions(const World& world, const vec3i32& section) {
+            constexpr i32 LAYERS = S + MC_PATH_CLEARANCE + 2; // From one under the section to the headroom of its top layer
+
+            auto pRegions = std::make_shared<SectionRegions>();
+
+            if (section.y < 0 || section.y >= static_cast<i32>(MC_CHUNK_SECTION_COUNT))
+                return pRegions;
+
+            const std::array<const ChunkSection*, 3> sections = {
+                world.GetSection(section + vec3i32{ 0, -1, 0 }), world.GetSection(section), world.GetSection(section + vec3i32{ 0, 1, 0 })
+            };
+
+            if (!sections[0] && !sections[1])
+                return pRegions; // Nothing to stand on
+
+            std::array<u8, LAYERS * S * S> solid{};
+
+            for (i32 ly = -1; ly < LAYERS - 1; ++ly) {
+                const ChunkSection* pSection = sections[ly < 0 ? 0 : (ly < S ? 1 : 2)];
+                if (!pSection)
+                    continue;
+
+                const u32 y = WorldToLocal(ly);
+
+                for (u32 z = 0; z < MC_CHUNK_SECTION_SIZE; ++z)
+                    for (u32 x = 0; x < MC_CHUNK_SECTION_SIZE; ++x)
+                        solid[((ly + 1) * S + z) * S + x] = IsSolid(pSection->Get(x, y, z));
+            }
+
+            const auto Solid = [&solid](const i32 x, const i32 y, const i32 z) { return solid[((y + 1) * S + z) * S + x] != 0; };
+
+            std::vector<u16>& cells = pRegions->cells;
+            cells.assign(MC_CHUNK_SECTION_VOLUME, SectionRegions::NONE);
+
+            bool bAny = false;
+
+            for (i32 y = 0; y < S; ++y) {
+                for (i32 z = 0; z < S; ++z) {
+                    for (i32 x = 0; x < S; ++x) {
+                        if (!Solid(x, y - 1, z))
+                            continue;
+
+                        bool bClear = true;
+                        for (i32 h = 0; h < MC_PATH_CLEARANCE && bClear; ++h)
+                            bClear = !Solid(x, y + h, z);
+
+                        if (!bClear)
+                            continue;
+
+                        cells[SectionRegions::Index(x, y, z)] = static_cast<u16>((SectionRegions::NONE - 1) | (Solid(x, y + MC_PATH_CLEARANCE, z) ? 0 : SectionRegions::HEADROOM));
+                        bAny = true;
+                    }
+                }
+            }
+
+            if (!bAny) {
+                cells.clear();
+                cells.shrink_to_fit();
+                return pRegions;
+            }
+
+            // Flood fills, NONE - 1 marking the cells not reached yet
+            std::array<u16, MC_CHUNK_SECTION_VOLUME> stack;
+            u16 regionCount = 0;
+
+            for (u32 start = 0; start < MC_CHUNK_SECTION_VOLUME; ++start) {
+                if (SectionRegions::RegionOf(cells[start]) != SectionRegions::NONE - 1)
+                    continue;
+
+                const u16 region = regionCount++;
+                vec3f32   sum{ 0.f, 0.f, 0.f };
+                u32       count = 0;
+                u32       top   = 0;
+
+                cells[start] = static_cast<u16>((cells[start] & SectionRegions::HEADROOM) | region);
+                stack[top++] = static_cast<u16>(start);
+
+                while (top > 0) {
+                    const u32 index = stack[--top];
+                    const i32 x = static_cast<i32>(index % S), z = static_cast<i32>(index / S % S), y = static_cast<i32>(index / (S * S));
+
+                    sum += vec3f32{ static_cast<f32>(x), static_cast<f32>(y), static_cast<f32>(z) };
+                    ++count;
+
+                    for (const auto& [dx, dz] : DIRECTIONS) {
+                        for (i32 dy = -1; dy <= 1; ++dy) {
+                            const i32 nx = x + dx, ny = y + dy, nz = z + dz;
+
+                            if (nx < 0 || nx >= S || ny < 0 || ny >= S || nz < 0 || nz >= S)
+                                continue;
+
+                            u16& next = cells[SectionRegions::Index(nx, ny, nz)];
+
+                            if (SectionRegions::RegionOf(next) == SectionRegions::NONE - 1 && SectionRegions::CanStep(cells[index], next, dy)) {
+                                next = static_cast<u16>((next & SectionRegions::HEADROOM) | region);
+                                stack[top++] = static_cast<u16>(SectionRegions::Index(nx, ny, nz));
+                            }
+                        }
+                    }
+                }
+
+                const vec3f32 origin{ static_cast<f32>(ChunkToWorld(section.x)), static_cast<f32>(ChunkToWorld(section.y)), static_cast<f32>(ChunkToWorld(section.z)) };
+                pRegions->centroids.push_back(origin + sum * (1.f / static_cast<f32>(count)) + vec3f32{ 0.5f, 0.f, 0.5f });
+            }
+
+            return pRegions;
+        }
+
+        // Every step out of the section's cells, to the regions on the other side of its borders
+        std::shared_ptr<const SectionLinks> BuildLinks(const World& world, const vec3i32& section) {
+            const SectionRegions& regions = GetRegions(world, section);
+
+            auto pLinks = std::make_shared<SectionLinks>();
+            pLinks->linkStarts.assign(regions.centroids.size() + 1, 0);
+
+            if (regions.cells.empty())
+                return pLinks;
+
+            std::array<const SectionRegions*, 27> around{};
+
+            struct Portal {
+                u16 from;
+                u8  neighbour; // Index in around
+                u16 to;
+
+                inline bool operator<(const Portal& other) const { return std::tie(from, neighbour, to) < std::tie(other.from, other.neighbour, other.to); }
+                inline bool operator==(const Portal& other) const { return from == other.from && neighbour == other.neighbour && to == other.to; }
+            }; // struct Portal
+
+            std::vector<Portal> portals;
+
+            for (i32 y = 0; y < S; ++y) {
+                for (i32 z = 0; z < S; ++z) {
+                    for (i32 x = 0; x < S; ++x) {
+                        const u16 cell = regions.cells[SectionRegions::Index(x, y, z)];
+
+                        if (SectionRegions::RegionOf(cell) == SectionRegions::NONE)
+                            continue;
+
+                        for (const auto& [dx, dz] : DIRECTIONS) {
+                            for (i32 dy = -1; dy <= 1; ++dy) {
+                                const i32 nx = x + dx, ny = y + dy, nz = z + dz;
+
+                                if (nx >= 0 && nx < S && ny >= 0 && ny < S && nz >= 0 && nz < S)
+                                    continue;
+
+                                const i32 ox = nx < 0 ? -1 : (nx >= S ? 1 : 0), oy = ny < 0 ? -1 : (ny >= S ? 1 : 0), oz = nz < 0 ? -1 : (nz >= S ? 1 : 0);
+                                const u8  neighbour = static_cast<u8>((ox + 1) + (oy + 1) * 3 + (oz + 1) * 9);
+
+                                if (!around[neighbour])
+                                    around[neighbour] = &GetRegions(world, section + vec3i32{ ox, oy, oz });
+
+                                const u16 next = around[neighbour]->Get(WorldToLocal(nx), WorldToLocal(ny), WorldToLocal(nz));
+
+                                if (SectionRegions::CanStep(cell, next, dy))
+                                    portals.push_back(Portal{ SectionRegions::RegionOf(cell), neighbour, SectionRegions::RegionOf(next) });
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::sort(portals.begin(), portals.end());
+            portals.erase(std::unique(portals.begin(), portals.end()), portals.end());
+
+            pLinks->links.reserve(portals.size());
+
+            for (const Portal& portal : portals) {
+                const vec3i32  offset{ portal.neighbour % 3 - 1, portal.neighbour / 3 % 3 - 1, portal.neighbour / 9 - 1 };
+                const vec3f32& centroid = around[portal.neighbour]->centroids[portal.to];
+
+                pLinks->links.push_back(RegionLink{ section + offset, portal.to, Distance(regions.centroids[portal.from], centroid), centroid });
+                ++pLinks->linkStarts[portal.from + 1];
+            }
+
+            for (std::size_t r = 1; r < pLinks->linkStarts.size(); ++r)
+                pLinks->linkStarts[r] += pLinks->linkStarts[r - 1];
+
+            return pLinks;
+        }
+
+        // Built outside the lock on a miss; two threads missing the same section build it twice and keep the first
+        const SectionRegions& GetRegions(const World& world, const vec3i32& section) {
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+                const auto it = m_regions.find(section);
+                if (it != m_regions.end())
+                    return *it->second;
+            }
+
+            std::shared_ptr<const SectionRegions> pRegions = BuildRegions(world, section);
+
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+            const auto [it, bInserted] = m_regions.try_emplace(section, std::move(pRegions));
+            if (bInserted)
+                ++m_stats.regionBuilds;
+
+            return *it->second;
+        }
+
+        const SectionLinks& GetLinks(const World& world, const vec3i32& section) {
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+                const auto it = m_links.find(section);
+                if (it != m_links.end())
+                    return *it->second;
+            }
+
+            std::shared_ptr<const SectionLinks> pLinks = BuildLinks(world, section);
+
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+            const auto [it, bInserted] = m_links.try_emplace(section, std::move(pLinks));
+            if (bInserted)
+                ++m_stats.linkBuilds;
+
+            return *it->second;
+        }
+
+        // Through the thread's cache of the sections it looked at last, so most steps take no lock
+        u16 GetCell(const World& world, Scratch& scratch, const vec3i32& cell) {
+            if (cell.y < 0 || cell.y >= MC_CHUNK_HEIGHT)
+                return SectionRegions::NONE;
+
+            const vec3i32      section = SectionOf(cell);
+            SectionCacheEntry& entry   = scratch.sectionCache[SectionCoordHash{}(section) % scratch.sectionCache.size()];
+
+            if (!entry.pRegions || entry.section != section)
+                entry = SectionCacheEntry{ section, &GetRegions(world, section) };
+
+            return entry.pRegions->Get(WorldToLocal(cell.x), WorldToLocal(cell.y), WorldToLocal(cell.z));
+        }
+
+        // A* over the regions, leaving the ones on the path in the scratch's corridor
+        bool SearchRegions(const World& world, Scratch& scratch, const u64 startKey, const u64 goalKey, const vec3i32& goal, const vec3f32& startCentroid) {
+            SearchPool& pool = scratch.regions;
+            pool.Begin();
+
+            const vec3f32 goalPosition{ static_cast<f32>(goal.x) + 0.5f, static_cast<f32>(goal.y), static_cast<f32>(goal.z) + 0.5f };
+
+            pool.Push(pool.Insert(startKey, 0.f, SearchPool::NONE), Distance(startCentroid, goalPosition));
+
+            for (u32 current = pool.Pop(); current != SearchPool::NONE; current = pool.Pop()) {
+                SearchPool::Node& node = pool.Get(current);
+                node.bClosed = true;
+
+                if (node.key == goalKey) {
+                    scratch.corridor.clear();
+
+                    for (u32 n = current; n != SearchPool::NONE; n = pool.Get(n).parent)
+                        scratch.corridor.push_back(pool.Get(n).key);
+
+                    std::sort(scratch.corridor.begin(), scratch.corridor.end());
+                    return true;
+                }
+
+                const u64           key     = node.key;
+                const f32           g       = node.g;
+                const vec3i32       section = RegionKeySection(key);
+                const SectionLinks& links   = GetLinks(world, section);
+                const u16           region  = static_cast<u16>(key & SectionRegions::NONE);
+
+                for (u32 l = links.linkStarts[region]; l < links.linkStarts[region + 1]; ++l) {
+                    const RegionLink& link    = links.links[l];
+                    const u64         nextKey = RegionKey(link.section, link.region);
+                    const f32         nextG   = g + link.cost;
+
+                    u32 next = pool.Find(nextKey);
+
+                    if (next == SearchPool::NONE) {
+                        if ((next = pool.Insert(nextKey, nextG, current)) == SearchPool::NONE)
+                            return false;
+                    } else {
+                        SearchPool::Node& existing = pool.Get(next);
+
+                        if (existing.bClosed || existing.g <= nextG)
+                            continue;
+
+                        existing.g      = nextG;
+                        existing.parent = current;
+                    }
+
+                    if (!pool.Push(next, nextG + Distance(link.centroid, goalPosition)))
+                        return false;
+                }
+            }
+
+            return false;
+        }
+
+        // A* over the cells, only through the corridor's regions when bCorridor
+        bool SearchCells(const World& world, Scratch& scratch, const vec3i32& start, const vec3i32& goal, const bool bCorridor, PathResult& result) {
+            SearchPool& pool = scratch.cells;
+            pool.Begin();
+
+            const u64 goalKey = CellKey(goal);
+
+            pool.Push(pool.Insert(CellKey(start), 0.f, SearchPool::NONE), Distance(start, goal));
+
+            for (u32 current = pool.Pop(); current != SearchPool::NONE; current = pool.Pop()) {
+                SearchPool::Node& node = pool.Get(current);
+                node.bClosed = true;
+
+                ++result.expanded;
+
+                if (node.key == goalKey) {
+                    for (u32 n = current; n != SearchPool::NONE; n = pool.Get(n).parent)
+                        result.path.push_back(CellKeyCell(pool.Get(n).key));
+
+                    std::reverse(result.path.begin(), result.path.end());
+                    return true;
+                }
+
+                const f32     g    = node.g;
+                const vec3i32 cell = CellKeyCell(node.key);
+                const u16     from = GetCell(world, scratch, cell);
+
+                for (const auto& [dx, dz] : DIRECTIONS) {
+                    for (i32 dy = -1; dy <= 1; ++dy) {
+                        const vec3i32 to   = cell + vec3i32{ dx, dy, dz };
+                        const u16     next = GetCell(world, scratch, to);
+
+                        if (!SectionRegions::CanStep(from, next, dy))
+                            continue;
+
+                        if (bCorridor && !std::binary_search(scratch.corridor.begin(), scratch.corridor.end(), RegionKey(SectionOf(to), SectionRegions::RegionOf(next))))
+                            continue;
+
+                        const u64 nextKey = CellKey(to);
+                        const f32 nextG   = g + 1.f + (dy != 0 ? CLIMB_COST : 0.f);
+
+                        u32 neighbour = pool.Find(nextKey);
+
+                        if (neighbour == SearchPool::NONE) {
+                            if ((neighbour = pool.Insert(nextKey, nextG, current)) == SearchPool::NONE)
+                                return false;
+                        } else {
+                            SearchPool::Node& existing = pool.Get(neighbour);
+
+                            if (existing.bClosed || existing.g <= nextG)
+                                continue;
+
+                            existing.g      = nextG;
+                            existing.parent = current;
+                        }
+
+                        if (!pool.Push(neighbour, nextG + Distance(to, goal)))
+                            return false;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+    public:
+        Pathfinder() = default;
+
+        Pathfinder(const Pathfinder&) = delete;
+        Pathfinder& operator=(const Pathfinder&) = delete;
+
+        /*
+         * Finds a path on the calling thread, leaving it in result.path. bHierarchical searches the
+         * regions first, without it the cells are searched directly, which is what the regions save.
+         * The world must not change during the call; reading it from several threads is fine.
+         */
+        bool FindPath(const World& world, const PathRequest& request, PathResult& result, const bool bHierarchical = true) {
+            Scratch& scratch = GetScratch();
+
+            result.path.clear();
+            result.regions  = 0;
+            result.expanded = 0;
+
+            scratch.sectionCache.fill(SectionCacheEntry{});
+
+            const u16 start = GetCell(world, scratch, request.start);
+            const u16 goal  = GetCell(world, scratch, request.goal);
+
+            if (SectionRegions::RegionOf(start) == SectionRegions::NONE || SectionRegions::RegionOf(goal) == SectionRegions::NONE)
+                return false;
+
+            if (bHierarchical) {
+                const vec3i32 startSection = SectionOf(request.start);
+                const u64     startKey     = RegionKey(startSection, SectionRegions::RegionOf(start));
+                const u64     goalKey      = RegionKey(SectionOf(request.goal), SectionRegions::RegionOf(goal));
+
+                if (!SearchRegions(world, scratch, startKey, goalKey, request.goal, GetRegions(world, startSection).centroids[SectionRegions::RegionOf(start)]))
+                    return false;
+
+                result.regions = static_cast<u32>(scratch.corridor.size());
+            }
+
+            return SearchCells(world, scratch, request.start, request.goal, bHierarchical, result);
+        }
+
+        // Each request on whichever worker gets to it, results[i] answering requests[i]. Their paths' storage is reused
+        void FindPaths(const World& world, const std::vector<PathRequest>& requests, std::vector<PathResult>& results, ThreadPool& pool, const bool bHierarchical = true) {
+            results.resize(requests.size());
+
+            pool.ParallelFor(requests.size(), 2, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    FindPath(world, requests[i], results[i], bHierarchical);
+            });
+        }
+
+        /*
+         * Drops what the blocks of a section feed: its regions and those of the sections above and under it,
+         * whose cells stand on or reach into it, then the portals of every section next to those.
+         * Not to be called while paths are searched.
+         */
+        void Invalidate(const vec3i32& section) {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+            for (i32 dy = -1; dy <= 1; ++dy)
+                m_stats.invalidations += m_regions.erase(section + vec3i32{ 0, dy, 0 });
+
+            for (i32 dy = -2; dy <= 2; ++dy)
+                for (i32 dz = -1; dz <= 1; ++dz)
+                    for (i32 dx = -1; dx <= 1; ++dx)
+                        m_links.erase(section + vec3i32{ dx, dy, dz });
+        }
+
+        // For chunks loaded or unloaded: sections out of the world read as air until then
+        void InvalidateChunk(const ChunkCoord coord) {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+            for (i32 y = 0; y < static_cast<i32>(MC_CHUNK_SECTION_COUNT); ++y) {
+                m_stats.invalidations += m_regions.erase(vec3i32{ coord.x, y, coord.z });
+
+                for (i32 dz = -1; dz <= 1; ++dz)
+                    for (i32 dx = -1; dx <= 1; ++dx)
+                        m_links.erase(vec3i32{ coord.x + dx, y, coord.z + dz });
+            }
+        }
+
+        PathStats GetStats() const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+            PathStats stats = m_stats;
+            stats.sections  = m_regions.size();
+
+            for (const auto& [section, pRegions] : m_regions)
+                stats.bytes += sizeof(SectionRegions) + pRegions->cells.capacity() * sizeof(u16) + pRegions->centroids.capacity() * sizeof(vec3f32);
+
+            for (const auto& [section, pLinks] : m_links)
+                stats.bytes += sizeof(SectionLinks) + pLinks->linkStarts.capacity() * sizeof(u32) + pLinks->links.capacity() * sizeof(RegionLink);
+
+            return stats;
+        }
+    }; // class Pathfinder
+
+}; // namespace mc
\ No newline at end of file
@@ -28,6 +28,7 @@ namespace mc {
             std::vector<vk::QueueFamilyProperties> m_queueFamilyPropss;
             vk::PhysicalDeviceProperties		   m_deviceProperties;
             vk::PhysicalDeviceMemoryProperties     m_memoryProperties;
+            std::vector<vk::ExtensionProperties>   m_extensionProperties;
 
             mc::u32 m_score = 0;
 
@@ -80,10 +81,10 @@ namespace mc {
             }
 
             void CheckExtensionSupport() {
-                const auto instanceLayerProperties = m_physical.enumerateDeviceExtensionProperties();
+                m_extensionProperties = m_physical.enumerateDeviceExtensionProperties();
 
                 for (const char* const requiredDeviceExt : mc::MC_VULKAN_DEVICE_EXTENSIONS) {
-                    if (!mc::vk_utils::IsExtensionPresent(requiredDeviceExt, instanceLayerProperties)) {
+                    if (!mc::vk_utils::IsExtensionPresent(requiredDeviceExt, m_extensionProperties)) {
                         m_bExtensionsSupported = false;
                         break;
                     }
@@ -134,6 +135,9 @@ namespace mc {
             inline const vk::PhysicalDeviceProperties&       GetProperties()       const { return m_deviceProperties; }
             inline const vk::PhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_memoryProperties; }
 
+            // For the optional extensions, which are only enabled when the device has them
+            inline bool IsExtensionSupported(const char* extensionName) const { return mc::vk_utils::IsExtensionPresent(extensionName, m_extensionProperties); }
+
             std::vector<vk::DeviceQueueCreateInfo> GenerateDeviceQueueCreateInfos() const {
                 std::unordered_set<mc::u32> uniqueFamilyIndices;
                 uniqueFamilyIndices.reserve(_QF_COUNT);
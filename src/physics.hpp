@@ -0,0 +1,89 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "geometry.hpp"
+
+/*
+ * Swept AABB against voxel terrain, resolved one axis at a time (Y first so entities
+ * land before sliding). Each axis clips the displacement against every solid block
+ * the box would sweep through.
+ */
+
+namespace mc {
+
+    constexpr f32 MC_COLLISION_EPSILON = 1e-4f;
+
+    struct CollisionResult {
+        vec3f32 displacement; // What is left of the requested displacement after clipping
+        bool    bCollided[3];
+    }; // struct CollisionResult
+
+    namespace details {
+        inline f32& Axis(vec3f32& v, const int a)       { return (&v.x)[a]; }
+        inline f32  Axis(const vec3f32& v, const int a) { return (&v.x)[a]; }
+    }; // namespace details
+
+    inline CollisionResult SweepAABB(const World& world, AABBf32 box, const vec3f32& displacement) {
+        using details::Axis;
+
+        constexpr int AXIS_ORDER[3] = { 1, 0, 2 };
+
+        CollisionResult result{ displacement, { false, false, false } };
+
+        for (const int a : AXIS_ORDER) {
+            f32 d = Axis(result.displacement, a);
+
+            if (d == 0.f)
+                continue;
+
+            // Blocks the box can touch while moving along a
+            vec3i32 lo, hi;
+            for (int b = 0; b < 3; ++b) {
+                f32 from = Axis(box.min, b) + MC_COLLISION_EPSILON;
+                f32 to   = Axis(box.max, b) - MC_COLLISION_EPSILON;
+
+                if (b == a) {
+                    from = d > 0.f ? Axis(box.max, b) - MC_COLLISION_EPSILON : Axis(box.min, b) + d;
+                    to   = d > 0.f ? Axis(box.max, b) + d                    : Axis(box.min, b) + MC_COLLISION_EPSILON;
+                }
+
+                (&lo.x)[b] = static_cast<i32>(std::floor(from));
+                (&hi.x)[b] = static_cast<i32>(std::floor(to));
+            }
+
+            for (i32 y = lo.y; y <= hi.y; ++y) {
+                for (i32 z = lo.z; z <= hi.z; ++z) {
+                    for (i32 x = lo.x; x <= hi.x; ++x) {
+                        if (!IsSolid(world.GetBlock(vec3i32{ x, y, z })))
+                            continue;
+
+                        const f32 blockMin = static_cast<f32>(a == 0 ? x : (a == 1 ? y : z));
+                        const f32 blockMax = blockMin + 1.f;
+
+                        if (d > 0.f) {
+                            const f32 allowed = blockMin - Axis(box.max, a);
+                            if (allowed >= -MC_COLLISION_EPSILON && allowed < d)
+                                d = std::max(allowed, 0.f);
+                        } else {
+                            const f32 allowed = blockMax - Axis(box.min, a);
+                            if (allowed <= MC_COLLISION_EPSILON && allowed > d)
+                                d = std::min(allowed, 0.f);
+                        }
+                    }
+                }
+            }
+
+            if (d != Axis(result.displacement, a)) {
+                result.bCollided[a]          = true;
+                Axis(result.displacement, a) = d;
+            }
+
+            Axis(box.min, a) += d;
+            Axis(box.max, a) += d;
+        }
+
+        return result;
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+
+namespace mc {
+
+    struct quatf32 { f32 x, y, z, w; };
+
+    constexpr quatf32 IdentityQuatf32() { return quatf32{ 0.f, 0.f, 0.f, 1.f }; }
+
+    inline quatf32 AxisAngleQuatf32(const vec3f32& axis, const f32 radians) {
+        const vec3f32 n = Normalize(axis);
+        const f32     s = std::sin(radians * 0.5f);
+
+        return quatf32{ n.x * s, n.y * s, n.z * s, std::cos(radians * 0.5f) };
+    }
+
+    constexpr quatf32 operator*(const quatf32& a, const quatf32& b) {
+        return quatf32{
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+        };
+    }
+
+    constexpr quatf32 Conjugate(const quatf32& q) { return quatf32{ -q.x, -q.y, -q.z, q.w }; }
+
+    constexpr f32 Dot(const quatf32& a, const quatf32& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+    inline quatf32 Normalize(const quatf32& q) {
+        const f32 length = std::sqrt(Dot(q, q));
+
+        return length > 0.f ? quatf32{ q.x / length, q.y / length, q.z / length, q.w / length } : IdentityQuatf32();
+    }
+
+    constexpr vec3f32 Rotate(const quatf32& q, const vec3f32& v) {
+        const vec3f32 u{ q.x, q.y, q.z };
+        const vec3f32 t = Cross(u, v) * 2.f;
+
+        return v + t * q.w + Cross(u, t);
+    }
+
+    inline quatf32 Slerp(const quatf32& a, quatf32 b, const f32 t) {
+        f32 cosTheta = Dot(a, b);
+
+        if (cosTheta < 0.f) {
+            b        = quatf32{ -b.x, -b.y, -b.z, -b.w };
+            cosTheta = -cosTheta;
+        }
+
+        // Nearly parallel: fall back to a normalized lerp
+        if (cosTheta > 0.9995f)
+            return Normalize(quatf32{ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t });
+
+        const f32 theta = std::acos(cosTheta);
+        const f32 wa    = std::sin((1.f - t) * theta) / std::sin(theta);
+        const f32 wb    = std::sin(t * theta)         / std::sin(theta);
+
+        return quatf32{ a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+    }
+
+    constexpr mat4f32 ToMat4f32(const quatf32& q) {
+        const f32 xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        const f32 xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        const f32 wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        return mat4f32{ {
+            vec4f32{ 1.f - 2.f * (yy + zz), 2.f * (xy + wz),       2.f * (xz - wy),       0.f },
+            vec4f32{ 2.f * (xy - wz),       1.f - 2.f * (xx + zz), 2.f * (yz + wx),       0.f },
+            vec4f32{ 2.f * (xz + wy),       2.f * (yz - wx),       1.f - 2.f * (xx + yy), 0.f },
+            vec4f32{ 0.f,                   0.f,                   0.f,                   1.f }
+        } };
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "vector.hpp"
+#include "threadPool.hpp"
+
+/*
+ * Voxel ray traversal (Amanatides & Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing").
+ * Missing/empty sections and empty 4^3 bricks are crossed in a single step by jumping
+ * to the point where the ray leaves them, then resuming the DDA from there.
+ */
+
+namespace mc {
+
+    struct Ray {
+        vec3f32 origin;
+        vec3f32 direction;   // Does not need to be normalized
+        f32     maxDistance;
+    }; // struct Ray
+
+    struct RaycastHit {
+        vec3i32   block;    // Position of the hit block
+        BlockFace face;     // Face of the hit block the ray entered through, None when starting inside it
+        f32       distance; // Along the normalized direction
+        Block     type;
+    }; // struct RaycastHit
+
+    namespace details {
+
+        class VoxelTraversal {
+        private:
+            const World& m_world;
+
+            vec3f32 m_origin;
+            vec3f32 m_direction;
+            vec3f32 m_invDirection;
+            vec3i32 m_step;
+
+            vec3i32   m_voxel;
+            vec3f32   m_tMax;
+            vec3f32   m_tDelta;
+            f32       m_t    = 0.f;
+            BlockFace m_face = BlockFace::None;
+
+            vec3i32             m_cachedSectionCoord{ 0, -1, 0 };
+            const ChunkSection* m_pCachedSection = nullptr;
+
+        private:
+            static constexpr f32 INF = std::numeric_limits<f32>::infinity();
+
+            static constexpr BlockFace EntryFace(const int axis, const i32 step) {
+                return static_cast<BlockFace>(axis * 2 + (step > 0 ? 0 : 1));
+            }
+
+            static inline f32 Axis(const vec3f32& v, const int a) { return (&v.x)[a]; }
+            static inline i32 Axis(const vec3i32& v, const int a) { return (&v.x)[a]; }
+            static inline f32& Axis(vec3f32& v, const int a)      { return (&v.x)[a]; }
+            static inline i32& Axis(vec3i32& v, const int a)      { return (&v.x)[a]; }
+
+            // The distance to the next boundary only depends on the voxel and the ray, so it can be rebuilt after a jump
+            void ResetTMax() {
+                for (int a = 0; a < 3; ++a) {
+                    const i32 step = Axis(m_step, a);
+
+                    Axis(m_tMax, a) = step == 0 ? INF : (static_cast<f32>(Axis(m_voxel, a) + (step > 0 ? 1 : 0)) - Axis(m_origin, a)) * Axis(m_invDirection, a);
+                }
+            }
+
+            // Moves to the first voxel outside of the [lo, hi) box the ray is currently in
+            void JumpOutOf(const vec3i32& lo, const vec3i32& hi) {
+                f32 tExit = INF;
+                int exitAxis = 0;
+
+                for (int a = 0; a < 3; ++a) {
+                    const i32 step = Axis(m_step, a);
+                    if (step == 0)
+                        continue;
+
+                    const f32 t = (static_cast<f32>(step > 0 ? Axis(hi, a) : Axis(lo, a)) - Axis(m_origin, a)) * Axis(m_invDirection, a);
+
+                    if (t < tExit) {
+                        tExit    = t;
+                        exitAxis = a;
+                    }
+                }
+
+                for (int a = 0; a < 3; ++a) {
+                    if (a == exitAxis) {
+                        Axis(m_voxel, a) = Axis(m_step, a) > 0 ? Axis(hi, a) : Axis(lo, a) - 1;
+                    } else {
+                        const i32 v = static_cast<i32>(std::floor(Axis(m_origin, a) + Axis(m_direction, a) * tExit));
+
+                        Axis(m_voxel, a) = std::clamp(v, Axis(lo, a), Axis(hi, a) - 1);
+                    }
+                }
+
+                m_t    = std::max(m_t, tExit);
+                m_face = EntryFace(exitAxis, Axis(m_step, exitAxis));
+
+                ResetTMax();
+            }
+
+            void StepOnce() {
+                int a = 0;
+                if (m_tMax.y < Axis(m_tMax, a)) a = 1;
+                if (m_tMax.z < Axis(m_tMax, a)) a = 2;
+
+                m_t               = Axis(m_tMax, a);
+                Axis(m_voxel, a) += Axis(m_step, a);
+                Axis(m_tMax, a)  += Axis(m_tDelta, a);
+                m_face            = EntryFace(a, Axis(m_step, a));
+            }
+
+            const ChunkSection* FetchSection(const vec3i32& sectionCoord) {
+                if (sectionCoord != m_cachedSectionCoord) {
+                    m_cachedSectionCoord = sectionCoord;
+                    m_pCachedSection     = m_world.GetSection(sectionCoord);
+                }
+
+                return m_pCachedSection;
+            }
+
+        public:
+            VoxelTraversal(const World& world, const vec3f32& origin, const vec3f32& direction)
+                : m_world(world), m_origin(origin), m_direction(direction)
+            {
+                m_voxel = FloorToVec3i32(origin);
+
+                for (int a = 0; a < 3; ++a) {
+                    const f32 d = Axis(direction, a);
+
+                    Axis(m_step, a)         = d > 0.f ? 1 : (d < 0.f ? -1 : 0);
+                    Axis(m_invDirection, a) = d != 0.f ? 1.f / d : INF;
+                    Axis(m_tDelta, a)       = d != 0.f ? std::fabs(1.f / d) : INF;
+                }
+
+                ResetTMax();
+            }
+
+            std::optional<RaycastHit> Run(const f32 maxDistance) {
+                constexpr i32 S = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+                constexpr i32 B = static_cast<i32>(MC_BRICK_SIZE);
+
+                while (m_t <= maxDistance) {
+                    // Leaving the vertical range of the world for good
+                    if ((m_voxel.y < 0 && m_step.y <= 0) || (m_voxel.y >= MC_CHUNK_HEIGHT && m_step.y >= 0))
+                        return {};
+
+                    const vec3i32 sectionCoord{ m_voxel.x >> 4, m_voxel.y >> 4, m_voxel.z >> 4 };
+                    const vec3i32 sectionLo{ sectionCoord.x * S, sectionCoord.y * S, sectionCoord.z * S };
+
+                    const ChunkSection* pSection = (m_voxel.y >= 0 && m_voxel.y < MC_CHUNK_HEIGHT) ? FetchSection(sectionCoord) : nullptr;
+
+                    if (!pSection || pSection->IsEmpty()) {
+                        JumpOutOf(sectionLo, sectionLo + vec3i32{ S, S, S });
+                        continue;
+                    }
+
+                    const u32 lx = WorldToLocal(m_voxel.x), ly = WorldToLocal(m_voxel.y), lz = WorldToLocal(m_voxel.z);
+
+                    if (pSection->IsBrickEmpty(lx, ly, lz)) {
+                        const vec3i32 brickLo = sectionLo + vec3i32{ static_cast<i32>(lx & ~3u), static_cast<i32>(ly & ~3u), static_cast<i32>(lz & ~3u) };
+
+                        JumpOutOf(brickLo, brickLo + vec3i32{ B, B, B });
+                        continue;
+                    }
+
+                    const Block block = pSection->Get(lx, ly, lz);
+
+                    if (IsSolid(block))
+                        return RaycastHit{ m_voxel, m_face, m_t, block };
+
+                    StepOnce();
+                }
+
+                return {};
+            }
+        }; // class VoxelTraversal
+
+    }; // namespace details
+
+    inline std::optional<RaycastHit> Raycast(const World& world, const Ray& ray) {
+        const f32 length = Length(ray.direction);
+
+        if (length <= 0.f)
+            return {};
+
+        return details::VoxelTraversal(world, ray.origin, ray.direction * (1.f / length)).Run(ray.maxDistance);
+    }
+
+    inline bool HasLineOfSight(const World& world, const vec3f32& from, const vec3f32& to) {
+        const vec3f32 delta    = to - from;
+        const f32     distance = Length(delta);
+
+        if (distance <= 0.f)
+            return true;
+
+        const std::optional<RaycastHit> hit = Raycast(world, Ray{ from, delta, distance });
+
+        return !hit.has_value() || hit->distance >= distance;
+    }
+
+    // The world must not be modified while a batch is in flight
+    inline void RaycastBatch(const World& world, const Ray* pRays, std::optional<RaycastHit>* pHits, const std::size_t count, ThreadPool& pool) {
+        constexpr std::size_t RAYS_PER_JOB = 256;
+
+        pool.ParallelFor(count, RAYS_PER_JOB, [&](const std::size_t begin, const std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                pHits[i] = Raycast(world, pRays[i]);
+        });
+    }
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "noise.hpp"
+#include "raycast.hpp"
+#include "threadPool.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * Rays per second through generated terrain, one at a time with Raycast and spread over the pool with
+ * RaycastBatch, at a block picking reach and at two longer ones that cross whole empty sections.
+ * Every ray starts at eye height above the ground in the middle of the world, looking anywhere from
+ * straight down to a little above the horizon. Generation is not timed.
+ */
+
+namespace mc {
+
+    class RaycastBenchmark {
+    private:
+        static constexpr u64 SEED        = 0x52617973ull;
+        static constexpr f32 EYE_HEIGHT  = 1.62f;
+        static constexpr f32 DISTANCES[] = { 8.f, 32.f, 128.f };
+        static constexpr i32 ORIGIN_SIDE = 4;                    // Chunks the origins are spread over, in the middle of the world
+        static constexpr i32 WORLD_SIDE  = ORIGIN_SIDE + 2 * 8;  // Leaves the longest reach inside the world
+
+        static std::vector<Ray> MakeRays(const WorldGenerator& generator, const u32 count, const f32 distance) {
+            const i32 lo   = ChunkToWorld((WORLD_SIDE - ORIGIN_SIDE) / 2);
+            const i32 span = ORIGIN_SIDE * MC_CHUNK_SECTION_SIZE;
+
+            std::vector<Ray> rays;
+            rays.reserve(count);
+
+            for (u32 i = 0; i < count; ++i) {
+                const u64 h  = noise::Hash(SEED, static_cast<i32>(i), static_cast<i32>(distance), 0);
+                const u64 h2 = noise::Hash(h);
+                const i32 x  = lo + static_cast<i32>(h % static_cast<u64>(span));
+                const i32 z  = lo + static_cast<i32>((h >> 16) % static_cast<u64>(span));
+
+                const f32 yaw   = noise::HashToUnit(h2) * 6.2831853f;
+                const f32 pitch = -1.5707963f + noise::HashToUnit(noise::Hash(h2)) * 1.8f; // Straight down to about 15 degrees up
+
+                const vec3f32 origin{ x + 0.5f, static_cast<f32>(generator.GetTerrainHeight(x, z) + 1) + EYE_HEIGHT, z + 0.5f };
+                const vec3f32 direction{ std::cos(pitch) * std::cos(yaw), std::sin(pitch), std::cos(pitch) * std::sin(yaw) };
+
+                rays.push_back(Ray{ origin, direction, distance });
+            }
+
+            return rays;
+        }
+
+        static f64 RaysPerSecond(const std::size_t count, const u64 elapsedUS) {
+            return static_cast<f64>(count) * 1'000'000.0 / static_cast<f64>(std::max<u64>(elapsedUS, 1));
+        }
+
+    public:
+        static void RunAll(const u32 count, ThreadPool& pool, std::ostream& out) {
+            World              world;
+            WorldGenerator     generator(SEED);
+            GenerationPipeline generation(generator, pool);
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = 0; z < WORLD_SIDE; ++z)
+                for (i32 x = 0; x < WORLD_SIDE; ++x)
+                    chunks.push_back(&world.CreateChunk(ChunkCoord{ x, z }));
+
+            generation.Generate(chunks);
+
+            for (Chunk* pChunk : chunks)
+                pChunk->Intern(world.GetSectionPool());
+
+            out << "[BENCHMARK] " << count << " rays per reach through " << chunks.size() << " generated chunks, batches on " << pool.GetThreadCount() + 1 << " threads\n";
+
+            for (const f32 distance : DISTANCES) {
+                const std::vector<Ray> rays = MakeRays(generator, count, distance);
+                std::vector<std::optional<RaycastHit>> hits(rays.size());
+
+                Timer timer;
+                for (std::size_t i = 0; i < rays.size(); ++i)
+                    hits[i] = Raycast(world, rays[i]);
+                const u64 serialUS = timer.GetElapsedUS();
+
+                const std::size_t hitCount = static_cast<std::size_t>(std::count_if(hits.begin(), hits.end(), [](const std::optional<RaycastHit>& hit) { return hit.has_value(); }));
+
+                timer.Reset();
+                RaycastBatch(world, rays.data(), hits.data(), rays.size(), pool);
+                const u64 batchUS = timer.GetElapsedUS();
+
+                const f64 serial = RaysPerSecond(rays.size(), serialUS);
+                const f64 batch  = RaysPerSecond(rays.size(), batchUS);
+
+                out << "[BENCHMARK] reach " << std::setw(3) << static_cast<u32>(distance) << " | " << std::setw(3) << hitCount * 100 / std::max<std::size_t>(rays.size(), 1) << "% hit"
+                    << " | Raycast " << std::fixed << std::setprecision(2) << std::setw(7) << serial / 1'000'000.0 << " M rays/s"
+                    << " | RaycastBatch " << std::setw(7) << batch / 1'000'000.0 << " M rays/s, " << std::setprecision(1) << batch / serial << "x\n";
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class RaycastBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -2,8 +2,19 @@
 
 #include "header.hpp"
 #include "vertex.hpp"
+#include "uniforms.hpp"
 #include "fileUtils.hpp"
+#include "bitmapFont.hpp"
 #include "vertexBuffer.hpp"
+#include "uniformBuffer.hpp"
+#include "stagingBuffer.hpp"
+#include "farFieldPass.hpp"
+#include "timer.hpp"
+#include "threadPool.hpp"
+#include "gpuMemory.hpp"
+#include "gpuTimeline.hpp"
+#include "framePacer.hpp"
+#include "taskGraph.hpp"
 #include "physicalDeviceSupport.hpp"
 
 namespace mc {
@@ -21,6 +32,21 @@ namespace mc {
 
     class Renderer {
     private:
+        struct DrawCommand {
+            const mc::VertexBuffer* pVertexBuffer;
+            u32                     firstVertex;
+            u32                     vertexCount;
+            mc::vec3f32             origin;
+        }; // struct DrawCommand
+
+        struct PendingCopy {
+            vk::Buffer                  dstBuffer;
+            std::vector<vk::BufferCopy> regions;
+        }; // struct PendingCopy
+
+        // The pipelines the shader watcher can rebuild, each with a slot for its rebuilt one to wait in
+        enum class ReloadSlot : u32 { eWorld, eOverlay, eFarField, eFarFieldCompute, Count };
+
         struct {
             vk::Instance instance;
 
@@ -36,45 +62,153 @@ namespace mc {
 
             vk::Device device;
 
+            // VK_EXT_memory_budget needs VK_KHR_get_physical_device_properties2, both are optional
+            bool bPhysicalDeviceProperties2;
+            bool bMemoryBudget;
+
+            bool bTimelineSemaphores; // Opted into, and then only kept if the loader and the device have Vulkan 1.2
+
+            // VK_KHR_present_id and VK_KHR_present_wait, which tell the pacer when frames reach the display
+            bool bPresentWait;
+
+            mc::PresentPolicy presentPolicy;
+            mc::FramePacer    pacer;
+            u32               framesInFlight; // The policy's, clamped to [1, MC_MAX_FRAMES_IN_FLIGHT]
+
             vk::SwapchainKHR swapChain;
 
             vk::SurfaceFormatKHR swapChainSurfaceFormat;
             vk::PresentModeKHR swapChainPresentMode;
             vk::Extent2D swapChainExtent;
 
+            vk::Format depthFormat;
+            vk::Image depthImage;
+            vk::DeviceMemory depthMemory;
+            vk::ImageView depthImageView;
+
             vk::RenderPass renderPass;
 
             std::vector<vk::Image> swapChainImages;
             std::vector<vk::ImageView> swapChainImageViews;
             std::vector<vk::Framebuffer> swapChainFrameBuffers;
 
+            vk::DescriptorSetLayout descriptorSetLayout;
+            vk::DescriptorPool descriptorPool;
+            vk::DescriptorSet descriptorSet;
+
             vk::PipelineLayout pipelineLayout;
             vk::Pipeline pipeline;
 
-            mc::VertexBuffer vertexBuffer;
+            // Read and baked by startup tasks of their own, then dropped once the pipelines and the atlas are made
+            std::optional<std::vector<char>> vertCode;
+            std::optional<std::vector<char>> fragCode;
+            std::optional<std::vector<char>> overlayVertCode;
+            std::optional<std::vector<char>> overlayFragCode;
+            std::optional<std::vector<char>> farFieldCompCode;
+            std::optional<std::vector<char>> farFieldVertCode;
+            std::optional<std::vector<char>> farFieldFragCode;
+            std::vector<u8>                  fontAtlas;
 
-            vk::CommandPool commandPool;
+            // Hot reloaded pipelines wait here for the next frame; replaced ones until the GPU passed the last submission using them
+            std::mutex                                                            reloadMutex;
+            std::array<vk::Pipeline, static_cast<std::size_t>(ReloadSlot::Count)> reloadedPipelines;
+            std::deque<std::pair<vk::Pipeline, u64>>                              retiredPipelines;
+
+            // Vertex buffers dropped while submissions can still use them, with the timeline value to wait for
+            std::deque<std::pair<mc::VertexBuffer, u64>>    retiredBuffers;
+            std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> retiringBytes;
+
+            mc::UniformRingBuffer uniformBuffer;
+            mc::FrameUniforms frameUniforms;
+            mc::Timer startupTimer;
+
+            std::vector<DrawCommand> drawCommands;
+
+            // One per frame in flight, the GPU may still copy from the previous frame's
+            std::array<mc::StagingBuffer, MC_MAX_FRAMES_IN_FLIGHT> stagingBuffers;
+            std::vector<PendingCopy>                               pendingCopies;
 
-            std::vector<vk::CommandBuffer> commandBuffers;
+            vk::CommandPool commandPool;
 
-            vk::Semaphore imageAvailableSemaphore;
-            vk::Semaphore renderFinishedSemaphore;
+            std::vector<vk::CommandBuffer> commandBuffers; // One per frame in flight
+
+            // Draws are split in batches recorded into secondary buffers on the thread pool. Each batch has
+            // its own pool per frame in flight, so no pool is ever used by two threads at once, and the
+            // pools are reset whole at the start of their frame instead of freeing buffers.
+            std::array<std::vector<vk::CommandPool>,   MC_MAX_FRAMES_IN_FLIGHT> recordingPools;
+            std::array<std::vector<vk::CommandBuffer>, MC_MAX_FRAMES_IN_FLIGHT> secondaryBuffers;
+
+            mc::ThreadPool* pThreadPool;
+            u32 recordingBatchLimit;
+            u64 lastRecordUS;
+
+            std::array<vk::Semaphore, MC_MAX_FRAMES_IN_FLIGHT> imageAvailableSemaphores;
+            std::array<vk::Semaphore, MC_MAX_FRAMES_IN_FLIGHT> renderFinishedSemaphores;
+
+            // Every submission to the graphics queue signals its next value; a frame slot is reused once its last value passed
+            mc::GpuTimeline                          timeline;
+            std::array<u64, MC_MAX_FRAMES_IN_FLIGHT> frameValues;
+
+            // The debug overlay: a pipeline of its own over the font atlas, built once at startup whether it shows or
+            // not, a mapped vertex buffer per frame in flight, and a secondary buffer recorded on the frames that draw it
+            bool                    bOverlay; // Its shaders were found
+            vk::DescriptorSetLayout overlayDescriptorSetLayout;
+            vk::DescriptorPool      overlayDescriptorPool;
+            vk::DescriptorSet       overlayDescriptorSet;
+            vk::PipelineLayout      overlayPipelineLayout;
+            vk::Pipeline            overlayPipeline;
+            vk::Image               fontImage;
+            vk::DeviceMemory        fontMemory;
+            vk::ImageView           fontImageView;
+            vk::Sampler             fontSampler;
+
+            std::array<mc::VertexBuffer, MC_MAX_FRAMES_IN_FLIGHT>  overlayBuffers;
+            std::array<vk::CommandBuffer, MC_MAX_FRAMES_IN_FLIGHT> overlaySecondaryBuffers;
+            u32                                                    overlayVertexCount;
+
+            // GPU time of the frames drawing the overlay, from timestamps around their command buffer, read once their slot comes back
+            vk::QueryPool                             timestampPool;
+            f64                                       timestampPeriodNS;
+            u64                                       timestampMask;
+            std::array<bool, MC_MAX_FRAMES_IN_FLIGHT> bTimestamped;
+            std::optional<u64>                        gpuTimeUS;
+
+            // The far field: its compute pass, then a full screen triangle drawing the pass' pixels with their depth first
+            // in the render pass, for the meshes to test against. Made by the first frame drawing it, the tree's size known then
+            std::unique_ptr<mc::FarFieldPass>                      pFarFieldPass;
+            vk::PipelineLayout                                     farFieldPipelineLayout;
+            vk::Pipeline                                           farFieldPipeline;
+            std::array<vk::CommandBuffer, MC_MAX_FRAMES_IN_FLIGHT> farFieldSecondaryBuffers;
+            bool                                                   bFarFieldQueued;   // DrawFarField was called for the next Render
+            bool                                                   bFarFieldReported; // Its shaders were missing, which is said once
+            mc::ChunkCoord                                         farFieldWindowLo;
+            i32                                                    farFieldWindowChunks;
+
+            u32 lastDrawCount;
 
             u32 swapChainImageCount;
+            u32 frameIndex;
+            u64 frameNumber;
         } static s_;
 
     private:
         static void CreateInstance() {
             vk::ApplicationInfo appInfo{};
-            appInfo.apiVersion = MC_VULKAN_VERSION;
+            appInfo.apiVersion = s_.bTimelineSemaphores ? MC_VULKAN_TIMELINE_VERSION : MC_VULKAN_VERSION;
             appInfo.applicationVersion = MC_APPLICATION_VERSION;
             appInfo.engineVersion = MC_APPLICATION_VERSION;
             appInfo.pApplicationName = "Minecraft";
             appInfo.pEngineName = "F. Weiss <3";
 
+            std::vector<const char*> extensions(MC_VULKAN_INSTANCE_EXTENSIONS.begin(), MC_VULKAN_INSTANCE_EXTENSIONS.end());
+
+            s_.bPhysicalDeviceProperties2 = mc::vk_utils::IsExtensionPresent(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, vk::enumerateInstanceExtensionProperties());
+            if (s_.bPhysicalDeviceProperties2)
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
             vk::InstanceCreateInfo instanceCI{};
-            instanceCI.enabledExtensionCount   = static_cast<u32>(MC_VULKAN_INSTANCE_EXTENSIONS.size());
-            instanceCI.ppEnabledExtensionNames = MC_VULKAN_INSTANCE_EXTENSIONS.data();
+            instanceCI.enabledExtensionCount   = static_cast<u32>(extensions.size());
+            instanceCI.ppEnabledExtensionNames = extensions.data();
 
             instanceCI.enabledLayerCount   = static_cast<u32>(MC_VULKAN_LAYERS.size());
             instanceCI.ppEnabledLayerNames = MC_VULKAN_LAYERS.data();
@@ -101,9 +235,45 @@ namespace mc {
 
             vk::PhysicalDeviceFeatures enabledDeviceFeatures{};
 
+            std::vector<const char*> extensions(MC_VULKAN_DEVICE_EXTENSIONS.begin(), MC_VULKAN_DEVICE_EXTENSIONS.end());
+
+            s_.bMemoryBudget = s_.bPhysicalDeviceProperties2 && s_.physicalSupport.IsExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            if (s_.bMemoryBudget)
+                extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+            s_.bPresentWait = s_.bPhysicalDeviceProperties2
+                && s_.physicalSupport.IsExtensionSupported(VK_KHR_PRESENT_ID_EXTENSION_NAME)
+                && s_.physicalSupport.IsExtensionSupported(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+                && mc::vk_utils::SupportsPresentWait(s_.instance, s_.physical);
+
+            if (s_.bPresentWait) {
+                extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            }
+
+            // The optional features chain in front of each other
+            void* pFeatures = nullptr;
+
+            vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+            vk::PhysicalDevicePresentIdFeaturesKHR   presentIdFeatures{};
+            if (s_.bPresentWait) {
+                presentWaitFeatures.presentWait = VK_TRUE;
+                presentIdFeatures.presentId     = VK_TRUE;
+                presentIdFeatures.pNext         = &presentWaitFeatures;
+                pFeatures                       = &presentIdFeatures;
+            }
+
+            vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+            if (s_.bTimelineSemaphores) {
+                timelineFeatures.timelineSemaphore = VK_TRUE;
+                timelineFeatures.pNext             = pFeatures;
+                pFeatures                          = &timelineFeatures;
+            }
+
             vk::DeviceCreateInfo deviceCI{};
-            deviceCI.enabledExtensionCount   = static_cast<u32>(MC_VULKAN_DEVICE_EXTENSIONS.size());
-            deviceCI.ppEnabledExtensionNames = MC_VULKAN_DEVICE_EXTENSIONS.data();
+            deviceCI.pNext                   = pFeatures;
+            deviceCI.enabledExtensionCount   = static_cast<u32>(extensions.size());
+            deviceCI.ppEnabledExtensionNames = extensions.data();
 
             deviceCI.enabledLayerCount   = static_cast<u32>(MC_VULKAN_LAYERS.size());
             deviceCI.ppEnabledLayerNames = MC_VULKAN_LAYERS.data();
@@ -127,7 +297,7 @@ namespace mc {
             const auto surfaceCapabilities = s_.physical.getSurfaceCapabilitiesKHR(s_.surface);
 
             s_.swapChainSurfaceFormat = mc::vk_utils::PickSwapChainSurfaceFormat(s_.physical.getSurfaceFormatsKHR(s_.surface));
-            s_.swapChainPresentMode = mc::vk_utils::PickSwapChainPresentMode(s_.physical.getSurfacePresentModesKHR(s_.surface));
+            s_.swapChainPresentMode = mc::vk_utils::PickSwapChainPresentMode(s_.physical.getSurfacePresentModesKHR(s_.surface), s_.presentPolicy.presentModes);
             s_.swapChainExtent = mc::vk_utils::PickSwapChainExtent(surfaceCapabilities);
 
             vk::SwapchainCreateInfoKHR sci{};
@@ -139,7 +309,7 @@ namespace mc {
             sci.imageColorSpace = s_.swapChainSurfaceFormat.colorSpace;
             sci.imageFormat = s_.swapChainSurfaceFormat.format;
             sci.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
-            sci.minImageCount = surfaceCapabilities.minImageCount + 1;
+            sci.minImageCount = mc::vk_utils::PickSwapChainImageCount(surfaceCapabilities, s_.presentPolicy.imageCount != 0 ? s_.presentPolicy.imageCount : surfaceCapabilities.minImageCount + s_.presentPolicy.extraImages);
             sci.oldSwapchain = vk::SwapchainKHR();
             sci.presentMode = s_.swapChainPresentMode;
             sci.preTransform = vk::SurfaceTransformFlagBitsKHR::eIdentity;
@@ -163,6 +333,45 @@ namespace mc {
             s_.swapChain = s_.device.createSwapchainKHR(sci);
         }
 
+        static void CreateDepthResources() {
+            s_.depthFormat = mc::vk_utils::PickDepthFormat(s_.physical);
+
+            vk::ImageCreateInfo ici{};
+            ici.imageType     = vk::ImageType::e2D;
+            ici.extent        = vk::Extent3D{ s_.swapChainExtent.width, s_.swapChainExtent.height, 1 };
+            ici.mipLevels     = 1;
+            ici.arrayLayers   = 1;
+            ici.format        = s_.depthFormat;
+            ici.tiling        = vk::ImageTiling::eOptimal;
+            ici.initialLayout = vk::ImageLayout::eUndefined;
+            ici.usage         = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+            ici.samples       = vk::SampleCountFlagBits::e1;
+            ici.sharingMode   = vk::SharingMode::eExclusive;
+
+            s_.depthImage = s_.device.createImage(ici);
+
+            const vk::MemoryRequirements requirements = s_.device.getImageMemoryRequirements(s_.depthImage);
+
+            vk::MemoryAllocateInfo allocationInfo{};
+            allocationInfo.allocationSize  = requirements.size;
+            allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(s_.physicalSupport.GetMemoryProperties(), requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            s_.depthMemory = mc::GpuMemory::Allocate(s_.device, allocationInfo);
+            s_.device.bindImageMemory(s_.depthImage, s_.depthMemory, 0);
+
+            vk::ImageViewCreateInfo ivci{};
+            ivci.image = s_.depthImage;
+            ivci.viewType = vk::ImageViewType::e2D;
+            ivci.format = s_.depthFormat;
+            ivci.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
+            ivci.subresourceRange.baseMipLevel = 0;
+            ivci.subresourceRange.levelCount = 1;
+            ivci.subresourceRange.baseArrayLayer = 0;
+            ivci.subresourceRange.layerCount = 1;
+
+            s_.depthImageView = s_.device.createImageView(ivci);
+        }
+
         static void CreateRenderPass() {
             vk::AttachmentDescription colorAttachment{};
             colorAttachment.format = s_.swapChainSurfaceFormat.format;// swapChainImageFormat;
@@ -174,20 +383,49 @@ namespace mc {
             colorAttachment.initialLayout = vk::ImageLayout::eUndefined;// VK_IMAGE_LAYOUT_UNDEFINED;
             colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
 
+            vk::AttachmentDescription depthAttachment{};
+            depthAttachment.format = s_.depthFormat;
+            depthAttachment.samples = vk::SampleCountFlagBits::e1;
+            depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+            depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+            depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+            depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+            depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+            depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
             vk::AttachmentReference colorAttachmentRef{};
             colorAttachmentRef.attachment = 0;
             colorAttachmentRef.layout = vk::ImageLayout::eColorAttachmentOptimal;
 
+            vk::AttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 1;
+            depthAttachmentRef.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
             vk::SubpassDescription subpass{};
             subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
             subpass.colorAttachmentCount = 1;
             subpass.pColorAttachments = &colorAttachmentRef;
+            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+            vk::SubpassDependency dependency{};
+            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependency.dstSubpass = 0;
+            // The depth image is shared by the frames in flight: the previous frame's depth writes, late ones included
+            // (the far field's composite writes gl_FragDepth), must be done before this frame clears it
+            dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+            dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+            dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+            std::array attachments = { colorAttachment, depthAttachment };
 
             vk::RenderPassCreateInfo rpci{};
-            rpci.attachmentCount = 1;
-            rpci.pAttachments = &colorAttachment;
+            rpci.attachmentCount = static_cast<u32>(attachments.size());
+            rpci.pAttachments = attachments.data();
             rpci.subpassCount = 1;
             rpci.pSubpasses = &subpass;
+            rpci.dependencyCount = 1;
+            rpci.pDependencies = &dependency;
 
             s_.renderPass = s_.device.createRenderPass(rpci);
         }
@@ -217,12 +455,13 @@ namespace mc {
                 s_.swapChainImageViews[i] = s_.device.createImageView(ivci);
 
                 vk::ImageView attachments[] = {
-                    s_.swapChainImageViews[i]
+                    s_.swapChainImageViews[i],
+                    s_.depthImageView
                 };
 
                 vk::FramebufferCreateInfo fbci{};
                 fbci.renderPass = s_.renderPass;
-                fbci.attachmentCount = 1;
+                fbci.attachmentCount = 2;
                 fbci.pAttachments = attachments;
                 fbci.width = s_.swapChainExtent.width;
                 fbci.height = s_.swapChainExtent.height;
@@ -232,18 +471,48 @@ namespace mc {
             }
         }
 
-        static void CreateGraphicsPipeline() {
-            auto CreateShaderModule = [](const vk::Device& device, const std::vector<char>& byteCode) -> vk::ShaderModule {
-                vk::ShaderModuleCreateInfo smci{};
-                smci.codeSize = byteCode.size();
-                smci.pCode    = reinterpret_cast<const mc::u32*>(byteCode.data());
-            
-                return device.createShaderModule(smci);
-            };
+        static void CreateDescriptorSetLayout() {
+            vk::DescriptorSetLayoutBinding frameUniformsBinding{};
+            frameUniformsBinding.binding         = 0;
+            frameUniformsBinding.descriptorType  = vk::DescriptorType::eUniformBufferDynamic;
+            frameUniformsBinding.descriptorCount = 1;
+            frameUniformsBinding.stageFlags      = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+            vk::DescriptorSetLayoutCreateInfo dslci{};
+            dslci.bindingCount = 1;
+            dslci.pBindings    = &frameUniformsBinding;
+
+            s_.descriptorSetLayout = s_.device.createDescriptorSetLayout(dslci);
+        }
+
+        static void CreatePipelineLayout() {
+            vk::PushConstantRange chunkPushConstantRange{};
+            chunkPushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+            chunkPushConstantRange.offset     = 0;
+            chunkPushConstantRange.size       = sizeof(mc::ChunkPushConstants);
+
+            vk::PipelineLayoutCreateInfo plci{};
+            plci.setLayoutCount = 1;
+            plci.pSetLayouts = &s_.descriptorSetLayout;
+            plci.pushConstantRangeCount = 1;
+            plci.pPushConstantRanges = &chunkPushConstantRange;
+
+            s_.pipelineLayout = s_.device.createPipelineLayout(plci);
+        }
+
+        static vk::ShaderModule CreateShaderModule(const std::vector<char>& byteCode) {
+            vk::ShaderModuleCreateInfo smci{};
+            smci.codeSize = byteCode.size();
+            smci.pCode    = reinterpret_cast<const mc::u32*>(byteCode.data());
+
+            return s_.device.createShaderModule(smci);
+        }
+
+        // Only creates device objects from the layout and render pass, so it may run on any thread
+        static vk::Pipeline BuildGraphicsPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode) {
+            const vk::ShaderModule vertShaderModule = CreateShaderModule(vertCode);
+            const vk::ShaderModule fragShaderModule = CreateShaderModule(fragCode);
 
-            const vk::ShaderModule vertShaderModule = CreateShaderModule(s_.device, mc::ReadBinaryFileToBuffer("res/shaders/vert.spv").value());
-            const vk::ShaderModule fragShaderModule = CreateShaderModule(s_.device, mc::ReadBinaryFileToBuffer("res/shaders/frag.spv").value());
-            
             vk::PipelineShaderStageCreateInfo vssci{};
             vssci.stage  = vk::ShaderStageFlagBits::eVertex;// VK_SHADER_STAGE_VERTEX_BIT;
             vssci.module = vertShaderModule;
@@ -307,6 +576,13 @@ namespace mc {
             pmsci.alphaToCoverageEnable = VK_FALSE; // Optional
             pmsci.alphaToOneEnable = VK_FALSE; // Optional
 
+            vk::PipelineDepthStencilStateCreateInfo pdssci{};
+            pdssci.depthTestEnable = VK_TRUE;
+            pdssci.depthWriteEnable = VK_TRUE;
+            pdssci.depthCompareOp = vk::CompareOp::eLess;
+            pdssci.depthBoundsTestEnable = VK_FALSE;
+            pdssci.stencilTestEnable = VK_FALSE;
+
             vk::PipelineColorBlendAttachmentState pcbas{};
             pcbas.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
             pcbas.blendEnable = VK_FALSE;
@@ -336,14 +612,6 @@ namespace mc {
             dynamicState.dynamicStateCount = static_cast<u32>(dynamicStates.size());
             dynamicState.pDynamicStates    = dynamicStates.data();
 
-            vk::PipelineLayoutCreateInfo plci{};
-            plci.setLayoutCount = 0; // Optional
-            plci.pSetLayouts = nullptr; // Optional
-            plci.pushConstantRangeCount = 0; // Optional
-            plci.pPushConstantRanges = nullptr; // Optional
-
-            s_.pipelineLayout = s_.device.createPipelineLayout(plci);
-
             vk::GraphicsPipelineCreateInfo gpci{};
             gpci.stageCount = static_cast<u32>(shaderStages.size());
             gpci.pStages    = shaderStages.data();
@@ -352,7 +620,7 @@ namespace mc {
             gpci.pViewportState = &pvsci;
             gpci.pRasterizationState = &prsci;
             gpci.pMultisampleState = &pmsci;
-            gpci.pDepthStencilState = nullptr; // Optional
+            gpci.pDepthStencilState = &pdssci;
             gpci.pColorBlendState = &pcbsci;
             gpci.pDynamicState = nullptr; // Optional
             gpci.layout = s_.pipelineLayout;
@@ -361,22 +629,194 @@ namespace mc {
             gpci.basePipelineHandle = vk::Pipeline{}; // Optional
             gpci.basePipelineIndex  = -1; // Optional
 
-            s_.pipeline = s_.device.createGraphicsPipeline({}, gpci).value;
+            const vk::Pipeline pipeline = s_.device.createGraphicsPipeline({}, gpci).value;
 
             s_.device.destroyShaderModule(vertShaderModule);
             s_.device.destroyShaderModule(fragShaderModule);
+
+            return pipeline;
         }
 
-        static void CreateVertexBuffers() {
-            std::array vertices = {
-                Vertex{{0.0f, -0.5f}, {1.0f, 0.0f, 1.0f}},
-                Vertex{{0.5f,  0.5f}, {1.0f, 1.0f, 0.0f}},
-                Vertex{{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}
-            };
+        static void CreateGraphicsPipeline() {
+            s_.pipeline = BuildGraphicsPipeline(s_.vertCode.value(), s_.fragCode.value());
 
-            s_.vertexBuffer = mc::VertexBuffer(s_.device, s_.physicalSupport.GetMemoryProperties(), sizeof(vertices));
-            std::memcpy(s_.vertexBuffer.GetData(), vertices.data(), sizeof(vertices));
-            s_.vertexBuffer.Upload();
+            s_.vertCode.reset();
+            s_.fragCode.reset();
+        }
+
+        // Everything read from disk at startup, all of it before any of it is needed
+        static void LoadShaders() {
+            s_.vertCode        = mc::ReadBinaryFileToBuffer("res/shaders/shader.vert.spv");
+            s_.fragCode        = mc::ReadBinaryFileToBuffer("res/shaders/shader.frag.spv");
+            s_.overlayVertCode = mc::ReadBinaryFileToBuffer("res/shaders/overlay.vert.spv");
+            s_.overlayFragCode = mc::ReadBinaryFileToBuffer("res/shaders/overlay.frag.spv");
+
+            s_.farFieldCompCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.comp.spv");
+            s_.farFieldVertCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.vert.spv");
+            s_.farFieldFragCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.frag.spv");
+        }
+
+        // The far field's compute pipeline is swapped in its pass, by ReplacePipeline
+        static vk::Pipeline& GetReloadTarget(const ReloadSlot slot) {
+            switch (slot) {
+            case ReloadSlot::eOverlay:  return s_.overlayPipeline;
+            case ReloadSlot::eFarField: return s_.farFieldPipeline;
+            default:                    return s_.pipeline;
+            }
+        }
+
+        // Called at a frame boundary, before recording: installs the pipelines rebuilt by ReloadPipelines.
+        // The replaced ones were last recorded by the submission before
+        static void SwapReloadedPipelines() {
+            std::lock_guard<std::mutex> lock(s_.reloadMutex);
+
+            for (u32 i = 0; i < s_.reloadedPipelines.size(); ++i) {
+                if (!s_.reloadedPipelines[i])
+                    continue;
+
+                const ReloadSlot   slot     = static_cast<ReloadSlot>(i);
+                const vk::Pipeline reloaded = std::exchange(s_.reloadedPipelines[i], vk::Pipeline{});
+                const vk::Pipeline replaced = slot == ReloadSlot::eFarFieldCompute ? s_.pFarFieldPass->ReplacePipeline(reloaded) : std::exchange(GetReloadTarget(slot), reloaded);
+
+                s_.retiredPipelines.emplace_back(replaced, s_.timeline.GetSubmittedValue());
+            }
+        }
+
+        // Builds a pipeline on the calling thread for the next frame to swap in. A failed build keeps the current one
+        static void QueueReloadedPipeline(const ReloadSlot slot, const char* name, const std::function<vk::Pipeline()>& build) {
+            vk::Pipeline pipeline;
+
+            try {
+                pipeline = build();
+            } catch (const std::exception& e) {
+                std::cout << "[RENDERER] The " << name << " pipeline failed to reload: " << e.what() << '\n' << std::flush;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(s_.reloadMutex);
+
+            vk::Pipeline& reloaded = s_.reloadedPipelines[static_cast<std::size_t>(slot)];
+
+            // Two reloads between frames: the first one was never used
+            if (reloaded)
+                s_.device.destroyPipeline(reloaded);
+
+            reloaded = pipeline;
+
+            std::cout << "[RENDERER] The " << name << " pipeline reloaded\n" << std::flush;
+        }
+
+        // Destroys the retired pipelines and buffers the GPU is done with
+        static void ReleaseRetired() {
+            const u64 completed = s_.timeline.GetCompletedValue();
+
+            while (!s_.retiredPipelines.empty() && s_.retiredPipelines.front().second <= completed) {
+                s_.device.destroyPipeline(s_.retiredPipelines.front().first);
+                s_.retiredPipelines.pop_front();
+            }
+
+            while (!s_.retiredBuffers.empty() && s_.retiredBuffers.front().second <= completed) {
+                const mc::VertexBuffer& buffer = s_.retiredBuffers.front().first;
+
+                s_.retiringBytes[buffer.GetHeapIndex()] -= buffer.GetAllocationSize();
+                s_.retiredBuffers.pop_front();
+            }
+        }
+
+        static void CreateUniformBuffers() {
+            s_.uniformBuffer = mc::UniformRingBuffer(s_.device, s_.physicalSupport.GetProperties(), s_.physicalSupport.GetMemoryProperties(), sizeof(mc::FrameUniforms), s_.framesInFlight);
+
+            s_.frameUniforms.view       = mc::IdentityMat4f32();
+            s_.frameUniforms.projection = mc::IdentityMat4f32();
+        }
+
+        // The set is allocated and written once: the per frame slot is picked with a dynamic offset at bind time
+        static void CreateDescriptorSets() {
+            vk::DescriptorPoolSize poolSize{};
+            poolSize.type            = vk::DescriptorType::eUniformBufferDynamic;
+            poolSize.descriptorCount = 1;
+
+            vk::DescriptorPoolCreateInfo dpci{};
+            dpci.maxSets       = 1;
+            dpci.poolSizeCount = 1;
+            dpci.pPoolSizes    = &poolSize;
+
+            s_.descriptorPool = s_.device.createDescriptorPool(dpci);
+
+            vk::DescriptorSetAllocateInfo dsai{};
+            dsai.descriptorPool     = s_.descriptorPool;
+            dsai.descriptorSetCount = 1;
+            dsai.pSetLayouts        = &s_.descriptorSetLayout;
+
+            s_.descriptorSet = s_.device.allocateDescriptorSets(dsai)[0];
+
+            const vk::DescriptorBufferInfo bufferInfo = s_.uniformBuffer.GetDescriptorBufferInfo();
+
+            vk::WriteDescriptorSet wds{};
+            wds.dstSet          = s_.descriptorSet;
+            wds.dstBinding      = 0;
+            wds.dstArrayElement = 0;
+            wds.descriptorType  = vk::DescriptorType::eUniformBufferDynamic;
+            wds.descriptorCount = 1;
+            wds.pBufferInfo     = &bufferInfo;
+
+            s_.device.updateDescriptorSets(wds, nullptr);
+        }
+
+        static void CreateStagingBuffer(const u32 frame, const vk::DeviceSize capacity) {
+            s_.stagingBuffers[frame] = mc::StagingBuffer(s_.device, s_.physicalSupport.GetMemoryProperties(), capacity);
+        }
+
+        // Records every queued upload, then makes the copied ranges visible to vertex input
+        static void RecordPendingCopies(const vk::CommandBuffer& cmdBuff) {
+            if (s_.pendingCopies.empty())
+                return;
+
+            // Earlier submissions may still be drawing from the ranges overwritten: a read before write, so no memory barrier
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, nullptr);
+
+            for (const PendingCopy& copy : s_.pendingCopies)
+                cmdBuff.copyBuffer(s_.stagingBuffers[s_.frameIndex].GetHandle(), copy.dstBuffer, copy.regions);
+
+            vk::MemoryBarrier barrier{};
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead;
+
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, {}, barrier, nullptr, nullptr);
+
+            s_.pendingCopies.clear();
+        }
+
+        // Submits the queued uploads on their own and waits for them, so the staging buffer can be reused
+        static void FlushPendingCopies() {
+            if (s_.pendingCopies.empty()) {
+                s_.stagingBuffers[s_.frameIndex].Reset();
+                return;
+            }
+
+            vk::CommandBufferAllocateInfo cbai{};
+            cbai.commandPool        = s_.commandPool;
+            cbai.level              = vk::CommandBufferLevel::ePrimary;
+            cbai.commandBufferCount = 1;
+
+            const vk::CommandBuffer cmdBuff = s_.device.allocateCommandBuffers(cbai)[0];
+
+            vk::CommandBufferBeginInfo beginInfo{};
+            beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+            cmdBuff.begin(beginInfo);
+            RecordPendingCopies(cmdBuff);
+            cmdBuff.end();
+
+            vk::SubmitInfo submitInfo{};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers    = &cmdBuff;
+
+            // Also waits for the frames still in flight, which were submitted before
+            s_.timeline.Wait(s_.timeline.Submit(submitInfo));
+
+            s_.device.freeCommandBuffers(s_.commandPool, cmdBuff);
+            s_.stagingBuffers[s_.frameIndex].Reset();
         }
 
         static void CreateCommandPool() {
@@ -391,41 +831,776 @@ namespace mc {
             vk::CommandBufferAllocateInfo cbai{};
             cbai.commandPool = s_.commandPool;
             cbai.level = vk::CommandBufferLevel::ePrimary;// VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-            cbai.commandBufferCount = s_.swapChainImageCount;
+            cbai.commandBufferCount = s_.framesInFlight;
 
             s_.commandBuffers = s_.device.allocateCommandBuffers(cbai);
         }
 
+        static void CreateRecordingPools() {
+            const u32 batchCount = s_.pThreadPool->GetThreadCount() + 1; // The workers and the render thread
+
+            vk::CommandPoolCreateInfo cpci{};
+            cpci.queueFamilyIndex = s_.physicalSupport.GetGraphicsQFData().indices.value().familyIndex;
+            cpci.flags = vk::CommandPoolCreateFlagBits::eTransient;
+
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                for (u32 i = 0; i < batchCount; ++i) {
+                    const vk::CommandPool pool = s_.device.createCommandPool(cpci);
+
+                    vk::CommandBufferAllocateInfo cbai{};
+                    cbai.commandPool        = pool;
+                    cbai.level              = vk::CommandBufferLevel::eSecondary;
+                    cbai.commandBufferCount = 1;
+
+                    s_.recordingPools[frame].push_back(pool);
+                    s_.secondaryBuffers[frame].push_back(s_.device.allocateCommandBuffers(cbai)[0]);
+                }
+            }
+
+            s_.recordingBatchLimit = batchCount;
+        }
+
         static void CreateSemaphores() {
             vk::SemaphoreCreateInfo sci{};
 
-            s_.imageAvailableSemaphore = s_.device.createSemaphore(sci);
-            s_.renderFinishedSemaphore = s_.device.createSemaphore(sci);
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                s_.imageAvailableSemaphores[frame] = s_.device.createSemaphore(sci);
+                s_.renderFinishedSemaphores[frame] = s_.device.createSemaphore(sci);
+            }
+
+            const mc::GpuTimelineMode mode = s_.bTimelineSemaphores ? mc::GpuTimelineMode::eTimeline : mc::GpuTimelineMode::eFences;
+
+            s_.timeline = mc::GpuTimeline(s_.device, s_.physicalSupport.GetGraphicsQFData().queue.value(), mode);
+            s_.frameValues.fill(0);
+        }
+
+        // Paces only when presenting with FIFO, the one mode where the CPU can end up waiting on the display
+        static void StartFramePacer() {
+            const bool bFifo   = s_.swapChainPresentMode == vk::PresentModeKHR::eFifo || s_.swapChainPresentMode == vk::PresentModeKHR::eFifoRelaxed;
+            const bool bPacing = s_.presentPolicy.bPacing && bFifo;
+
+            s_.pacer.Startup(s_.device, s_.swapChain, s_.bPresentWait, bPacing, s_.framesInFlight);
+
+            std::cout << "[RENDERER] Presenting with " << mc::PresentPolicy::GetPresentModeName(s_.swapChainPresentMode) << ", " << s_.device.getSwapchainImagesKHR(s_.swapChain).size()
+                      << " images, " << s_.framesInFlight << " frames in flight, " << (bPacing ? (s_.bPresentWait ? "paced on present wait" : "paced on acquire") : "not paced") << '\n' << std::flush;
+        }
+
+        // The atlas is uploaded once, through a staging buffer of its own, and waited for
+        static void CreateFontAtlas() {
+            const std::vector<u8> atlas = std::move(s_.fontAtlas);
+
+            vk::ImageCreateInfo ici{};
+            ici.imageType     = vk::ImageType::e2D;
+            ici.extent        = vk::Extent3D{ mc::BitmapFont::ATLAS_WIDTH, mc::BitmapFont::ATLAS_HEIGHT, 1 };
+            ici.mipLevels     = 1;
+            ici.arrayLayers   = 1;
+            ici.format        = vk::Format::eR8Unorm;
+            ici.tiling        = vk::ImageTiling::eOptimal;
+            ici.initialLayout = vk::ImageLayout::eUndefined;
+            ici.usage         = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+            ici.samples       = vk::SampleCountFlagBits::e1;
+            ici.sharingMode   = vk::SharingMode::eExclusive;
+
+            s_.fontImage = s_.device.createImage(ici);
+
+            const vk::MemoryRequirements requirements = s_.device.getImageMemoryRequirements(s_.fontImage);
+
+            vk::MemoryAllocateInfo allocationInfo{};
+            allocationInfo.allocationSize  = requirements.size;
+            allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(s_.physicalSupport.GetMemoryProperties(), requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            s_.fontMemory = mc::GpuMemory::Allocate(s_.device, allocationInfo);
+            s_.device.bindImageMemory(s_.fontImage, s_.fontMemory, 0);
+
+            mc::StagingBuffer staging(s_.device, s_.physicalSupport.GetMemoryProperties(), atlas.size());
+            const vk::DeviceSize stagingOffset = staging.Push(atlas.data(), atlas.size()).value();
+
+            vk::CommandBufferAllocateInfo cbai{};
+            cbai.commandPool        = s_.commandPool;
+            cbai.level              = vk::CommandBufferLevel::ePrimary;
+            cbai.commandBufferCount = 1;
+
+            const vk::CommandBuffer cmdBuff = s_.device.allocateCommandBuffers(cbai)[0];
+
+            vk::CommandBufferBeginInfo beginInfo{};
+            beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+            vk::ImageMemoryBarrier barrier{};
+            barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image                       = s_.fontImage;
+            barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.layerCount = 1;
+            barrier.oldLayout                   = vk::ImageLayout::eUndefined;
+            barrier.newLayout                   = vk::ImageLayout::eTransferDstOptimal;
+            barrier.dstAccessMask               = vk::AccessFlagBits::eTransferWrite;
+
+            vk::BufferImageCopy region{};
+            region.bufferOffset                = stagingOffset;
+            region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = ici.extent;
+
+            cmdBuff.begin(beginInfo);
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+            cmdBuff.copyBufferToImage(staging.GetHandle(), s_.fontImage, vk::ImageLayout::eTransferDstOptimal, region);
+
+            barrier.oldLayout     = vk::ImageLayout::eTransferDstOptimal;
+            barrier.newLayout     = vk::ImageLayout::eShaderReadOnlyOptimal;
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+            cmdBuff.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, barrier);
+            cmdBuff.end();
+
+            vk::SubmitInfo submitInfo{};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers    = &cmdBuff;
+
+            s_.timeline.Wait(s_.timeline.Submit(submitInfo));
+            s_.device.freeCommandBuffers(s_.commandPool, cmdBuff);
+
+            vk::ImageViewCreateInfo ivci{};
+            ivci.image                           = s_.fontImage;
+            ivci.viewType                        = vk::ImageViewType::e2D;
+            ivci.format                          = vk::Format::eR8Unorm;
+            ivci.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+            ivci.subresourceRange.levelCount = 1;
+            ivci.subresourceRange.layerCount = 1;
+
+            s_.fontImageView = s_.device.createImageView(ivci);
+
+            // Nearest, so the pixels stay crisp at any integer scale
+            vk::SamplerCreateInfo sci{};
+            sci.magFilter    = vk::Filter::eNearest;
+            sci.minFilter    = vk::Filter::eNearest;
+            sci.mipmapMode   = vk::SamplerMipmapMode::eNearest;
+            sci.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+            sci.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+            sci.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+
+            s_.fontSampler = s_.device.createSampler(sci);
+        }
+
+        static vk::Pipeline BuildOverlayPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode) {
+            const vk::ShaderModule vertShaderModule = CreateShaderModule(vertCode);
+            const vk::ShaderModule fragShaderModule = CreateShaderModule(fragCode);
+
+            vk::PipelineShaderStageCreateInfo vssci{};
+            vssci.stage  = vk::ShaderStageFlagBits::eVertex;
+            vssci.module = vertShaderModule;
+            vssci.pName  = "main";
+
+            vk::PipelineShaderStageCreateInfo fssci{};
+            fssci.stage  = vk::ShaderStageFlagBits::eFragment;
+            fssci.module = fragShaderModule;
+            fssci.pName  = "main";
+
+            std::array shaderStages = { vssci, fssci };
+
+            const auto bindingDescription    = mc::OverlayVertex::GetBindingDescription();
+            const auto attributeDescriptions = mc::OverlayVertex::GetAttributeDescriptions();
+
+            vk::PipelineVertexInputStateCreateInfo pvisci{};
+            pvisci.vertexBindingDescriptionCount   = 1;
+            pvisci.pVertexBindingDescriptions      = &bindingDescription;
+            pvisci.vertexAttributeDescriptionCount = static_cast<u32>(attributeDescriptions.size());
+            pvisci.pVertexAttributeDescriptions    = attributeDescriptions.data();
+
+            vk::PipelineInputAssemblyStateCreateInfo piasci{};
+            piasci.topology = vk::PrimitiveTopology::eTriangleList;
+
+            vk::Viewport viewport{ 0.f, 0.f, (float)s_.swapChainExtent.width, (float)s_.swapChainExtent.height, 0.f, 1.f };
+            vk::Rect2D   scissor{ vk::Offset2D{ 0, 0 }, s_.swapChainExtent };
+
+            vk::PipelineViewportStateCreateInfo pvsci{};
+            pvsci.viewportCount = 1;
+            pvsci.pViewports    = &viewport;
+            pvsci.scissorCount  = 1;
+            pvsci.pScissors     = &scissor;
+
+            // Quads are built without caring for their winding
+            vk::PipelineRasterizationStateCreateInfo prsci{};
+            prsci.polygonMode = vk::PolygonMode::eFill;
+            prsci.lineWidth   = 1.0f;
+            prsci.cullMode    = vk::CullModeFlagBits::eNone;
+            prsci.frontFace   = vk::FrontFace::eClockwise;
+
+            vk::PipelineMultisampleStateCreateInfo pmsci{};
+            pmsci.rasterizationSamples = vk::SampleCountFlagBits::e1;
+            pmsci.minSampleShading     = 1.0f;
+
+            // Over everything, and leaving the depth alone
+            vk::PipelineDepthStencilStateCreateInfo pdssci{};
+            pdssci.depthTestEnable  = VK_FALSE;
+            pdssci.depthWriteEnable = VK_FALSE;
+
+            vk::PipelineColorBlendAttachmentState pcbas{};
+            pcbas.colorWriteMask      = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+            pcbas.blendEnable         = VK_TRUE;
+            pcbas.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+            pcbas.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+            pcbas.colorBlendOp        = vk::BlendOp::eAdd;
+            pcbas.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+            pcbas.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+            pcbas.alphaBlendOp        = vk::BlendOp::eAdd;
+
+            vk::PipelineColorBlendStateCreateInfo pcbsci{};
+            pcbsci.attachmentCount = 1;
+            pcbsci.pAttachments    = &pcbas;
+
+            vk::GraphicsPipelineCreateInfo gpci{};
+            gpci.stageCount          = static_cast<u32>(shaderStages.size());
+            gpci.pStages             = shaderStages.data();
+            gpci.pVertexInputState   = &pvisci;
+            gpci.pInputAssemblyState = &piasci;
+            gpci.pViewportState      = &pvsci;
+            gpci.pRasterizationState = &prsci;
+            gpci.pMultisampleState   = &pmsci;
+            gpci.pDepthStencilState  = &pdssci;
+            gpci.pColorBlendState    = &pcbsci;
+            gpci.layout              = s_.overlayPipelineLayout;
+            gpci.renderPass          = s_.renderPass;
+            gpci.subpass             = 0;
+            gpci.basePipelineIndex   = -1;
+
+            const vk::Pipeline pipeline = s_.device.createGraphicsPipeline({}, gpci).value;
+
+            s_.device.destroyShaderModule(vertShaderModule);
+            s_.device.destroyShaderModule(fragShaderModule);
+
+            return pipeline;
+        }
+
+        /*
+         * Everything the overlay needs is made here, once, so showing and hiding it only decides whether a
+         * frame records it. Its shaders are compiled by the build; without them the overlay is unavailable.
+         */
+        static void CreateOverlay() {
+            const std::optional<std::vector<char>> vertCode = std::move(s_.overlayVertCode);
+            const std::optional<std::vector<char>> fragCode = std::move(s_.overlayFragCode);
+
+            s_.bOverlay = vertCode.has_value() && fragCode.has_value();
+
+            if (!s_.bOverlay) {
+                std::cout << "[RENDERER] The overlay's shaders were not built, the overlay is unavailable\n" << std::flush;
+                return;
+            }
+
+            CreateFontAtlas();
+
+            vk::DescriptorSetLayoutBinding fontBinding{};
+            fontBinding.binding         = 0;
+            fontBinding.descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+            fontBinding.descriptorCount = 1;
+            fontBinding.stageFlags      = vk::ShaderStageFlagBits::eFragment;
+
+            vk::DescriptorSetLayoutCreateInfo dslci{};
+            dslci.bindingCount = 1;
+            dslci.pBindings    = &fontBinding;
+
+            s_.overlayDescriptorSetLayout = s_.device.createDescriptorSetLayout(dslci);
+
+            vk::PushConstantRange pushConstantRange{};
+            pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+            pushConstantRange.offset     = 0;
+            pushConstantRange.size       = sizeof(mc::OverlayPushConstants);
+
+            vk::PipelineLayoutCreateInfo plci{};
+            plci.setLayoutCount         = 1;
+            plci.pSetLayouts            = &s_.overlayDescriptorSetLayout;
+            plci.pushConstantRangeCount = 1;
+            plci.pPushConstantRanges    = &pushConstantRange;
+
+            s_.overlayPipelineLayout = s_.device.createPipelineLayout(plci);
+            s_.overlayPipeline       = BuildOverlayPipeline(vertCode.value(), fragCode.value());
+
+            vk::DescriptorPoolSize poolSize{};
+            poolSize.type            = vk::DescriptorType::eCombinedImageSampler;
+            poolSize.descriptorCount = 1;
+
+            vk::DescriptorPoolCreateInfo dpci{};
+            dpci.maxSets       = 1;
+            dpci.poolSizeCount = 1;
+            dpci.pPoolSizes    = &poolSize;
+
+            s_.overlayDescriptorPool = s_.device.createDescriptorPool(dpci);
+
+            vk::DescriptorSetAllocateInfo dsai{};
+            dsai.descriptorPool     = s_.overlayDescriptorPool;
+            dsai.descriptorSetCount = 1;
+            dsai.pSetLayouts        = &s_.overlayDescriptorSetLayout;
+
+            s_.overlayDescriptorSet = s_.device.allocateDescriptorSets(dsai)[0];
+
+            const vk::DescriptorImageInfo imageInfo{ s_.fontSampler, s_.fontImageView, vk::ImageLayout::eShaderReadOnlyOptimal };
+
+            vk::WriteDescriptorSet wds{};
+            wds.dstSet          = s_.overlayDescriptorSet;
+            wds.dstBinding      = 0;
+            wds.descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+            wds.descriptorCount = 1;
+            wds.pImageInfo      = &imageInfo;
+
+            s_.device.updateDescriptorSets(wds, nullptr);
+
+            // From the frame's first recording pool, which is reset with the frame
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                s_.overlayBuffers[frame] = CreateVertexBuffer(MC_OVERLAY_MAX_VERTICES * sizeof(mc::OverlayVertex), mc::VertexBufferMode::eMapped);
+
+                vk::CommandBufferAllocateInfo cbai{};
+                cbai.commandPool        = s_.recordingPools[frame][0];
+                cbai.level              = vk::CommandBufferLevel::eSecondary;
+                cbai.commandBufferCount = 1;
+
+                s_.overlaySecondaryBuffers[frame] = s_.device.allocateCommandBuffers(cbai)[0];
+            }
+
+            // Two per frame in flight, on queues whose timestamps are meaningful
+            const u32 family = s_.physicalSupport.GetGraphicsQFData().indices.value().familyIndex;
+            const u32 bits   = s_.physical.getQueueFamilyProperties()[family].timestampValidBits;
+
+            if (bits > 0) {
+                vk::QueryPoolCreateInfo qpci{};
+                qpci.queryType  = vk::QueryType::eTimestamp;
+                qpci.queryCount = 2 * MC_MAX_FRAMES_IN_FLIGHT;
+
+                s_.timestampPool     = s_.device.createQueryPool(qpci);
+                s_.timestampPeriodNS = s_.physicalSupport.GetProperties().limits.timestampPeriod;
+                s_.timestampMask     = bits >= 64 ? ~u64{ 0 } : (u64{ 1 } << bits) - 1;
+            }
+
+            s_.bTimestamped.fill(false);
+        }
+
+        // Called once the frame slot is free again: its timestamps, if written, are available
+        static void ReadTimestamps(const u32 frame) {
+            if (!s_.bTimestamped[frame])
+                return;
+
+            s_.bTimestamped[frame] = false;
+
+            std::array<u64, 2> ticks{};
+            if (s_.device.getQueryPoolResults(s_.timestampPool, 2 * frame, 2, sizeof(ticks), ticks.data(), sizeof(u64), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess)
+                s_.gpuTimeUS = static_cast<u64>(static_cast<f64>((ticks[1] - ticks[0]) & s_.timestampMask) * s_.timestampPeriodNS / 1000.0);
+        }
+
+        static vk::Pipeline BuildFarFieldPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode) {
+            const vk::ShaderModule vertShaderModule = CreateShaderModule(vertCode);
+            const vk::ShaderModule fragShaderModule = CreateShaderModule(fragCode);
+
+            vk::PipelineShaderStageCreateInfo vssci{};
+            vssci.stage  = vk::ShaderStageFlagBits::eVertex;
+            vssci.module = vertShaderModule;
+            vssci.pName  = "main";
+
+            vk::PipelineShaderStageCreateInfo fssci{};
+            fssci.stage  = vk::ShaderStageFlagBits::eFragment;
+            fssci.module = fragShaderModule;
+            fssci.pName  = "main";
+
+            std::array shaderStages = { vssci, fssci };
+
+            // The triangle is made from the vertex index
+            vk::PipelineVertexInputStateCreateInfo pvisci{};
+
+            vk::PipelineInputAssemblyStateCreateInfo piasci{};
+            piasci.topology = vk::PrimitiveTopology::eTriangleList;
+
+            vk::Viewport viewport{ 0.f, 0.f, (float)s_.swapChainExtent.width, (float)s_.swapChainExtent.height, 0.f, 1.f };
+            vk::Rect2D   scissor{ vk::Offset2D{ 0, 0 }, s_.swapChainExtent };
+
+            vk::PipelineViewportStateCreateInfo pvsci{};
+            pvsci.viewportCount = 1;
+            pvsci.pViewports    = &viewport;
+            pvsci.scissorCount  = 1;
+            pvsci.pScissors     = &scissor;
+
+            vk::PipelineRasterizationStateCreateInfo prsci{};
+            prsci.polygonMode = vk::PolygonMode::eFill;
+            prsci.lineWidth   = 1.0f;
+            prsci.cullMode    = vk::CullModeFlagBits::eNone;
+            prsci.frontFace   = vk::FrontFace::eClockwise;
+
+            vk::PipelineMultisampleStateCreateInfo pmsci{};
+            pmsci.rasterizationSamples = vk::SampleCountFlagBits::e1;
+            pmsci.minSampleShading     = 1.0f;
+
+            // The depth is the fragment shader's, the pass' hits
+            vk::PipelineDepthStencilStateCreateInfo pdssci{};
+            pdssci.depthTestEnable  = VK_TRUE;
+            pdssci.depthWriteEnable = VK_TRUE;
+            pdssci.depthCompareOp   = vk::CompareOp::eLess;
+
+            vk::PipelineColorBlendAttachmentState pcbas{};
+            pcbas.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+            pcbas.blendEnable    = VK_FALSE;
+
+            vk::PipelineColorBlendStateCreateInfo pcbsci{};
+            pcbsci.attachmentCount = 1;
+            pcbsci.pAttachments    = &pcbas;
+
+            vk::GraphicsPipelineCreateInfo gpci{};
+            gpci.stageCount          = static_cast<u32>(shaderStages.size());
+            gpci.pStages             = shaderStages.data();
+            gpci.pVertexInputState   = &pvisci;
+            gpci.pInputAssemblyState = &piasci;
+            gpci.pViewportState      = &pvsci;
+            gpci.pRasterizationState = &prsci;
+            gpci.pMultisampleState   = &pmsci;
+            gpci.pDepthStencilState  = &pdssci;
+            gpci.pColorBlendState    = &pcbsci;
+            gpci.layout              = s_.farFieldPipelineLayout;
+            gpci.renderPass          = s_.renderPass;
+            gpci.subpass             = 0;
+            gpci.basePipelineIndex   = -1;
+
+            const vk::Pipeline pipeline = s_.device.createGraphicsPipeline({}, gpci).value;
+
+            s_.device.destroyShaderModule(vertShaderModule);
+            s_.device.destroyShaderModule(fragShaderModule);
+
+            return pipeline;
+        }
+
+        // Its shaders are compiled by the build; without them the far field is not drawn, which is said once
+        static bool CreateFarField(const vk::DeviceSize treeBytes) {
+            // Against a shader reload replacing the code meanwhile
+            std::lock_guard<std::mutex> lock(s_.reloadMutex);
+
+            if (!s_.farFieldCompCode.has_value() || !s_.farFieldVertCode.has_value() || !s_.farFieldFragCode.has_value()) {
+                if (!std::exchange(s_.bFarFieldReported, true))
+                    std::cout << "[RENDERER] The far field's shaders were not built, the far field is not drawn\n" << std::flush;
+
+                return false;
+            }
+
+            s_.pFarFieldPass = std::make_unique<mc::FarFieldPass>(s_.device, s_.physicalSupport.GetMemoryProperties(), s_.farFieldCompCode.value(), treeBytes, s_.swapChainExtent);
+
+            vk::PipelineLayoutCreateInfo plci{};
+            plci.setLayoutCount = 1;
+            plci.pSetLayouts    = &s_.pFarFieldPass->GetSetLayout();
+
+            s_.farFieldPipelineLayout = s_.device.createPipelineLayout(plci);
+            s_.farFieldPipeline       = BuildFarFieldPipeline(s_.farFieldVertCode.value(), s_.farFieldFragCode.value());
+
+            s_.farFieldCompCode.reset();
+            s_.farFieldVertCode.reset();
+            s_.farFieldFragCode.reset();
+
+            // From the frame's first recording pool, which is reset with the frame
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                vk::CommandBufferAllocateInfo cbai{};
+                cbai.commandPool        = s_.recordingPools[frame][0];
+                cbai.level              = vk::CommandBufferLevel::eSecondary;
+                cbai.commandBufferCount = 1;
+
+                s_.farFieldSecondaryBuffers[frame] = s_.device.allocateCommandBuffers(cbai)[0];
+            }
+
+            return true;
+        }
+
+        static void DestroyFarField() {
+            if (!s_.pFarFieldPass)
+                return;
+
+            s_.device.destroyPipeline(s_.farFieldPipeline);
+            s_.device.destroyPipelineLayout(s_.farFieldPipelineLayout);
+            s_.pFarFieldPass.reset();
+        }
+
+        static void DestroyOverlay() {
+            if (!s_.bOverlay)
+                return;
+
+            if (s_.timestampPool)
+                s_.device.destroyQueryPool(s_.timestampPool);
+
+            for (mc::VertexBuffer& buffer : s_.overlayBuffers)
+                buffer = mc::VertexBuffer();
+
+            s_.device.destroyPipeline(s_.overlayPipeline);
+            s_.device.destroyPipelineLayout(s_.overlayPipelineLayout);
+            s_.device.destroyDescriptorPool(s_.overlayDescriptorPool);
+            s_.device.destroyDescriptorSetLayout(s_.overlayDescriptorSetLayout);
+
+            s_.device.destroySampler(s_.fontSampler);
+            s_.device.destroyImageView(s_.fontImageView);
+            s_.device.destroyImage(s_.fontImage);
+            mc::GpuMemory::Free(s_.device, s_.fontMemory);
         }
 
     public:
-        static void Startup() {
-            CreateInstance();
-            
-            s_.surface = mc::AppSurface::CreateVulkanSurface(s_.instance);
-            
-            s_.physicalSupport = mc::vk_utils::PickPhysicalDevice(s_.instance, s_.surface);
-            s_.physical        = s_.physicalSupport.GetPhysical();
-            std::cout << "[RENDERER] Selected " << s_.physicalSupport.GetProperties().deviceName << " for rendering\n" << std::flush;
-
-            CreateLogicalDeviceAndFetchQueues();
-            CreateSwapChain();
-            CreateRenderPass();
-            CreateSwapChainImagesViewsFrameBuffers();
-            CreateGraphicsPipeline();
-            CreateVertexBuffers();
-            CreateCommandPool();
-            CreateCommandBuffers();
-            CreateSemaphores();
+        /*
+         * Adds the renderer's startup to the graph, the window included, each task waiting only for what
+         * it uses. The window is made on the main thread, while the instance is created and the shaders
+         * read; everything else follows the device. The pipelines compile while the frame buffers, the
+         * buffers and the command pools are made. bTimelineSemaphores opts into Vulkan 1.2 for them;
+         * fences are used when the loader or the device can't.
+         */
+        static void AddStartupTasks(mc::TaskGraph& graph, mc::ThreadPool& threadPool, const bool bTimelineSemaphores = false, const mc::PresentPolicy& presentPolicy = mc::PresentPolicy{}) {
+            s_.pThreadPool    = &threadPool;
+            s_.presentPolicy  = presentPolicy;
+            s_.framesInFlight = std::clamp<u32>(presentPolicy.framesInFlight, 1u, MC_MAX_FRAMES_IN_FLIGHT);
+
+            const mc::TaskGraph::TaskId window = graph.Add("window", {}, [] { mc::AppSurface::Acquire(); }, true);
+
+            const mc::TaskGraph::TaskId instance = graph.Add("instance", {}, [bTimelineSemaphores] {
+                s_.bTimelineSemaphores = bTimelineSemaphores && vk::enumerateInstanceVersion() >= MC_VULKAN_TIMELINE_VERSION;
+
+                CreateInstance();
+            });
+
+            const mc::TaskGraph::TaskId shaders = graph.Add("shader files", {}, [] { LoadShaders(); });
+            const mc::TaskGraph::TaskId font    = graph.Add("font atlas", {}, [] { s_.fontAtlas = mc::BitmapFont::BakeAtlas(); });
+
+            const mc::TaskGraph::TaskId device = graph.Add("device", { window, instance }, [bTimelineSemaphores] {
+                s_.surface = mc::AppSurface::CreateVulkanSurface(s_.instance);
+
+                s_.physicalSupport = mc::vk_utils::PickPhysicalDevice(s_.instance, s_.surface);
+                s_.physical        = s_.physicalSupport.GetPhysical();
+                std::cout << "[RENDERER] Selected " << s_.physicalSupport.GetProperties().deviceName << " for rendering\n" << std::flush;
+
+                s_.bTimelineSemaphores = s_.bTimelineSemaphores && mc::vk_utils::SupportsTimelineSemaphores(s_.physical);
+                if (bTimelineSemaphores)
+                    std::cout << "[RENDERER] Synchronizing with " << (s_.bTimelineSemaphores ? "timeline semaphores" : "fences, Vulkan 1.2 timeline semaphores are unavailable") << '\n' << std::flush;
+
+                CreateLogicalDeviceAndFetchQueues();
+                mc::GpuMemory::Startup(s_.instance, s_.physical, s_.bMemoryBudget);
+            });
+
+            const mc::TaskGraph::TaskId swapChain = graph.Add("swap chain", { device }, [] {
+                CreateSwapChain();
+                StartFramePacer();
+                CreateDepthResources();
+            });
+
+            const mc::TaskGraph::TaskId renderPass = graph.Add("render pass", { swapChain }, [] { CreateRenderPass(); });
+            const mc::TaskGraph::TaskId layouts    = graph.Add("layouts", { device }, [] {
+                CreateDescriptorSetLayout();
+                CreatePipelineLayout();
+            });
+
+            graph.Add("frame buffers", { renderPass }, [] { CreateSwapChainImagesViewsFrameBuffers(); });
+            graph.Add("pipeline", { shaders, renderPass, layouts }, [] { CreateGraphicsPipeline(); });
+
+            graph.Add("buffers", { layouts }, [] {
+                CreateUniformBuffers();
+                CreateDescriptorSets();
+                for (u32 frame = 0; frame < s_.framesInFlight; ++frame)
+                    CreateStagingBuffer(frame, MC_STAGING_BUFFER_SIZE);
+            });
+
+            const mc::TaskGraph::TaskId commands = graph.Add("command pools", { device }, [] {
+                CreateCommandPool();
+                CreateCommandBuffers();
+                CreateRecordingPools();
+                CreateSemaphores();
+            });
+
+            // Uploads the atlas with the command pool and the queue, which no other startup task touches
+            graph.Add("overlay", { shaders, font, renderPass, commands }, [] { CreateOverlay(); });
+        }
+
+        static void SetCamera(const mc::mat4f32& view, const mc::mat4f32& projection, const mc::vec3f32& position) {
+            s_.frameUniforms.view           = view;
+            s_.frameUniforms.projection     = projection;
+            s_.frameUniforms.cameraPosition = mc::vec4f32{ position.x, position.y, position.z, 1.f };
+        }
+
+        static inline f32 GetAspectRatio() {
+            return static_cast<f32>(s_.swapChainExtent.width) / static_cast<f32>(std::max(s_.swapChainExtent.height, 1u));
+        }
+
+        static mc::VertexBuffer CreateVertexBuffer(const std::size_t size, const mc::VertexBufferMode mode) {
+            return mc::VertexBuffer(s_.device, s_.physicalSupport.GetProperties(), s_.physicalSupport.GetMemoryProperties(), size, mode);
+        }
+
+        /*
+         * Queues a copy of the buffer's dirty ranges, one vkCmdCopyBuffer region each, to be
+         * recorded ahead of the next frame's render pass. The buffer must stay alive until then.
+         * Mapped buffers hold their data already and are only flushed.
+         */
+        static void Upload(mc::VertexBuffer& vertexBuffer) {
+            if (vertexBuffer.GetMode() == mc::VertexBufferMode::eMapped) {
+                vertexBuffer.Flush();
+                return;
+            }
+
+            const std::vector<mc::ByteRange>& ranges = vertexBuffer.GetDirtyRanges();
+            if (ranges.empty())
+                return;
+
+            PendingCopy copy{ vertexBuffer.GetHandle(), {} };
+            copy.regions.reserve(ranges.size());
+
+            const mc::u8* const pSrc = static_cast<const mc::u8*>(vertexBuffer.GetData());
+
+            mc::StagingBuffer& stagingBuffer = s_.stagingBuffers[s_.frameIndex];
+
+            for (const mc::ByteRange& range : ranges) {
+                std::optional<vk::DeviceSize> srcOffset = stagingBuffer.Push(pSrc + range.offset, range.size);
+
+                if (!srcOffset.has_value()) {
+                    if (!copy.regions.empty())
+                        s_.pendingCopies.push_back(std::move(copy));
+
+                    FlushPendingCopies();
+
+                    if (range.size > stagingBuffer.GetCapacity())
+                        CreateStagingBuffer(s_.frameIndex, mc::vk_utils::AlignUp(range.size, MC_STAGING_BUFFER_SIZE));
+
+                    copy = PendingCopy{ vertexBuffer.GetHandle(), {} };
+                    srcOffset = stagingBuffer.Push(pSrc + range.offset, range.size);
+                }
+
+                copy.regions.push_back(vk::BufferCopy{ srcOffset.value(), range.offset, range.size });
+            }
+
+            s_.pendingCopies.push_back(std::move(copy));
+            vertexBuffer.ClearDirtyRanges();
+        }
+
+        /*
+         * Keeps a vertex buffer alive until the GPU passed every submission that can still use it:
+         * the frames in flight, and the next submission, which may carry uploads to it.
+         */
+        static void Retire(mc::VertexBuffer&& vertexBuffer) {
+            if (vertexBuffer.GetAllocationSize() == 0)
+                return;
+
+            s_.retiringBytes[vertexBuffer.GetHeapIndex()] += vertexBuffer.GetAllocationSize();
+            s_.retiredBuffers.emplace_back(std::move(vertexBuffer), s_.timeline.GetNextValue());
+        }
+
+        // Memory of a heap that retired buffers still hold, and that is freed within the frames in flight
+        static inline vk::DeviceSize GetRetiringBytes(const u32 heap) { return s_.retiringBytes[heap]; }
+
+        // For what is retired elsewhere, like MeshArena ranges: retired now, it is free to reuse once the completed value reaches this
+        static inline u64 GetRetireValue()    { return s_.timeline.GetNextValue();      }
+        static inline u64 GetCompletedValue() { return s_.timeline.GetCompletedValue(); }
+
+        // Waits for every submission so far, before destroying what they may use
+        static void WaitIdle() {
+            s_.timeline.WaitIdle();
+        }
+
+        static inline mc::GpuTimelineMode GetTimelineMode() { return s_.timeline.GetMode(); }
+
+        // Called before the frame samples input: the pacer may sleep here so the sample is as late as possible
+        static void BeginFrame() {
+            s_.pacer.BeginFrame();
+        }
+
+        // The frames presented from now on show this input sample, until the next one
+        static inline void MarkInputSampled() { s_.pacer.MarkInputSampled(); }
+
+        static inline mc::FrameLatencyStats GetFrameLatencyStats()   { return s_.pacer.GetStats(); }
+        static inline void                  ResetFrameLatencyStats() { s_.pacer.ResetStats();     }
+
+        /*
+         * Rebuilds the pipelines using any of the changed shader sources (names like "shader.vert") from the
+         * .spv files on disk, on the calling thread (typically the shader watcher's). The results are swapped
+         * in by the next Render(); there is no device wait.
+         */
+        static void ReloadPipelines(const std::set<std::string>& changed) {
+            const auto IsChanged = [&changed](const std::initializer_list<const char*> names) {
+                return std::any_of(names.begin(), names.end(), [&changed](const char* name) { return changed.count(name) > 0; });
+            };
+
+            const auto ReadShader = [](const std::string& name) {
+                return mc::ReadBinaryFileToBuffer("res/shaders/" + name + ".spv").value();
+            };
+
+            if (IsChanged({ "shader.vert", "shader.frag" }))
+                QueueReloadedPipeline(ReloadSlot::eWorld, "world", [&] { return BuildGraphicsPipeline(ReadShader("shader.vert"), ReadShader("shader.frag")); });
+
+            // Without its shaders at startup the overlay was never made, there is nothing to rebuild
+            if (s_.bOverlay && IsChanged({ "overlay.vert", "overlay.frag" }))
+                QueueReloadedPipeline(ReloadSlot::eOverlay, "overlay", [&] { return BuildOverlayPipeline(ReadShader("overlay.vert"), ReadShader("overlay.frag")); });
+
+            if (!IsChanged({ "farField.vert", "farField.frag", "farField.comp" }))
+                return;
+
+            // Until the first frame drawing it makes the far field, its code waits to be used: it is replaced instead.
+            // Once made, the pass and its layouts stay until shutdown, which stops the watcher first
+            {
+                std::lock_guard<std::mutex> lock(s_.reloadMutex);
+
+                if (!s_.pFarFieldPass) {
+                    s_.farFieldCompCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.comp.spv");
+                    s_.farFieldVertCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.vert.spv");
+                    s_.farFieldFragCode = mc::ReadBinaryFileToBuffer("res/shaders/farField.frag.spv");
+
+                    return;
+                }
+            }
+
+            if (IsChanged({ "farField.vert", "farField.frag" }))
+                QueueReloadedPipeline(ReloadSlot::eFarField, "far field", [&] { return BuildFarFieldPipeline(ReadShader("farField.vert"), ReadShader("farField.frag")); });
+
+            if (IsChanged({ "farField.comp" }))
+                QueueReloadedPipeline(ReloadSlot::eFarFieldCompute, "far field compute", [&] { return s_.pFarFieldPass->BuildPipeline(ReadShader("farField.comp")); });
+        }
+
+        // Caps how many batches (hence threads) record draws, clamped to [1, worker count + 1]
+        static void SetRecordingBatchLimit(const u32 limit) {
+            s_.recordingBatchLimit = std::clamp<u32>(limit, 1u, static_cast<u32>(s_.recordingPools[0].size()));
+        }
+
+        // Wall time spent recording the last frame's secondary command buffers
+        static inline u64 GetLastRecordUS() { return s_.lastRecordUS; }
+
+        static inline u32 GetLastDrawCount() { return s_.lastDrawCount; }
+
+        static inline bool IsOverlayAvailable() { return s_.bOverlay; }
+
+        // Where this frame's overlay vertices go, MC_OVERLAY_MAX_VERTICES of them: the frame slot's mapped buffer, which the GPU is done with
+        static mc::OverlayVertex* GetOverlayVertices() {
+            return s_.bOverlay ? static_cast<mc::OverlayVertex*>(s_.overlayBuffers[s_.frameIndex].GetData()) : nullptr;
+        }
+
+        // Draws the first vertexCount overlay vertices over the next Render()'s scene, in one draw call
+        static void DrawOverlay(const u32 vertexCount) {
+            if (!s_.bOverlay)
+                return;
+
+            s_.overlayVertexCount = std::min(vertexCount, MC_OVERLAY_MAX_VERTICES);
+
+            mc::VertexBuffer& buffer = s_.overlayBuffers[s_.frameIndex];
+            buffer.MarkDirty(0, s_.overlayVertexCount * sizeof(mc::OverlayVertex));
+            buffer.Flush();
+        }
+
+        /*
+         * Ray marches the tree under the next Render()'s scene, over the windowChunks x windowChunks columns
+         * from windowLo, and queues the upload of what changed in it. The tree must stay alive until then.
+         */
+        static void DrawFarField(mc::VoxelTree& tree, const mc::ChunkCoord windowLo, const i32 windowChunks) {
+            if (!s_.pFarFieldPass && !CreateFarField(tree.GetByteSize()))
+                return;
+
+            s_.pFarFieldPass->Upload(tree, s_.frameIndex);
+
+            s_.bFarFieldQueued      = true;
+            s_.farFieldWindowLo     = windowLo;
+            s_.farFieldWindowChunks = windowChunks;
+        }
+
+        // The GPU time of the last frame that drew the overlay, handed out once, when its timestamps came back
+        static std::optional<u64> TakeGpuTimeUS() { return std::exchange(s_.gpuTimeUS, std::nullopt); }
+
+        // Queues a draw of vertexCount vertices from firstVertex on for the next Render(); the buffer must stay alive until then
+        static void Draw(const mc::VertexBuffer& vertexBuffer, const u32 firstVertex, const u32 vertexCount, const mc::vec3f32& origin) {
+            s_.drawCommands.push_back(DrawCommand{ &vertexBuffer, firstVertex, vertexCount, origin });
         }
 
         static void Render() {
-            const u32 imgIdx = s_.device.acquireNextImageKHR(s_.swapChain, UINT64_MAX, s_.imageAvailableSemaphore);
+            const mc::Timer acquireTimer;
+            const u32 imgIdx = s_.device.acquireNextImageKHR(s_.swapChain, UINT64_MAX, s_.imageAvailableSemaphores[s_.frameIndex]);
+            s_.pacer.OnAcquired(acquireTimer.GetElapsedUS());
 
             //
             //
@@ -433,41 +1608,178 @@ namespace mc {
             //
             //
 
-            const vk::CommandBuffer cmdBuff      = s_.commandBuffers[imgIdx];
-            const vk::Queue         gfxQueue     = s_.physicalSupport.GetGraphicsQFData().queue.value();
+            const vk::CommandBuffer cmdBuff      = s_.commandBuffers[s_.frameIndex];
             const vk::Queue         presentQueue = s_.physicalSupport.GetPresentationQFData().queue.value();
             const vk::Framebuffer   frameBuffer  = s_.swapChainFrameBuffers[imgIdx];
 
+            //
+            //
+            // Update Per Frame Uniforms
+            //
+            //
+
+            const f32 seconds = s_.startupTimer.GetElapsedMS() / 1000.f;
+
+            s_.frameUniforms.time = mc::vec4f32{ seconds, seconds - s_.frameUniforms.time.x, static_cast<f32>(s_.frameNumber), 0.f };
+            s_.uniformBuffer.Write(s_.frameIndex, s_.frameUniforms);
+
+            const u32 uniformOffset = s_.uniformBuffer.GetDynamicOffset(s_.frameIndex);
+
             //
             // 
             // Reccord Command Buffers
             //
             //
 
+            SwapReloadedPipelines();
+
+            const mc::Timer recordTimer;
+
+            for (const vk::CommandPool pool : s_.recordingPools[s_.frameIndex])
+                s_.device.resetCommandPool(pool, {});
+
+            const std::size_t drawCount  = s_.drawCommands.size();
+            const u32         batchCount = std::clamp<u32>(static_cast<u32>((drawCount + MC_MIN_DRAWS_PER_RECORDING_BATCH - 1) / MC_MIN_DRAWS_PER_RECORDING_BATCH), 1u, s_.recordingBatchLimit);
+            const std::size_t batchSize  = (drawCount + batchCount - 1) / batchCount;
+
+            const std::vector<vk::CommandBuffer>& secondaryBuffers = s_.secondaryBuffers[s_.frameIndex];
+
+            vk::CommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.renderPass  = s_.renderPass;
+            inheritanceInfo.subpass     = 0;
+            inheritanceInfo.framebuffer = frameBuffer;
+
+            s_.pThreadPool->ParallelFor(batchCount, 1, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t batch = begin; batch < end; ++batch) {
+                    const vk::CommandBuffer secondary = secondaryBuffers[batch];
+
+                    vk::CommandBufferBeginInfo secondaryBeginInfo{};
+                    secondaryBeginInfo.flags            = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+                    secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+                    secondary.begin(secondaryBeginInfo);
+                    secondary.bindPipeline(vk::PipelineBindPoint::eGraphics, s_.pipeline);
+                    secondary.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, s_.pipelineLayout, 0, 1, &s_.descriptorSet, 1, &uniformOffset);
+
+                    const std::size_t drawEnd = std::min(drawCount, (batch + 1) * batchSize);
+
+                    // Meshes share a few large buffers, so most draws need no new binding
+                    const mc::VertexBuffer* pBound = nullptr;
+
+                    for (std::size_t i = batch * batchSize; i < drawEnd; ++i) {
+                        const DrawCommand& drawCommand = s_.drawCommands[i];
+
+                        const mc::ChunkPushConstants pushConstants{ mc::ToVec4f32(drawCommand.origin, 0.f) };
+                        secondary.pushConstants(s_.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pushConstants), &pushConstants);
+
+                        if (std::exchange(pBound, drawCommand.pVertexBuffer) != drawCommand.pVertexBuffer)
+                            drawCommand.pVertexBuffer->Bind(secondary);
+
+                        secondary.draw(drawCommand.vertexCount, 1, drawCommand.firstVertex, 0);
+                    }
+
+                    secondary.end();
+                }
+            });
+
+            s_.lastDrawCount = static_cast<u32>(drawCount);
+            s_.drawCommands.clear();
+
+            // First in the render pass, so the meshes are tested against its depth
+            const bool bFarField = std::exchange(s_.bFarFieldQueued, false);
+
+            if (bFarField) {
+                const vk::CommandBuffer secondary = s_.farFieldSecondaryBuffers[s_.frameIndex];
+
+                vk::CommandBufferBeginInfo secondaryBeginInfo{};
+                secondaryBeginInfo.flags            = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+                secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+                secondary.begin(secondaryBeginInfo);
+                secondary.bindPipeline(vk::PipelineBindPoint::eGraphics, s_.farFieldPipeline);
+                secondary.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, s_.farFieldPipelineLayout, 0, s_.pFarFieldPass->GetSet(), nullptr);
+                secondary.draw(3, 1, 0, 0);
+                secondary.end();
+            }
+
+            // Last, so it is drawn over the scene
+            const bool bOverlay = s_.overlayVertexCount > 0;
+
+            if (bOverlay) {
+                const vk::CommandBuffer secondary = s_.overlaySecondaryBuffers[s_.frameIndex];
+
+                vk::CommandBufferBeginInfo secondaryBeginInfo{};
+                secondaryBeginInfo.flags            = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+                secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+                const mc::OverlayPushConstants pushConstants{ mc::vec4f32{ 2.f / s_.swapChainExtent.width, 2.f / s_.swapChainExtent.height, 0.f, 0.f } };
+
+                secondary.begin(secondaryBeginInfo);
+                secondary.bindPipeline(vk::PipelineBindPoint::eGraphics, s_.overlayPipeline);
+                secondary.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, s_.overlayPipelineLayout, 0, s_.overlayDescriptorSet, nullptr);
+                secondary.pushConstants(s_.overlayPipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pushConstants), &pushConstants);
+                s_.overlayBuffers[s_.frameIndex].Bind(secondary);
+                secondary.draw(s_.overlayVertexCount, 1, 0, 0);
+                secondary.end();
+
+                s_.overlayVertexCount = 0;
+            }
+
+            const bool bTimestamps = bOverlay && s_.timestampPool;
+
             vk::RenderPassBeginInfo renderPassInfo{};
             renderPassInfo.renderPass  = s_.renderPass;
             renderPassInfo.framebuffer = frameBuffer;// swapChainFramebuffers[i];
             renderPassInfo.renderArea.offset = vk::Offset2D{ 0, 0 };
             renderPassInfo.renderArea.extent = s_.swapChainExtent;
 
-            vk::ClearValue clearColor;
-            clearColor.color.setFloat32({ 0.3f, 0.3f, 1.0f, 1.0f });
+            std::array<vk::ClearValue, 2> clearValues;
+            clearValues[0].color.setFloat32({ 0.3f, 0.3f, 1.0f, 1.0f });
+            clearValues[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
 
-            renderPassInfo.clearValueCount = 1;
-            renderPassInfo.pClearValues    = &clearColor;
+            renderPassInfo.clearValueCount = static_cast<u32>(clearValues.size());
+            renderPassInfo.pClearValues    = clearValues.data();
 
             vk::CommandBufferBeginInfo beginInfo{};
             beginInfo.flags = {}; // Optional
             beginInfo.pInheritanceInfo = nullptr; // Optional
 
             cmdBuff.begin(beginInfo);
-            cmdBuff.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-            cmdBuff.bindPipeline(vk::PipelineBindPoint::eGraphics, s_.pipeline);
-            s_.vertexBuffer.Bind(cmdBuff);
-            cmdBuff.draw(3, 1, 0, 0);
+
+            if (bTimestamps) {
+                cmdBuff.resetQueryPool(s_.timestampPool, 2 * s_.frameIndex, 2);
+                cmdBuff.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, s_.timestampPool, 2 * s_.frameIndex);
+            }
+
+            RecordPendingCopies(cmdBuff);
+
+            if (bFarField) {
+                const mc::vec3f32 cameraPosition{ s_.frameUniforms.cameraPosition.x, s_.frameUniforms.cameraPosition.y, s_.frameUniforms.cameraPosition.z };
+
+                s_.pFarFieldPass->Record(cmdBuff, mc::FarFieldPass::MakePushConstants(s_.frameUniforms.view, s_.frameUniforms.projection, cameraPosition, s_.farFieldWindowLo, s_.farFieldWindowChunks));
+            }
+
+            cmdBuff.beginRenderPass(renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+
+            if (bFarField)
+                cmdBuff.executeCommands(s_.farFieldSecondaryBuffers[s_.frameIndex]);
+
+            cmdBuff.executeCommands(batchCount, secondaryBuffers.data());
+
+            if (bOverlay)
+                cmdBuff.executeCommands(s_.overlaySecondaryBuffers[s_.frameIndex]);
+
             cmdBuff.endRenderPass();
+
+            if (bTimestamps) {
+                cmdBuff.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, s_.timestampPool, 2 * s_.frameIndex + 1);
+                s_.bTimestamped[s_.frameIndex] = true;
+            }
+
             cmdBuff.end();
 
+            s_.lastRecordUS = recordTimer.GetElapsedUS();
+
             // 
             //
             // Submit Command Buffers
@@ -476,9 +1788,9 @@ namespace mc {
 
             vk::SubmitInfo submitInfo{};
 
-            std::array waitSemaphores = { s_.imageAvailableSemaphore };
+            std::array waitSemaphores = { s_.imageAvailableSemaphores[s_.frameIndex] };
             std::array waitStages = { (vk::PipelineStageFlags)vk::PipelineStageFlagBits::eColorAttachmentOutput };
-            std::array signalSemaphores = { s_.renderFinishedSemaphore };
+            std::array signalSemaphores = { s_.renderFinishedSemaphores[s_.frameIndex] };
 
             submitInfo.waitSemaphoreCount   = static_cast<u32>(waitSemaphores.size());
             submitInfo.pWaitSemaphores      = waitSemaphores.data();
@@ -488,7 +1800,7 @@ namespace mc {
             submitInfo.signalSemaphoreCount = static_cast<u32>(signalSemaphores.size());
             submitInfo.pSignalSemaphores    = signalSemaphores.data();
 
-            gfxQueue.submit(submitInfo);
+            s_.frameValues[s_.frameIndex] = s_.timeline.Submit(submitInfo);
 
             //
             //
@@ -504,23 +1816,76 @@ namespace mc {
             presentInfo.pImageIndices      = &imgIdx;
             presentInfo.pResults           = nullptr; // Optional
 
+            const u64 presentId = s_.pacer.GetNextPresentId();
+
+            vk::PresentIdKHR presentIdInfo{};
+            presentIdInfo.swapchainCount = 1;
+            presentIdInfo.pPresentIds    = &presentId;
+
+            presentInfo.pNext = s_.bPresentWait ? &presentIdInfo : nullptr;
+
             presentQueue.presentKHR(presentInfo);
+            s_.pacer.OnPresented();
 
-            //TODO: Upgrade to frames in flight
-            presentQueue.waitIdle();
+            s_.frameIndex = (s_.frameIndex + 1) % s_.framesInFlight;
+            ++s_.frameNumber;
+
+            // The next frame reuses this slot's command buffers, uniforms and staging buffer, and uploads go to it from now on
+            s_.timeline.Wait(s_.frameValues[s_.frameIndex]);
+            s_.stagingBuffers[s_.frameIndex].Reset();
+
+            ReadTimestamps(s_.frameIndex);
+            ReleaseRetired();
         }
 
         static void Shutdown() {
-            s_.device.destroySemaphore(s_.imageAvailableSemaphore);
-            s_.device.destroySemaphore(s_.renderFinishedSemaphore);
+            s_.device.waitIdle();
+
+            s_.retiredBuffers.clear();
+            s_.retiringBytes.fill(0);
+            s_.timeline = mc::GpuTimeline();
+
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                s_.device.destroySemaphore(s_.imageAvailableSemaphores[frame]);
+                s_.device.destroySemaphore(s_.renderFinishedSemaphores[frame]);
+            }
 
             s_.device.destroyCommandPool(s_.commandPool);
 
-            s_.vertexBuffer.~VertexBuffer();
+            for (u32 frame = 0; frame < s_.framesInFlight; ++frame) {
+                for (const vk::CommandPool pool : s_.recordingPools[frame])
+                    s_.device.destroyCommandPool(pool);
+
+                s_.recordingPools[frame].clear();
+                s_.secondaryBuffers[frame].clear();
+            }
+
+            DestroyOverlay();
+            DestroyFarField();
+
+            s_.uniformBuffer = mc::UniformRingBuffer();
+            for (mc::StagingBuffer& stagingBuffer : s_.stagingBuffers)
+                stagingBuffer = mc::StagingBuffer();
+            s_.pendingCopies.clear();
 
             s_.device.destroyPipeline(s_.pipeline);
+
+            for (vk::Pipeline& reloaded : s_.reloadedPipelines) {
+                if (reloaded)
+                    s_.device.destroyPipeline(reloaded);
+
+                reloaded = vk::Pipeline{};
+            }
+
+            for (const auto& [pipeline, value] : s_.retiredPipelines)
+                s_.device.destroyPipeline(pipeline);
+
+            s_.retiredPipelines.clear();
             s_.device.destroyPipelineLayout(s_.pipelineLayout);
 
+            s_.device.destroyDescriptorPool(s_.descriptorPool);
+            s_.device.destroyDescriptorSetLayout(s_.descriptorSetLayout);
+
             for (const auto& frameBuffer : s_.swapChainFrameBuffers)
                 s_.device.destroyFramebuffer(frameBuffer);
             s_.swapChainFrameBuffers.clear();
@@ -529,6 +1894,10 @@ namespace mc {
                 s_.device.destroyImageView(imgView);
             s_.swapChainImageViews.clear();
 
+            s_.device.destroyImageView(s_.depthImageView);
+            s_.device.destroyImage(s_.depthImage);
+            mc::GpuMemory::Free(s_.device, s_.depthMemory);
+
             s_.device.destroyRenderPass(s_.renderPass);
             s_.device.destroySwapchainKHR(s_.swapChain);
             s_.device.destroy();
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "noise.hpp"
+#include "threadPool.hpp"
+#include "worldSaver.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * What an autosave costs: every round edits one block in each of DIRTY_CHUNKS generated chunks,
+ * saves, and waits for the batch to be written. SaveStats::lastSnapshotUS is the tick's share,
+ * lastWriteUS the background thread's. The region files go to DIRECTORY, rewritten on every run;
+ * generation is not timed.
+ */
+
+namespace mc {
+
+    class SaveBenchmark {
+    private:
+        static constexpr u64         SEED         = 0x53617665ull;
+        static constexpr i32         SIDE         = 32; // Chunks along each side of the world, about DIRTY_CHUNKS
+        static constexpr std::size_t DIRTY_CHUNKS = 1000;
+        static constexpr const char* DIRECTORY    = "save-benchmark";
+
+    public:
+        static void RunAll(const u32 rounds, ThreadPool& pool, std::ostream& out) {
+            World              world;
+            WorldGenerator     generator(SEED);
+            GenerationPipeline generation(generator, pool);
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = 0; z < SIDE; ++z)
+                for (i32 x = 0; x < SIDE; ++x)
+                    chunks.push_back(&world.CreateChunk(ChunkCoord{ x, z }));
+
+            generation.Generate(chunks);
+
+            for (Chunk* pChunk : chunks)
+                pChunk->Intern(world.GetSectionPool());
+
+            chunks.resize(std::min(chunks.size(), DIRTY_CHUNKS));
+
+            WorldSaver saver(DIRECTORY, pool);
+
+            out << "[BENCHMARK] " << rounds << " saves of " << chunks.size() << " edited chunks to " << DIRECTORY << "/ on " << pool.GetThreadCount() + 1 << " threads\n";
+
+            u64 snapshotUS = 0, maxSnapshotUS = 0;
+            u64 writeUS    = 0, maxWriteUS    = 0;
+            SaveStats stats;
+
+            for (u32 round = 0; round < rounds; ++round) {
+                // A block just above the ground, placed and removed on alternate rounds so every edit changes something
+                for (const Chunk* pChunk : chunks) {
+                    const u64 h = noise::Hash(SEED, pChunk->GetCoord().x, 0, pChunk->GetCoord().z);
+                    const i32 x = ChunkToWorld(pChunk->GetCoord().x) + static_cast<i32>(h % MC_CHUNK_SECTION_SIZE);
+                    const i32 z = ChunkToWorld(pChunk->GetCoord().z) + static_cast<i32>((h >> 8) % MC_CHUNK_SECTION_SIZE);
+
+                    world.SetBlock(vec3i32{ x, generator.GetTerrainHeight(x, z) + 1, z }, round % 2 == 0 ? Block::Dirt : Block::Air);
+                }
+
+                saver.Save(world);
+                saver.Flush();
+
+                stats = saver.GetStats();
+
+                snapshotUS   += stats.lastSnapshotUS;
+                writeUS      += stats.lastWriteUS;
+                maxSnapshotUS = std::max(maxSnapshotUS, stats.lastSnapshotUS);
+                maxWriteUS    = std::max(maxWriteUS, stats.lastWriteUS);
+            }
+
+            const f64 count = static_cast<f64>(std::max<u32>(rounds, 1));
+
+            out << "[BENCHMARK] snapshot " << std::fixed << std::setprecision(3) << static_cast<f64>(snapshotUS) / count / 1000.0 << " ms avg, " << maxSnapshotUS / 1000.0 << " ms max"
+                << " | write " << static_cast<f64>(writeUS) / count / 1000.0 << " ms avg, " << maxWriteUS / 1000.0 << " ms max"
+                << " | " << stats.lastChunkCount << " chunks, " << stats.lastByteCount / 1024 << " KB of regions per save\n"
+                << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class SaveBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,627 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "entity.hpp"
+#include "udpSocket.hpp"
+#include "threadPool.hpp"
+#include "chunkCodec.hpp"
+#include "netProtocol.hpp"
+#include "netConnection.hpp"
+#include "pathfinder.hpp"
+#include "worldSaver.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * The authoritative, headless side of a multiplayer game. Every tick it reads client inputs,
+ * generates the chunks players need, steps the entities, then streams each client the
+ * chunks within its view radius and a snapshot of the entities within its interest radius.
+ * Mobs walk along paths to places around them, searched in one batch per tick on the pool.
+ */
+
+namespace mc {
+
+    struct ServerSettings {
+        u16 port           = MC_NET_DEFAULT_PORT;
+        u32 maxClients     = 256;
+        i32 viewRadius     = 6; // Chunks streamed around each player (Chebyshev distance)
+        i32 interestRadius = 3; // Chunks whose entities go in a player's snapshots
+        u32 mobCount       = 500;
+        i32 mobRange       = 96; // Mobs wander within this many blocks of the origin
+        i32 mobWander      = 32; // How far away a mob heads each time it picks a new place
+
+        u32         maxChunkSendsPerTick  = 4;          // Per client
+        std::size_t maxPendingReliable    = 128 << 10;  // Per client: no new chunk while this much is still unacked
+        u32         maxPacketsPerTick     = 16;         // Per client
+        u32         maxGenerationsPerTick = 32;
+
+        std::string saveDirectory = "save";
+    }; // struct ServerSettings
+
+    struct ServerStats {
+        u64 lastTickUS = 0;
+        u64 maxTickUS  = 0; // Since the last ResetStats()
+        u64 sumTickUS  = 0;
+        u64 tickCount  = 0;
+
+        u64 pathUS     = 0; // Searching the mobs' paths
+        u64 paths      = 0;
+        u64 pathsFound = 0;
+    }; // struct ServerStats
+
+    class Server {
+    private:
+        struct ClientState {
+            NetConnection connection;
+            EntityID      player     = 0;
+            i32           viewRadius = 0;
+            bool          bWelcomed  = false;
+
+            i8   moveX = 0, moveZ = 0;
+            bool bJump = false;
+
+            std::unordered_set<ChunkCoord, ChunkCoordHash> sentChunks;
+
+            std::array<NetSnapshot, MC_NET_SNAPSHOT_HISTORY> history;
+            u32 ackedSnapshot = 0;
+        }; // struct ClientState
+
+        ServerSettings  m_settings;
+        ThreadPool&     m_pool;
+        UdpSocket       m_socket;
+        mc::Timer       m_clock;
+
+        World          m_world;
+        WorldGenerator     m_generator;
+        GenerationPipeline m_generation;
+        EntitySystem       m_entities;
+        WorldSaver         m_saver;
+
+        std::unordered_map<NetAddress, std::unique_ptr<ClientState>, NetAddressHash> m_clients;
+
+        std::vector<EntityID> m_mobs;
+
+        // Per mob, the cells it walks through and the next one it heads for
+        struct MobPath {
+            std::vector<vec3i32> cells;
+            u32                  next = 0;
+        }; // struct MobPath
+
+        Pathfinder               m_paths;
+        std::vector<MobPath>     m_mobPaths;
+        std::vector<PathRequest> m_pathRequests; // This tick's batch, and the mob each is for
+        std::vector<u32>         m_pathMobs;
+        std::vector<PathResult>  m_pathResults;
+
+        // Chunks are encoded once and shared by every client they are sent to
+        std::unordered_map<ChunkCoord, std::shared_ptr<const std::vector<u8>>, ChunkCoordHash> m_encodedChunks;
+
+        // Entity slots by chunk, rebuilt every tick for interest queries
+        std::unordered_map<ChunkCoord, std::vector<u32>, ChunkCoordHash> m_entitiesByChunk;
+
+        u64 m_tick           = 0;
+        u32 m_nextSnapshotId = 1;
+
+        ServerStats m_stats;
+
+    private:
+        inline f64 Now() const { return static_cast<f64>(m_clock.GetElapsedUS()) * 1e-6; }
+
+        static inline ChunkCoord ChunkOf(const vec3f32& p) {
+            return ChunkCoord{ WorldToChunk(static_cast<i32>(std::floor(p.x))), WorldToChunk(static_cast<i32>(std::floor(p.z))) };
+        }
+
+        inline vec3f32 SurfacePosition(const i32 x, const i32 z) const {
+            return vec3f32{ x + 0.5f, static_cast<f32>(m_generator.GetTerrainHeight(x, z)) + 2.f, z + 0.5f };
+        }
+
+        std::shared_ptr<const std::vector<u8>> GetEncodedChunk(const ChunkCoord coord) {
+            auto& pEncoded = m_encodedChunks[coord];
+
+            if (!pEncoded) {
+                auto pMessage = std::make_shared<std::vector<u8>>();
+
+                ByteWriter writer(*pMessage);
+                writer.WriteU8(static_cast<u8>(NetMessageType::eChunkData));
+                writer.WriteI32(coord.x);
+                writer.WriteI32(coord.z);
+                EncodeChunk(*m_world.GetChunk(coord), writer);
+
+                pEncoded = std::move(pMessage);
+            }
+
+            return pEncoded;
+        }
+
+        void ReceivePackets(const f64 now) {
+            std::array<u8, 2048> buffer;
+            NetAddress from;
+
+            while (const std::optional<std::size_t> size = m_socket.Receive(buffer.data(), buffer.size(), from)) {
+                auto it = m_clients.find(from);
+
+                // A client is only allocated once its packet delivers a Hello, and while there is room for it
+                if (it == m_clients.end()) {
+                    if (m_clients.size() >= m_settings.maxClients)
+                        continue;
+
+                    NetConnection connection(from, now);
+
+                    if (!connection.ProcessPacket(buffer.data(), size.value(), now))
+                        continue;
+
+                    const NetMessage* pMessage = connection.PeekMessage();
+
+                    if (!pMessage || !pMessage->bReliable || pMessage->data.empty() || pMessage->data[0] != static_cast<u8>(NetMessageType::eHello))
+                        continue;
+
+                    auto pClient = std::make_unique<ClientState>();
+                    pClient->connection = std::move(connection);
+
+                    m_clients.emplace(from, std::move(pClient));
+                    continue;
+                }
+
+                it->second->connection.ProcessPacket(buffer.data(), size.value(), now);
+            }
+        }
+
+        void HandleMessages(ClientState& client) {
+            while (const std::optional<NetMessage> message = client.connection.PopMessage()) {
+                ByteReader reader(message->data.data(), message->data.size());
+
+                switch (static_cast<NetMessageType>(reader.ReadU8())) {
+                case NetMessageType::eHello: {
+                    const i32 viewRadius = reader.ReadU8();
+
+                    if (!reader.IsValid() || client.bWelcomed)
+                        break;
+
+                    client.viewRadius = std::clamp(viewRadius, 1, m_settings.viewRadius);
+                    client.bWelcomed  = true;
+
+                    // Spread players around the spawn point so they do not all start inside each other
+                    const i32 spread = static_cast<i32>(m_clients.size() % 64);
+                    client.player = m_entities.Spawn(SurfacePosition((spread % 8) * 3, (spread / 8) * 3), vec3f32{ 0.3f, 0.9f, 0.3f });
+
+                    std::vector<u8> welcome;
+                    ByteWriter writer(welcome);
+                    writer.WriteU8(static_cast<u8>(NetMessageType::eWelcome));
+                    writer.WriteU32(client.player);
+
+                    client.connection.SendReliable(welcome);
+                    break;
+                }
+                case NetMessageType::eInput: {
+                    const u32  ack   = reader.ReadU32();
+                    const i8   moveX = static_cast<i8>(reader.ReadU8());
+                    const i8   moveZ = static_cast<i8>(reader.ReadU8());
+                    const bool bJump = reader.ReadU8() != 0;
+
+                    if (!reader.IsValid())
+                        break;
+
+                    if (ack > client.ackedSnapshot && client.history[ack % MC_NET_SNAPSHOT_HISTORY].id == ack)
+                        client.ackedSnapshot = ack;
+
+                    client.moveX = moveX;
+                    client.moveZ = moveZ;
+                    client.bJump = bJump;
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+
+        void DropTimedOutClients(const f64 now) {
+            for (auto it = m_clients.begin(); it != m_clients.end();) {
+                if (!it->second->connection.IsTimedOut(now)) {
+                    ++it;
+                    continue;
+                }
+
+                if (it->second->bWelcomed)
+                    m_entities.Despawn(it->second->player);
+
+                it = m_clients.erase(it);
+            }
+        }
+
+        void ApplyInputs() {
+            constexpr f32 WALK_SPEED = 4.3f;
+            constexpr f32 JUMP_SPEED = 8.f;
+            constexpr f32 MOB_SPEED  = 2.f;
+
+            for (const auto& [address, pClient] : m_clients) {
+                if (!pClient->bWelcomed)
+                    continue;
+
+                const u32 slot = m_entities.GetSlot(pClient->player).value();
+                vec3f32 velocity = m_entities.GetVelocity(slot);
+
+                velocity.x = pClient->moveX / 127.f * WALK_SPEED;
+                velocity.z = pClient->moveZ / 127.f * WALK_SPEED;
+
+                if (pClient->bJump && m_entities.IsOnGround(slot))
+                    velocity.y = JUMP_SPEED;
+
+                m_entities.SetVelocity(slot, velocity);
+            }
+
+            // Mobs follow their path, jumping onto the cells above them; without one they pick a new heading every
+            // two seconds, turning back towards the origin once out of range
+            for (u32 i = 0; i < m_mobs.size(); ++i) {
+                const u32 slot = m_entities.GetSlot(m_mobs[i]).value();
+
+                if (!m_entities.IsOnGround(slot))
+                    continue;
+
+                const vec3f32 position = m_entities.GetPosition(slot);
+                MobPath&      path     = m_mobPaths[i];
+
+                while (path.next < path.cells.size() && IsReached(position, path.cells[path.next]))
+                    ++path.next;
+
+                if (path.next < path.cells.size()) {
+                    const vec3i32 cell    = path.cells[path.next];
+                    const vec3f32 heading = Normalize(vec3f32{ cell.x + 0.5f - position.x, 0.f, cell.z + 0.5f - position.z });
+                    const bool    bClimb  = cell.y > FeetCell(position).y;
+
+                    m_entities.SetVelocity(slot, vec3f32{ heading.x * MOB_SPEED, bClimb ? JUMP_SPEED : m_entities.GetVelocity(slot).y, heading.z * MOB_SPEED });
+                    continue;
+                }
+
+                const f32 angle = noise::HashToUnit(noise::Hash(0x4D6F62ull, static_cast<i32>(i), 0, static_cast<i32>(m_tick / (2 * MC_NET_TICK_RATE)))) * 6.2831853f;
+
+                vec3f32 heading{ std::cos(angle), 0.f, std::sin(angle) };
+                if (std::abs(position.x) > m_settings.mobRange || std::abs(position.z) > m_settings.mobRange)
+                    heading = Normalize(vec3f32{ -position.x, 0.f, -position.z });
+
+                m_entities.SetVelocity(slot, vec3f32{ heading.x * MOB_SPEED, m_entities.GetVelocity(slot).y, heading.z * MOB_SPEED });
+            }
+        }
+
+        // The cell a mob's feet are in, its box being centered on its position
+        static inline vec3i32 FeetCell(const vec3f32& position) {
+            constexpr f32 MOB_HALF_HEIGHT = 0.45f;
+
+            return vec3i32{ static_cast<i32>(std::floor(position.x)), static_cast<i32>(std::floor(position.y - MOB_HALF_HEIGHT + 0.01f)), static_cast<i32>(std::floor(position.z)) };
+        }
+
+        static inline bool IsReached(const vec3f32& position, const vec3i32& cell) {
+            return std::abs(cell.x + 0.5f - position.x) < 0.35f && std::abs(cell.z + 0.5f - position.z) < 0.35f;
+        }
+
+        /*
+         * Every REPATH_TICKS each mob heads for a new place around it, its repaths spread over the ticks.
+         * The tick's requests are searched in one batch on the pool; mobs whose search failed wander instead.
+         */
+        void PlanMobPaths() {
+            constexpr u64 REPATH_TICKS = 4 * MC_NET_TICK_RATE;
+
+            m_pathRequests.clear();
+            m_pathMobs.clear();
+
+            for (u32 i = 0; i < m_mobs.size(); ++i) {
+                if ((m_tick + i) % REPATH_TICKS != 0)
+                    continue;
+
+                const u32 slot = m_entities.GetSlot(m_mobs[i]).value();
+
+                if (!m_entities.IsOnGround(slot))
+                    continue;
+
+                const vec3f32 position = m_entities.GetPosition(slot);
+                const u64     h        = noise::Hash(0x50617468ull, static_cast<i32>(i), 0, static_cast<i32>(m_tick / REPATH_TICKS));
+                const i32     x        = std::clamp(static_cast<i32>(position.x) + static_cast<i32>(h % (2 * m_settings.mobWander + 1)) - m_settings.mobWander, -m_settings.mobRange, m_settings.mobRange);
+                const i32     z        = std::clamp(static_cast<i32>(position.z) + static_cast<i32>((h >> 16) % (2 * m_settings.mobWander + 1)) - m_settings.mobWander, -m_settings.mobRange, m_settings.mobRange);
+
+                m_pathRequests.push_back(PathRequest{ FeetCell(position), vec3i32{ x, m_generator.GetTerrainHeight(x, z) + 1, z } });
+                m_pathMobs.push_back(i);
+            }
+
+            if (m_pathRequests.empty())
+                return;
+
+            const mc::Timer timer;
+
+            m_paths.FindPaths(m_world, m_pathRequests, m_pathResults, m_pool);
+
+            for (std::size_t r = 0; r < m_pathRequests.size(); ++r) {
+                MobPath& path = m_mobPaths[m_pathMobs[r]];
+
+                // Swapped rather than copied, so both keep their storage for the next searches
+                path.cells.swap(m_pathResults[r].path);
+                path.next = 1;
+
+                m_stats.pathsFound += !path.cells.empty();
+            }
+
+            m_stats.pathUS += timer.GetElapsedUS();
+            m_stats.paths  += m_pathRequests.size();
+        }
+
+        // Generates the missing chunks around players and under mobs, nearest to a player first
+        void GenerateChunks() {
+            std::vector<std::pair<i32, ChunkCoord>> missing;
+            std::unordered_set<ChunkCoord, ChunkCoordHash> seen;
+
+            const auto Require = [&](const ChunkCoord coord, const i32 priority) {
+                if (!m_world.GetChunk(coord) && seen.insert(coord).second)
+                    missing.emplace_back(priority, coord);
+            };
+
+            for (const auto& [address, pClient] : m_clients) {
+                if (!pClient->bWelcomed)
+                    continue;
+
+                const ChunkCoord center = ChunkOf(m_entities.GetPosition(m_entities.GetSlot(pClient->player).value()));
+
+                for (i32 dz = -pClient->viewRadius; dz <= pClient->viewRadius; ++dz)
+                    for (i32 dx = -pClient->viewRadius; dx <= pClient->viewRadius; ++dx)
+                        Require(ChunkCoord{ center.x + dx, center.z + dz }, std::max(std::abs(dx), std::abs(dz)));
+            }
+
+            for (const EntityID mob : m_mobs)
+                Require(ChunkOf(m_entities.GetPosition(m_entities.GetSlot(mob).value())), 0);
+
+            const std::size_t count = std::min<std::size_t>(missing.size(), m_settings.maxGenerationsPerTick);
+            std::partial_sort(missing.begin(), missing.begin() + count, missing.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            std::vector<Chunk*> chunks(count);
+            for (std::size_t i = 0; i < count; ++i)
+                chunks[i] = &m_world.CreateChunk(missing[i].second);
+
+            LoadOrGenerate(chunks);
+        }
+
+        // Chunks come from the save when it has them, from the generation pipeline otherwise
+        void LoadOrGenerate(const std::vector<Chunk*>& chunks) {
+            std::vector<u8> loaded(chunks.size());
+
+            m_pool.ParallelFor(chunks.size(), 4, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    loaded[i] = m_saver.LoadChunk(*chunks[i]);
+            });
+
+            std::vector<Chunk*> generated;
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+                if (!loaded[i])
+                    generated.push_back(chunks[i]);
+
+            m_generation.Generate(generated);
+
+            m_pool.ParallelFor(chunks.size(), 4, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    chunks[i]->Intern(m_world.GetSectionPool());
+            });
+
+            for (const Chunk* pChunk : chunks)
+                m_paths.InvalidateChunk(pChunk->GetCoord());
+        }
+
+        void BucketEntities() {
+            for (auto& [coord, slots] : m_entitiesByChunk)
+                slots.clear();
+
+            for (u32 slot = 0; slot < m_entities.GetCount(); ++slot)
+                m_entitiesByChunk[ChunkOf(m_entities.GetPosition(slot))].push_back(slot);
+        }
+
+        void StreamChunks(ClientState& client, const ChunkCoord center) {
+            // Unload what the client walked away from, with one chunk of hysteresis
+            for (auto it = client.sentChunks.begin(); it != client.sentChunks.end();) {
+                if (client.connection.IsWindowFull())
+                    return;
+
+                if (std::max(std::abs(it->x - center.x), std::abs(it->z - center.z)) <= client.viewRadius + 1) {
+                    ++it;
+                    continue;
+                }
+
+                std::vector<u8> unload;
+                ByteWriter writer(unload);
+                writer.WriteU8(static_cast<u8>(NetMessageType::eChunkUnload));
+                writer.WriteI32(it->x);
+                writer.WriteI32(it->z);
+
+                if (!client.connection.SendReliable(unload))
+                    return;
+
+                it = client.sentChunks.erase(it);
+            }
+
+            u32 sends = 0;
+
+            // Rings outwards from the player, so the nearest chunks arrive first
+            for (i32 ring = 0; ring <= client.viewRadius; ++ring) {
+                for (i32 dz = -ring; dz <= ring; ++dz) {
+                    for (i32 dx = -ring; dx <= ring; ++dx) {
+                        if (std::max(std::abs(dx), std::abs(dz)) != ring)
+                            continue;
+
+                        // Nothing is encoded for a client that could not send it yet
+                        if (sends >= m_settings.maxChunkSendsPerTick || client.connection.GetPendingReliable() >= m_settings.maxPendingReliable || client.connection.IsWindowFull())
+                            return;
+
+                        const ChunkCoord coord{ center.x + dx, center.z + dz };
+
+                        if (client.sentChunks.count(coord) || !m_world.GetChunk(coord))
+                            continue;
+
+                        if (!client.connection.SendReliable(*GetEncodedChunk(coord)))
+                            return;
+
+                        client.sentChunks.insert(coord);
+                        ++sends;
+                    }
+                }
+            }
+        }
+
+        void SendSnapshot(ClientState& client, const ChunkCoord center, const vec3f32& position) {
+            std::vector<std::pair<f32, u32>> candidates;
+
+            for (i32 dz = -m_settings.interestRadius; dz <= m_settings.interestRadius; ++dz) {
+                for (i32 dx = -m_settings.interestRadius; dx <= m_settings.interestRadius; ++dx) {
+                    const auto it = m_entitiesByChunk.find(ChunkCoord{ center.x + dx, center.z + dz });
+
+                    if (it == m_entitiesByChunk.end())
+                        continue;
+
+                    for (const u32 slot : it->second) {
+                        const vec3f32 d = m_entities.GetPosition(slot) - position;
+                        candidates.emplace_back(Dot(d, d), slot);
+                    }
+                }
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            std::vector<std::pair<EntityID, EntityState>> visible;
+            visible.reserve(candidates.size());
+
+            for (const auto& [distanceSq, slot] : candidates)
+                visible.emplace_back(m_entities.GetID(slot), EntityState::Quantize(m_entities.GetPosition(slot), m_entities.GetVelocity(slot)));
+
+            static const NetSnapshot EMPTY;
+
+            const NetSnapshot& baseline = client.ackedSnapshot != 0 ? client.history[client.ackedSnapshot % MC_NET_SNAPSHOT_HISTORY] : EMPTY;
+            const u32          id       = m_nextSnapshotId;
+
+            std::vector<u8> message;
+            client.history[id % MC_NET_SNAPSHOT_HISTORY] = EncodeSnapshot(id, baseline, visible, message);
+
+            // The acked baseline was just overwritten: its id cannot be acked anymore, fall back to a full snapshot
+            if (client.ackedSnapshot % MC_NET_SNAPSHOT_HISTORY == id % MC_NET_SNAPSHOT_HISTORY)
+                client.ackedSnapshot = 0;
+
+            client.connection.SendUnreliable(std::move(message));
+        }
+
+    public:
+        Server(const ServerSettings& settings, ThreadPool& pool, const u64 seed)
+            : m_settings(settings), m_pool(pool), m_socket(settings.port), m_generator(seed), m_generation(m_generator, pool), m_saver(settings.saveDirectory, pool)
+        {
+            // The mob area is generated up front so mobs spawn on the ground
+            const i32 radius = WorldToChunk(m_settings.mobRange) + 1;
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = -radius; z <= radius; ++z)
+                for (i32 x = -radius; x <= radius; ++x)
+                    chunks.push_back(&m_world.CreateChunk(ChunkCoord{ x, z }));
+
+            LoadOrGenerate(chunks);
+
+            for (u32 i = 0; i < m_settings.mobCount; ++i) {
+                const u64 h = noise::Hash(0x537061ull, static_cast<i32>(i), 0, 0);
+                const i32 x = static_cast<i32>(h % (2 * m_settings.mobRange)) - m_settings.mobRange;
+                const i32 z = static_cast<i32>((h >> 16) % (2 * m_settings.mobRange)) - m_settings.mobRange;
+
+                m_mobs.push_back(m_entities.Spawn(SurfacePosition(x, z), vec3f32{ 0.3f, 0.45f, 0.3f }));
+            }
+
+            m_mobPaths.resize(m_mobs.size());
+        }
+
+        ~Server() { m_saver.Save(m_world); }
+
+        inline u16                GetPort()        const { return m_socket.GetPort(); }
+        inline std::size_t        GetClientCount() const { return m_clients.size();   }
+        inline const ServerStats& GetStats()       const { return m_stats;            }
+        inline World&             GetWorld()             { return m_world;            }
+
+        inline void ResetStats() { m_stats = ServerStats{}; }
+
+        // Bytes sent and received over every current connection
+        NetStats GetTotalTraffic() const {
+            NetStats total;
+
+            for (const auto& [address, pClient] : m_clients) {
+                const NetStats& stats = pClient->connection.GetStats();
+
+                total.bytesSent       += stats.bytesSent;
+                total.bytesReceived   += stats.bytesReceived;
+                total.packetsSent     += stats.packetsSent;
+                total.packetsReceived += stats.packetsReceived;
+                total.fragmentsResent += stats.fragmentsResent;
+            }
+
+            return total;
+        }
+
+        void Tick() {
+            const mc::Timer timer;
+            const f64       now = Now();
+
+            ReceivePackets(now);
+
+            for (const auto& [address, pClient] : m_clients)
+                HandleMessages(*pClient);
+
+            DropTimedOutClients(now);
+            PlanMobPaths();
+            ApplyInputs();
+            GenerateChunks();
+
+            m_entities.Tick(m_world, 1.f / MC_NET_TICK_RATE, m_pool);
+
+            // Edited sections are re-encoded the next time they are sent, and their regions rebuilt by the next search through them
+            for (const vec3i32& section : m_world.GetDirtySections()) {
+                m_encodedChunks.erase(ChunkCoord{ section.x, section.z });
+                m_paths.Invalidate(section);
+            }
+            while (!m_world.GetDirtySections().empty())
+                m_world.ClearDirtySection(*m_world.GetDirtySections().begin());
+
+            BucketEntities();
+
+            std::vector<ClientState*> clients;
+            for (const auto& [address, pClient] : m_clients)
+                if (pClient->bWelcomed)
+                    clients.push_back(pClient.get());
+
+            // Encoding the chunks first keeps the shared cache out of the parallel section
+            for (ClientState* pClient : clients) {
+                const ChunkCoord center = ChunkOf(m_entities.GetPosition(m_entities.GetSlot(pClient->player).value()));
+
+                StreamChunks(*pClient, center);
+            }
+
+            m_pool.ParallelFor(clients.size(), 8, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    ClientState&  client   = *clients[i];
+                    const vec3f32 position = m_entities.GetPosition(m_entities.GetSlot(client.player).value());
+
+                    SendSnapshot(client, ChunkOf(position), position);
+
+                    for (const std::vector<u8>& packet : client.connection.BuildPackets(now, m_settings.maxPacketsPerTick))
+                        m_socket.SendTo(client.connection.GetAddress(), packet.data(), packet.size());
+                }
+            });
+
+            // Clients still handshaking get their acks too
+            for (const auto& [address, pClient] : m_clients)
+                if (!pClient->bWelcomed)
+                    for (const std::vector<u8>& packet : pClient->connection.BuildPackets(now, 1))
+                        m_socket.SendTo(address, packet.data(), packet.size());
+
+            ++m_tick;
+            ++m_nextSnapshotId;
+
+            // Only the snapshot is taken here, the encoding and writing happen in the background
+            if (m_tick % (MC_AUTOSAVE_INTERVAL_MS * MC_NET_TICK_RATE / 1000u) == 0)
+                m_saver.Save(m_world);
+
+            m_stats.lastTickUS = timer.GetElapsedUS();
+            m_stats.maxTickUS  = std::max(m_stats.maxTickUS, m_stats.lastTickUS);
+            m_stats.sumTickUS += m_stats.lastTickUS;
+            ++m_stats.tickCount;
+        }
+    }; // class Server
+
+}; // namespace mc
\ No newline at end of file
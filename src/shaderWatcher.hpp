@@ -0,0 +1,134 @@
+#pragma once
+
+#include "header.hpp"
+
+#ifdef MC_LINUX
+#   include <poll.h>
+#   include <unistd.h>
+#   include <sys/inotify.h>
+#endif // MC_LINUX
+
+/*
+ * Watches a shader directory for saved GLSL sources, recompiles them to <name>.<stage>.spv
+ * (the same layout the build produces) and calls back with the names of the changed files that
+ * compiled, so one broken shader does not hold back the others. Everything, the callback
+ * included, runs on the watcher's own thread.
+ *
+ * Only implemented on Linux (inotify); elsewhere Start() does nothing.
+ */
+
+#ifndef MC_GLSLANG_VALIDATOR
+#   define MC_GLSLANG_VALIDATOR "glslangValidator"
+#endif
+
+namespace mc {
+
+    class ShaderWatcher {
+    private:
+        std::string                                        m_directory;
+        std::function<void(const std::set<std::string>&)> m_onCompiled;
+
+        std::thread       m_thread;
+        std::atomic<bool> m_bStopping{ false };
+
+    private:
+        static bool IsShaderSource(const std::string& name) {
+            constexpr std::array STAGES = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+
+            const std::size_t dot = name.rfind('.');
+
+            return dot != std::string::npos && std::find(STAGES.begin(), STAGES.end(), name.substr(dot)) != STAGES.end();
+        }
+
+        bool Compile(const std::string& name) const {
+            const std::string command = std::string("\"") + MC_GLSLANG_VALIDATOR + "\" -V \"" + m_directory + '/' + name + "\" -o \"" + m_directory + '/' + name + ".spv\"";
+
+            std::cout << "[SHADERS] Recompiling " << name << '\n' << std::flush;
+
+            return std::system(command.c_str()) == 0;
+        }
+
+#ifdef MC_LINUX
+        void WatchLoop() {
+            const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+            if (fd < 0 || inotify_add_watch(fd, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+                std::cout << "[SHADERS] Cannot watch " << m_directory << ", hot reload is disabled\n" << std::flush;
+
+                if (fd >= 0)
+                    close(fd);
+
+                return;
+            }
+
+            std::set<std::string> changed;
+            alignas(inotify_event) char buffer[4096];
+
+            while (!m_bStopping) {
+                pollfd pfd{ fd, POLLIN, 0 };
+
+                // Editors often write a file more than once per save: once events stop for 50ms the batch is compiled
+                const int ready = poll(&pfd, 1, changed.empty() ? 100 : 50);
+
+                if (ready > 0) {
+                    for (ssize_t length; (length = read(fd, buffer, sizeof(buffer))) > 0;) {
+                        for (ssize_t offset = 0; offset < length;) {
+                            const inotify_event* pEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+                            if (pEvent->len > 0 && IsShaderSource(pEvent->name))
+                                changed.insert(pEvent->name);
+
+                            offset += sizeof(inotify_event) + pEvent->len;
+                        }
+                    }
+
+                    continue;
+                }
+
+                if (changed.empty())
+                    continue;
+
+                std::set<std::string> compiled;
+                for (const std::string& name : changed)
+                    if (Compile(name))
+                        compiled.insert(name);
+
+                if (!compiled.empty())
+                    m_onCompiled(compiled);
+
+                changed.clear();
+            }
+
+            close(fd);
+        }
+#endif // MC_LINUX
+
+    public:
+        ShaderWatcher() = default;
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+        void Start(const std::string& directory, std::function<void(const std::set<std::string>&)> onCompiled) {
+            Stop();
+
+            m_directory  = directory;
+            m_onCompiled = std::move(onCompiled);
+            m_bStopping  = false;
+
+#ifdef MC_LINUX
+            m_thread = std::thread(&ShaderWatcher::WatchLoop, this);
+#endif // MC_LINUX
+        }
+
+        void Stop() {
+            m_bStopping = true;
+
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+
+        ~ShaderWatcher() { Stop(); }
+    }; // class ShaderWatcher
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+#include "geometry.hpp"
+
+/*
+ * Wide math for the hot paths (culling, physics, bulk transforms).
+ * Every type converts to and from the packed storage types of vector.hpp / matrix.hpp,
+ * and falls back to their constexpr scalar implementations when no SIMD is available.
+ */
+
+namespace mc {
+
+    namespace simd {
+
+        struct alignas(16) vec4 {
+#ifdef MC_SIMD_SSE
+            __m128 v;
+
+            static inline vec4    Load(const vec4f32& s)  { return vec4{ _mm_loadu_ps(&s.x) }; }
+            static inline vec4    Splat(const f32 s)      { return vec4{ _mm_set1_ps(s) };     }
+            inline        vec4f32 Store() const           { vec4f32 s; _mm_storeu_ps(&s.x, v); return s; }
+#else
+            vec4f32 v;
+
+            static inline vec4    Load(const vec4f32& s)  { return vec4{ s };                  }
+            static inline vec4    Splat(const f32 s)      { return vec4{ vec4f32{ s, s, s, s } }; }
+            inline        vec4f32 Store() const           { return v;                          }
+#endif
+        }; // struct vec4
+
+#ifdef MC_SIMD_SSE
+        inline vec4 operator+(const vec4 a, const vec4 b) { return vec4{ _mm_add_ps(a.v, b.v) }; }
+        inline vec4 operator-(const vec4 a, const vec4 b) { return vec4{ _mm_sub_ps(a.v, b.v) }; }
+        inline vec4 operator*(const vec4 a, const vec4 b) { return vec4{ _mm_mul_ps(a.v, b.v) }; }
+        inline vec4 operator*(const vec4 a, const f32 s)  { return vec4{ _mm_mul_ps(a.v, _mm_set1_ps(s)) }; }
+        inline vec4 Min(const vec4 a, const vec4 b)       { return vec4{ _mm_min_ps(a.v, b.v) }; }
+        inline vec4 Max(const vec4 a, const vec4 b)       { return vec4{ _mm_max_ps(a.v, b.v) }; }
+
+        inline f32 Dot(const vec4 a, const vec4 b) {
+            const __m128 m    = _mm_mul_ps(a.v, b.v);
+            const __m128 shuf = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 sums = _mm_add_ps(m, shuf);
+
+            return _mm_cvtss_f32(_mm_add_ss(sums, _mm_movehl_ps(shuf, sums)));
+        }
+
+        template <int I>
+        inline vec4 Broadcast(const vec4 a) { return vec4{ _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(I, I, I, I)) }; }
+#else
+        inline vec4 operator+(const vec4 a, const vec4 b) { return vec4{ a.v + b.v }; }
+        inline vec4 operator-(const vec4 a, const vec4 b) { return vec4{ a.v - b.v }; }
+        inline vec4 operator*(const vec4 a, const vec4 b) { return vec4{ a.v * b.v }; }
+        inline vec4 operator*(const vec4 a, const f32 s)  { return vec4{ a.v * s   }; }
+        inline vec4 Min(const vec4 a, const vec4 b)       { return vec4{ vec4f32{ std::min(a.v.x, b.v.x), std::min(a.v.y, b.v.y), std::min(a.v.z, b.v.z), std::min(a.v.w, b.v.w) } }; }
+        inline vec4 Max(const vec4 a, const vec4 b)       { return vec4{ vec4f32{ std::max(a.v.x, b.v.x), std::max(a.v.y, b.v.y), std::max(a.v.z, b.v.z), std::max(a.v.w, b.v.w) } }; }
+
+        inline f32 Dot(const vec4 a, const vec4 b) { return mc::Dot(a.v, b.v); }
+
+        template <int I>
+        inline vec4 Broadcast(const vec4 a) { const f32 s = (&a.v.x)[I]; return vec4::Splat(s); }
+#endif
+
+        struct alignas(32) mat4 {
+            vec4 columns[4];
+
+            static inline mat4 Load(const mat4f32& m) {
+                return mat4{ { vec4::Load(m.columns[0]), vec4::Load(m.columns[1]), vec4::Load(m.columns[2]), vec4::Load(m.columns[3]) } };
+            }
+
+            inline mat4f32 Store() const {
+                return mat4f32{ { columns[0].Store(), columns[1].Store(), columns[2].Store(), columns[3].Store() } };
+            }
+        }; // struct mat4
+
+        inline vec4 operator*(const mat4& m, const vec4 v) {
+            return m.columns[0] * Broadcast<0>(v) + m.columns[1] * Broadcast<1>(v) + m.columns[2] * Broadcast<2>(v) + m.columns[3] * Broadcast<3>(v);
+        }
+
+        inline mat4 operator*(const mat4& a, const mat4& b) {
+            mat4 r;
+
+#ifdef MC_SIMD_AVX
+            // Two result columns per iteration: each 128 bit lane holds one column of b
+            const __m256 a0 = _mm256_broadcast_ps(&a.columns[0].v);
+            const __m256 a1 = _mm256_broadcast_ps(&a.columns[1].v);
+            const __m256 a2 = _mm256_broadcast_ps(&a.columns[2].v);
+            const __m256 a3 = _mm256_broadcast_ps(&a.columns[3].v);
+
+            for (int i = 0; i < 4; i += 2) {
+                const __m256 bb = _mm256_load_ps(reinterpret_cast<const f32*>(&b.columns[i]));
+
+                __m256 c = _mm256_mul_ps(a0, _mm256_permute_ps(bb, 0x00));
+                c = _mm256_add_ps(c, _mm256_mul_ps(a1, _mm256_permute_ps(bb, 0x55)));
+                c = _mm256_add_ps(c, _mm256_mul_ps(a2, _mm256_permute_ps(bb, 0xAA)));
+                c = _mm256_add_ps(c, _mm256_mul_ps(a3, _mm256_permute_ps(bb, 0xFF)));
+
+                _mm256_store_ps(reinterpret_cast<f32*>(&r.columns[i]), c);
+            }
+#else
+            for (int i = 0; i < 4; ++i)
+                r.columns[i] = a * b.columns[i];
+#endif
+
+            return r;
+        }
+
+        inline mat4 Transpose(const mat4& src) {
+            mat4 m = src;
+
+#ifdef MC_SIMD_SSE
+            _MM_TRANSPOSE4_PS(m.columns[0].v, m.columns[1].v, m.columns[2].v, m.columns[3].v);
+
+            return m;
+#else
+            return mat4::Load(mc::Transpose(m.Store()));
+#endif
+        }
+
+        /*
+         * Eight lanes of f32, the building block of the SoA batch types.
+         * One __m256 with AVX, a pair of __m128 with SSE, a plain array otherwise.
+         */
+        namespace details {
+#if defined(MC_SIMD_AVX)
+            struct f32x8 { __m256 v; };
+
+            inline f32x8 Load8(const f32* p)                 { return f32x8{ _mm256_load_ps(p) }; }
+            inline void  Store8(f32* p, const f32x8 a)       { _mm256_store_ps(p, a.v); }
+            inline f32x8 Splat8(const f32 s)                 { return f32x8{ _mm256_set1_ps(s) }; }
+            inline f32x8 Add8(const f32x8 a, const f32x8 b)  { return f32x8{ _mm256_add_ps(a.v, b.v) }; }
+            inline f32x8 Mul8(const f32x8 a, const f32x8 b)  { return f32x8{ _mm256_mul_ps(a.v, b.v) }; }
+            inline u32   MaskLE8(const f32x8 a, const f32x8 b) { return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ))); }
+            inline u32   MaskLT8(const f32x8 a, const f32x8 b) { return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))); }
+#elif defined(MC_SIMD_SSE)
+            struct f32x8 { __m128 lo, hi; };
+
+            inline f32x8 Load8(const f32* p)                 { return f32x8{ _mm_load_ps(p), _mm_load_ps(p + 4) }; }
+            inline void  Store8(f32* p, const f32x8 a)       { _mm_store_ps(p, a.lo); _mm_store_ps(p + 4, a.hi); }
+            inline f32x8 Splat8(const f32 s)                 { return f32x8{ _mm_set1_ps(s), _mm_set1_ps(s) }; }
+            inline f32x8 Add8(const f32x8 a, const f32x8 b)  { return f32x8{ _mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi) }; }
+            inline f32x8 Mul8(const f32x8 a, const f32x8 b)  { return f32x8{ _mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi) }; }
+            inline u32   MaskLE8(const f32x8 a, const f32x8 b) { return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(a.lo, b.lo)) | (_mm_movemask_ps(_mm_cmple_ps(a.hi, b.hi)) << 4)); }
+            inline u32   MaskLT8(const f32x8 a, const f32x8 b) { return static_cast<u32>(_mm_movemask_ps(_mm_cmplt_ps(a.lo, b.lo)) | (_mm_movemask_ps(_mm_cmplt_ps(a.hi, b.hi)) << 4)); }
+#else
+            struct f32x8 { std::array<f32, 8> v; };
+
+            inline f32x8 Load8(const f32* p)                 { f32x8 r; std::copy(p, p + 8, r.v.begin()); return r; }
+            inline void  Store8(f32* p, const f32x8 a)       { std::copy(a.v.begin(), a.v.end(), p); }
+            inline f32x8 Splat8(const f32 s)                 { f32x8 r; r.v.fill(s); return r; }
+            inline f32x8 Add8(const f32x8 a, const f32x8 b)  { f32x8 r; for (int i = 0; i < 8; ++i) r.v[i] = a.v[i] + b.v[i]; return r; }
+            inline f32x8 Mul8(const f32x8 a, const f32x8 b)  { f32x8 r; for (int i = 0; i < 8; ++i) r.v[i] = a.v[i] * b.v[i]; return r; }
+            inline u32   MaskLE8(const f32x8 a, const f32x8 b) { u32 m = 0; for (int i = 0; i < 8; ++i) m |= (a.v[i] <= b.v[i]) << i; return m; }
+            inline u32   MaskLT8(const f32x8 a, const f32x8 b) { u32 m = 0; for (int i = 0; i < 8; ++i) m |= (a.v[i] <  b.v[i]) << i; return m; }
+#endif
+        }; // namespace details
+
+        struct alignas(32) vec3x8 {
+            f32 x[8];
+            f32 y[8];
+            f32 z[8];
+
+            inline void Set(const u32 lane, const vec3f32& v) { x[lane] = v.x; y[lane] = v.y; z[lane] = v.z; }
+            inline vec3f32 Get(const u32 lane) const          { return vec3f32{ x[lane], y[lane], z[lane] }; }
+        }; // struct vec3x8
+
+        struct alignas(32) AABBx8 {
+            vec3x8 min;
+            vec3x8 max;
+
+            inline void Set(const u32 lane, const AABBf32& box) { min.Set(lane, box.min); max.Set(lane, box.max); }
+        }; // struct AABBx8
+
+        // Transforms eight points (w = 1) at once, without perspective divide
+        inline void TransformPoints(const mat4f32& m, const vec3x8& in, vec3x8& out) {
+            using namespace details;
+
+            const f32x8 x = Load8(in.x), y = Load8(in.y), z = Load8(in.z);
+
+            const auto Row = [&](const int r) {
+                const f32* c0 = &m.columns[0].x; const f32* c1 = &m.columns[1].x;
+                const f32* c2 = &m.columns[2].x; const f32* c3 = &m.columns[3].x;
+
+                return Add8(Add8(Mul8(x, Splat8(c0[r])), Mul8(y, Splat8(c1[r]))), Add8(Mul8(z, Splat8(c2[r])), Splat8(c3[r])));
+            };
+
+            Store8(out.x, Row(0));
+            Store8(out.y, Row(1));
+            Store8(out.z, Row(2));
+        }
+
+        // Bit i of the result is set when boxes[i] overlaps the query box
+        inline u32 Overlaps(const AABBx8& boxes, const AABBf32& query) {
+            using namespace details;
+
+            return MaskLT8(Load8(boxes.min.x), Splat8(query.max.x)) & MaskLT8(Splat8(query.min.x), Load8(boxes.max.x))
+                 & MaskLT8(Load8(boxes.min.y), Splat8(query.max.y)) & MaskLT8(Splat8(query.min.y), Load8(boxes.max.y))
+                 & MaskLT8(Load8(boxes.min.z), Splat8(query.max.z)) & MaskLT8(Splat8(query.min.z), Load8(boxes.max.z));
+        }
+
+        // Bit i of the result is set when boxes[i] is at least partially inside the frustum
+        inline u32 Intersects(const Frustumf32& frustum, const AABBx8& boxes) {
+            using namespace details;
+
+            u32 mask = 0xFF;
+            for (const vec4f32& plane : frustum.planes) {
+                // The plane is shared by all lanes, so picking the "positive vertex" is a per plane choice
+                const f32x8 px = Load8(plane.x >= 0.f ? boxes.max.x : boxes.min.x);
+                const f32x8 py = Load8(plane.y >= 0.f ? boxes.max.y : boxes.min.y);
+                const f32x8 pz = Load8(plane.z >= 0.f ? boxes.max.z : boxes.min.z);
+
+                const f32x8 distance = Add8(Add8(Mul8(px, Splat8(plane.x)), Mul8(py, Splat8(plane.y))), Add8(Mul8(pz, Splat8(plane.z)), Splat8(plane.w)));
+
+                mask &= MaskLE8(Splat8(0.f), distance);
+            }
+
+            return mask;
+        }
+
+    }; // namespace simd
+
+}; // namespace mc
\ No newline at end of file
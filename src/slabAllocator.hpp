@@ -0,0 +1,338 @@
+#pragma once
+
+#include "header.hpp"
+
+#ifndef _WIN32
+#   include <sys/mman.h>
+#endif // _WIN32
+
+/*
+ * Fixed size blocks carved from 2 MiB slabs, for what is allocated and freed all the time at one
+ * size: chunk sections as chunks load and unload, meshing scratch. A slab is one huge page where the
+ * system gives them (mmap and MADV_HUGEPAGE), so sections walked together share TLB entries and a slab
+ * faults in at once rather than a page at a time. Slabs are kept for reuse, never given back.
+ *
+ * Each thread keeps a cache of free blocks per block size, so allocating and freeing touch no lock
+ * nor shared cache line; the pool's mutex is only taken to move blocks between the pool and a cache
+ * in batches. A block freed on another thread than the one that allocated it goes to the cache of
+ * the freeing thread.
+ */
+
+namespace mc {
+
+    struct SlabStats {
+        std::size_t blockSize    = 0;
+        std::size_t slabs        = 0;
+        std::size_t capacity     = 0; // Blocks the slabs hold
+        std::size_t used         = 0; // Blocks allocated and not freed yet
+        std::size_t threadCached = 0; // Free blocks sitting in the threads' caches
+    }; // struct SlabStats
+
+    class SlabPool {
+    public:
+        static constexpr std::size_t SLAB_BYTES  = std::size_t{ 2 } << 20;
+        static constexpr std::size_t BLOCK_ALIGN = 64; // Blocks never share a cache line
+        static constexpr u32         BATCH       = 32; // Blocks moved between the pool and a thread cache at once
+
+        struct FreeBlock {
+            FreeBlock* pNext;
+        }; // struct FreeBlock
+
+    private:
+        std::size_t m_blockSize;
+
+        mutable std::mutex m_mutex;
+        FreeBlock*         m_pFree = nullptr;
+        std::vector<char*> m_slabs;
+        char*              m_pCarve    = nullptr; // Blocks of the newest slab are carved as needed, its pages fault in on first use
+        char*              m_pCarveEnd = nullptr;
+        std::size_t        m_outside   = 0; // Blocks handed to the thread caches, in use or not
+
+        std::atomic<std::size_t> m_used{ 0 };
+
+        // Pools are never destroyed: blocks can be freed by static destructors running after them
+        static std::mutex& GetRegistryMutex() { static std::mutex& mutex = *new std::mutex; return mutex; }
+        static std::vector<SlabPool*>& GetRegistry() { static std::vector<SlabPool*>& registry = *new std::vector<SlabPool*>; return registry; }
+
+        static char* MapSlab() {
+#ifdef _WIN32
+            // Large pages need a privilege users rarely have, so regular pages on Windows
+            void* const p = VirtualAlloc(nullptr, SLAB_BYTES, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+            if (!p)
+                throw std::bad_alloc();
+
+            return static_cast<char*>(p);
+#else
+            // Twice the size, then trimmed to a slab aligned on a huge page boundary
+            void* const p = mmap(nullptr, SLAB_BYTES * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+
+            char* const pBase    = static_cast<char*>(p);
+            char* const pAligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(pBase) + SLAB_BYTES - 1) & ~(SLAB_BYTES - 1));
+
+            if (pAligned != pBase)
+                munmap(pBase, static_cast<std::size_t>(pAligned - pBase));
+
+            munmap(pAligned + SLAB_BYTES, static_cast<std::size_t>(pBase + SLAB_BYTES * 2 - (pAligned + SLAB_BYTES)));
+
+#   ifdef MADV_HUGEPAGE
+            madvise(pAligned, SLAB_BYTES, MADV_HUGEPAGE); // Only a hint, fine to fail
+#   endif // MADV_HUGEPAGE
+
+            return pAligned;
+#endif // _WIN32
+        }
+
+        explicit SlabPool(const std::size_t blockSize)
+            : m_blockSize(blockSize)
+        {
+            std::lock_guard<std::mutex> lock(GetRegistryMutex());
+            GetRegistry().push_back(this);
+        }
+
+    public:
+        static constexpr std::size_t GetBlockSize(const std::size_t size) { return (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1); }
+
+        // The pool of a block size, shared by every type rounding up to it
+        template <std::size_t BLOCK_SIZE>
+        static SlabPool& Get() {
+            static_assert(BLOCK_SIZE % BLOCK_ALIGN == 0 && BLOCK_SIZE <= SLAB_BYTES, "Not a slab block size");
+
+            static SlabPool& pool = *new SlabPool(BLOCK_SIZE);
+            return pool;
+        }
+
+        SlabPool(const SlabPool&) = delete;
+        SlabPool& operator=(const SlabPool&) = delete;
+
+        // Up to BATCH free blocks for a thread cache, linked, mapping a slab when none is left
+        FreeBlock* TakeBatch(u32& count) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            FreeBlock* pHead = nullptr;
+            count = 0;
+
+            while (count < BATCH && m_pFree) {
+                FreeBlock* const pBlock = m_pFree;
+                m_pFree = pBlock->pNext;
+
+                pBlock->pNext = pHead;
+                pHead = pBlock;
+                ++count;
+            }
+
+            while (count < BATCH) {
+                if (static_cast<std::size_t>(m_pCarveEnd - m_pCarve) < m_blockSize) {
+                    if (count > 0)
+                        break;
+
+                    m_pCarve    = MapSlab();
+                    m_pCarveEnd = m_pCarve + SLAB_BYTES;
+                    m_slabs.push_back(m_pCarve);
+                }
+
+                FreeBlock* const pBlock = reinterpret_cast<FreeBlock*>(m_pCarve);
+                m_pCarve += m_blockSize;
+
+                pBlock->pNext = pHead;
+                pHead = pBlock;
+                ++count;
+            }
+
+            m_outside += count;
+
+            return pHead;
+        }
+
+        void GiveBatch(FreeBlock* const pHead, FreeBlock* const pTail, const u32 count) {
+            if (count == 0)
+                return;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            pTail->pNext = m_pFree;
+            m_pFree      = pHead;
+            m_outside   -= count;
+        }
+
+        inline void OnAllocated() { m_used.fetch_add(1, std::memory_order_relaxed); }
+        inline void OnFreed()     { m_used.fetch_sub(1, std::memory_order_relaxed); }
+
+        SlabStats GetStats() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            SlabStats stats;
+            stats.blockSize    = m_blockSize;
+            stats.slabs        = m_slabs.size();
+            stats.capacity     = m_slabs.size() * (SLAB_BYTES / m_blockSize);
+            stats.used         = m_used.load(std::memory_order_relaxed);
+            stats.threadCached = m_outside - std::min(m_outside, stats.used);
+
+            return stats;
+        }
+
+        // Every pool made so far, by block size
+        static std::vector<SlabStats> GetAllStats() {
+            std::vector<SlabStats> stats;
+
+            {
+                std::lock_guard<std::mutex> lock(GetRegistryMutex());
+
+                for (const SlabPool* pPool : GetRegistry())
+                    stats.push_back(pPool->GetStats());
+            }
+
+            std::sort(stats.begin(), stats.end(), [](const SlabStats& a, const SlabStats& b) { return a.blockSize < b.blockSize; });
+
+            return stats;
+        }
+    }; // class SlabPool
+
+    // The calling thread's free blocks for one block size
+    template <std::size_t BLOCK_SIZE>
+    class SlabCache {
+    private:
+        static constexpr u32 MAX_CACHED = SlabPool::BATCH * 2;
+
+        struct State {
+            SlabPool::FreeBlock* pHead = nullptr;
+            u32                  count = 0;
+            bool                 bGone = false; // Past the thread's exit flush, frees go straight to the pool
+        }; // struct State
+
+        // Gives the cached blocks back when the thread exits. State has no destructor of its own so
+        // that frees made later in the thread's teardown still find it
+        struct Flusher {
+            ~Flusher() {
+                Flush(s_state.count);
+                s_state.bGone = true;
+            }
+        }; // struct Flusher
+
+        static thread_local State   s_state;
+        static thread_local Flusher s_flusher;
+
+    private:
+        static void Flush(const u32 count) {
+            if (count == 0)
+                return;
+
+            SlabPool::FreeBlock* const pHead = s_state.pHead;
+            SlabPool::FreeBlock*       pTail = pHead;
+
+            for (u32 i = 1; i < count; ++i)
+                pTail = pTail->pNext;
+
+            s_state.pHead  = pTail->pNext;
+            s_state.count -= count;
+
+            SlabPool::Get<BLOCK_SIZE>().GiveBatch(pHead, pTail, count);
+        }
+
+    public:
+        static void* Allocate() {
+            SlabPool& pool = SlabPool::Get<BLOCK_SIZE>();
+
+            if (!s_state.pHead) {
+                (void)&s_flusher; // Registers the exit flush on the thread's first refill
+
+                u32 count;
+                s_state.pHead = pool.TakeBatch(count);
+                s_state.count = count;
+            }
+
+            SlabPool::FreeBlock* const pBlock = s_state.pHead;
+            s_state.pHead = pBlock->pNext;
+            --s_state.count;
+
+            pool.OnAllocated();
+
+            return pBlock;
+        }
+
+        static void Deallocate(void* const p) noexcept {
+            SlabPool& pool = SlabPool::Get<BLOCK_SIZE>();
+            pool.OnFreed();
+
+            SlabPool::FreeBlock* const pBlock = static_cast<SlabPool::FreeBlock*>(p);
+
+            if (s_state.bGone) {
+                pool.GiveBatch(pBlock, pBlock, 1);
+                return;
+            }
+
+            if (!s_state.pHead)
+                (void)&s_flusher; // A thread may free blocks before it ever allocates one
+
+            pBlock->pNext = s_state.pHead;
+            s_state.pHead = pBlock;
+
+            if (++s_state.count > MAX_CACHED)
+                Flush(SlabPool::BATCH);
+        }
+    }; // class SlabCache
+
+    template <std::size_t BLOCK_SIZE>
+    thread_local typename SlabCache<BLOCK_SIZE>::State SlabCache<BLOCK_SIZE>::s_state;
+
+    template <std::size_t BLOCK_SIZE>
+    thread_local typename SlabCache<BLOCK_SIZE>::Flusher SlabCache<BLOCK_SIZE>::s_flusher;
+
+    // For the standard containers and std::allocate_shared: single objects come from the slabs, arrays from the heap
+    template <typename T>
+    class SlabAllocator {
+    private:
+        static_assert(alignof(T) <= SlabPool::BLOCK_ALIGN, "Slab blocks are only aligned on cache lines");
+
+        using Cache = SlabCache<SlabPool::GetBlockSize(sizeof(T))>;
+
+    public:
+        using value_type = T;
+
+        SlabAllocator() noexcept = default;
+
+        template <typename U>
+        SlabAllocator(const SlabAllocator<U>&) noexcept { }
+
+        T* allocate(const std::size_t n) {
+            return n == 1 ? static_cast<T*>(Cache::Allocate()) : static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* const p, const std::size_t n) noexcept {
+            if (n == 1)
+                Cache::Deallocate(p);
+            else
+                ::operator delete(p);
+        }
+
+        template <typename U> bool operator==(const SlabAllocator<U>&) const noexcept { return true;  }
+        template <typename U> bool operator!=(const SlabAllocator<U>&) const noexcept { return false; }
+    }; // class SlabAllocator
+
+    template <typename T>
+    struct SlabDelete {
+        void operator()(T* const p) const noexcept {
+            p->~T();
+            SlabAllocator<T>{}.deallocate(p, 1);
+        }
+    }; // struct SlabDelete
+
+    template <typename T>
+    using SlabPtr = std::unique_ptr<T, SlabDelete<T>>;
+
+    template <typename T, typename... Args>
+    SlabPtr<T> MakeSlab(Args&&... args) {
+        T* const p = SlabAllocator<T>{}.allocate(1);
+
+        try {
+            return SlabPtr<T>(new (p) T(std::forward<Args>(args)...));
+        } catch (...) {
+            SlabAllocator<T>{}.deallocate(p, 1);
+            throw;
+        }
+    }
+
+}; // namespace mc
\ No newline at end of file
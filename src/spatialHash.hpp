@@ -0,0 +1,119 @@
+#pragma once
+
+#include "header.hpp"
+#include "geometry.hpp"
+
+/*
+ * Uniform grid broadphase, rebuilt from scratch every tick.
+ * Entities are bucketed by the cell of their center with a counting sort, and their
+ * boxes are copied into SoA arrays so queries stream through memory.
+ */
+
+namespace mc {
+
+    class SpatialHash {
+    private:
+        f32 m_cellSize    = 1.f;
+        f32 m_invCellSize = 1.f;
+        f32 m_maxHalfExtent = 0.f;
+
+        u32 m_bucketMask = 0;
+
+        std::vector<u32> m_bucketStart; // Bucket b owns m_sorted[m_bucketStart[b], m_bucketStart[b + 1])
+        std::vector<u32> m_sorted;      // Entity indices grouped by bucket
+        std::vector<u32> m_entityBucket;
+
+        std::vector<f32> m_minX, m_minY, m_minZ;
+        std::vector<f32> m_maxX, m_maxY, m_maxZ;
+
+    private:
+        inline i32 ToCell(const f32 v) const { return static_cast<i32>(std::floor(v * m_invCellSize)); }
+
+        inline u32 Bucket(const i32 x, const i32 y, const i32 z) const {
+            const u32 h = static_cast<u32>(x) * 73856093u ^ static_cast<u32>(y) * 19349663u ^ static_cast<u32>(z) * 83492791u;
+
+            return h & m_bucketMask;
+        }
+
+    public:
+        void Build(const std::size_t count, const vec3f32* pPositions, const vec3f32* pHalfExtents, const f32 cellSize) {
+            m_cellSize    = cellSize;
+            m_invCellSize = 1.f / cellSize;
+
+            u32 bucketCount = 1;
+            while (bucketCount < count * 2)
+                bucketCount <<= 1;
+            m_bucketMask = bucketCount - 1;
+
+            m_bucketStart.assign(bucketCount + 1, 0);
+            m_sorted.resize(count);
+            m_entityBucket.resize(count);
+
+            m_minX.resize(count); m_minY.resize(count); m_minZ.resize(count);
+            m_maxX.resize(count); m_maxY.resize(count); m_maxZ.resize(count);
+
+            m_maxHalfExtent = 0.f;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const vec3f32& p = pPositions[i];
+                const vec3f32& e = pHalfExtents[i];
+
+                m_minX[i] = p.x - e.x; m_minY[i] = p.y - e.y; m_minZ[i] = p.z - e.z;
+                m_maxX[i] = p.x + e.x; m_maxY[i] = p.y + e.y; m_maxZ[i] = p.z + e.z;
+
+                m_maxHalfExtent = std::max({ m_maxHalfExtent, e.x, e.y, e.z });
+
+                const u32 bucket = Bucket(ToCell(p.x), ToCell(p.y), ToCell(p.z));
+                m_entityBucket[i] = bucket;
+                ++m_bucketStart[bucket + 1];
+            }
+
+            std::partial_sum(m_bucketStart.begin(), m_bucketStart.end(), m_bucketStart.begin());
+
+            std::vector<u32> cursor(m_bucketStart.begin(), m_bucketStart.end() - 1);
+            for (std::size_t i = 0; i < count; ++i)
+                m_sorted[cursor[m_entityBucket[i]]++] = static_cast<u32>(i);
+        }
+
+        inline AABBf32 GetBox(const u32 i) const {
+            return AABBf32{ vec3f32{ m_minX[i], m_minY[i], m_minZ[i] }, vec3f32{ m_maxX[i], m_maxY[i], m_maxZ[i] } };
+        }
+
+        // Calls f(index) for every entity whose box overlaps the query box (the entity owning the query included)
+        template <typename F>
+        void Query(const AABBf32& box, F&& f) const {
+            // Entities are bucketed by center, so reach out by the largest half extent
+            const i32 x0 = ToCell(box.min.x - m_maxHalfExtent), x1 = ToCell(box.max.x + m_maxHalfExtent);
+            const i32 y0 = ToCell(box.min.y - m_maxHalfExtent), y1 = ToCell(box.max.y + m_maxHalfExtent);
+            const i32 z0 = ToCell(box.min.z - m_maxHalfExtent), z1 = ToCell(box.max.z + m_maxHalfExtent);
+
+            // Distinct cells can share a bucket: visit each bucket once.
+            // Queries are expected to span a few cells, past 64 buckets an entity may be reported twice.
+            std::array<u32, 64> visited;
+            u32 visitedCount = 0;
+
+            for (i32 y = y0; y <= y1; ++y) {
+                for (i32 z = z0; z <= z1; ++z) {
+                    for (i32 x = x0; x <= x1; ++x) {
+                        const u32 bucket = Bucket(x, y, z);
+
+                        if (std::find(visited.begin(), visited.begin() + visitedCount, bucket) != visited.begin() + visitedCount)
+                            continue;
+                        if (visitedCount < visited.size())
+                            visited[visitedCount++] = bucket;
+
+                        for (u32 s = m_bucketStart[bucket]; s < m_bucketStart[bucket + 1]; ++s) {
+                            const u32 i = m_sorted[s];
+
+                            if (m_minX[i] < box.max.x && m_maxX[i] > box.min.x
+                             && m_minY[i] < box.max.y && m_maxY[i] > box.min.y
+                             && m_minZ[i] < box.max.z && m_maxZ[i] > box.min.z)
+                                f(i);
+                        }
+                    }
+                }
+            }
+        }
+    }; // class SpatialHash
+
+}; // namespace mc
\ No newline at end of file
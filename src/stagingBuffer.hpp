@@ -0,0 +1,95 @@
+#pragma once
+
+#include "header.hpp"
+#include "gpuMemory.hpp"
+#include "vulkanUtils.hpp"
+
+/*
+ * A persistently mapped, host visible buffer used as the source of vkCmdCopyBuffer uploads.
+ * Space is handed out linearly and recycled all at once with Reset(), once the GPU is done
+ * with every copy recorded from it.
+ */
+
+namespace mc {
+
+	class StagingBuffer {
+	private:
+		vk::Buffer       m_buffer;
+		vk::DeviceMemory m_memory;
+
+		vk::Device m_device;
+
+		mc::u8*        m_mapped   = nullptr;
+		vk::DeviceSize m_capacity = 0;
+		vk::DeviceSize m_offset   = 0;
+
+	public:
+		StagingBuffer() = default;
+
+		StagingBuffer(StagingBuffer&& other) noexcept {
+			*this = std::move(other);
+		}
+
+		StagingBuffer(const vk::Device& device, const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const vk::DeviceSize capacity)
+			: m_device(device), m_capacity(capacity)
+		{
+			vk::BufferCreateInfo bci{};
+			bci.size        = m_capacity;
+			bci.usage       = vk::BufferUsageFlagBits::eTransferSrc;
+			bci.sharingMode = vk::SharingMode::eExclusive;
+
+			m_buffer = m_device.createBuffer(bci);
+
+			const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(m_buffer);
+
+			vk::MemoryAllocateInfo allocationInfo{};
+			allocationInfo.allocationSize  = requirements.size;
+			allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+			m_memory = mc::GpuMemory::Allocate(m_device, allocationInfo);
+
+			m_device.bindBufferMemory(m_buffer, m_memory, 0);
+
+			m_mapped = static_cast<mc::u8*>(m_device.mapMemory(m_memory, 0, VK_WHOLE_SIZE));
+		}
+
+		StagingBuffer& operator=(StagingBuffer&& other) noexcept {
+			std::swap(m_buffer,   other.m_buffer);
+			std::swap(m_memory,   other.m_memory);
+			std::swap(m_device,   other.m_device);
+			std::swap(m_mapped,   other.m_mapped);
+			std::swap(m_capacity, other.m_capacity);
+			std::swap(m_offset,   other.m_offset);
+
+			return *this;
+		}
+
+		// Copies size bytes in and returns their offset in the buffer, or nothing when full
+		std::optional<vk::DeviceSize> Push(const void* pData, const vk::DeviceSize size) {
+			if (m_offset + size > m_capacity)
+				return {};
+
+			const vk::DeviceSize offset = m_offset;
+
+			std::memcpy(m_mapped + offset, pData, static_cast<std::size_t>(size));
+			m_offset += size;
+
+			return offset;
+		}
+
+		inline void Reset() noexcept { m_offset = 0; }
+
+		inline const vk::Buffer& GetHandle()   const noexcept { return m_buffer;   }
+		inline vk::DeviceSize    GetCapacity() const noexcept { return m_capacity; }
+		inline vk::DeviceSize    GetUsed()     const noexcept { return m_offset;   }
+
+		~StagingBuffer() {
+			if ((VkDevice)m_device != VK_NULL_HANDLE) {
+				m_device.unmapMemory(m_memory);
+				mc::GpuMemory::Free(m_device, m_memory);
+				m_device.destroyBuffer(m_buffer);
+			}
+		}
+	}; // class StagingBuffer
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "header.hpp"
+#include "timer.hpp"
+#include "gpuTimeline.hpp"
+#include "vulkanUtils.hpp"
+
+/*
+ * Measures what the CPU pays to submit work and to wait for it, with fences and with timeline
+ * semaphores, on a device of its own so no window is needed. Submissions are empty command buffers
+ * kept MC_DEFAULT_FRAMES_IN_FLIGHT deep like the renderer's frames: what is timed is the synchronization,
+ * not the GPU's work. No validation layer is enabled, it would dwarf the difference.
+ */
+
+namespace mc {
+
+    struct SubmitBenchmarkResult {
+        GpuTimelineMode mode;
+        u32             submissions = 0;
+        u64             submitNS    = 0; // Submitting, and polling the completed value as a frame does to release resources
+        u64             waitNS      = 0; // Waiting for the submission MC_DEFAULT_FRAMES_IN_FLIGHT before
+    }; // struct SubmitBenchmarkResult
+
+    class SubmitBenchmark {
+    private:
+        vk::Instance       m_instance;
+        vk::PhysicalDevice m_physical;
+        vk::Device         m_device;
+        vk::Queue          m_queue;
+        u32                m_queueFamily         = 0;
+        bool               m_bTimelineSemaphores = false;
+
+    private:
+        static std::optional<u32> FindGraphicsQueueFamily(const vk::PhysicalDevice& physical) {
+            const std::vector<vk::QueueFamilyProperties> families = physical.getQueueFamilyProperties();
+
+            for (u32 i = 0; i < families.size(); ++i)
+                if (families[i].queueCount > 0 && (families[i].queueFlags & vk::QueueFlagBits::eGraphics))
+                    return i;
+
+            return {};
+        }
+
+    public:
+        SubmitBenchmark() {
+            const bool bInstance12 = vk::enumerateInstanceVersion() >= MC_VULKAN_TIMELINE_VERSION;
+
+            vk::ApplicationInfo appInfo{};
+            appInfo.apiVersion         = bInstance12 ? MC_VULKAN_TIMELINE_VERSION : MC_VULKAN_VERSION;
+            appInfo.applicationVersion = MC_APPLICATION_VERSION;
+            appInfo.engineVersion      = MC_APPLICATION_VERSION;
+            appInfo.pApplicationName   = "Minecraft submit benchmark";
+            appInfo.pEngineName        = "F. Weiss <3";
+
+            vk::InstanceCreateInfo instanceCI{};
+            instanceCI.pApplicationInfo = &appInfo;
+
+            m_instance = vk::createInstance(instanceCI);
+
+            // The first device with a graphics queue, unless a later one also has timeline semaphores
+            for (const vk::PhysicalDevice& physical : m_instance.enumeratePhysicalDevices()) {
+                const std::optional<u32> family = FindGraphicsQueueFamily(physical);
+                if (!family.has_value())
+                    continue;
+
+                const bool bTimeline = bInstance12 && mc::vk_utils::SupportsTimelineSemaphores(physical);
+
+                if (!m_physical || (bTimeline && !m_bTimelineSemaphores)) {
+                    m_physical            = physical;
+                    m_queueFamily         = family.value();
+                    m_bTimelineSemaphores = bTimeline;
+                }
+            }
+
+            if (!m_physical)
+                throw std::runtime_error("No Vulkan device with a graphics queue was found");
+
+            const f32 priority = 1.f;
+
+            vk::DeviceQueueCreateInfo dqci{};
+            dqci.queueFamilyIndex = m_queueFamily;
+            dqci.queueCount       = 1;
+            dqci.pQueuePriorities = &priority;
+
+            vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+            timelineFeatures.timelineSemaphore = VK_TRUE;
+
+            vk::DeviceCreateInfo deviceCI{};
+            deviceCI.pNext                = m_bTimelineSemaphores ? &timelineFeatures : nullptr;
+            deviceCI.queueCreateInfoCount = 1;
+            deviceCI.pQueueCreateInfos    = &dqci;
+
+            m_device = m_physical.createDevice(deviceCI);
+            m_queue  = m_device.getQueue(m_queueFamily, 0);
+        }
+
+        SubmitBenchmark(const SubmitBenchmark&) = delete;
+        SubmitBenchmark& operator=(const SubmitBenchmark&) = delete;
+
+        inline bool        SupportsTimelineSemaphores() const { return m_bTimelineSemaphores; }
+        inline std::string GetDeviceName()              const { return m_physical.getProperties().deviceName.data(); }
+
+        SubmitBenchmarkResult Run(const GpuTimelineMode mode, const u32 submissions) {
+            vk::CommandPoolCreateInfo cpci{};
+            cpci.queueFamilyIndex = m_queueFamily;
+
+            const vk::CommandPool pool = m_device.createCommandPool(cpci);
+
+            vk::CommandBufferAllocateInfo cbai{};
+            cbai.commandPool        = pool;
+            cbai.level              = vk::CommandBufferLevel::ePrimary;
+            cbai.commandBufferCount = MC_DEFAULT_FRAMES_IN_FLIGHT;
+
+            // Recorded once: a buffer is only submitted again after the wait on its previous submission
+            const std::vector<vk::CommandBuffer> cmdBuffs = m_device.allocateCommandBuffers(cbai);
+            for (const vk::CommandBuffer& cmdBuff : cmdBuffs) {
+                cmdBuff.begin(vk::CommandBufferBeginInfo{});
+                cmdBuff.end();
+            }
+
+            SubmitBenchmarkResult result{ mode, submissions, 0, 0 };
+
+            {
+                mc::GpuTimeline timeline(m_device, m_queue, mode);
+                std::array<u64, MC_DEFAULT_FRAMES_IN_FLIGHT> values{};
+
+                for (u32 i = 0; i < submissions; ++i) {
+                    const u32 slot = i % MC_DEFAULT_FRAMES_IN_FLIGHT;
+
+                    const mc::Timer waitTimer;
+                    timeline.Wait(values[slot]);
+                    result.waitNS += waitTimer.GetElapsedNS();
+
+                    vk::SubmitInfo submitInfo{};
+                    submitInfo.commandBufferCount = 1;
+                    submitInfo.pCommandBuffers    = &cmdBuffs[slot];
+
+                    const mc::Timer submitTimer;
+                    values[slot] = timeline.Submit(submitInfo);
+                    timeline.GetCompletedValue();
+                    result.submitNS += submitTimer.GetElapsedNS();
+                }
+
+                timeline.WaitIdle();
+            }
+
+            m_device.destroyCommandPool(pool);
+
+            return result;
+        }
+
+        // Runs both modes, the timeline one only where the device has it
+        static void RunAll(const u32 submissions, std::ostream& out) {
+            SubmitBenchmark benchmark;
+
+            out << "[BENCHMARK] " << submissions << " submissions on " << benchmark.GetDeviceName() << ", " << MC_DEFAULT_FRAMES_IN_FLIGHT << " in flight\n";
+
+            std::vector<GpuTimelineMode> modes = { GpuTimelineMode::eFences };
+            if (benchmark.SupportsTimelineSemaphores())
+                modes.push_back(GpuTimelineMode::eTimeline);
+            else
+                out << "[BENCHMARK] Timeline semaphores are unavailable, only fences are measured\n";
+
+            for (const GpuTimelineMode mode : modes) {
+                const SubmitBenchmarkResult result = benchmark.Run(mode, submissions);
+                const f64 count = static_cast<f64>(std::max(result.submissions, 1u));
+
+                out << "[BENCHMARK] " << std::left << std::setw(9) << (mode == GpuTimelineMode::eTimeline ? "timeline" : "fences") << std::right << std::fixed << std::setprecision(2)
+                    << " submit " << std::setw(8) << static_cast<f64>(result.submitNS) / count / 1000.0 << " us"
+                    << " | wait "  << std::setw(8) << static_cast<f64>(result.waitNS)   / count / 1000.0 << " us\n";
+            }
+
+            out << std::flush;
+        }
+
+        ~SubmitBenchmark() {
+            m_device.waitIdle();
+            m_device.destroy();
+            m_instance.destroy();
+        }
+    }; // class SubmitBenchmark
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "header.hpp"
+#include "timer.hpp"
+
+/*
+ * Tasks run once each, every one as soon as the tasks it depends on are done: what the startup is
+ * made of. They mostly wait, on the driver or on the disk, so they run on a few threads of the
+ * graph's own besides the caller rather than on the pool, whose queue the world generation fills
+ * and which would hold the renderer's tasks behind it. A task with work to split still uses the
+ * pool from within. Tasks marked for the main thread only run on the caller's.
+ *
+ * Each task's start and end are kept. The critical path is the chain of dependencies whose tasks
+ * took the longest together, which no count of threads can start faster than; it is marked on the
+ * printed timeline, so a serial run shows it too.
+ */
+
+namespace mc {
+
+    class TaskGraph {
+    public:
+        using TaskId = u32;
+
+    private:
+        static constexpr u32 MAIN_THREAD = 0; // The caller's index
+        static constexpr u32 BAR_WIDTH   = 48;
+
+        struct Task {
+            std::string           name;
+            std::vector<TaskId>   dependencies;
+            std::vector<TaskId>   dependents;
+            std::function<void()> function;
+            bool                  bMainThread;
+
+            u32  waiting   = 0; // Dependencies not done yet
+            u32  thread    = 0; // The one it ran on
+            u64  startUS   = 0; // Since Run was called
+            u64  endUS     = 0;
+            bool bCritical = false;
+        }; // struct Task
+
+        std::vector<Task> m_tasks;
+        u32               m_threadCount; // Besides the caller
+        bool              m_bSerial = false;
+        u64               m_wallUS  = 0;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+        std::set<TaskId>        m_ready; // The first added go first
+        std::size_t             m_done    = 0;
+        std::size_t             m_running = 0;
+        std::exception_ptr      m_pException;
+
+    private:
+        // Called with the lock held. The main thread takes its own tasks first, as no other can. Nothing
+        // more starts once a task threw
+        std::optional<TaskId> Claim(const bool bMainThread) {
+            if (m_pException)
+                return {};
+
+            for (const bool bOwnOnly : { bMainThread, false }) {
+                for (const TaskId id : m_ready) {
+                    if (m_tasks[id].bMainThread != bMainThread && (bOwnOnly || m_tasks[id].bMainThread))
+                        continue;
+
+                    m_ready.erase(id);
+                    return id;
+                }
+            }
+
+            return {};
+        }
+
+        // Called with the lock held
+        bool IsFinished() const {
+            return m_done == m_tasks.size() || (m_pException && m_running == 0);
+        }
+
+        void RunTasks(const u32 thread, const Timer& clock) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            for (;;) {
+                std::optional<TaskId> id;
+
+                while (!(id = Claim(thread == MAIN_THREAD)).has_value() && !IsFinished())
+                    m_condition.wait(lock);
+
+                if (!id.has_value())
+                    return;
+
+                Task& task = m_tasks[id.value()];
+                task.thread  = thread;
+                task.startUS = clock.GetElapsedUS();
+                ++m_running;
+
+                lock.unlock();
+
+                std::exception_ptr pException;
+
+                try {
+                    task.function();
+                } catch (...) {
+                    pException = std::current_exception();
+                }
+
+                const u64 endUS = clock.GetElapsedUS();
+
+                lock.lock();
+
+                task.endUS = endUS;
+                --m_running;
+                ++m_done;
+
+                if (pException && !m_pException)
+                    m_pException = pException;
+
+                for (const TaskId dependent : task.dependents)
+                    if (--m_tasks[dependent].waiting == 0)
+                        m_ready.insert(dependent);
+
+                m_condition.notify_all();
+            }
+        }
+
+        // Tasks only depend on earlier ones, so one pass in order finds the longest chain ending at each
+        void MarkCriticalPath() {
+            if (m_tasks.empty())
+                return;
+
+            std::vector<u64>    chainUS(m_tasks.size());
+            std::vector<TaskId> previous(m_tasks.size()); // The task itself at the chain's start
+
+            for (TaskId id = 0; id < m_tasks.size(); ++id) {
+                previous[id] = id;
+
+                for (const TaskId dependency : m_tasks[id].dependencies)
+                    if (previous[id] == id || chainUS[dependency] > chainUS[previous[id]])
+                        previous[id] = dependency;
+
+                chainUS[id] = (previous[id] != id ? chainUS[previous[id]] : 0) + m_tasks[id].endUS - m_tasks[id].startUS;
+            }
+
+            TaskId id = static_cast<TaskId>(std::max_element(chainUS.begin(), chainUS.end()) - chainUS.begin());
+
+            for (m_tasks[id].bCritical = true; previous[id] != id; id = previous[id])
+                m_tasks[previous[id]].bCritical = true;
+        }
+
+    public:
+        explicit TaskGraph(const u32 threadCount)
+            : m_threadCount(threadCount)
+        { }
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        // Dependencies are tasks added before, which keeps the graph free of cycles
+        TaskId Add(std::string name, std::vector<TaskId> dependencies, std::function<void()> function, const bool bMainThread = false) {
+            const TaskId id = static_cast<TaskId>(m_tasks.size());
+
+            for (const TaskId dependency : dependencies) {
+                if (dependency >= id)
+                    throw std::runtime_error("Task " + name + " depends on a task added after it");
+
+                m_tasks[dependency].dependents.push_back(id);
+            }
+
+            Task task;
+            task.name         = std::move(name);
+            task.dependencies = std::move(dependencies);
+            task.function     = std::move(function);
+            task.bMainThread  = bMainThread;
+
+            m_tasks.push_back(std::move(task));
+
+            return id;
+        }
+
+        // Returns once every task ran, or rethrows the first exception once the tasks running then are done.
+        // bSerial runs them one after the other on the caller, in the order they were added
+        void Run(const bool bSerial = false) {
+            const Timer clock;
+
+            m_bSerial = bSerial;
+
+            if (bSerial) {
+                for (Task& task : m_tasks) {
+                    task.startUS = clock.GetElapsedUS();
+                    task.function();
+                    task.endUS = clock.GetElapsedUS();
+                }
+            } else {
+                for (TaskId id = 0; id < m_tasks.size(); ++id) {
+                    m_tasks[id].waiting = static_cast<u32>(m_tasks[id].dependencies.size());
+
+                    if (m_tasks[id].waiting == 0)
+                        m_ready.insert(id);
+                }
+
+                std::vector<std::thread> threads;
+                threads.reserve(m_threadCount);
+
+                for (u32 i = 1; i <= m_threadCount; ++i)
+                    threads.emplace_back(&TaskGraph::RunTasks, this, i, std::cref(clock));
+
+                RunTasks(MAIN_THREAD, clock);
+
+                for (std::thread& thread : threads)
+                    thread.join();
+
+                if (m_pException)
+                    std::rethrow_exception(m_pException);
+            }
+
+            m_wallUS = clock.GetElapsedUS();
+
+            MarkCriticalPath();
+        }
+
+        inline u64 GetWallUS() const { return m_wallUS; }
+
+        // One line per task in the order they started, the critical path marked with '*' and drawn with '#'
+        void PrintTimeline(std::ostream& out) const {
+            std::vector<const Task*> tasks;
+            for (const Task& task : m_tasks)
+                tasks.push_back(&task);
+
+            std::stable_sort(tasks.begin(), tasks.end(), [](const Task* a, const Task* b) { return a->startUS < b->startUS; });
+
+            std::size_t nameWidth  = 0;
+            u64         workUS     = 0;
+            u64         criticalUS = 0;
+
+            for (const Task* pTask : tasks) {
+                nameWidth   = std::max(nameWidth, pTask->name.size());
+                workUS     += pTask->endUS - pTask->startUS;
+                criticalUS += pTask->bCritical ? pTask->endUS - pTask->startUS : 0;
+            }
+
+            const u64 wallUS = std::max<u64>(m_wallUS, 1);
+
+            out << "[STARTUP] " << m_tasks.size() << " tasks " << (m_bSerial ? "one after the other" : "on " + std::to_string(m_threadCount + 1) + " threads") << " in " << std::fixed << std::setprecision(1)
+                << m_wallUS / 1e3 << " ms, " << workUS / 1e3 << " ms of work, " << criticalUS / 1e3 << " ms on the critical path\n";
+
+            for (const Task* pTask : tasks) {
+                const u64 first = pTask->startUS * BAR_WIDTH / wallUS;
+                const u64 last  = std::max(first + 1, pTask->endUS * BAR_WIDTH / wallUS);
+
+                std::string bar(BAR_WIDTH, ' ');
+                for (u64 i = first; i < std::min<u64>(last, BAR_WIDTH); ++i)
+                    bar[i] = pTask->bCritical ? '#' : '-';
+
+                out << "[STARTUP] " << (pTask->bCritical ? '*' : ' ') << ' ' << std::left << std::setw(static_cast<int>(nameWidth)) << pTask->name << ' '
+                    << std::setw(4) << (pTask->thread == MAIN_THREAD ? std::string("main") : std::to_string(pTask->thread)) << std::right << " |" << bar << "| "
+                    << std::setw(7) << pTask->startUS / 1e3 << " + " << std::setw(7) << (pTask->endUS - pTask->startUS) / 1e3 << " ms\n";
+            }
+
+            out << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+    }; // class TaskGraph
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * A fixed set of workers pulling type erased jobs from a shared queue.
+ */
+
+namespace mc {
+
+    class ThreadPool {
+    private:
+        std::vector<std::thread>          m_workers;
+        std::queue<std::function<void()>> m_jobs;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+
+        bool m_bStopping = false;
+
+    private:
+        void WorkerLoop() {
+            for (;;) {
+                std::function<void()> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this] { return m_bStopping || !m_jobs.empty(); });
+
+                    if (m_bStopping && m_jobs.empty())
+                        return;
+
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop();
+                }
+
+                job();
+            }
+        }
+
+    public:
+        explicit ThreadPool(const u32 threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+            m_workers.reserve(threadCount);
+
+            for (u32 i = 0; i < threadCount; ++i)
+                m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_bStopping = true;
+            }
+
+            m_condition.notify_all();
+
+            for (std::thread& worker : m_workers)
+                worker.join();
+        }
+
+        inline u32 GetThreadCount() const { return static_cast<u32>(m_workers.size()); }
+
+        template <typename F>
+        auto Submit(F&& f) -> std::future<decltype(f())> {
+            using R = decltype(f());
+
+            // std::function needs a copyable callable, hence the shared_ptr around the packaged_task
+            auto pTask = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+            std::future<R> future = pTask->get_future();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.emplace([pTask] { (*pTask)(); });
+            }
+
+            m_condition.notify_one();
+
+            return future;
+        }
+
+        // Calls f(begin, end) over [0, count) in batches of at most grain items and waits for all of them.
+        // Batches are claimed from a shared counter and the calling thread claims them too, so a call
+        // never waits behind unrelated jobs queued ahead of its helpers: it just runs the batches itself.
+        template <typename F>
+        void ParallelFor(const std::size_t count, const std::size_t grain, F&& f) {
+            if (count == 0)
+                return;
+
+            const std::size_t step       = std::max<std::size_t>(grain, 1);
+            const std::size_t batchCount = (count + step - 1) / step;
+
+            if (batchCount == 1) {
+                f(std::size_t{ 0 }, count);
+                return;
+            }
+
+            struct State {
+                std::atomic<std::size_t> next{ 0 };
+                std::size_t              done = 0;
+                std::exception_ptr       pException;
+
+                std::mutex              mutex;
+                std::condition_variable condition;
+            }; // struct State
+
+            const auto pState = std::make_shared<State>();
+
+            // A helper that starts after every batch was claimed returns without touching f, which may be gone by then
+            const auto RunBatches = [pState, &f, step, count, batchCount] {
+                for (std::size_t batch = pState->next++; batch < batchCount; batch = pState->next++) {
+                    std::exception_ptr pException;
+
+                    try {
+                        f(batch * step, std::min(batch * step + step, count));
+                    } catch (...) {
+                        pException = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> lock(pState->mutex);
+
+                    if (pException && !pState->pException)
+                        pState->pException = pException;
+
+                    if (++pState->done == batchCount)
+                        pState->condition.notify_all();
+                }
+            };
+
+            const std::size_t helperCount = std::min<std::size_t>(batchCount - 1, m_workers.size());
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                for (std::size_t i = 0; i < helperCount; ++i)
+                    m_jobs.emplace(RunBatches);
+            }
+
+            m_condition.notify_all();
+
+            RunBatches();
+
+            std::unique_lock<std::mutex> lock(pState->mutex);
+            pState->condition.wait(lock, [&] { return pState->done == batchCount; });
+
+            if (pState->pException)
+                std::rethrow_exception(pState->pException);
+        }
+    }; // class ThreadPool
+
+}; // namespace mc
\ No newline at end of file
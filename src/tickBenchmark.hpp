@@ -0,0 +1,80 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "threadPool.hpp"
+#include "blockTicks.hpp"
+#include "worldGenerator.hpp"
+#include "generationPipeline.hpp"
+
+/*
+ * Measures what block ticks cost as the loaded world grows: a square of generated chunks holding
+ * about the given number of blocks, air included, with sand dropped from a few blocks up in every
+ * chunk so scheduled ticks have falls to run next to the random ticks. Generation is not timed.
+ */
+
+namespace mc {
+
+    class TickBenchmark {
+    private:
+        static constexpr u64 CHUNK_VOLUME = static_cast<u64>(MC_CHUNK_SECTION_VOLUME) * MC_CHUNK_SECTION_COUNT;
+
+        static constexpr u32 FALLING_COLUMNS_PER_CHUNK = 4;
+        static constexpr i32 FALL_HEIGHT               = 12;
+
+    public:
+        static void Run(const u64 blocks, const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            const i32 side = static_cast<i32>(std::ceil(std::sqrt(static_cast<f64>((blocks + CHUNK_VOLUME - 1) / CHUNK_VOLUME))));
+
+            World              world;
+            WorldGenerator     generator(0x5469636B73ull);
+            GenerationPipeline generation(generator, pool);
+
+            std::vector<Chunk*> chunks;
+            for (i32 z = 0; z < side; ++z)
+                for (i32 x = 0; x < side; ++x)
+                    chunks.push_back(&world.CreateChunk(ChunkCoord{ x, z }));
+
+            generation.Generate(chunks);
+
+            for (Chunk* pChunk : chunks)
+                pChunk->Intern(world.GetSectionPool());
+
+            BlockTickScheduler scheduler(generator.GetSeed());
+
+            for (const Chunk* pChunk : chunks) {
+                for (u32 i = 0; i < FALLING_COLUMNS_PER_CHUNK; ++i) {
+                    const u64 h = noise::Hash(generator.GetSeed(), pChunk->GetCoord().x, static_cast<i32>(i), pChunk->GetCoord().z);
+                    const i32 x = ChunkToWorld(pChunk->GetCoord().x) + static_cast<i32>(h % MC_CHUNK_SECTION_SIZE);
+                    const i32 z = ChunkToWorld(pChunk->GetCoord().z) + static_cast<i32>((h >> 8) % MC_CHUNK_SECTION_SIZE);
+                    const vec3i32 p{ x, std::min(generator.GetTerrainHeight(x, z) + FALL_HEIGHT, MC_CHUNK_HEIGHT - 1), z };
+
+                    world.SetBlock(p, Block::Sand);
+                    scheduler.NotifyNeighbours(world, p);
+                }
+            }
+
+            for (u32 i = 0; i < ticks; ++i)
+                scheduler.Tick(world, pool);
+
+            const BlockTickStats stats = scheduler.GetStats();
+            const f64 count = static_cast<f64>(std::max<u64>(stats.ticks, 1));
+
+            out << "[BENCHMARK] " << std::setw(5) << static_cast<u64>(side) * side * CHUNK_VOLUME / 1'000'000 << "M blocks in " << std::setw(4) << side * side << " chunks, "
+                << scheduler.GetRegionCount() << " regions | tick " << std::fixed << std::setprecision(3) << static_cast<f64>(stats.tickUS) / count / 1000.0 << " ms avg, "
+                << stats.maxTickUS / 1000.0 << " ms max | per tick " << std::setprecision(1) << static_cast<f64>(stats.sectionsSampled) / count << " of "
+                << static_cast<f64>(stats.sectionsLoaded) / count << " sections sampled, " << static_cast<f64>(stats.random) / count << " random and "
+                << static_cast<f64>(stats.scheduled) / count << " scheduled ticks, " << static_cast<f64>(stats.changes) / count << " changes\n"
+                << std::defaultfloat << std::setprecision(6) << std::flush;
+        }
+
+        static void RunAll(const u32 ticks, ThreadPool& pool, std::ostream& out) {
+            out << "[BENCHMARK] " << ticks << " block ticks on " << pool.GetThreadCount() + 1 << " threads\n";
+
+            for (const u64 blocks : { 1'000'000ull, 10'000'000ull, 100'000'000ull })
+                Run(blocks, ticks, pool, out);
+        }
+    }; // class TickBenchmark
+
+}; // namespace mc
\ No newline at end of file
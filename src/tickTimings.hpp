@@ -0,0 +1,146 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * Per tick timings of a replay. Replays of the same recording simulate the same ticks, so two
+ * reports can be compared row by row, and a regression gate can fail on the percentiles.
+ *
+ * Reports are CSV: "tick,simulation_us,frame_us,state". frame_us is the time of the frame the tick
+ * was simulated in, 0 when replaying headless. state hashes the simulation after the tick, so
+ * a comparison can tell when two runs stopped simulating the same thing.
+ */
+
+namespace mc {
+
+    struct TickTiming {
+        u32 tick;
+        u64 simulationUS;
+        u64 frameUS;
+        u64 state;
+
+        // What the comparison looks at: the whole frame when there was one
+        inline u64 GetTotalUS() const { return frameUS != 0 ? frameUS : simulationUS; }
+    }; // struct TickTiming
+
+    class TickTimings {
+    private:
+        std::vector<TickTiming> m_ticks;
+
+    public:
+        static std::optional<TickTimings> Load(const std::string& filename) {
+            std::ifstream file(filename);
+
+            if (!file.is_open())
+                return {};
+
+            TickTimings timings;
+            std::string line;
+
+            std::getline(file, line); // Header
+            while (std::getline(file, line)) {
+                TickTiming timing{};
+                char comma;
+
+                std::istringstream row(line);
+                if (row >> timing.tick >> comma >> timing.simulationUS >> comma >> timing.frameUS >> comma >> std::hex >> timing.state)
+                    timings.m_ticks.push_back(timing);
+            }
+
+            return timings;
+        }
+
+        inline const std::vector<TickTiming>& GetTicks() const { return m_ticks; }
+
+        inline void Add(const u32 tick, const u64 simulationUS, const u64 state) { m_ticks.push_back(TickTiming{ tick, simulationUS, 0, state }); }
+
+        // Ticks simulated since firstTick share the frame that just ended
+        void SetFrameTime(const u32 firstTick, const u64 frameUS) {
+            for (auto it = m_ticks.rbegin(); it != m_ticks.rend() && it->tick >= firstTick; ++it)
+                it->frameUS = frameUS;
+        }
+
+        bool Save(const std::string& filename) const {
+            std::ofstream file(filename);
+
+            if (!file.is_open())
+                return false;
+
+            file << "tick,simulation_us,frame_us,state\n";
+            for (const TickTiming& timing : m_ticks)
+                file << std::dec << timing.tick << ',' << timing.simulationUS << ',' << timing.frameUS << ',' << std::hex << timing.state << '\n';
+
+            return file.good();
+        }
+
+        // p in [0, 1], over GetTotalUS()
+        u64 GetPercentile(const f64 p) const {
+            if (m_ticks.empty())
+                return 0;
+
+            std::vector<u64> totals(m_ticks.size());
+            std::transform(m_ticks.begin(), m_ticks.end(), totals.begin(), [](const TickTiming& t) { return t.GetTotalUS(); });
+
+            const std::size_t index = std::min(totals.size() - 1, static_cast<std::size_t>(p * static_cast<f64>(totals.size())));
+            std::nth_element(totals.begin(), totals.begin() + index, totals.end());
+
+            return totals[index];
+        }
+
+        void PrintSummary(std::ostream& out) const {
+            u64 sum = 0, max = 0;
+            for (const TickTiming& timing : m_ticks) {
+                sum += timing.GetTotalUS();
+                max  = std::max(max, timing.GetTotalUS());
+            }
+
+            out << "[REPLAY] " << m_ticks.size() << " ticks | avg " << (m_ticks.empty() ? 0 : sum / m_ticks.size())
+                << " us, p50 " << GetPercentile(0.5) << " us, p99 " << GetPercentile(0.99) << " us, max " << max << " us\n" << std::flush;
+        }
+
+        // Compares two replays of the same recording. Fails when the p50 or p99 of the current one is more
+        // than tolerance (a fraction) above the baseline's, or when they did not simulate the same ticks
+        static bool Compare(const TickTimings& baseline, const TickTimings& current, const f64 tolerance, std::ostream& out) {
+            if (baseline.m_ticks.size() != current.m_ticks.size()) {
+                out << "[REPLAY] The reports cover " << baseline.m_ticks.size() << " and " << current.m_ticks.size() << " ticks, not the same replay\n";
+                return false;
+            }
+
+            for (std::size_t i = 0; i < current.m_ticks.size(); ++i) {
+                if (baseline.m_ticks[i].state != current.m_ticks[i].state) {
+                    out << "[REPLAY] The simulations diverge at tick " << current.m_ticks[i].tick << ", the timings are not comparable\n";
+                    return false;
+                }
+            }
+
+            // The ticks that got slowest relative to the baseline point at what regressed
+            std::vector<std::pair<f64, u32>> ratios;
+            ratios.reserve(current.m_ticks.size());
+
+            for (std::size_t i = 0; i < current.m_ticks.size(); ++i)
+                ratios.emplace_back(static_cast<f64>(current.m_ticks[i].GetTotalUS()) / std::max<u64>(baseline.m_ticks[i].GetTotalUS(), 1), current.m_ticks[i].tick);
+
+            const std::size_t worst = std::min<std::size_t>(5, ratios.size());
+            std::partial_sort(ratios.begin(), ratios.begin() + worst, ratios.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+            bool bPassed = true;
+
+            for (const f64 p : { 0.5, 0.99 }) {
+                const u64 before = baseline.GetPercentile(p);
+                const u64 after  = current.GetPercentile(p);
+                const bool bRegressed = static_cast<f64>(after) > static_cast<f64>(before) * (1.0 + tolerance);
+
+                out << "[REPLAY] p" << static_cast<u32>(p * 100) << ": " << before << " us -> " << after << " us" << (bRegressed ? " REGRESSED" : "") << '\n';
+                bPassed = bPassed && !bRegressed;
+            }
+
+            out << "[REPLAY] Slowest ticks relative to the baseline:";
+            for (std::size_t i = 0; i < worst; ++i)
+                out << ' ' << ratios[i].second << " (x" << std::setprecision(3) << ratios[i].first << ')';
+            out << '\n' << std::flush;
+
+            return bPassed;
+        }
+    }; // class TickTimings
+
+}; // namespace mc
\ No newline at end of file
@@ -3,7 +3,7 @@
 #include "header.hpp"
 
 /*
- * A very simple Timer class.
+ * A very simple Timer class, and a history of the times it measures for what shows them live.
  */
 
 namespace mc {
@@ -22,6 +22,71 @@ namespace mc {
 
             return std::chrono::duration_cast<std::chrono::milliseconds>(end - m_start).count();
         }
+
+        inline u64 GetElapsedUS() const {
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            return std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count();
+        }
+
+        inline u64 GetElapsedNS() const {
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count();
+        }
+
+        inline void Reset() { m_start = std::chrono::high_resolution_clock::now(); }
+
+        // The elapsed time, the timer restarting from now: successive laps cover all the time in between
+        inline u64 Lap() {
+            const auto end = std::chrono::high_resolution_clock::now();
+            const u64  us  = std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count();
+
+            m_start = end;
+
+            return us;
+        }
     }; // class Timer
 
+    // The last CAPACITY samples of a timing, in microseconds, oldest first
+    template <u32 CAPACITY>
+    class TimingHistory {
+    private:
+        std::array<u32, CAPACITY> m_samples{};
+        u32                       m_next  = 0;
+        u32                       m_count = 0;
+        u64                       m_sum   = 0; // Of the samples held
+
+    public:
+        static constexpr u32 GetCapacity() { return CAPACITY; }
+
+        void Add(const u64 us) {
+            const u32 sample = static_cast<u32>(std::min<u64>(us, UINT32_MAX));
+
+            m_sum += sample;
+            m_sum -= m_count == CAPACITY ? m_samples[m_next] : 0;
+
+            m_samples[m_next] = sample;
+            m_next  = (m_next + 1) % CAPACITY;
+            m_count = std::min(m_count + 1, CAPACITY);
+        }
+
+        inline u32 GetCount() const { return m_count; }
+
+        // i in [0, GetCount()), 0 being the oldest sample
+        inline u32 Get(const u32 i) const { return m_samples[(m_next + CAPACITY - m_count + i) % CAPACITY]; }
+
+        inline u32 GetLast()    const { return m_count > 0 ? Get(m_count - 1) : 0; }
+        inline f64 GetAverage() const { return m_count > 0 ? static_cast<f64>(m_sum) / m_count : 0.0; }
+
+        u32 GetMax() const {
+            u32 max = 0;
+
+            for (u32 i = 0; i < m_count; ++i)
+                max = std::max(max, m_samples[i]);
+
+            return max;
+        }
+    }; // class TimingHistory
+
 }; // namespace mc
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "header.hpp"
+
+/*
+ * A hierarchical timing wheel. Scheduling and expiring an entry are O(1) whatever the number
+ * of entries, where a priority queue pays O(log n) for both. Level 0 has a slot per tick for the
+ * next 256 ticks, level 1 a slot per 256 ticks for the next 65536, and so on: an entry drops a
+ * level when the wheel reaches its slot, so it is moved at most LEVELS - 1 times before it expires.
+ */
+
+namespace mc {
+
+    template <typename T>
+    class TimingWheel {
+    private:
+        static constexpr u32 SLOT_BITS  = 8;
+        static constexpr u32 SLOT_COUNT = 1u << SLOT_BITS;
+        static constexpr u32 LEVELS     = 4;
+
+        static constexpr u64 MAX_DELAY = (u64{ 1 } << (SLOT_BITS * LEVELS)) - 1; // Further is clamped
+
+        struct Entry {
+            u64 due;
+            T   value;
+        }; // struct Entry
+
+        std::array<std::array<std::vector<Entry>, SLOT_COUNT>, LEVELS> m_levels;
+
+        u64         m_now  = 0; // The tick the next Advance expires
+        std::size_t m_size = 0;
+
+    private:
+        static constexpr u64 GetLevelSpan(const u32 level) { return u64{ 1 } << (SLOT_BITS * level); }
+
+        // The lowest level whose slots still tell the due tick apart from now
+        void Insert(Entry&& entry) {
+            const u64 delay = entry.due - m_now;
+
+            u32 level = 0;
+            while (level + 1 < LEVELS && delay >= GetLevelSpan(level + 1))
+                ++level;
+
+            m_levels[level][(entry.due >> (SLOT_BITS * level)) & (SLOT_COUNT - 1)].push_back(std::move(entry));
+        }
+
+    public:
+        explicit TimingWheel(const u64 now = 0)
+            : m_now(now)
+        { }
+
+        // Due ticks already passed expire at the next Advance
+        void Schedule(const u64 due, T value) {
+            Insert(Entry{ std::clamp(due, m_now, m_now + MAX_DELAY), std::move(value) });
+            ++m_size;
+        }
+
+        /*
+         * Hands f every entry due at the current tick, then moves on to the next one. Entries that
+         * f schedules for the current tick expire at the next Advance.
+         */
+        template <typename F>
+        void Advance(F&& f) {
+            // Higher levels first: what one cascades can land in a slot the level below cascades now
+            for (u32 level = LEVELS - 1; level > 0; --level) {
+                if ((m_now & (GetLevelSpan(level) - 1)) != 0)
+                    continue;
+
+                std::vector<Entry> entries;
+                entries.swap(m_levels[level][(m_now >> (SLOT_BITS * level)) & (SLOT_COUNT - 1)]);
+
+                for (Entry& entry : entries)
+                    Insert(std::move(entry));
+            }
+
+            std::vector<Entry> expired;
+            expired.swap(m_levels[0][m_now & (SLOT_COUNT - 1)]);
+
+            m_size -= expired.size();
+            ++m_now;
+
+            for (Entry& entry : expired)
+                f(std::move(entry.value));
+        }
+
+        inline u64         GetNow()  const noexcept { return m_now;       }
+        inline std::size_t GetSize() const noexcept { return m_size;      }
+        inline bool        IsEmpty() const noexcept { return m_size == 0; }
+    }; // class TimingWheel
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "header.hpp"
+#include "parseUtils.hpp"
+
+#ifdef _WIN32
+#   pragma comment(lib, "ws2_32.lib")
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <netdb.h>
+#   include <arpa/inet.h>
+#   include <netinet/in.h>
+#   include <sys/socket.h>
+#endif // _WIN32
+
+/*
+ * A non blocking IPv4 UDP socket. Windows.h already brings in the winsock API this uses.
+ */
+
+namespace mc {
+
+    struct NetAddress {
+        u32 ip   = 0; // Host byte order
+        u16 port = 0;
+
+        constexpr bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+        constexpr bool operator!=(const NetAddress& other) const { return !(*this == other); }
+
+        // "host" or "host:port"; resolves names, throws when it cannot
+        static NetAddress Resolve(const std::string& text, const u16 defaultPort) {
+            const std::size_t colon = text.rfind(':');
+            const std::string host  = colon == std::string::npos ? text : text.substr(0, colon);
+            const u16         port  = colon == std::string::npos ? defaultPort : ParseUnsigned<u16>("The port of " + text, text.substr(colon + 1));
+
+            addrinfo hints{};
+            hints.ai_family   = AF_INET;
+            hints.ai_socktype = SOCK_DGRAM;
+
+            addrinfo* pResult = nullptr;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &pResult) != 0 || !pResult)
+                throw std::runtime_error("NetAddress::Resolve failed for " + text);
+
+            const NetAddress address{ ntohl(reinterpret_cast<const sockaddr_in*>(pResult->ai_addr)->sin_addr.s_addr), port };
+            freeaddrinfo(pResult);
+
+            return address;
+        }
+    }; // struct NetAddress
+
+    struct NetAddressHash {
+        inline std::size_t operator()(const NetAddress& a) const noexcept {
+            return std::hash<u64>()((static_cast<u64>(a.ip) << 16) | a.port);
+        }
+    }; // struct NetAddressHash
+
+    class UdpSocket {
+    private:
+#ifdef _WIN32
+        using Handle = SOCKET;
+        static constexpr Handle INVALID = INVALID_SOCKET;
+#else
+        using Handle = int;
+        static constexpr Handle INVALID = -1;
+#endif // _WIN32
+
+        Handle m_handle = INVALID;
+
+    private:
+        static void Close(const Handle handle) {
+#ifdef _WIN32
+            closesocket(handle);
+#else
+            close(handle);
+#endif // _WIN32
+        }
+
+    public:
+        UdpSocket() = default;
+
+        // port 0 picks any free port
+        explicit UdpSocket(const u16 port) {
+#ifdef _WIN32
+            static const bool bStarted = [] { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+            if (!bStarted)
+                throw std::runtime_error("WSAStartup failed");
+#endif // _WIN32
+
+            m_handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (m_handle == INVALID)
+                throw std::runtime_error("UdpSocket: socket() failed");
+
+            sockaddr_in address{};
+            address.sin_family      = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_ANY);
+            address.sin_port        = htons(port);
+
+            if (bind(m_handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                Close(m_handle);
+                throw std::runtime_error("UdpSocket: bind() failed on port " + std::to_string(port));
+            }
+
+#ifdef _WIN32
+            u_long bNonBlocking = 1;
+            ioctlsocket(m_handle, FIONBIO, &bNonBlocking);
+#else
+            fcntl(m_handle, F_SETFL, fcntl(m_handle, F_GETFL, 0) | O_NONBLOCK);
+#endif // _WIN32
+
+            // Chunk streaming to many clients at once overflows the default buffers
+            const int bufferSize = 4 << 20;
+            setsockopt(m_handle, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+            setsockopt(m_handle, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+        }
+
+        UdpSocket(UdpSocket&& other) noexcept { std::swap(m_handle, other.m_handle); }
+
+        UdpSocket& operator=(UdpSocket&& other) noexcept {
+            std::swap(m_handle, other.m_handle);
+
+            return *this;
+        }
+
+        u16 GetPort() const {
+            sockaddr_in address{};
+#ifdef _WIN32
+            int length = sizeof(address);
+#else
+            socklen_t length = sizeof(address);
+#endif // _WIN32
+            getsockname(m_handle, reinterpret_cast<sockaddr*>(&address), &length);
+
+            return ntohs(address.sin_port);
+        }
+
+        bool SendTo(const NetAddress& to, const void* pData, const std::size_t size) const {
+            sockaddr_in address{};
+            address.sin_family      = AF_INET;
+            address.sin_addr.s_addr = htonl(to.ip);
+            address.sin_port        = htons(to.port);
+
+            return sendto(m_handle, static_cast<const char*>(pData), static_cast<int>(size), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == static_cast<int>(size);
+        }
+
+        // Returns the datagram size, or nothing once no datagram is waiting
+        std::optional<std::size_t> Receive(void* pBuffer, const std::size_t capacity, NetAddress& from) const {
+            sockaddr_in address{};
+#ifdef _WIN32
+            int length = sizeof(address);
+#else
+            socklen_t length = sizeof(address);
+#endif // _WIN32
+
+            const auto received = recvfrom(m_handle, static_cast<char*>(pBuffer), static_cast<int>(capacity), 0, reinterpret_cast<sockaddr*>(&address), &length);
+
+            if (received < 0)
+                return {};
+
+            from = NetAddress{ ntohl(address.sin_addr.s_addr), ntohs(address.sin_port) };
+
+            return static_cast<std::size_t>(received);
+        }
+
+        ~UdpSocket() {
+            if (m_handle != INVALID)
+                Close(m_handle);
+        }
+    }; // class UdpSocket
+
+}; // namespace mc
\ No newline at end of file
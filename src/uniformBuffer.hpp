@@ -0,0 +1,93 @@
+#pragma once
+
+#include "header.hpp"
+#include "gpuMemory.hpp"
+#include "vulkanUtils.hpp"
+
+/*
+ * A persistently mapped ring of uniform slots, one per frame in flight.
+ * Every slot is aligned to minUniformBufferOffsetAlignment so it can be
+ * selected with a dynamic offset on a single, never reallocated, descriptor set.
+ */
+
+namespace mc {
+
+	class UniformRingBuffer {
+	private:
+		vk::Buffer       m_buffer;
+		vk::DeviceMemory m_memory;
+
+		vk::Device m_device;
+
+		mc::u8*        m_mapped    = nullptr;
+		vk::DeviceSize m_slotSize  = 0;
+		vk::DeviceSize m_stride    = 0;
+		mc::u32        m_slotCount = 0;
+
+	public:
+		UniformRingBuffer() = default;
+
+		UniformRingBuffer(UniformRingBuffer&& other) noexcept {
+			*this = std::move(other);
+		}
+
+		UniformRingBuffer(const vk::Device& device, const vk::PhysicalDeviceProperties& deviceProperties, const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const std::size_t slotSize, const mc::u32 slotCount)
+			: m_device(device), m_slotSize(slotSize), m_slotCount(slotCount)
+		{
+			m_stride = mc::vk_utils::AlignUp(slotSize, deviceProperties.limits.minUniformBufferOffsetAlignment);
+
+			vk::BufferCreateInfo bci{};
+			bci.size        = m_stride * m_slotCount;
+			bci.usage       = vk::BufferUsageFlagBits::eUniformBuffer;
+			bci.sharingMode = vk::SharingMode::eExclusive;
+
+			m_buffer = m_device.createBuffer(bci);
+
+			const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(m_buffer);
+
+			vk::MemoryAllocateInfo allocationInfo{};
+			allocationInfo.allocationSize  = requirements.size;
+			allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+			m_memory = mc::GpuMemory::Allocate(m_device, allocationInfo);
+
+			m_device.bindBufferMemory(m_buffer, m_memory, 0);
+
+			m_mapped = static_cast<mc::u8*>(m_device.mapMemory(m_memory, 0, VK_WHOLE_SIZE));
+		}
+
+		UniformRingBuffer& operator=(UniformRingBuffer&& other) noexcept {
+			std::swap(m_buffer,    other.m_buffer);
+			std::swap(m_memory,    other.m_memory);
+			std::swap(m_device,    other.m_device);
+			std::swap(m_mapped,    other.m_mapped);
+			std::swap(m_slotSize,  other.m_slotSize);
+			std::swap(m_stride,    other.m_stride);
+			std::swap(m_slotCount, other.m_slotCount);
+
+			return *this;
+		}
+
+		template <typename T>
+		void Write(const mc::u32 slot, const T& data) {
+			assert(slot < m_slotCount && sizeof(T) <= m_slotSize);
+
+			std::memcpy(m_mapped + slot * m_stride, &data, sizeof(T));
+		}
+
+		inline mc::u32 GetDynamicOffset(const mc::u32 slot) const noexcept { return static_cast<mc::u32>(slot * m_stride); }
+
+		inline vk::DescriptorBufferInfo GetDescriptorBufferInfo() const noexcept {
+			return vk::DescriptorBufferInfo{ m_buffer, 0, m_slotSize };
+		}
+
+		~UniformRingBuffer() {
+			if ((VkDevice)m_device != VK_NULL_HANDLE) {
+				m_device.unmapMemory(m_memory);
+				mc::GpuMemory::Free(m_device, m_memory);
+				m_device.destroyBuffer(m_buffer);
+			}
+		}
+	}; // class UniformRingBuffer
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "header.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+
+/*
+ * CPU side mirrors of the shader interface blocks (std140 for uniforms).
+ * Keep these in sync with res/shaders/shader.vert, res/shaders/overlay.vert and res/shaders/farField.comp.
+ */
+
+namespace mc {
+
+    struct FrameUniforms {
+        mat4f32 view;
+        mat4f32 projection;
+        vec4f32 cameraPosition;
+        vec4f32 time; // x: seconds since startup, y: delta seconds, z: frame number
+    }; // struct FrameUniforms
+
+    struct ChunkPushConstants {
+        vec4f32 origin; // xyz: world space origin of the chunk section being drawn
+    }; // struct ChunkPushConstants
+
+    struct OverlayPushConstants {
+        vec4f32 scale; // xy: 2 / the screen size in pixels, which maps pixels to clip space
+    }; // struct OverlayPushConstants
+
+    // The far field's view is the camera's without its translation: rays start at the camera, in floats however far it went
+    struct FarFieldPushConstants {
+        mat4f32 inverseViewProjection; // From clip space to directions from the camera
+        vec4f32 depthRowZ;             // Rows of the view projection giving clip z and w, for the hits' depth
+        vec4f32 depthRowW;
+        vec4f32 origin;                // xyz: the camera relative to the window's corner, w: how far rays go
+        i32     window[4];             // x, y: the window's first chunk along x and z, z: its side in chunks
+    }; // struct FarFieldPushConstants
+
+    static_assert(sizeof(FrameUniforms)         == 2 * 64 + 2 * 16, "FrameUniforms must match the std140 layout of the shader block");
+    static_assert(sizeof(ChunkPushConstants)    <= 128,             "Push constants must fit in the guaranteed minimum of 128 bytes");
+    static_assert(sizeof(OverlayPushConstants)  <= 128,             "Push constants must fit in the guaranteed minimum of 128 bytes");
+    static_assert(sizeof(FarFieldPushConstants) <= 128,             "Push constants must fit in the guaranteed minimum of 128 bytes");
+
+}; // namespace mc
\ No newline at end of file
@@ -2,10 +2,74 @@
 
 #include "header.hpp"
 
+/*
+ * Plain storage vectors. Their layout is what mc::Vertex and the shader
+ * interface blocks rely on, so they must stay tightly packed. Everything
+ * below is constexpr scalar code; see simd.hpp for the wide versions.
+ */
+
 namespace mc {
 
 	struct vec2f32 { union { struct { f32 x, y;       }; struct { f32 r, g;       }; }; };
 	struct vec3f32 { union { struct { f32 x, y, z;    }; struct { f32 r, g, b;    }; }; };
 	struct vec4f32 { union { struct { f32 x, y, z, w; }; struct { f32 r, g, b, a; }; }; };
 
+	struct vec3i32 { i32 x, y, z; };
+
+	static_assert(sizeof(vec2f32) == 2 * sizeof(f32) && sizeof(vec3f32) == 3 * sizeof(f32) && sizeof(vec4f32) == 4 * sizeof(f32), "Storage vectors must stay tightly packed");
+
+	constexpr vec2f32 operator+(const vec2f32& a, const vec2f32& b) { return vec2f32{ a.x + b.x, a.y + b.y }; }
+	constexpr vec2f32 operator-(const vec2f32& a, const vec2f32& b) { return vec2f32{ a.x - b.x, a.y - b.y }; }
+	constexpr vec2f32 operator*(const vec2f32& a, const f32 s)      { return vec2f32{ a.x * s,   a.y * s   }; }
+
+	constexpr vec3f32 operator+(const vec3f32& a, const vec3f32& b) { return vec3f32{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+	constexpr vec3f32 operator-(const vec3f32& a, const vec3f32& b) { return vec3f32{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	constexpr vec3f32 operator*(const vec3f32& a, const vec3f32& b) { return vec3f32{ a.x * b.x, a.y * b.y, a.z * b.z }; }
+	constexpr vec3f32 operator*(const vec3f32& a, const f32 s)      { return vec3f32{ a.x * s,   a.y * s,   a.z * s   }; }
+	constexpr vec3f32 operator-(const vec3f32& a)                   { return vec3f32{ -a.x,      -a.y,      -a.z      }; }
+
+	constexpr vec4f32 operator+(const vec4f32& a, const vec4f32& b) { return vec4f32{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+	constexpr vec4f32 operator-(const vec4f32& a, const vec4f32& b) { return vec4f32{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+	constexpr vec4f32 operator*(const vec4f32& a, const vec4f32& b) { return vec4f32{ a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+	constexpr vec4f32 operator*(const vec4f32& a, const f32 s)      { return vec4f32{ a.x * s,   a.y * s,   a.z * s,   a.w * s   }; }
+
+	constexpr vec3f32& operator+=(vec3f32& a, const vec3f32& b) { return a = a + b; }
+	constexpr vec3f32& operator-=(vec3f32& a, const vec3f32& b) { return a = a - b; }
+	constexpr vec3f32& operator*=(vec3f32& a, const f32 s)      { return a = a * s; }
+
+	constexpr f32 Dot(const vec2f32& a, const vec2f32& b) { return a.x * b.x + a.y * b.y; }
+	constexpr f32 Dot(const vec3f32& a, const vec3f32& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	constexpr f32 Dot(const vec4f32& a, const vec4f32& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+	constexpr vec3f32 Cross(const vec3f32& a, const vec3f32& b) {
+		return vec3f32{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	constexpr vec3f32 Min(const vec3f32& a, const vec3f32& b) { return vec3f32{ std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+	constexpr vec3f32 Max(const vec3f32& a, const vec3f32& b) { return vec3f32{ std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+
+	template <typename V>
+	inline f32 Length(const V& v) { return std::sqrt(Dot(v, v)); }
+
+	template <typename V>
+	inline V Normalize(const V& v) {
+		const f32 length = Length(v);
+
+		return length > 0.f ? v * (1.f / length) : v;
+	}
+
+	constexpr vec3i32 operator+(const vec3i32& a, const vec3i32& b) { return vec3i32{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+	constexpr vec3i32 operator-(const vec3i32& a, const vec3i32& b) { return vec3i32{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	constexpr bool    operator==(const vec3i32& a, const vec3i32& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	constexpr bool    operator!=(const vec3i32& a, const vec3i32& b) { return !(a == b); }
+
+	inline vec3i32 FloorToVec3i32(const vec3f32& v) {
+		return vec3i32{ static_cast<i32>(std::floor(v.x)), static_cast<i32>(std::floor(v.y)), static_cast<i32>(std::floor(v.z)) };
+	}
+
+	constexpr vec3f32 ToVec3f32(const vec3i32& v) { return vec3f32{ static_cast<f32>(v.x), static_cast<f32>(v.y), static_cast<f32>(v.z) }; }
+
+	constexpr vec4f32 ToVec4f32(const vec3f32& v, const f32 w) { return vec4f32{ v.x, v.y, v.z, w }; }
+	constexpr vec3f32 ToVec3f32(const vec4f32& v)              { return vec3f32{ v.x, v.y, v.z };    }
+
 }; // namespace mc
\ No newline at end of file
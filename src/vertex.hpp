@@ -35,4 +35,41 @@ namespace mc {
         }
     }; // struct Vertex
 
+    // The debug overlay's, in pixels from the top left corner of the screen
+    struct OverlayVertex {
+        vec2f32 position;
+        vec2f32 uv;    // Into the font atlas, whose solid cell draws plain rectangles
+        u32     color; // RGBA8, red in the low byte
+
+        static inline vk::VertexInputBindingDescription GetBindingDescription() {
+            vk::VertexInputBindingDescription bindingDescription{};
+            bindingDescription.binding   = 0;
+            bindingDescription.inputRate = vk::VertexInputRate::eVertex;
+            bindingDescription.stride    = sizeof(mc::OverlayVertex);
+
+            return bindingDescription;
+        }
+
+        static inline auto GetAttributeDescriptions() {
+            std::array<vk::VertexInputAttributeDescription, 3> attributeDescriptions{};
+
+            attributeDescriptions[0].binding  = 0;
+            attributeDescriptions[0].format   = vk::Format::eR32G32Sfloat;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].offset   = offsetof(mc::OverlayVertex, position);
+
+            attributeDescriptions[1].binding  = 0;
+            attributeDescriptions[1].format   = vk::Format::eR32G32Sfloat;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].offset   = offsetof(mc::OverlayVertex, uv);
+
+            attributeDescriptions[2].binding  = 0;
+            attributeDescriptions[2].format   = vk::Format::eR8G8B8A8Unorm;
+            attributeDescriptions[2].location = 2;
+            attributeDescriptions[2].offset   = offsetof(mc::OverlayVertex, color);
+
+            return attributeDescriptions;
+        }
+    }; // struct OverlayVertex
+
 }; // namespace mc
\ No newline at end of file
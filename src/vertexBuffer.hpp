@@ -1,82 +1,191 @@
-#pragma once
-
-#include "header.hpp"
-#include "vulkanUtils.hpp"
-
-namespace mc {
-
-	class VertexBuffer {
-	private:
-		vk::Buffer       m_buffer;
-		vk::DeviceMemory m_memory;
-
-		vk::Device m_device;
-
-		std::vector<mc::u8> m_vertices;
-
-	public:
-		VertexBuffer() = default;
-
-		VertexBuffer(VertexBuffer&& other) {
-			m_buffer = other.m_buffer;
-			m_memory = other.m_memory;
-			m_device = other.m_device;
-			m_vertices = std::move(other.m_vertices);
-
-			other.m_buffer = vk::Buffer{};
-			other.m_memory = vk::DeviceMemory{};
-			other.m_device = vk::Device{};
-		}
-
-		VertexBuffer(const vk::Device& device, const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const std::size_t size)
-			: m_device(device), m_vertices(size)
-		{
-			vk::BufferCreateInfo bci{};
-			bci.size        = size;
-			bci.usage       = vk::BufferUsageFlagBits::eVertexBuffer;
-			bci.sharingMode = vk::SharingMode::eExclusive;
-
-			m_buffer = m_device.createBuffer(bci);
-
-			const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(m_buffer);
-
-			vk::MemoryAllocateInfo allocationInfo{};
-			allocationInfo.allocationSize  = requirements.size;
-			allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-			m_memory = device.allocateMemory(allocationInfo);
-
-			device.bindBufferMemory(m_buffer, m_memory, 0);
-		}
-
-		VertexBuffer& operator=(VertexBuffer&& other) {
-			new (this) VertexBuffer(std::move(other));
-
-			return *this;
-		}
-
-		void* GetData() const noexcept { return (void*)m_vertices.data(); }
-
-		void Upload() const {
-			void* const buff = m_device.mapMemory(m_memory, 0, m_vertices.size());
-
-			std::memcpy(buff, m_vertices.data(), m_vertices.size());
-
-			m_device.unmapMemory(m_memory);
-		}
-
-		void Bind(const vk::CommandBuffer& cmdBuff) const {
-			vk::DeviceSize offset = 0;
-
-			cmdBuff.bindVertexBuffers(0, 1, &m_buffer, &offset);
-		}
-
-		~VertexBuffer() {
-			if ((VkDevice)m_device != VK_NULL_HANDLE) {
-				m_device.freeMemory(m_memory);
-				m_device.destroyBuffer(m_buffer);
-			}
-		}
-	}; // class VertexBuffer
-
+#pragma once
+
+#include "header.hpp"
+#include "gpuMemory.hpp"
+#include "vulkanUtils.hpp"
+
+namespace mc {
+
+	// A byte range of a buffer that changed since it was last uploaded
+	struct ByteRange {
+		std::size_t offset;
+		std::size_t size;
+	}; // struct ByteRange
+
+	// Adds [offset, offset + size) to sorted, non overlapping ranges, absorbing every range it overlaps or touches
+	inline void AddByteRange(std::vector<ByteRange>& ranges, const std::size_t offset, const std::size_t size) {
+		ByteRange range{ offset, size };
+
+		auto it = std::lower_bound(ranges.begin(), ranges.end(), range, [](const ByteRange& a, const ByteRange& b) { return a.offset + a.size < b.offset; });
+
+		while (it != ranges.end() && it->offset <= range.offset + range.size) {
+			const std::size_t end = std::max(range.offset + range.size, it->offset + it->size);
+
+			range.offset = std::min(range.offset, it->offset);
+			range.size   = end - range.offset;
+
+			it = ranges.erase(it);
+		}
+
+		ranges.insert(it, range);
+	}
+
+	enum class VertexBufferMode : mc::u8 {
+		eStaged, // Device local; writes go to a CPU copy whose dirty ranges the renderer copies over (see Renderer::Upload)
+		eMapped, // Host visible and mapped for the buffer's whole life; writes land in the mapping, no CPU copy is kept
+	}; // enum class VertexBufferMode
+
+	/*
+	 * Both modes track dirty ranges: a staged buffer uploads them, a mapped buffer only
+	 * needs to flush them when its memory type is not host coherent.
+	 */
+	class VertexBuffer {
+	private:
+		vk::Buffer       m_buffer;
+		vk::DeviceMemory m_memory;
+
+		vk::Device m_device;
+
+		VertexBufferMode m_mode = VertexBufferMode::eStaged;
+		std::size_t      m_size = 0;
+
+		std::vector<mc::u8> m_vertices; // eStaged only
+
+		mc::u8*        m_mapped              = nullptr; // eMapped only
+		bool           m_bCoherent           = true;
+		vk::DeviceSize m_nonCoherentAtomSize = 1;
+		vk::DeviceSize m_allocationSize      = 0;
+		mc::u32        m_heapIndex           = 0;
+
+		std::vector<ByteRange> m_dirtyRanges; // Sorted, non overlapping
+
+	public:
+		VertexBuffer() = default;
+
+		VertexBuffer(VertexBuffer&& other) noexcept {
+			*this = std::move(other);
+		}
+
+		VertexBuffer(const vk::Device& device, const vk::PhysicalDeviceProperties& deviceProperties, const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const std::size_t size, const VertexBufferMode mode)
+			: m_device(device), m_mode(mode), m_size(size)
+		{
+			vk::BufferCreateInfo bci{};
+			bci.size        = size;
+			bci.usage       = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst;
+			bci.sharingMode = vk::SharingMode::eExclusive;
+
+			m_buffer = m_device.createBuffer(bci);
+
+			const vk::MemoryRequirements requirements = m_device.getBufferMemoryRequirements(m_buffer);
+
+			vk::MemoryAllocateInfo allocationInfo{};
+			allocationInfo.allocationSize = requirements.size;
+
+			if (m_mode == VertexBufferMode::eStaged) {
+				allocationInfo.memoryTypeIndex = mc::vk_utils::FindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			} else {
+				// Device local and host visible memory (resizable BAR, integrated GPUs) first, plain host memory otherwise
+				const std::optional<mc::u32> preferred = mc::vk_utils::TryFindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible);
+
+				allocationInfo.memoryTypeIndex = preferred.has_value() ? preferred.value() : mc::vk_utils::FindMemoryType(deviceMemoryProperties, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible);
+
+				m_bCoherent           = static_cast<bool>(deviceMemoryProperties.memoryTypes[allocationInfo.memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+				m_nonCoherentAtomSize = deviceProperties.limits.nonCoherentAtomSize;
+			}
+
+			m_allocationSize = requirements.size;
+			m_heapIndex      = mc::GpuMemory::GetHeapIndex(allocationInfo.memoryTypeIndex);
+			m_memory         = mc::GpuMemory::Allocate(m_device, allocationInfo);
+
+			m_device.bindBufferMemory(m_buffer, m_memory, 0);
+
+			if (m_mode == VertexBufferMode::eStaged)
+				m_vertices.resize(size);
+			else
+				m_mapped = static_cast<mc::u8*>(m_device.mapMemory(m_memory, 0, VK_WHOLE_SIZE));
+		}
+
+		VertexBuffer& operator=(VertexBuffer&& other) noexcept {
+			std::swap(m_buffer,              other.m_buffer);
+			std::swap(m_memory,              other.m_memory);
+			std::swap(m_device,              other.m_device);
+			std::swap(m_mode,                other.m_mode);
+			std::swap(m_size,                other.m_size);
+			std::swap(m_vertices,            other.m_vertices);
+			std::swap(m_mapped,              other.m_mapped);
+			std::swap(m_bCoherent,           other.m_bCoherent);
+			std::swap(m_nonCoherentAtomSize, other.m_nonCoherentAtomSize);
+			std::swap(m_allocationSize,      other.m_allocationSize);
+			std::swap(m_heapIndex,           other.m_heapIndex);
+			std::swap(m_dirtyRanges,         other.m_dirtyRanges);
+
+			return *this;
+		}
+
+		// The CPU copy of a staged buffer, the mapping itself for a mapped one
+		void* GetData() const noexcept { return m_mode == VertexBufferMode::eStaged ? (void*)m_vertices.data() : (void*)m_mapped; }
+
+		inline std::size_t       GetSize()   const noexcept { return m_size;   }
+		inline VertexBufferMode  GetMode()   const noexcept { return m_mode;   }
+		inline const vk::Buffer& GetHandle() const noexcept { return m_buffer; }
+
+		// What the buffer takes from its memory heap, which is 0 for an empty buffer
+		inline vk::DeviceSize GetAllocationSize() const noexcept { return m_allocationSize; }
+		inline mc::u32        GetHeapIndex()      const noexcept { return m_heapIndex;      }
+
+		inline const std::vector<ByteRange>& GetDirtyRanges() const noexcept { return m_dirtyRanges; }
+		inline void ClearDirtyRanges() noexcept { m_dirtyRanges.clear(); }
+
+		void MarkDirty(const std::size_t offset, const std::size_t size) {
+			if (size == 0 || (m_mode == VertexBufferMode::eMapped && m_bCoherent))
+				return;
+
+			AddByteRange(m_dirtyRanges, offset, size);
+		}
+
+		void Write(const std::size_t offset, const void* pData, const std::size_t size) {
+			std::memcpy(static_cast<mc::u8*>(GetData()) + offset, pData, size);
+
+			MarkDirty(offset, size);
+		}
+
+		// Marks the whole buffer for upload
+		void MarkAllDirty() { MarkDirty(0, m_size); }
+
+		// Makes the writes to a non coherent mapping visible to the device, ranges widened to nonCoherentAtomSize
+		void Flush() {
+			if (m_mode != VertexBufferMode::eMapped || m_dirtyRanges.empty())
+				return;
+
+			std::vector<vk::MappedMemoryRange> ranges;
+			ranges.reserve(m_dirtyRanges.size());
+
+			for (const ByteRange& range : m_dirtyRanges) {
+				const vk::DeviceSize begin = mc::vk_utils::AlignDown(range.offset, m_nonCoherentAtomSize);
+				const vk::DeviceSize end   = std::min(mc::vk_utils::AlignUp(range.offset + range.size, m_nonCoherentAtomSize), m_allocationSize);
+
+				ranges.push_back(vk::MappedMemoryRange{ m_memory, begin, end - begin });
+			}
+
+			m_device.flushMappedMemoryRanges(ranges);
+			m_dirtyRanges.clear();
+		}
+
+		void Bind(const vk::CommandBuffer& cmdBuff) const {
+			vk::DeviceSize offset = 0;
+
+			cmdBuff.bindVertexBuffers(0, 1, &m_buffer, &offset);
+		}
+
+		~VertexBuffer() {
+			if ((VkDevice)m_device != VK_NULL_HANDLE) {
+				if (m_mapped)
+					m_device.unmapMemory(m_memory);
+
+				mc::GpuMemory::Free(m_device, m_memory);
+				m_device.destroyBuffer(m_buffer);
+			}
+		}
+	}; // class VertexBuffer
+
 }; // namespace mc
\ No newline at end of file
@@ -0,0 +1,483 @@
+#pragma once
+
+#include "header.hpp"
+#include "chunk.hpp"
+#include "vector.hpp"
+#include "chunkMesher.hpp"
+#include "vertexBuffer.hpp"
+
+/*
+ * The far field's terrain as the GPU ray marches it: a 64-tree, each level splitting a cube in
+ * 4 x 4 x 4 children with one bit per child, like the brick masks the raycasts already skip empty
+ * space with. A region of 4^3 sections has a mask of its non empty sections, a section one of its
+ * non empty bricks, and a brick one of its blocks. Only the set children are stored, in the order
+ * of their bits, so a child is found by counting the bits before its own.
+ *
+ * It all lives in one array of u32, which the renderer uploads as a storage buffer:
+ *   - the header: one RGBA8 colour per block, then the meshes' face shades, so both look alike
+ *   - the grid: a cell per section of GRID_SIDE x GRID_SIDE columns, which wraps around like a
+ *     ring buffer so the window can follow the camera without moving what stays in it. A cell
+ *     is 0 for air, SOLID_BIT | block for a section full of blocks, else the offset of its node
+ *   - the region masks, two words each, wrapping around the same way
+ *   - the nodes, allocated in power of two classes and recycled as sections change
+ *
+ * A node is its brick mask, then three words per brick: the brick's block mask, and either
+ * SOLID_BIT | block when it holds one block only, or the offset from the node of its blocks,
+ * one byte each and only for the set bits. Full bricks keep their most common block alone:
+ * they only show in the far field by a face, at a distance where a block or two makes no odds.
+ *
+ * Raycast is the CPU twin of res/shaders/farField.comp; keep the two in sync.
+ */
+
+namespace mc {
+
+    // A section encoded on any thread, set in the tree on the one owning it
+    struct EncodedSection {
+        vec3i32          coord;
+        u64              hash = 0; // The section's, 0 for air
+        u32              cell = 0; // What the grid holds when the node is empty
+        std::vector<u32> node;
+    }; // struct EncodedSection
+
+    struct VoxelTreeHit {
+        vec3i32   block;
+        BlockFace face;     // Entered through, None when starting inside the block
+        f32       distance; // Along the normalized direction
+        Block     type;
+    }; // struct VoxelTreeHit
+
+    struct VoxelTreeStats {
+        std::size_t nodes      = 0; // Sections with a node
+        std::size_t solid      = 0; // Sections of one block, held by their cell alone
+        std::size_t nodeBytes  = 0; // Allocated to nodes, size classes rounded
+        std::size_t freeBytes  = 0; // Recycled and waiting in the free lists
+        std::size_t capacity   = 0; // For nodes
+        u64         dropped    = 0; // Sections left out because the nodes were full
+    }; // struct VoxelTreeStats
+
+    class VoxelTree {
+    public:
+        static constexpr u32 GRID_SIDE    = 128; // In sections, the widest window the grid can hold
+        static constexpr u32 REGION_SIDE  = GRID_SIDE / 4;
+        static constexpr u32 SOLID_BIT    = 0x80000000u;
+        static constexpr u32 SHADE_BEGIN  = 32; // Header words before are the block colours
+        static constexpr u32 HEADER_WORDS = 64;
+        static constexpr u32 GRID_BEGIN   = HEADER_WORDS;
+        static constexpr u32 GRID_WORDS   = GRID_SIDE * GRID_SIDE * MC_CHUNK_SECTION_COUNT;
+        static constexpr u32 REGION_BEGIN = GRID_BEGIN + GRID_WORDS;
+        static constexpr u32 REGION_WORDS = REGION_SIDE * REGION_SIDE * (MC_CHUNK_SECTION_COUNT / 4) * 2;
+        static constexpr u32 NODE_BEGIN   = REGION_BEGIN + REGION_WORDS;
+        static constexpr u32 MAX_STEPS    = 1024; // A ray still marching after as many is taken for sky
+
+        static_assert(static_cast<u32>(Block::Count) <= SHADE_BEGIN, "The header has one colour word per block");
+
+    private:
+        static constexpr u32 MIN_NODE_WORDS = 4;
+        static constexpr u32 CLASS_COUNT    = 10; // Up to 2048 words, past the largest node: 2 + 64 * 3 + 64 * 16
+
+        std::vector<u32>       m_words;
+        std::vector<ByteRange> m_dirtyRanges;
+
+        // Per grid cell: the words of its node's class, and the hash of the section set in it
+        std::vector<u32> m_nodeWords;
+        std::vector<u64> m_hashes;
+
+        std::array<std::vector<u32>, CLASS_COUNT> m_freeNodes;
+        u32                                       m_top; // End of the nodes allocated so far
+
+        VoxelTreeStats m_stats;
+
+    private:
+        static constexpr u32 ClassOf(const u32 words) {
+            u32 c = 0;
+            while ((MIN_NODE_WORDS << c) < words)
+                ++c;
+
+            return c;
+        }
+
+        static inline u32 PopCount(const u64 bits) { return static_cast<u32>(std::bitset<64>(bits).count()); }
+
+        // The bits of a 64 bit mask below bit i
+        static inline u32 Rank(const u64 mask, const u32 i) { return PopCount(mask & ((u64{ 1 } << i) - 1)); }
+
+        void MarkDirty(const u32 word, const u32 count) {
+            AddByteRange(m_dirtyRanges, std::size_t{ word } * sizeof(u32), std::size_t{ count } * sizeof(u32));
+        }
+
+        std::optional<u32> AllocateNode(const u32 words) {
+            const u32 c = ClassOf(words);
+
+            if (!m_freeNodes[c].empty()) {
+                const u32 offset = m_freeNodes[c].back();
+                m_freeNodes[c].pop_back();
+                m_stats.freeBytes -= (MIN_NODE_WORDS << c) * sizeof(u32);
+
+                return offset;
+            }
+
+            if (m_top + (MIN_NODE_WORDS << c) > m_words.size())
+                return {};
+
+            const u32 offset = m_top;
+            m_top += MIN_NODE_WORDS << c;
+            m_stats.nodeBytes += (MIN_NODE_WORDS << c) * sizeof(u32);
+
+            return offset;
+        }
+
+        void SetRegionBit(const vec3i32& section, const bool bSet) {
+            const u32 word = RegionIndex(section) + (SectionBit(section) >> 5);
+            const u32 bit  = 1u << (SectionBit(section) & 31);
+
+            m_words[word] = bSet ? m_words[word] | bit : m_words[word] & ~bit;
+            MarkDirty(word, 1);
+        }
+
+    public:
+        // Words of the whole array
+        static constexpr u32 GetWordCount(const std::size_t nodeWords) { return NODE_BEGIN + static_cast<u32>(nodeWords); }
+
+        static constexpr u32 GridIndex(const vec3i32& section) {
+            return GRID_BEGIN + ((static_cast<u32>(section.z) & (GRID_SIDE - 1)) * GRID_SIDE + (static_cast<u32>(section.x) & (GRID_SIDE - 1))) * MC_CHUNK_SECTION_COUNT + static_cast<u32>(section.y);
+        }
+
+        // The first of the region's two mask words
+        static constexpr u32 RegionIndex(const vec3i32& section) {
+            const u32 x = static_cast<u32>(section.x >> 2) & (REGION_SIDE - 1);
+            const u32 z = static_cast<u32>(section.z >> 2) & (REGION_SIDE - 1);
+
+            return REGION_BEGIN + ((z * REGION_SIDE + x) * (MC_CHUNK_SECTION_COUNT / 4) + static_cast<u32>(section.y >> 2)) * 2;
+        }
+
+        // Ordered like the bricks of a section and the blocks of a brick: y, then z, then x
+        static constexpr u32 SectionBit(const vec3i32& section) {
+            return ((static_cast<u32>(section.y) & 3) * 4 + (static_cast<u32>(section.z) & 3)) * 4 + (static_cast<u32>(section.x) & 3);
+        }
+
+        /*
+         * Thread safe. A section of nothing but blocks is held by its grid cell alone, under the
+         * block it has most of; sections with air get a node.
+         */
+        static EncodedSection EncodeSection(const vec3i32& coord, const ChunkSection* pSection) {
+            constexpr u32 BLOCK_COUNT = static_cast<u32>(Block::Count);
+
+            EncodedSection encoded;
+            encoded.coord = coord;
+
+            if (!pSection || pSection->IsEmpty())
+                return encoded;
+
+            encoded.hash = pSection->GetHash();
+
+            const u64 brickMask = pSection->GetBrickMask();
+
+            std::array<u32, BLOCK_COUNT> sectionCounts{};
+            std::vector<u32>             bricks;
+            std::vector<u32>             blocks; // Offsets in the bricks' third words are into this until the end
+            bool                         bFull = brickMask == ~u64{ 0 };
+
+            for (u32 brick = 0; brick < MC_BRICK_COUNT; ++brick) {
+                if (!(brickMask & (u64{ 1 } << brick)))
+                    continue;
+
+                const u32 bx = (brick & 3) * MC_BRICK_SIZE;
+                const u32 bz = ((brick >> 2) & 3) * MC_BRICK_SIZE;
+                const u32 by = (brick >> 4) * MC_BRICK_SIZE;
+
+                std::array<u32, BLOCK_COUNT> counts{};
+                std::array<u8, 64>           present;
+                u32                          presentCount = 0;
+                u64                          mask         = 0;
+
+                for (u32 i = 0; i < 64; ++i) {
+                    const Block block = pSection->Get(bx + (i & 3), by + (i >> 4), bz + ((i >> 2) & 3));
+
+                    if (block == Block::Air)
+                        continue;
+
+                    mask |= u64{ 1 } << i;
+                    ++counts[static_cast<u32>(block)];
+                    present[presentCount++] = static_cast<u8>(block);
+                }
+
+                const u32 common = static_cast<u32>(std::max_element(counts.begin() + 1, counts.end()) - counts.begin());
+
+                for (u32 b = 0; b < BLOCK_COUNT; ++b)
+                    sectionCounts[b] += counts[b];
+
+                bFull = bFull && presentCount == 64;
+
+                bricks.push_back(static_cast<u32>(mask));
+                bricks.push_back(static_cast<u32>(mask >> 32));
+
+                if (presentCount == 64 || counts[common] == presentCount) {
+                    bricks.push_back(SOLID_BIT | common);
+                    continue;
+                }
+
+                bricks.push_back(static_cast<u32>(blocks.size()));
+
+                for (u32 i = 0; i < presentCount; i += 4) {
+                    u32 word = 0;
+                    for (u32 j = i; j < std::min(i + 4, presentCount); ++j)
+                        word |= static_cast<u32>(present[j]) << ((j - i) * 8);
+
+                    blocks.push_back(word);
+                }
+            }
+
+            if (bFull) {
+                encoded.cell = SOLID_BIT | static_cast<u32>(std::max_element(sectionCounts.begin() + 1, sectionCounts.end()) - sectionCounts.begin());
+                return encoded;
+            }
+
+            const u32 blocksBegin = 2 + static_cast<u32>(bricks.size());
+
+            encoded.node.reserve(blocksBegin + blocks.size());
+            encoded.node.push_back(static_cast<u32>(brickMask));
+            encoded.node.push_back(static_cast<u32>(brickMask >> 32));
+
+            for (std::size_t i = 0; i < bricks.size(); ++i)
+                encoded.node.push_back(i % 3 == 2 && !(bricks[i] & SOLID_BIT) ? bricks[i] + blocksBegin : bricks[i]);
+
+            encoded.node.insert(encoded.node.end(), blocks.begin(), blocks.end());
+
+            return encoded;
+        }
+
+        // The grid and the masks start empty, and with the header, dirty: the GPU's copy starts undefined
+        explicit VoxelTree(const std::size_t nodeWords)
+            : m_words(GetWordCount(nodeWords), 0),
+              m_nodeWords(GRID_WORDS, 0),
+              m_hashes(GRID_WORDS, 0),
+              m_top(NODE_BEGIN)
+        {
+            for (u32 b = 0; b < static_cast<u32>(Block::Count); ++b) {
+                const vec3f32& color = GetBlockProperties(static_cast<Block>(b)).color;
+
+                m_words[b] = static_cast<u32>(color.r * 255.f + 0.5f) | (static_cast<u32>(color.g * 255.f + 0.5f) << 8) | (static_cast<u32>(color.b * 255.f + 0.5f) << 16) | (255u << 24);
+            }
+
+            // Indexed by BlockFace, None lit fully
+            for (u32 face = 0; face <= static_cast<u32>(BlockFace::None); ++face) {
+                const f32 shade = face < details::FACES.size() ? details::FACES[face].shade : 1.f;
+
+                std::memcpy(&m_words[SHADE_BEGIN + face], &shade, sizeof(shade));
+            }
+
+            m_stats.capacity = nodeWords * sizeof(u32);
+
+            MarkDirty(0, NODE_BEGIN);
+        }
+
+        VoxelTree(const VoxelTree&) = delete;
+        VoxelTree& operator=(const VoxelTree&) = delete;
+
+        /*
+         * Replaces what the section's cell held, which must be air or the same section: cells are
+         * shared by sections GRID_SIDE apart, so one leaving the window is cleared first. A section
+         * with the hash already set is left alone. Returns false when the nodes are full, the
+         * section then being left out.
+         */
+        bool SetSection(const EncodedSection& encoded) {
+            const u32 cell  = GridIndex(encoded.coord);
+            const u32 index = cell - GRID_BEGIN;
+
+            if (m_hashes[index] == encoded.hash && (encoded.hash != 0 || m_words[cell] == 0))
+                return true;
+
+            if (m_nodeWords[index] > 0) {
+                m_freeNodes[ClassOf(m_nodeWords[index])].push_back(m_words[cell]);
+                m_stats.freeBytes += m_nodeWords[index] * sizeof(u32);
+                --m_stats.nodes;
+                m_nodeWords[index] = 0;
+            } else if (m_words[cell] & SOLID_BIT) {
+                --m_stats.solid;
+            }
+
+            u32  value = encoded.cell;
+            bool bSet  = true;
+
+            if (!encoded.node.empty()) {
+                const std::optional<u32> offset = AllocateNode(static_cast<u32>(encoded.node.size()));
+
+                if (offset.has_value()) {
+                    std::copy(encoded.node.begin(), encoded.node.end(), m_words.begin() + offset.value());
+                    MarkDirty(offset.value(), static_cast<u32>(encoded.node.size()));
+
+                    value              = offset.value();
+                    m_nodeWords[index] = MIN_NODE_WORDS << ClassOf(static_cast<u32>(encoded.node.size()));
+                    ++m_stats.nodes;
+                } else {
+                    value = 0;
+                    bSet  = false;
+                    ++m_stats.dropped;
+                }
+            } else if (value & SOLID_BIT) {
+                ++m_stats.solid;
+            }
+
+            m_words[cell]   = value;
+            m_hashes[index] = bSet ? encoded.hash : 0;
+            MarkDirty(cell, 1);
+
+            SetRegionBit(encoded.coord, value != 0);
+
+            return bSet;
+        }
+
+        inline void ClearSection(const vec3i32& coord) { SetSection(EncodedSection{ coord }); }
+
+        // Of the section set in the coord's cell, 0 for air and for a section left out
+        inline u64 GetSectionHash(const vec3i32& coord) const { return m_hashes[GridIndex(coord) - GRID_BEGIN]; }
+
+        inline const u32*  GetData()     const { return m_words.data(); }
+        inline std::size_t GetByteSize() const { return m_words.size() * sizeof(u32); }
+
+        inline const std::vector<ByteRange>& GetDirtyRanges() const { return m_dirtyRanges; }
+        inline void                          ClearDirtyRanges()     { m_dirtyRanges.clear(); }
+
+        inline const VoxelTreeStats& GetStats() const { return m_stats; }
+
+        /*
+         * What the far field shows along a ray, the window being the windowChunks x windowChunks
+         * columns from windowLo. Rays are marched from the window's corner rather than the world's
+         * origin, in floats, like the shader does.
+         */
+        std::optional<VoxelTreeHit> Raycast(const vec3f32& origin, const vec3f32& direction, const f32 maxDistance, const ChunkCoord windowLo, const i32 windowChunks) const {
+            constexpr f32 INF = std::numeric_limits<f32>::infinity();
+            constexpr i32 S   = static_cast<i32>(MC_CHUNK_SECTION_SIZE);
+            constexpr i32 B   = static_cast<i32>(MC_BRICK_SIZE);
+
+            const f32 length = Length(direction);
+
+            if (length <= 0.f)
+                return {};
+
+            const vec3i32 windowOrigin{ windowLo.x * S, 0, windowLo.z * S };
+            const vec3f32 o = origin - ToVec3f32(windowOrigin);
+            const vec3f32 d = direction * (1.f / length);
+            const i32     extent = windowChunks * S;
+
+            vec3i32 voxel = FloorToVec3i32(o);
+            vec3i32 step;
+            vec3f32 invDirection, tDelta, tMax;
+            f32     t    = 0.f;
+            u32     face = static_cast<u32>(BlockFace::None);
+
+            const auto Axis = [](auto& v, const int a) -> auto& { return (&v.x)[a]; };
+
+            const auto ResetTMax = [&] {
+                for (int a = 0; a < 3; ++a)
+                    Axis(tMax, a) = Axis(step, a) == 0 ? INF : (static_cast<f32>(Axis(voxel, a) + (Axis(step, a) > 0 ? 1 : 0)) - Axis(o, a)) * Axis(invDirection, a);
+            };
+
+            // To the first voxel outside of the [lo, hi) box the ray is in, as VoxelTraversal does
+            const auto JumpOutOf = [&](const vec3i32& lo, const vec3i32& hi) {
+                f32 tExit    = INF;
+                int exitAxis = 0;
+
+                for (int a = 0; a < 3; ++a) {
+                    if (Axis(step, a) == 0)
+                        continue;
+
+                    const f32 tAxis = (static_cast<f32>(Axis(step, a) > 0 ? Axis(hi, a) : Axis(lo, a)) - Axis(o, a)) * Axis(invDirection, a);
+
+                    if (tAxis < tExit) {
+                        tExit    = tAxis;
+                        exitAxis = a;
+                    }
+                }
+
+                for (int a = 0; a < 3; ++a) {
+                    if (a == exitAxis)
+                        Axis(voxel, a) = Axis(step, a) > 0 ? Axis(hi, a) : Axis(lo, a) - 1;
+                    else
+                        Axis(voxel, a) = std::clamp(static_cast<i32>(std::floor(Axis(o, a) + Axis(d, a) * tExit)), Axis(lo, a), Axis(hi, a) - 1);
+                }
+
+                t    = std::max(t, tExit);
+                face = static_cast<u32>(exitAxis * 2 + (Axis(step, exitAxis) > 0 ? 0 : 1));
+
+                ResetTMax();
+            };
+
+            for (int a = 0; a < 3; ++a) {
+                const f32 v = Axis(d, a);
+
+                Axis(step, a)         = v > 0.f ? 1 : (v < 0.f ? -1 : 0);
+                Axis(invDirection, a) = v != 0.f ? 1.f / v : INF;
+                Axis(tDelta, a)       = v != 0.f ? std::fabs(1.f / v) : INF;
+            }
+
+            ResetTMax();
+
+            for (u32 i = 0; i < MAX_STEPS && t <= maxDistance; ++i) {
+                // Out of the window for good, as it is a box
+                if (voxel.x < 0 || voxel.x >= extent || voxel.z < 0 || voxel.z >= extent)
+                    return {};
+
+                if ((voxel.y < 0 && step.y <= 0) || (voxel.y >= MC_CHUNK_HEIGHT && step.y >= 0))
+                    return {};
+
+                const vec3i32 local{ voxel.x >> 4, voxel.y >> 4, voxel.z >> 4 };
+                const vec3i32 section   = local + vec3i32{ windowLo.x, 0, windowLo.z };
+                const vec3i32 sectionLo = vec3i32{ local.x * S, local.y * S, local.z * S };
+                const vec3i32 regionLo  = vec3i32{ ((section.x >> 2) * 4 - windowLo.x) * S, (local.y >> 2) * 4 * S, ((section.z >> 2) * 4 - windowLo.z) * S };
+
+                const u64 regionMask = voxel.y >= 0 && voxel.y < MC_CHUNK_HEIGHT ? m_words[RegionIndex(section)] | (u64{ m_words[RegionIndex(section) + 1] } << 32) : 0;
+
+                if (regionMask == 0) {
+                    JumpOutOf(regionLo, regionLo + vec3i32{ 4 * S, 4 * S, 4 * S });
+                    continue;
+                }
+
+                const u32 cell = m_words[GridIndex(section)];
+
+                if (!(regionMask & (u64{ 1 } << SectionBit(section))) || cell == 0) {
+                    JumpOutOf(sectionLo, sectionLo + vec3i32{ S, S, S });
+                    continue;
+                }
+
+                if (cell & SOLID_BIT)
+                    return VoxelTreeHit{ voxel + windowOrigin, static_cast<BlockFace>(face), t, static_cast<Block>(cell & 0xFF) };
+
+                const u32 lx = WorldToLocal(voxel.x), ly = WorldToLocal(voxel.y), lz = WorldToLocal(voxel.z);
+                const u32 brick     = ChunkSection::BrickIndex(lx, ly, lz);
+                const u64 brickMask = m_words[cell] | (u64{ m_words[cell + 1] } << 32);
+
+                if (!(brickMask & (u64{ 1 } << brick))) {
+                    const vec3i32 brickLo = sectionLo + vec3i32{ static_cast<i32>(lx & ~3u), static_cast<i32>(ly & ~3u), static_cast<i32>(lz & ~3u) };
+
+                    JumpOutOf(brickLo, brickLo + vec3i32{ B, B, B });
+                    continue;
+                }
+
+                const u32 record    = cell + 2 + 3 * Rank(brickMask, brick);
+                const u32 bit       = ((ly & 3) * 4 + (lz & 3)) * 4 + (lx & 3);
+                const u64 blockMask = m_words[record] | (u64{ m_words[record + 1] } << 32);
+
+                if (blockMask & (u64{ 1 } << bit)) {
+                    const u32 blocks = m_words[record + 2];
+                    const u32 rank   = Rank(blockMask, bit);
+                    const u32 type   = blocks & SOLID_BIT ? blocks & 0xFF : (m_words[cell + blocks + rank / 4] >> (rank % 4 * 8)) & 0xFF;
+
+                    return VoxelTreeHit{ voxel + windowOrigin, static_cast<BlockFace>(face), t, static_cast<Block>(type) };
+                }
+
+                int a = 0;
+                if (tMax.y < Axis(tMax, a)) a = 1;
+                if (tMax.z < Axis(tMax, a)) a = 2;
+
+                t               = Axis(tMax, a);
+                Axis(voxel, a) += Axis(step, a);
+                Axis(tMax, a)  += Axis(tDelta, a);
+                face            = static_cast<u32>(a * 2 + (Axis(step, a) > 0 ? 0 : 1));
+            }
+
+            return {};
+        }
+    }; // class VoxelTree
+
+}; // namespace mc
\ No newline at end of file
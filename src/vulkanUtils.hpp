@@ -32,14 +32,22 @@ namespace mc {
             return formats[0];
         }
 
-        vk::PresentModeKHR PickSwapChainPresentMode(const std::vector<vk::PresentModeKHR>& modes) {
-            for (const auto& mode : modes)
-                if (mode == vk::PresentModeKHR::eMailbox)
-                    return mode;
+        // The first of the preferred modes the surface has, FIFO otherwise since every surface has it
+        vk::PresentModeKHR PickSwapChainPresentMode(const std::vector<vk::PresentModeKHR>& modes, const std::vector<vk::PresentModeKHR>& preferred) {
+            for (const vk::PresentModeKHR preference : preferred)
+                if (std::find(modes.begin(), modes.end(), preference) != modes.end())
+                    return preference;
 
             return vk::PresentModeKHR::eFifo;
         }
 
+        // Between the surface's minimum and maximum, the latter being 0 when there is none
+        u32 PickSwapChainImageCount(const vk::SurfaceCapabilitiesKHR& capabilities, const u32 requested) {
+            const u32 count = std::max(requested, capabilities.minImageCount);
+
+            return capabilities.maxImageCount == 0 ? count : std::min(count, capabilities.maxImageCount);
+        }
+
         vk::Extent2D PickSwapChainExtent(const vk::SurfaceCapabilitiesKHR& capabilities) {
             if (capabilities.currentExtent.width == UINT32_MAX)
                 return capabilities.currentExtent;
@@ -50,13 +58,67 @@ namespace mc {
             };
         }
 
-        mc::u32 FindMemoryType(const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const mc::u32 typeFilter, const vk::MemoryPropertyFlags properties) {
+        std::optional<mc::u32> TryFindMemoryType(const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const mc::u32 typeFilter, const vk::MemoryPropertyFlags properties) {
             for (mc::u32 i = 0; i < deviceMemoryProperties.memoryTypeCount; i++)
                 if ((typeFilter & (1 << i)) && (deviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
                     return i;
 
-            //TODO: Optional
-            throw std::runtime_error("FindMemoryType failed");
+            return {};
+        }
+
+        mc::u32 FindMemoryType(const vk::PhysicalDeviceMemoryProperties& deviceMemoryProperties, const mc::u32 typeFilter, const vk::MemoryPropertyFlags properties) {
+            const std::optional<mc::u32> index = TryFindMemoryType(deviceMemoryProperties, typeFilter, properties);
+
+            if (!index.has_value())
+                throw std::runtime_error("FindMemoryType failed");
+
+            return index.value();
+        }
+
+        vk::Format PickDepthFormat(const vk::PhysicalDevice& physical) {
+            constexpr std::array candidates = { vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint };
+
+            for (const vk::Format format : candidates)
+                if (physical.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+                    return format;
+
+            throw std::runtime_error("PickDepthFormat failed");
+        }
+
+        // Core since Vulkan 1.2, yet still a feature the device has to report. The instance must be 1.1 or newer
+        bool SupportsTimelineSemaphores(const vk::PhysicalDevice& physical) {
+            if (physical.getProperties().apiVersion < VK_API_VERSION_1_2)
+                return false;
+
+            const auto features = physical.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+
+            return features.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore == VK_TRUE;
+        }
+
+        // VK_KHR_present_id and VK_KHR_present_wait also need their features, read through VK_KHR_get_physical_device_properties2 on the instance
+        bool SupportsPresentWait(const vk::Instance& instance, const vk::PhysicalDevice& physical) {
+            const auto pfnGetFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(instance.getProcAddr("vkGetPhysicalDeviceFeatures2KHR"));
+            if (!pfnGetFeatures2)
+                return false;
+
+            vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR> chain;
+            pfnGetFeatures2(static_cast<VkPhysicalDevice>(physical), reinterpret_cast<VkPhysicalDeviceFeatures2*>(&chain.get<vk::PhysicalDeviceFeatures2>()));
+
+            return chain.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId == VK_TRUE && chain.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait == VK_TRUE;
+        }
+
+        constexpr vk::DeviceSize AlignUp(const vk::DeviceSize size, const vk::DeviceSize alignment) {
+            if (alignment == 0)
+                return size;
+
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        constexpr vk::DeviceSize AlignDown(const vk::DeviceSize size, const vk::DeviceSize alignment) {
+            if (alignment == 0)
+                return size;
+
+            return size & ~(alignment - 1);
         }
 
     }; // namespace details
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "header.hpp"
+#include "chunk.hpp"
+#include "timer.hpp"
+#include "epoch.hpp"
+
+/*
+ * The world is written by one thread at a time, through World and the chunks it hands out. Readers
+ * on other threads, meshers for one, read what was last published instead: Publish shares the
+ * chunks' current sections with them, and a chunk copies a published section before its next edit
+ * as it does for any shared section, so what readers see never changes under them. They take no lock:
+ * they read inside an EpochGuard, and the versions a Publish replaces are retired to the EpochDomain,
+ * which frees them once no guard can still reach them.
+ */
+
+namespace mc {
+
+    struct SectionStats {
+        std::size_t sections = 0; // Non empty sections across all chunks
+        std::size_t unique   = 0; // Distinct section instances backing them
+    }; // struct SectionStats
+
+    // A block to set in a section, at its ChunkSection::Index
+    struct SectionEdit {
+        u16   index;
+        Block block;
+    }; // struct SectionEdit
+
+    // What readers see of a chunk
+    struct PublishedChunk {
+        ChunkCoord coord;
+
+        std::array<std::atomic<const ChunkSection*>, MC_CHUNK_SECTION_COUNT> sections{};
+
+        // Writer side: keeps the published versions alive, and shared
+        std::array<std::shared_ptr<ChunkSection>, MC_CHUNK_SECTION_COUNT> owners;
+
+        explicit PublishedChunk(const ChunkCoord coord)
+            : coord(coord)
+        { }
+    }; // struct PublishedChunk
+
+    // The published chunks by coordinate, never changed once published: open addressing over a power of two
+    class PublishedChunkTable {
+    private:
+        std::vector<const PublishedChunk*> m_slots;
+        std::size_t                        m_mask;
+
+    public:
+        explicit PublishedChunkTable(const std::vector<const PublishedChunk*>& chunks) {
+            std::size_t capacity = 16;
+            while (capacity < chunks.size() * 2)
+                capacity *= 2;
+
+            m_slots.assign(capacity, nullptr);
+            m_mask = capacity - 1;
+
+            for (const PublishedChunk* pChunk : chunks) {
+                std::size_t i = ChunkCoordHash{}(pChunk->coord) & m_mask;
+
+                while (m_slots[i])
+                    i = (i + 1) & m_mask;
+
+                m_slots[i] = pChunk;
+            }
+        }
+
+        const PublishedChunk* Find(const ChunkCoord coord) const {
+            for (std::size_t i = ChunkCoordHash{}(coord) & m_mask; m_slots[i]; i = (i + 1) & m_mask)
+                if (m_slots[i]->coord == coord)
+                    return m_slots[i];
+
+            return nullptr;
+        }
+    }; // class PublishedChunkTable
+
+    struct PublishStats {
+        u64 publishes    = 0;
+        u64 sections     = 0; // Section versions published
+        u64 tables       = 0; // Chunk tables published, one per Publish that saw chunks come or go
+        u64 publishUS    = 0; // Summed over the publishes
+        u64 maxPublishUS = 0;
+    }; // struct PublishStats
+
+    class World {
+    private:
+        struct ChunkEntry {
+            std::unique_ptr<Chunk>          pChunk;
+            std::unique_ptr<PublishedChunk> pPublished; // Made by the first Publish that sees the chunk
+        }; // struct ChunkEntry
+
+        std::unordered_map<ChunkCoord, ChunkEntry, ChunkCoordHash> m_chunks;
+
+        // Readers load the table, then a chunk's sections; the writer replaces both and retires the old ones
+        std::atomic<const PublishedChunkTable*>      m_pPublishedTable{ nullptr };
+        std::unique_ptr<PublishedChunkTable>         m_pTable;
+        std::vector<std::unique_ptr<PublishedChunk>> m_unlinked; // Of destroyed chunks, still in the table until the next Publish
+        bool                                         m_bTableStale = false;
+        PublishStats                                 m_publishStats;
+
+        // Sections whose mesh no longer matches their blocks; a set, so edits within a tick coalesce
+        std::unordered_set<vec3i32, SectionCoordHash> m_dirtySections;
+
+        SectionPool m_sectionPool;
+
+        // Chunks edited since the last autosave snapshot
+        std::unordered_set<ChunkCoord, ChunkCoordHash> m_unsavedChunks;
+
+        // Chunks created or edited since the last Publish, the only ones it visits
+        std::unordered_set<ChunkCoord, ChunkCoordHash> m_unpublishedChunks;
+
+        // An edit on a section border also changes which faces the neighbour across it shows
+        void MarkDirty(const vec3i32& p) {
+            constexpr u32 LAST = MC_CHUNK_SECTION_SIZE - 1;
+
+            const vec3i32 section{ WorldToChunk(p.x), WorldToChunk(p.y), WorldToChunk(p.z) };
+            const u32 lx = WorldToLocal(p.x), ly = WorldToLocal(p.y), lz = WorldToLocal(p.z);
+
+            m_dirtySections.insert(section);
+
+            if (lx == 0)    m_dirtySections.insert(section + vec3i32{ -1, 0, 0 });
+            if (lx == LAST) m_dirtySections.insert(section + vec3i32{  1, 0, 0 });
+            if (ly == 0)    m_dirtySections.insert(section + vec3i32{ 0, -1, 0 });
+            if (ly == LAST) m_dirtySections.insert(section + vec3i32{ 0,  1, 0 });
+            if (lz == 0)    m_dirtySections.insert(section + vec3i32{ 0, 0, -1 });
+            if (lz == LAST) m_dirtySections.insert(section + vec3i32{ 0, 0,  1 });
+        }
+
+    public:
+        World() = default;
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        Chunk& CreateChunk(const ChunkCoord coord) {
+            std::unique_ptr<Chunk>& pChunk = m_chunks[coord].pChunk;
+
+            if (!pChunk) {
+                pChunk = std::make_unique<Chunk>(coord);
+                m_unpublishedChunks.insert(coord);
+            }
+
+            return *pChunk;
+        }
+
+        void DestroyChunk(const ChunkCoord coord) {
+            const auto it = m_chunks.find(coord);
+            if (it == m_chunks.end())
+                return;
+
+            if (it->second.pPublished) {
+                m_unlinked.push_back(std::move(it->second.pPublished));
+                m_bTableStale = true;
+            }
+
+            m_unpublishedChunks.erase(coord);
+            m_chunks.erase(it);
+        }
+
+        inline Chunk* GetChunk(const ChunkCoord coord) {
+            const auto it = m_chunks.find(coord);
+
+            return it != m_chunks.end() ? it->second.pChunk.get() : nullptr;
+        }
+
+        inline const Chunk* GetChunk(const ChunkCoord coord) const {
+            const auto it = m_chunks.find(coord);
+
+            return it != m_chunks.end() ? it->second.pChunk.get() : nullptr;
+        }
+
+        // Section coordinates are block coordinates divided by 16 (on all three axes)
+        const ChunkSection* GetSection(const vec3i32& sectionCoord) const {
+            if (sectionCoord.y < 0 || sectionCoord.y >= static_cast<i32>(MC_CHUNK_SECTION_COUNT))
+                return nullptr;
+
+            const Chunk* pChunk = GetChunk(ChunkCoord{ sectionCoord.x, sectionCoord.z });
+
+            return pChunk ? pChunk->GetSection(static_cast<u32>(sectionCoord.y)) : nullptr;
+        }
+
+        Block GetBlock(const vec3i32& p) const {
+            const Chunk* pChunk = GetChunk(ChunkCoord{ WorldToChunk(p.x), WorldToChunk(p.z) });
+
+            return pChunk ? pChunk->GetBlock(WorldToLocal(p.x), p.y, WorldToLocal(p.z)) : Block::Air;
+        }
+
+        void SetBlock(const vec3i32& p, const Block block) {
+            Chunk* pChunk = GetChunk(ChunkCoord{ WorldToChunk(p.x), WorldToChunk(p.z) });
+
+            if (!pChunk || p.y < 0 || p.y >= static_cast<i32>(MC_CHUNK_HEIGHT) || pChunk->GetBlock(WorldToLocal(p.x), p.y, WorldToLocal(p.z)) == block)
+                return;
+
+            pChunk->SetBlock(WorldToLocal(p.x), p.y, WorldToLocal(p.z), block);
+            MarkDirty(p);
+
+            m_unsavedChunks.insert(pChunk->GetCoord());
+            m_unpublishedChunks.insert(pChunk->GetCoord());
+        }
+
+        // Edits in bulk to one section: it is copied at most once, and it and the neighbours facing
+        // edits on its borders are marked dirty once rather than per block
+        void SetSectionBlocks(const vec3i32& sectionCoord, const std::vector<SectionEdit>& edits) {
+            constexpr u32 LAST = MC_CHUNK_SECTION_SIZE - 1;
+
+            Chunk* pChunk = GetChunk(ChunkCoord{ sectionCoord.x, sectionCoord.z });
+
+            if (!pChunk || edits.empty() || sectionCoord.y < 0 || sectionCoord.y >= static_cast<i32>(MC_CHUNK_SECTION_COUNT))
+                return;
+
+            ChunkSection& section = pChunk->GetOrCreateSection(static_cast<u32>(sectionCoord.y));
+
+            bool bChanged = false;
+            std::array<bool, 6> borders{}; // Indexed by BlockFace
+
+            for (const SectionEdit& edit : edits) {
+                const u32 x = edit.index % MC_CHUNK_SECTION_SIZE;
+                const u32 z = (edit.index / MC_CHUNK_SECTION_SIZE) % MC_CHUNK_SECTION_SIZE;
+                const u32 y = edit.index / (MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE);
+
+                if (section.Get(x, y, z) == edit.block)
+                    continue;
+
+                section.Set(x, y, z, edit.block);
+                bChanged = true;
+
+                borders[static_cast<u32>(BlockFace::NegX)] |= x == 0;
+                borders[static_cast<u32>(BlockFace::PosX)] |= x == LAST;
+                borders[static_cast<u32>(BlockFace::NegY)] |= y == 0;
+                borders[static_cast<u32>(BlockFace::PosY)] |= y == LAST;
+                borders[static_cast<u32>(BlockFace::NegZ)] |= z == 0;
+                borders[static_cast<u32>(BlockFace::PosZ)] |= z == LAST;
+            }
+
+            if (!bChanged)
+                return;
+
+            constexpr std::array<vec3i32, 6> FACE_OFFSETS = {
+                vec3i32{ -1, 0, 0 }, vec3i32{ 1, 0, 0 }, vec3i32{ 0, -1, 0 }, vec3i32{ 0, 1, 0 }, vec3i32{ 0, 0, -1 }, vec3i32{ 0, 0, 1 }
+            };
+
+            m_dirtySections.insert(sectionCoord);
+
+            for (u32 face = 0; face < 6; ++face)
+                if (borders[face])
+                    m_dirtySections.insert(sectionCoord + FACE_OFFSETS[face]);
+
+            m_unsavedChunks.insert(pChunk->GetCoord());
+            m_unpublishedChunks.insert(pChunk->GetCoord());
+        }
+
+        /*
+         * Makes the chunks as they are now what readers see, and retires what they saw before.
+         * Called by the writing thread between edits, once a frame: edits in between are not seen
+         * until then, however many there were. Returns the count of section versions published.
+         *
+         * Only the chunks created, edited through the World or marked dirty since the last call are
+         * visited. A chunk written to directly is seen if it was created since then, as generated ones are.
+         */
+        std::size_t Publish() {
+            const Timer timer;
+            EpochDomain& epochs = EpochDomain::Get();
+
+            std::size_t published = 0;
+
+            for (const ChunkCoord coord : m_unpublishedChunks) {
+                ChunkEntry& entry = m_chunks.at(coord);
+
+                if (!entry.pPublished) {
+                    entry.pPublished = std::make_unique<PublishedChunk>(coord);
+                    m_bTableStale    = true;
+                }
+
+                PublishedChunk& chunk = *entry.pPublished;
+
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y) {
+                    const std::shared_ptr<ChunkSection>& pCurrent = entry.pChunk->GetSectionPtr(y);
+
+                    if (pCurrent == chunk.owners[y])
+                        continue;
+
+                    chunk.sections[y].store(pCurrent.get(), std::memory_order_release);
+
+                    if (chunk.owners[y])
+                        epochs.Retire(std::move(chunk.owners[y]));
+
+                    chunk.owners[y] = pCurrent;
+                    ++published;
+                }
+            }
+
+            m_unpublishedChunks.clear();
+
+            if (m_bTableStale) {
+                std::vector<const PublishedChunk*> chunks;
+                chunks.reserve(m_chunks.size());
+
+                for (const auto& [coord, entry] : m_chunks)
+                    chunks.push_back(entry.pPublished.get());
+
+                auto pTable = std::make_unique<PublishedChunkTable>(chunks);
+                m_pPublishedTable.store(pTable.get(), std::memory_order_release);
+
+                // Unreachable from now on, but maybe not by the readers already in
+                if (m_pTable)
+                    epochs.Retire(std::move(m_pTable));
+
+                for (std::unique_ptr<PublishedChunk>& pUnlinked : m_unlinked)
+                    epochs.Retire(std::move(pUnlinked));
+
+                m_pTable = std::move(pTable);
+                m_unlinked.clear();
+                m_bTableStale = false;
+
+                ++m_publishStats.tables;
+            }
+
+            epochs.Collect();
+
+            const u64 elapsedUS = timer.GetElapsedUS();
+
+            ++m_publishStats.publishes;
+            m_publishStats.sections    += published;
+            m_publishStats.publishUS   += elapsedUS;
+            m_publishStats.maxPublishUS = std::max(m_publishStats.maxPublishUS, elapsedUS);
+
+            return published;
+        }
+
+        // From any thread, inside an EpochGuard: the section as of the last Publish, which no one changes
+        const ChunkSection* ReadSection(const vec3i32& sectionCoord) const {
+            if (sectionCoord.y < 0 || sectionCoord.y >= static_cast<i32>(MC_CHUNK_SECTION_COUNT))
+                return nullptr;
+
+            const PublishedChunkTable* pTable = m_pPublishedTable.load(std::memory_order_acquire);
+            const PublishedChunk*      pChunk = pTable ? pTable->Find(ChunkCoord{ sectionCoord.x, sectionCoord.z }) : nullptr;
+
+            return pChunk ? pChunk->sections[static_cast<u32>(sectionCoord.y)].load(std::memory_order_acquire) : nullptr;
+        }
+
+        // From any thread, inside an EpochGuard
+        Block ReadBlock(const vec3i32& p) const {
+            if (p.y < 0 || p.y >= MC_CHUNK_HEIGHT)
+                return Block::Air;
+
+            const ChunkSection* pSection = ReadSection(vec3i32{ WorldToChunk(p.x), WorldToChunk(p.y), WorldToChunk(p.z) });
+
+            return pSection ? pSection->Get(WorldToLocal(p.x), WorldToLocal(p.y), WorldToLocal(p.z)) : Block::Air;
+        }
+
+        inline PublishStats GetPublishStats() const { return m_publishStats; }
+
+        // For chunks replaced as a whole (e.g. received over the network): its sections and the sections facing it
+        void MarkChunkDirty(const ChunkCoord coord) {
+            if (GetChunk(coord))
+                m_unpublishedChunks.insert(coord);
+
+            for (i32 y = 0; y < static_cast<i32>(MC_CHUNK_SECTION_COUNT); ++y) {
+                m_dirtySections.insert(vec3i32{ coord.x, y, coord.z });
+
+                for (const vec3i32& neighbour : { vec3i32{ coord.x - 1, y, coord.z }, vec3i32{ coord.x + 1, y, coord.z }, vec3i32{ coord.x, y, coord.z - 1 }, vec3i32{ coord.x, y, coord.z + 1 } })
+                    if (GetSection(neighbour))
+                        m_dirtySections.insert(neighbour);
+            }
+        }
+
+        // Only edits made through World::SetBlock, SetSectionBlocks and MarkChunkDirty are tracked, not chunk generation
+        inline const std::unordered_set<vec3i32, SectionCoordHash>& GetDirtySections() const { return m_dirtySections; }
+
+        inline void ClearDirtySection(const vec3i32& sectionCoord) { m_dirtySections.erase(sectionCoord); }
+
+        inline std::size_t GetChunkCount() const { return m_chunks.size(); }
+
+        inline std::size_t GetUnsavedChunkCount() const { return m_unsavedChunks.size(); }
+
+        // Copies of the chunks edited since the last call. They share their sections with the live
+        // chunks, which copy a section before their next edit to it rather than the snapshot paying upfront
+        std::vector<Chunk> SnapshotUnsavedChunks() {
+            std::vector<Chunk> snapshot;
+            snapshot.reserve(m_unsavedChunks.size());
+
+            for (const ChunkCoord coord : m_unsavedChunks)
+                if (const Chunk* pChunk = GetChunk(coord))
+                    snapshot.push_back(*pChunk);
+
+            m_unsavedChunks.clear();
+
+            return snapshot;
+        }
+
+        // Chunks should be interned into it once generated or received
+        inline SectionPool& GetSectionPool() { return m_sectionPool; }
+
+        SectionStats GetSectionStats() const {
+            SectionStats stats;
+            std::unordered_set<const ChunkSection*> unique;
+
+            for (const auto& [coord, entry] : m_chunks) {
+                for (u32 y = 0; y < MC_CHUNK_SECTION_COUNT; ++y) {
+                    if (const ChunkSection* pSection = entry.pChunk->GetSection(y)) {
+                        ++stats.sections;
+                        unique.insert(pSection);
+                    }
+                }
+            }
+
+            stats.unique = unique.size();
+
+            return stats;
+        }
+
+        template <typename F>
+        void ForEachChunk(F&& f) {
+            for (auto& [coord, entry] : m_chunks)
+                f(*entry.pChunk);
+        }
+
+        template <typename F>
+        void ForEachChunk(F&& f) const {
+            for (const auto& [coord, entry] : m_chunks)
+                f(static_cast<const Chunk&>(*entry.pChunk));
+        }
+    }; // class World
+
+}; // namespace mc
\ No newline at end of file
@@ -0,0 +1,397 @@
+#pragma once
+
+#include "header.hpp"
+#include "noise.hpp"
+#include "world.hpp"
+
+/*
+ * World generation runs in stages: terrain, caves, ores, trees and structures. Each stage only
+ * writes the chunk it runs on. What spills over a chunk border (a tree canopy, a ruin) is placed
+ * by every chunk it overlaps: they all derive the same feature from the seed and from the
+ * heightmaps of the chunks around them, which is what a stage's neighbour radius is about.
+ */
+
+namespace mc {
+
+    constexpr i32 MC_SEA_LEVEL = 62;
+
+    // The terrain surface of each column of a chunk, at x + z * 16, before caves are carved
+    using Heightmap = std::array<u8, MC_CHUNK_SECTION_SIZE * MC_CHUNK_SECTION_SIZE>;
+
+    enum class GenerationStage : u8 {
+        Empty = 0,
+        Terrain,
+        Caves,
+        Ores,
+        Trees,
+        Structures,
+
+        Count,
+        Full = Structures
+    }; // enum class GenerationStage
+
+    struct GenerationStageInfo {
+        const char*     name;
+        GenerationStage neighbourStage; // What the chunks within radius must have completed first
+        i32             radius;
+    }; // struct GenerationStageInfo
+
+    constexpr i32 MC_GENERATION_MAX_RADIUS = 2;
+
+    namespace details {
+        constexpr inline std::array<GenerationStageInfo, static_cast<std::size_t>(GenerationStage::Count)> GENERATION_STAGES = {
+            GenerationStageInfo{ "empty",      GenerationStage::Empty,   0 },
+            GenerationStageInfo{ "terrain",    GenerationStage::Empty,   0 },
+            GenerationStageInfo{ "caves",      GenerationStage::Empty,   0 },
+            GenerationStageInfo{ "ores",       GenerationStage::Empty,   0 }, // Veins spill over, but only depend on the seed
+            GenerationStageInfo{ "trees",      GenerationStage::Terrain, 1 }, // Canopies reach 2 blocks over the border
+            GenerationStageInfo{ "structures", GenerationStage::Terrain, 2 }, // Ruins reach 1 chunk over, and sit on the terrain under them
+        };
+    }; // namespace details
+
+    constexpr const GenerationStageInfo& GetGenerationStageInfo(const GenerationStage stage) {
+        return details::GENERATION_STAGES[static_cast<std::size_t>(stage)];
+    }
+
+    // The heightmaps of the chunks around the one a stage runs on; only those within the stage's radius are set
+    class GenerationNeighbourhood {
+    private:
+        static constexpr i32 SIZE = 2 * MC_GENERATION_MAX_RADIUS + 1;
+
+        ChunkCoord m_center;
+
+        std::array<const Heightmap*, SIZE * SIZE> m_heightmaps{};
+
+    public:
+        explicit GenerationNeighbourhood(const ChunkCoord center)
+            : m_center(center)
+        { }
+
+        inline ChunkCoord GetCenter() const { return m_center; }
+
+        inline void Set(const i32 dx, const i32 dz, const Heightmap* pHeightmap) {
+            m_heightmaps[(dz + MC_GENERATION_MAX_RADIUS) * SIZE + dx + MC_GENERATION_MAX_RADIUS] = pHeightmap;
+        }
+
+        // The surface height at a world column, which must lie within the stage's radius
+        i32 GetHeight(const i32 worldX, const i32 worldZ) const {
+            const i32 dx = WorldToChunk(worldX) - m_center.x;
+            const i32 dz = WorldToChunk(worldZ) - m_center.z;
+
+            const Heightmap* pHeightmap = m_heightmaps[(dz + MC_GENERATION_MAX_RADIUS) * SIZE + dx + MC_GENERATION_MAX_RADIUS];
+            assert(std::abs(dx) <= MC_GENERATION_MAX_RADIUS && std::abs(dz) <= MC_GENERATION_MAX_RADIUS && pHeightmap);
+
+            return (*pHeightmap)[WorldToLocal(worldZ) * MC_CHUNK_SECTION_SIZE + WorldToLocal(worldX)];
+        }
+    }; // class GenerationNeighbourhood
+
+    class WorldGenerator {
+    private:
+        // Cave noise is sampled every 4 blocks and interpolated in between
+        static constexpr i32 CAVE_CELL = 4;
+
+        struct OreVein {
+            Block block;
+            u32   countPerChunk;
+            i32   maxY;
+            i32   radius;
+        }; // struct OreVein
+
+        static constexpr std::array<OreVein, 4> ORE_VEINS = {
+            OreVein{ Block::CoalOre,    16, 128, 2 },
+            OreVein{ Block::IronOre,    20, 64,  1 },
+            OreVein{ Block::GoldOre,    3,  32,  1 },
+            OreVein{ Block::DiamondOre, 1,  16,  1 },
+        };
+
+        u64 m_seed;
+
+    private:
+        inline u64 Random(const u64 salt, const ChunkCoord coord, const u32 index) const {
+            return noise::Hash(m_seed + salt, coord.x, static_cast<i32>(index), coord.z);
+        }
+
+        // Features are anchored anywhere, a chunk only writes their blocks over its own columns
+        static bool IsInChunk(const Chunk& chunk, const i32 worldX, const i32 worldZ) {
+            return WorldToChunk(worldX) == chunk.GetCoord().x && WorldToChunk(worldZ) == chunk.GetCoord().z;
+        }
+
+        // Negative inside caves: tunnels run where two noise fields both cross 0.5, caverns open where a third one peaks
+        f32 SampleCaveNoise(const i32 worldX, const i32 worldY, const i32 worldZ) const {
+            const f32 x = static_cast<f32>(worldX), y = static_cast<f32>(worldY), z = static_cast<f32>(worldZ);
+
+            const f32 a = noise::Fractal3D(m_seed + 11, x / 48.f, y / 24.f, z / 48.f, 2);
+            const f32 b = noise::Fractal3D(m_seed + 13, x / 48.f, y / 24.f, z / 48.f, 2);
+            const f32 c = noise::Fractal3D(m_seed + 17, x / 64.f, y / 32.f, z / 64.f, 2);
+
+            return std::min(std::max(std::abs(a - 0.5f), std::abs(b - 0.5f)) - 0.035f, (0.74f - c) * 0.5f);
+        }
+
+        bool CanTreeGrow(const i32 worldX, const i32 height, const i32 worldZ) const {
+            // Tested on the exact noise so every chunk makes the same call, with a margin over the interpolated carving
+            return height >= MC_SEA_LEVEL + 2 && height + 8 < MC_CHUNK_HEIGHT && GetCaveDensity(worldX, height, worldZ) > 0.01f;
+        }
+
+        void PlaceTree(Chunk& chunk, const i32 worldX, const i32 height, const i32 worldZ, const u64 h) const {
+            const i32 trunk = 4 + static_cast<i32>(h % 3);
+            const i32 top   = height + trunk;
+
+            for (i32 y = top - 2; y <= top + 1; ++y) {
+                const i32 radius = y < top ? 2 : 1;
+
+                for (i32 dz = -radius; dz <= radius; ++dz) {
+                    for (i32 dx = -radius; dx <= radius; ++dx) {
+                        // Some of the outer corners are left out
+                        if (std::abs(dx) == radius && std::abs(dz) == radius && ((h >> (8 + (y - top + 2) * 4 + (dx > 0) * 2 + (dz > 0))) & 1))
+                            continue;
+
+                        const i32 x = worldX + dx, z = worldZ + dz;
+                        if (IsInChunk(chunk, x, z) && chunk.GetBlock(WorldToLocal(x), y, WorldToLocal(z)) == Block::Air)
+                            chunk.SetBlock(WorldToLocal(x), y, WorldToLocal(z), Block::Leaves);
+                    }
+                }
+            }
+
+            // Trunks win over leaves, whatever order overlapping trees are placed in
+            if (IsInChunk(chunk, worldX, worldZ))
+                for (i32 y = height + 1; y < top; ++y)
+                    chunk.SetBlock(WorldToLocal(worldX), y, WorldToLocal(worldZ), Block::Wood);
+        }
+
+        // A ruined square of cobblestone walls on a planks floor, with a foundation down to the terrain
+        void PlaceRuin(Chunk& chunk, const GenerationNeighbourhood& neighbours, const i32 centerX, const i32 centerZ, const u64 h) const {
+            const i32 r = 3 + static_cast<i32>(h % 3);
+
+            const std::array<std::pair<i32, i32>, 5> samples = { { { 0, 0 }, { -r, -r }, { r, -r }, { -r, r }, { r, r } } };
+
+            i32 low = MC_CHUNK_HEIGHT, high = 0;
+            for (const auto& [dx, dz] : samples) {
+                const i32 height = neighbours.GetHeight(centerX + dx, centerZ + dz);
+
+                low  = std::min(low, height);
+                high = std::max(high, height);
+            }
+
+            // Too steep or under water, there is no ruin after all
+            if (high - low > 4 || low <= MC_SEA_LEVEL || high + 8 >= MC_CHUNK_HEIGHT)
+                return;
+
+            const i32 floor = (low + high + 1) / 2;
+
+            for (i32 z = centerZ - r; z <= centerZ + r; ++z) {
+                for (i32 x = centerX - r; x <= centerX + r; ++x) {
+                    if (!IsInChunk(chunk, x, z))
+                        continue;
+
+                    const u32 lx = WorldToLocal(x), lz = WorldToLocal(z);
+
+                    for (i32 y = neighbours.GetHeight(x, z) + 1; y < floor; ++y)
+                        chunk.SetBlock(lx, y, lz, Block::Cobblestone);
+
+                    chunk.SetBlock(lx, floor, lz, Block::Planks);
+
+                    const bool bCorner = std::abs(x - centerX) == r && std::abs(z - centerZ) == r;
+                    const bool bWall   = std::abs(x - centerX) == r || std::abs(z - centerZ) == r;
+
+                    // The walls crumble to a height of 0 to 4, the corners stand
+                    const i32 wall = bCorner ? 5 : bWall ? static_cast<i32>(noise::Hash(h, x, 0, z) % 5) : 0;
+
+                    for (i32 y = floor + 1; y <= floor + 6; ++y)
+                        chunk.SetBlock(lx, y, lz, y <= floor + wall ? Block::Cobblestone : Block::Air);
+                }
+            }
+        }
+
+    public:
+        explicit WorldGenerator(const u64 seed)
+            : m_seed(seed)
+        { }
+
+        inline u64 GetSeed() const { return m_seed; }
+
+        i32 GetTerrainHeight(const i32 worldX, const i32 worldZ) const {
+            const f32 n = noise::Fractal2D(m_seed, worldX / 96.f, worldZ / 96.f, 5);
+
+            return std::clamp(static_cast<i32>(40.f + n * 56.f), 1, MC_CHUNK_HEIGHT - 1);
+        }
+
+        // The cave noise at a block, interpolated from the corners of its cell like the carving does
+        f32 GetCaveDensity(const i32 worldX, const i32 worldY, const i32 worldZ) const {
+            const i32 x0 = worldX & ~(CAVE_CELL - 1), y0 = worldY & ~(CAVE_CELL - 1), z0 = worldZ & ~(CAVE_CELL - 1);
+            const f32 tx = (worldX - x0) / static_cast<f32>(CAVE_CELL), ty = (worldY - y0) / static_cast<f32>(CAVE_CELL), tz = (worldZ - z0) / static_cast<f32>(CAVE_CELL);
+
+            f32 corners[8];
+            for (int i = 0; i < 8; ++i)
+                corners[i] = SampleCaveNoise(x0 + (i & 1) * CAVE_CELL, y0 + ((i >> 1) & 1) * CAVE_CELL, z0 + (i >> 2) * CAVE_CELL);
+
+            const f32 z0v = noise::Lerp(noise::Lerp(corners[0], corners[1], tx), noise::Lerp(corners[2], corners[3], tx), ty);
+            const f32 z1v = noise::Lerp(noise::Lerp(corners[4], corners[5], tx), noise::Lerp(corners[6], corners[7], tx), ty);
+
+            return noise::Lerp(z0v, z1v, tz);
+        }
+
+        void GenerateTerrain(Chunk& chunk, Heightmap& heightmap) const {
+            const i32 baseX = ChunkToWorld(chunk.GetCoord().x);
+            const i32 baseZ = ChunkToWorld(chunk.GetCoord().z);
+
+            for (u32 z = 0; z < MC_CHUNK_SECTION_SIZE; ++z) {
+                for (u32 x = 0; x < MC_CHUNK_SECTION_SIZE; ++x) {
+                    const i32 height = GetTerrainHeight(baseX + static_cast<i32>(x), baseZ + static_cast<i32>(z));
+                    heightmap[z * MC_CHUNK_SECTION_SIZE + x] = static_cast<u8>(height);
+
+                    chunk.SetBlock(x, 0, z, Block::Bedrock);
+
+                    for (i32 y = 1; y <= height; ++y) {
+                        Block block = Block::Stone;
+
+                        if (y == height)
+                            block = height < MC_SEA_LEVEL + 2 ? Block::Sand : Block::Grass;
+                        else if (y > height - 4)
+                            block = height < MC_SEA_LEVEL + 2 ? Block::Sand : Block::Dirt;
+
+                        chunk.SetBlock(x, y, z, block);
+                    }
+
+                    for (i32 y = height + 1; y <= MC_SEA_LEVEL; ++y)
+                        chunk.SetBlock(x, y, z, Block::Water);
+                }
+            }
+        }
+
+        // Carves where the interpolated cave noise goes negative, filling the bottom with lava. Caves open
+        // to the surface on land, but stop 4 blocks under the floor of the sea and beaches so they stay dry
+        void CarveCaves(Chunk& chunk, const Heightmap& heightmap) const {
+            constexpr i32 CELLS = static_cast<i32>(MC_CHUNK_SECTION_SIZE) / CAVE_CELL;
+            constexpr i32 LAVA_LEVEL = 10;
+
+            const i32 baseX = ChunkToWorld(chunk.GetCoord().x);
+            const i32 baseZ = ChunkToWorld(chunk.GetCoord().z);
+            const i32 top   = *std::max_element(heightmap.begin(), heightmap.end());
+            const i32 cellsY = top / CAVE_CELL + 1;
+
+            // The corners of every cell, then the blocks in between
+            std::vector<f32> samples(static_cast<std::size_t>((CELLS + 1) * (CELLS + 1) * (cellsY + 1)));
+            const auto Sample = [&](const i32 cx, const i32 cy, const i32 cz) -> f32& { return samples[static_cast<std::size_t>((cy * (CELLS + 1) + cz) * (CELLS + 1) + cx)]; };
+
+            for (i32 cy = 0; cy <= cellsY; ++cy)
+                for (i32 cz = 0; cz <= CELLS; ++cz)
+                    for (i32 cx = 0; cx <= CELLS; ++cx)
+                        Sample(cx, cy, cz) = SampleCaveNoise(baseX + cx * CAVE_CELL, cy * CAVE_CELL, baseZ + cz * CAVE_CELL);
+
+            for (u32 z = 0; z < MC_CHUNK_SECTION_SIZE; ++z) {
+                for (u32 x = 0; x < MC_CHUNK_SECTION_SIZE; ++x) {
+                    const i32 height = heightmap[z * MC_CHUNK_SECTION_SIZE + x];
+                    const i32 ceiling = height < MC_SEA_LEVEL + 2 ? height - 4 : height;
+
+                    const i32 cx = static_cast<i32>(x) / CAVE_CELL, cz = static_cast<i32>(z) / CAVE_CELL;
+                    const f32 tx = (x % CAVE_CELL) / static_cast<f32>(CAVE_CELL), tz = (z % CAVE_CELL) / static_cast<f32>(CAVE_CELL);
+
+                    for (i32 y = 1; y <= ceiling; ++y) {
+                        const i32 cy = y / CAVE_CELL;
+                        const f32 ty = (y % CAVE_CELL) / static_cast<f32>(CAVE_CELL);
+
+                        const f32 z0v = noise::Lerp(noise::Lerp(Sample(cx, cy, cz),     Sample(cx + 1, cy, cz),     tx), noise::Lerp(Sample(cx, cy + 1, cz),     Sample(cx + 1, cy + 1, cz),     tx), ty);
+                        const f32 z1v = noise::Lerp(noise::Lerp(Sample(cx, cy, cz + 1), Sample(cx + 1, cy, cz + 1), tx), noise::Lerp(Sample(cx, cy + 1, cz + 1), Sample(cx + 1, cy + 1, cz + 1), tx), ty);
+
+                        if (noise::Lerp(z0v, z1v, tz) < 0.f)
+                            chunk.SetBlock(x, y, z, y <= LAVA_LEVEL ? Block::Lava : Block::Air);
+                    }
+                }
+            }
+        }
+
+        // Veins are blobs of ore replacing stone, anchored in a chunk and reaching up to 2 blocks out of it
+        void PlaceOres(Chunk& chunk) const {
+            const ChunkCoord coord = chunk.GetCoord();
+
+            for (i32 dz = -1; dz <= 1; ++dz) {
+                for (i32 dx = -1; dx <= 1; ++dx) {
+                    const ChunkCoord origin{ coord.x + dx, coord.z + dz };
+                    u32 index = 0;
+
+                    for (std::size_t ore = 0; ore < ORE_VEINS.size(); ++ore) {
+                        const OreVein& vein = ORE_VEINS[ore];
+
+                        for (u32 i = 0; i < vein.countPerChunk; ++i, ++index) {
+                            const u64 h  = Random(0x4F7265, origin, index);
+                            const i32 cx = ChunkToWorld(origin.x) + static_cast<i32>(h & 15);
+                            const i32 cz = ChunkToWorld(origin.z) + static_cast<i32>((h >> 4) & 15);
+                            const i32 cy = 1 + static_cast<i32>((h >> 8) % static_cast<u64>(vein.maxY));
+
+                            for (i32 z = cz - vein.radius; z <= cz + vein.radius; ++z) {
+                                for (i32 x = cx - vein.radius; x <= cx + vein.radius; ++x) {
+                                    if (!IsInChunk(chunk, x, z))
+                                        continue;
+
+                                    for (i32 y = cy - vein.radius; y <= cy + vein.radius; ++y) {
+                                        const i32 d = (x - cx) * (x - cx) + (y - cy) * (y - cy) + (z - cz) * (z - cz);
+
+                                        if (d <= vein.radius * vein.radius && chunk.GetBlock(WorldToLocal(x), y, WorldToLocal(z)) == Block::Stone)
+                                            chunk.SetBlock(WorldToLocal(x), y, WorldToLocal(z), vein.block);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Forests are denser where a low frequency noise is high; trees need dry grass that no cave opened
+        void PlaceTrees(Chunk& chunk, const GenerationNeighbourhood& neighbours) const {
+            const ChunkCoord coord = chunk.GetCoord();
+
+            for (i32 dz = -1; dz <= 1; ++dz) {
+                for (i32 dx = -1; dx <= 1; ++dx) {
+                    const ChunkCoord origin{ coord.x + dx, coord.z + dz };
+
+                    const f32 forest = noise::Value2D(m_seed + 23, origin.x / 6.f, origin.z / 6.f);
+                    const u32 count  = static_cast<u32>(std::max(0.f, forest - 0.3f) * 16.f);
+
+                    for (u32 i = 0; i < count; ++i) {
+                        const u64 h = Random(0x547265, origin, i);
+                        const i32 x = ChunkToWorld(origin.x) + static_cast<i32>(h & 15);
+                        const i32 z = ChunkToWorld(origin.z) + static_cast<i32>((h >> 4) & 15);
+
+                        // Canopies are 5 wide, only trees near the chunk matter
+                        if (x < ChunkToWorld(coord.x) - 2 || x > ChunkToWorld(coord.x) + 17 || z < ChunkToWorld(coord.z) - 2 || z > ChunkToWorld(coord.z) + 17)
+                            continue;
+
+                        const i32 height = neighbours.GetHeight(x, z);
+
+                        if (CanTreeGrow(x, height, z))
+                            PlaceTree(chunk, x, height, z, h);
+                    }
+                }
+            }
+        }
+
+        // One chunk in 16 holds a ruin, centered anywhere in it
+        void PlaceStructures(Chunk& chunk, const GenerationNeighbourhood& neighbours) const {
+            const ChunkCoord coord = chunk.GetCoord();
+
+            for (i32 dz = -1; dz <= 1; ++dz) {
+                for (i32 dx = -1; dx <= 1; ++dx) {
+                    const ChunkCoord origin{ coord.x + dx, coord.z + dz };
+                    const u64 h = Random(0x527569, origin, 0);
+
+                    if (h % 16 == 0)
+                        PlaceRuin(chunk, neighbours, ChunkToWorld(origin.x) + static_cast<i32>((h >> 8) & 15), ChunkToWorld(origin.z) + static_cast<i32>((h >> 12) & 15), h >> 16);
+                }
+            }
+        }
+
+        // Runs one stage on a chunk that completed the previous one, the neighbourhood holding what the stage's radius asks for
+        void RunStage(const GenerationStage stage, Chunk& chunk, Heightmap& heightmap, const GenerationNeighbourhood& neighbours) const {
+            switch (stage) {
+            case GenerationStage::Terrain:    GenerateTerrain(chunk, heightmap);   break;
+            case GenerationStage::Caves:      CarveCaves(chunk, heightmap);        break;
+            case GenerationStage::Ores:       PlaceOres(chunk);                    break;
+            case GenerationStage::Trees:      PlaceTrees(chunk, neighbours);       break;
+            case GenerationStage::Structures: PlaceStructures(chunk, neighbours);  break;
+            default: break;
+            }
+        }
+    }; // class WorldGenerator
+
+}; // namespace mc
\ No newline at end of file
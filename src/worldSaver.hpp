@@ -0,0 +1,321 @@
+#pragma once
+
+#include "header.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "fileUtils.hpp"
+#include "threadPool.hpp"
+#include "chunkCodec.hpp"
+
+/*
+ * Autosave without stalling the tick. Save() only snapshots the chunks edited since the previous
+ * save, which copies pointers to their sections: a live chunk copies a section before editing it
+ * while a snapshot still holds it. A background thread then encodes the snapshot on the thread
+ * pool, paletted and run length encoded, and rewrites the region files it touched in one batch.
+ *
+ * Only edited chunks are saved, the generator recreates the others. A region file holds the saved
+ * chunks of a 32 x 32 chunk area: a u32 magic and chunk count, then x, z, size and data per chunk.
+ *
+ * Regions are read from their file when first needed and only kept a while: a written region is
+ * dropped once its file is on disk, and loads keep at most MC_REGION_CACHE_SIZE others around.
+ */
+
+namespace mc {
+
+    constexpr i32 MC_REGION_SIZE  = 32;
+    constexpr u32 MC_REGION_MAGIC = 0x4D435247u; // "MCRG"
+
+    constexpr std::size_t MC_REGION_CACHE_SIZE = 16;
+
+    constexpr u32 MC_AUTOSAVE_INTERVAL_MS = 30'000u;
+
+    struct SaveStats {
+        u64         lastSnapshotUS = 0; // Main thread cost of the last Save()
+        u64         lastWriteUS    = 0; // Background encode and write time of the last batch
+        std::size_t lastChunkCount = 0;
+        std::size_t lastByteCount  = 0;
+    }; // struct SaveStats
+
+    class WorldSaver {
+    private:
+        using Region = std::unordered_map<ChunkCoord, std::shared_ptr<const std::vector<u8>>, ChunkCoordHash>;
+
+        struct CachedRegion {
+            Region chunks;
+            u64    lastUse  = 0;
+            bool   bWriting = false; // Newer than its file until the batch writing it is done, so it must stay
+        }; // struct CachedRegion
+
+        std::string m_directory;
+        ThreadPool& m_pool;
+
+        std::thread             m_thread;
+        std::mutex              m_queueMutex;
+        std::condition_variable m_queueCondition;
+        std::vector<Chunk>      m_queue;
+        bool                    m_bStopping = false;
+        bool                    m_bWriting  = false;
+
+        // Encoded chunks of the regions in use. The background thread writes, and LoadChunk reads,
+        // so both go through the mutex
+        std::mutex                                                   m_regionMutex;
+        std::unordered_map<ChunkCoord, CachedRegion, ChunkCoordHash> m_regions;
+        u64                                                          m_regionUses = 0;
+
+        std::mutex m_statsMutex;
+        SaveStats  m_stats;
+
+    private:
+        static inline ChunkCoord RegionOf(const ChunkCoord chunk) {
+            static_assert(MC_REGION_SIZE == 1 << 5);
+
+            // Arithmetic shifts floor negative coordinates, like WorldToChunk
+            return ChunkCoord{ chunk.x >> 5, chunk.z >> 5 };
+        }
+
+        inline std::string RegionFilename(const ChunkCoord region) const {
+            return m_directory + "/r." + std::to_string(region.x) + '.' + std::to_string(region.z) + ".bin";
+        }
+
+        // Expects m_regionMutex to be held. Reading a region in may evict the least recently used one
+        // not being written, so a previous result is only valid until the next call
+        CachedRegion& GetRegion(const ChunkCoord region) {
+            const auto it = m_regions.find(region);
+
+            if (it != m_regions.end()) {
+                it->second.lastUse = ++m_regionUses;
+                return it->second;
+            }
+
+            if (m_regions.size() >= MC_REGION_CACHE_SIZE) {
+                auto oldest = m_regions.end();
+
+                for (auto candidate = m_regions.begin(); candidate != m_regions.end(); ++candidate)
+                    if (!candidate->second.bWriting && (oldest == m_regions.end() || candidate->second.lastUse < oldest->second.lastUse))
+                        oldest = candidate;
+
+                if (oldest != m_regions.end())
+                    m_regions.erase(oldest);
+            }
+
+            CachedRegion& cached = m_regions[region];
+            cached.lastUse = ++m_regionUses;
+
+            Region& result = cached.chunks;
+
+            const std::optional<std::vector<char>> file = ReadBinaryFileToBuffer(RegionFilename(region));
+            if (!file.has_value())
+                return cached;
+
+            ByteReader reader(reinterpret_cast<const u8*>(file->data()), file->size());
+
+            if (reader.ReadU32() != MC_REGION_MAGIC)
+                return cached;
+
+            const u32 count = reader.ReadU32();
+            for (u32 i = 0; i < count && reader.IsValid(); ++i) {
+                const ChunkCoord coord{ reader.ReadI32(), reader.ReadI32() };
+                const u32        size  = reader.ReadU32();
+                const u8*        pData = reader.ReadBytes(size);
+
+                if (pData)
+                    result[coord] = std::make_shared<const std::vector<u8>>(pData, pData + size);
+            }
+
+            return cached;
+        }
+
+        void WriteBatch(std::vector<Chunk> chunks) {
+            const mc::Timer timer;
+
+            // Snapshots queued while the previous batch was being written may repeat a chunk: the last one wins
+            std::unordered_map<ChunkCoord, std::size_t, ChunkCoordHash> latest;
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+                latest[chunks[i].GetCoord()] = i;
+
+            std::vector<const Chunk*> unique;
+            std::vector<ChunkCoord>   coords;
+            unique.reserve(latest.size());
+            coords.reserve(latest.size());
+
+            for (const auto& [coord, index] : latest) {
+                unique.push_back(&chunks[index]);
+                coords.push_back(coord);
+            }
+
+            std::vector<std::shared_ptr<const std::vector<u8>>> encoded(unique.size());
+
+            m_pool.ParallelFor(unique.size(), 8, [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    auto pData = std::make_shared<std::vector<u8>>();
+
+                    ByteWriter writer(*pData);
+                    EncodeChunk(*unique[i], writer);
+
+                    encoded[i] = std::move(pData);
+                }
+            });
+
+            // Holding a copy of the sections is no longer needed, let the live chunks edit in place again
+            chunks.clear();
+
+            std::vector<FileWrite> files;
+            std::size_t bytes = 0;
+
+            std::unordered_set<ChunkCoord, ChunkCoordHash> touched;
+
+            {
+                const std::lock_guard<std::mutex> lock(m_regionMutex);
+
+                for (std::size_t i = 0; i < coords.size(); ++i) {
+                    CachedRegion& region = GetRegion(RegionOf(coords[i]));
+
+                    region.chunks[coords[i]] = std::move(encoded[i]);
+                    region.bWriting          = true;
+                    touched.insert(RegionOf(coords[i]));
+                }
+
+                for (const ChunkCoord region : touched) {
+                    const Region& saved = m_regions.at(region).chunks;
+
+                    FileWrite file{ RegionFilename(region), {} };
+                    ByteWriter writer(file.data);
+
+                    writer.WriteU32(MC_REGION_MAGIC);
+                    writer.WriteU32(static_cast<u32>(saved.size()));
+
+                    for (const auto& [coord, pData] : saved) {
+                        writer.WriteI32(coord.x);
+                        writer.WriteI32(coord.z);
+                        writer.WriteU32(static_cast<u32>(pData->size()));
+                        writer.WriteBytes(pData->data(), pData->size());
+                    }
+
+                    bytes += file.data.size();
+                    files.push_back(std::move(file));
+                }
+            }
+
+            const bool bWritten = WriteFilesAtomically(files);
+
+            if (!bWritten)
+                std::cout << "[SAVE] Could not write the world to " << m_directory << '\n' << std::flush;
+
+            // Once on disk the regions can be read back from their files. Those that could not be written
+            // stay, never evicted, so what they hold goes with the next batch that touches them
+            if (bWritten) {
+                const std::lock_guard<std::mutex> lock(m_regionMutex);
+
+                for (const ChunkCoord region : touched)
+                    m_regions.erase(region);
+            }
+
+            const std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.lastWriteUS    = timer.GetElapsedUS();
+            m_stats.lastChunkCount = coords.size();
+            m_stats.lastByteCount  = bytes;
+        }
+
+        void Run() {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+
+            while (true) {
+                m_queueCondition.wait(lock, [this] { return m_bStopping || !m_queue.empty(); });
+
+                if (m_queue.empty())
+                    return;
+
+                std::vector<Chunk> chunks = std::move(m_queue);
+                m_queue.clear();
+                m_bWriting = true;
+
+                lock.unlock();
+                WriteBatch(std::move(chunks));
+                lock.lock();
+
+                m_bWriting = false;
+                m_queueCondition.notify_all();
+            }
+        }
+
+    public:
+        WorldSaver(const std::string& directory, ThreadPool& pool)
+            : m_directory(directory), m_pool(pool)
+        {
+            if (!MakeDirectory(m_directory))
+                throw std::runtime_error("[SAVE] Could not create the save directory " + m_directory);
+
+            m_thread = std::thread([this] { Run(); });
+        }
+
+        WorldSaver(const WorldSaver&) = delete;
+        WorldSaver& operator=(const WorldSaver&) = delete;
+
+        // Writes whatever is still queued before returning
+        ~WorldSaver() {
+            {
+                const std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_bStopping = true;
+            }
+
+            m_queueCondition.notify_all();
+            m_thread.join();
+        }
+
+        inline SaveStats GetStats() {
+            const std::lock_guard<std::mutex> lock(m_statsMutex);
+            return m_stats;
+        }
+
+        // To be called between ticks: the world must not be edited while the snapshot is taken
+        void Save(World& world) {
+            const mc::Timer timer;
+
+            std::vector<Chunk> snapshot = world.SnapshotUnsavedChunks();
+
+            if (!snapshot.empty()) {
+                const std::lock_guard<std::mutex> lock(m_queueMutex);
+
+                if (m_queue.empty())
+                    m_queue = std::move(snapshot);
+                else
+                    std::move(snapshot.begin(), snapshot.end(), std::back_inserter(m_queue));
+            }
+
+            {
+                const std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_stats.lastSnapshotUS = timer.GetElapsedUS();
+            }
+
+            m_queueCondition.notify_all();
+        }
+
+        // Blocks until everything saved so far is on disk
+        void Flush() {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this] { return m_queue.empty() && !m_bWriting; });
+        }
+
+        // Decodes the saved version of the chunk into it, if there is one. The chunk must be empty
+        bool LoadChunk(Chunk& chunk) {
+            std::shared_ptr<const std::vector<u8>> pData;
+
+            {
+                const std::lock_guard<std::mutex> lock(m_regionMutex);
+
+                const Region& region = GetRegion(RegionOf(chunk.GetCoord())).chunks;
+                const auto    it     = region.find(chunk.GetCoord());
+
+                if (it == region.end())
+                    return false;
+
+                pData = it->second;
+            }
+
+            ByteReader reader(pData->data(), pData->size());
+
+            return DecodeChunk(reader, chunk);
+        }
+    }; // class WorldSaver
+
+}; // namespace mc
\ No newline at end of file